@@ -17,7 +17,19 @@
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <time.h>
 #include "fobos.h"
+#include "fobos_convert.h"
+#include "fobos_transport.h"
+#include "fobos_decim.h"
+#include "fobos_pfb.h"
+#include "fobos_fft.h"
+#include "fobos_psd.h"
+#include "fobos_pool.h"
+#include "fobos_record.h"
+#include "fobos_history.h"
+#include "fobos_replay.h"
+#include "fobos_thread.h"
 #ifdef _WIN32
 #include <libusb-1.0/libusb.h>
 #include <conio.h>
@@ -31,6 +43,12 @@
 #ifndef printf_internal
 #define printf_internal printf
 #endif // !printf_internal
+// full memory barrier, orders the rx_correction publication
+#ifdef _WIN32
+#define fobos_barrier() MemoryBarrier()
+#else
+#define fobos_barrier() __sync_synchronize()
+#endif
 //==============================================================================
 //#define FOBOS_PRINT_DEBUG
 //==============================================================================
@@ -62,6 +80,15 @@
 #define FOBOS_DEF_BUF_COUNT 16
 #define FOBOS_MAX_BUF_COUNT 64
 #define FOBOS_DEF_BUF_LENGTH    (16 * 32 * 512)
+#define FOBOS_ESTIMATOR_LEN 4096    // complex samples of every buffer fed to the iq estimator
+#define FOBOS_ESTIMATOR_K 0.05      // iq estimator smoothing per update
+#define FOBOS_MAX_WORKERS 16
+#define FOBOS_PART_MIN 8192         // samples per worker at least, shorter conversions stay on the caller
+#define FOBOS_SIM_SERIAL "SIM00000000"
+#define FOBOS_RX_PLANS 1024         // frequency plans kept, a power of 2
+#define FOBOS_RFFC507X_PLL_REGS 7   // 0x00, 0x0C .. 0x11
+#define FOBOS_RX_HOP_EVENTS 256     // hop events kept for the readers, a power of 2
+#define FOBOS_SWEEP_BUF_LENGTH 16384 // samples per transfer of a sweep, the unsettled one after every retune
 #define LIBUSB_BULK_TIMEOUT 0
 #define LIBUSB_BULK_IN_ENDPOINT 0x81
 #define LIBUSB_DDESCRIPTOR_LEN 64
@@ -77,6 +104,28 @@ enum fobos_async_status
     FOBOS_CANCELING
 };
 //==============================================================================
+// the mixer from sample on, the phase at any later sample s is
+// phase + nco.step * (s - sample), modulo 2^32
+struct fobos_rx_nco
+{
+    struct fobos_nco nco;
+    uint32_t phase;
+    uint64_t sample;
+};
+//==============================================================================
+// everything fobos_rx_set_lo() writes for one frequency, made without the device
+struct fobos_rx_plan
+{
+    double value;                   // requested, Hz
+    uint32_t band;                  // 1 - lowpass, 2 - bypass, 3 - highpass, 0 - empty
+    uint16_t gpo_mask;              // the dev_gpo bits the band sets
+    uint16_t gpo;
+    int swap_iq;
+    uint16_t rffc507x[FOBOS_RFFC507X_PLL_REGS];
+    uint16_t max2830[2];            // registers 3 and 4
+    double frequency;               // actual, Hz
+};
+//==============================================================================
 struct fobos_dev_t
 {
     //=== libusb ===============================================================
@@ -89,6 +138,8 @@ struct fobos_dev_t
     int transfer_errors;
     int dev_lost;
     int use_zerocopy;
+    const struct fobos_transport_ops * ops;     // libusb or the simulator
+    void * transport;                           // ops ctx
     //=== common ===============================================================
     uint16_t user_gpo;
     uint16_t dev_gpo;
@@ -114,13 +165,68 @@ struct fobos_dev_t
     int rx_swap_iq;
     int rx_calibration_state;
     int rx_calibration_pos;
-    float rx_dc_re;
-    float rx_dc_im;
     float rx_scale_re;
-    float rx_scale_im;
+    struct fobos_iq_correction rx_correction[2];    // published under rx_estimator_lock, read lock free
+    volatile uint32_t rx_correction_seq;            // rx_correction[rx_correction_seq & 1] is the current one
+    struct fobos_iq_estimator rx_estimator;
+    volatile int rx_estimator_retune;
+    struct fobos_rx_stats rx_stats;
+    uint64_t rx_stats_last_us;                      // completion time of the previous transfer, 0 - none
+    uint64_t rx_sample_counter;                     // samples the device sent since the calibration, lost ones too
+    uint64_t rx_cb_sample;                          // index of the first sample of the buffer in rx_cb
+    int rx_format;
     float * rx_buff;
+    const struct fobos_convert_kernel * rx_convert;
+    uint32_t rx_workers;                            // conversion threads, 0 - the event thread converts
+    struct fobos_pool * rx_pool;                    // while streaming with rx_workers
+    uint8_t * rx_pool_buff;                         // converted samples, one buffer per pool job
+    struct fobos_pool * rx_parts;                   // FOBOS_FORMAT_RAW: the consumer's conversions split over rx_workers
+    uint32_t rx_parts_workers;                      // rx_parts was created with
+    fobos_mutex_t rx_estimator_lock;                // rx_estimator and the rx_correction writer, one thread at a time
+    uint32_t rx_decimation;
+    struct fobos_decim * rx_decim;                  // NULL without decimation
+    uint32_t rx_channels;
+    struct fobos_pfb * rx_pfb;                      // NULL without the channelizer
+    struct fobos_psd * rx_psd;                      // NULL without the spectrum of the stream
+    float * rx_psd_block;                           // the block being filled, psd size complex
+    uint32_t rx_psd_len;                            // samples in rx_psd_block
+    uint32_t rx_psd_hop;                            // samples from a block to the next one
+    uint32_t rx_psd_averages;                       // blocks per row
+    uint64_t rx_psd_next;                           // stream index of the sample expected next
+    fobos_mutex_t rx_record_lock;                   // rx_record between the event thread and the user
+    struct fobos_record * rx_record;                // NULL - not recording
+    struct fobos_record_capture rx_record_capture;  // of the transfer recorded last
+    uint64_t rx_record_next;                        // stream index of the sample expected next
+    struct fobos_rx_recording rx_record_status;     // of the last recording once it stopped
+    struct fobos_history * rx_history;              // NULL - none, replaced only while not streaming
+    double rx_center;                               // set by fobos_rx_set_frequency(), 0 - not yet
+    double rx_if_offset;                            // center - lo the hardware is tuned to
+    int rx_auto_if;
+    double rx_nco_offset;                           // shifted to 0 Hz by the mixer, Hz
+    struct fobos_rx_nco rx_nco[3];                  // published by the user thread, read by the rx path
+    volatile uint32_t rx_nco_seq;                   // rx_nco[rx_nco_seq % 3] is the current one
+    double rx_center_actual;                        // where fobos_rx_tune() put the center
+    fobos_mutex_t rx_config_lock;                   // one batch or hop at a time, rx_config and its status, the hops
+    struct fobos_rx_config rx_config;               // the batch waiting for the event thread
+    volatile int rx_config_pending;
+    uint32_t rx_config_batches;
+    int rx_config_result;
+    int rx_batch;                                   // a batch runs, the gpo writes wait
+    int rx_batch_gpo;                               // a gpo write waits
+    uint16_t rx_batch_gpo_value;
+    struct fobos_rx_hop * rx_hops;                  // the schedule, NULL - no hopping
+    volatile uint32_t rx_hops_count;
+    uint32_t rx_hop;                                // the hop dwelling now
+    uint64_t rx_hop_next;                           // sample index the next hop is due at
+    struct fobos_rx_hop_event rx_hop_events[FOBOS_RX_HOP_EVENTS];
+    volatile uint32_t rx_hop_events_count;          // published so far, rx_hop_events[n % FOBOS_RX_HOP_EVENTS]
+    struct fobos_rx_plan rx_plans[FOBOS_RX_PLANS];   // direct mapped by the requested frequency
     uint16_t rffc507x_registers_local[31];
     uint16_t rffc500x_registers_remote[31];
+    uint32_t rffc507x_stale;                        // remote registers a failed write left unknown
+    uint16_t max2830_registers[16];                 // as last written
+    uint16_t max2830_stale;                         // registers a failed write left unknown
+    int rx_lo_stale;                                // a write of the lo failed, the next tune applies its plan again
 };
 //==============================================================================
 char * to_bin(uint16_t s16, char * str)
@@ -182,6 +288,10 @@ int fobos_rx_get_device_count(void)
 #ifdef FOBOS_PRINT_DEBUG
     printf_internal("%s();\n", __FUNCTION__);
 #endif // FOBOS_PRINT_DEBUG
+    if (fobos_sim_active())
+    {
+        return 1;
+    }
     result = libusb_init(&ctx);
     if (result < 0)
     {
@@ -219,6 +329,14 @@ int fobos_rx_list_devices(char * serials)
     printf_internal("%s();\n", __FUNCTION__);
 #endif // FOBOS_PRINT_DEBUG
     memset(string, 0, sizeof(string));
+    if (fobos_sim_active())
+    {
+        if (serials)
+        {
+            strcat(serials, FOBOS_SIM_SERIAL " ");
+        }
+        return 1;
+    }
     result = libusb_init(&ctx);
     if (result < 0)
     {
@@ -262,7 +380,7 @@ int fobos_check(struct fobos_dev_t * dev)
 {
     if (dev != NULL)
     {
-        if ((dev->libusb_ctx != NULL) && (dev->libusb_devh != NULL))
+        if ((dev->ops != NULL) && (dev->transport != NULL))
         {
             return 0;
         }
@@ -274,14 +392,26 @@ int fobos_check(struct fobos_dev_t * dev)
 #define CTRLI       (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_IN)
 #define CTRLO       (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT)
 #define CTRL_TIMEOUT    300
+static int fobos_control(struct fobos_dev_t * dev, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index, unsigned char * data, uint16_t length)
+{
+    if (dev->rx_batch_gpo)
+    {
+        // the gpo write a batch held back goes out ahead of the next request
+        dev->rx_batch_gpo = 0;
+        dev->rx_stats.control_transfers++;
+        dev->ops->control(dev->transport, CTRLO, 0xE4, dev->rx_batch_gpo_value, 0, 0, 0, CTRL_TIMEOUT);
+    }
+    dev->rx_stats.control_transfers++;
+    return dev->ops->control(dev->transport, request_type, request, value, index, data, length, CTRL_TIMEOUT);
+}
 void fobos_spi(struct fobos_dev_t * dev, uint8_t* tx, uint8_t* rx, uint16_t size)
 {
     int result = fobos_check(dev);
     uint16_t xsize = 0;
     if (result == 0)
     {
-        xsize += libusb_control_transfer(dev->libusb_devh, CTRLO, 0xE2, 1, 0, tx, size, CTRL_TIMEOUT);
-        xsize += libusb_control_transfer(dev->libusb_devh, CTRLI, 0xE2, 1, 0, rx, size, CTRL_TIMEOUT);
+        xsize += fobos_control(dev, CTRLO, 0xE2, 1, 0, tx, size);
+        xsize += fobos_control(dev, CTRLI, 0xE2, 1, 0, rx, size);
         if (xsize != size * 2)
         {
             result = -6;
@@ -302,7 +432,7 @@ void fobos_i2c_transfer(struct fobos_dev_t * dev, uint8_t address, uint8_t* tx_d
     {
         if ((tx_data != 0) && tx_size > 0)
         {
-            xsize = libusb_control_transfer(dev->libusb_devh, CTRLO, req_code, address, 0, tx_data, tx_size, CTRL_TIMEOUT);
+            xsize = fobos_control(dev, CTRLO, req_code, address, 0, tx_data, tx_size);
             if (xsize != tx_size)
             {
                 result = -6;
@@ -310,7 +440,7 @@ void fobos_i2c_transfer(struct fobos_dev_t * dev, uint8_t address, uint8_t* tx_d
         }
         if ((rx_data != 0) && rx_size > 0)
         {
-            xsize = libusb_control_transfer(dev->libusb_devh, CTRLI, req_code, address, 0, rx_data, rx_size, CTRL_TIMEOUT);
+            xsize = fobos_control(dev, CTRLI, req_code, address, 0, rx_data, rx_size);
             if (xsize != tx_size)
             {
                 result = -6;
@@ -332,7 +462,7 @@ void fobos_i2c_write(struct fobos_dev_t * dev, uint8_t address, uint8_t* data, u
     {
         if ((data != 0) && (size > 0))
         {
-            xsize = libusb_control_transfer(dev->libusb_devh, CTRLO, req_code, address, 0, data, size, CTRL_TIMEOUT);
+            xsize = fobos_control(dev, CTRLO, req_code, address, 0, data, size);
             if (xsize != size)
             {
                 result = -6;
@@ -354,7 +484,7 @@ void fobos_i2c_read(struct fobos_dev_t * dev, uint8_t address, uint8_t* data, ui
     {
         if ((data != 0) && (size > 0))
         {
-            xsize = libusb_control_transfer(dev->libusb_devh, CTRLI, req_code, address, 0, data, size, CTRL_TIMEOUT);
+            xsize = fobos_control(dev, CTRLI, req_code, address, 0, data, size);
             if (xsize != size)
             {
                 result = -6;
@@ -376,17 +506,30 @@ void fobos_max2830_write_reg(struct fobos_dev_t * dev, uint8_t addr, uint16_t da
     tx[0] = addr;
     tx[1] = data & 0xFF;
     tx[2] = (data >> 8) & 0xFF;
-    if (result == 0)
-    {
-        xsize = libusb_control_transfer(dev->libusb_devh, CTRLO, req_code, 1, 0, tx, 3, CTRL_TIMEOUT);
-        if (xsize != 3)
-        {
-            result = -6;
-        }
-    }
     if (result != 0)
     {
         printf_internal("fobos_max2830_write_reg() err %d\n", result);
+        return;
+    }
+    xsize = fobos_control(dev, CTRLO, req_code, 1, 0, tx, 3);
+    if (xsize != 3)
+    {
+        printf_internal("fobos_max2830_write_reg() err %d\n", -6);
+        // the chip may hold either value, written again on the next update
+        dev->max2830_stale |= 1 << (addr & 0x0F);
+        dev->rx_lo_stale = 1;
+        return;
+    }
+    dev->max2830_registers[addr & 0x0F] = data;
+    dev->max2830_stale &= ~(1 << (addr & 0x0F));
+}
+//==============================================================================
+// writes only a value the register does not hold yet
+static void fobos_max2830_update_reg(struct fobos_dev_t * dev, uint8_t addr, uint16_t data)
+{
+    if ((dev->max2830_registers[addr & 0x0F] != data) || (dev->max2830_stale & (1 << (addr & 0x0F))))
+    {
+        fobos_max2830_write_reg(dev, addr, data);
     }
 }
 //==============================================================================
@@ -411,23 +554,41 @@ int fobos_max2830_init(struct fobos_dev_t * dev)
     return 0;
 }
 //==============================================================================
-int fobos_max2830_set_frequency(struct fobos_dev_t * dev, double value, double * actual)
+// registers 3 and 4 for value Hz
+static void fobos_max2830_divider(double value, uint16_t * divider, double * actual)
 {
     double fcomp = 25000000.0;
     double div = value / fcomp;
     uint32_t div_int = (uint32_t)(div) & 0x000000FF;
     uint32_t div_frac = (uint32_t)((div - div_int) * 1048575.0 + 0.5);
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%f);\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG
-    fobos_max2830_write_reg(dev, 5, 0x00A0); // Reference Frequency Divider = 1
     if (actual)
     {
         div = (double)(div_int) + (double)(div_frac) / 1048575.0;
         *actual = div * fcomp;
     }
-    fobos_max2830_write_reg(dev, 3, ((div_frac << 8) | div_int) & 0x3FFF);
-    fobos_max2830_write_reg(dev, 4, (div_frac >> 6) & 0x3FFF);
+    divider[0] = ((div_frac << 8) | div_int) & 0x3FFF;
+    divider[1] = (div_frac >> 6) & 0x3FFF;
+}
+//==============================================================================
+// the divider spans both registers, 4 is written last whenever it changed
+static void fobos_max2830_set_divider(struct fobos_dev_t * dev, const uint16_t * divider)
+{
+    fobos_max2830_update_reg(dev, 5, 0x00A0); // Reference Frequency Divider = 1
+    if ((dev->max2830_registers[3] != divider[0]) || (dev->max2830_registers[4] != divider[1]) || (dev->max2830_stale & 0x18))
+    {
+        fobos_max2830_update_reg(dev, 3, divider[0]);
+        fobos_max2830_write_reg(dev, 4, divider[1]);
+    }
+}
+//==============================================================================
+int fobos_max2830_set_frequency(struct fobos_dev_t * dev, double value, double * actual)
+{
+    uint16_t divider[2];
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%f);\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    fobos_max2830_divider(value, divider, actual);
+    fobos_max2830_set_divider(dev, divider);
     return 0;
 }
 //==============================================================================
@@ -442,7 +603,7 @@ int fobos_rffc507x_write_reg(struct fobos_dev_t * dev, uint8_t addr, uint16_t da
     tx[2] = (data >> 8) & 0xFF;
     if (result == 0)
     {
-        xsize = libusb_control_transfer(dev->libusb_devh, CTRLO, req_code, 1, 0, tx, 3, CTRL_TIMEOUT);
+        xsize = fobos_control(dev, CTRLO, req_code, 1, 0, tx, 3);
         if (xsize != 3)
         {
             result = -6;
@@ -459,7 +620,7 @@ int fobos_rffc507x_read_reg(struct fobos_dev_t * dev, uint8_t addr, uint16_t * d
     uint16_t xsize;
     if ((result == 0) && data)
     {
-        xsize = libusb_control_transfer(dev->libusb_devh, CTRLI, req_code, addr, 0, rx, 2, CTRL_TIMEOUT);
+        xsize = fobos_control(dev, CTRLI, req_code, addr, 0, rx, 2);
         *data = rx[0] | (rx[1] << 8);
         if (xsize != 2)
         {
@@ -509,16 +670,25 @@ int fobos_rffc507x_commit(struct fobos_dev_t * dev, int force)
 {
     if (fobos_check(dev) == 0)
     {
+        int result = 0;
         for (int i = 0; i < RFFC507X_REGS_COUNT; i++)
         {
             uint16_t local = dev->rffc507x_registers_local[i];
-            if ((dev->rffc500x_registers_remote[i] != local) || force)
+            if ((dev->rffc500x_registers_remote[i] != local) || (dev->rffc507x_stale & (1u << i)) || force)
             {
-                fobos_rffc507x_write_reg(dev, i, local);
+                result = fobos_rffc507x_write_reg(dev, i, local);
+                if (result != 0)
+                {
+                    // the chip may hold either value, written again on the next commit
+                    dev->rffc507x_stale |= 1u << i;
+                    dev->rx_lo_stale = 1;
+                    continue;
+                }
+                dev->rffc507x_stale &= ~(1u << i);
             }
             dev->rffc500x_registers_remote[i] = local;
         }
-        return 0;
+        return result;
     }
     return -1;
 }
@@ -530,7 +700,10 @@ int fobos_rffc507x_init(struct fobos_dev_t * dev)
     {
         for (i = 0; i < RFFC507X_REGS_COUNT; i++)
         {
-            fobos_rffc507x_write_reg(dev, i, rffc507x_regs_default[i]);
+            if (fobos_rffc507x_write_reg(dev, i, rffc507x_regs_default[i]) != 0)
+            {
+                dev->rffc507x_stale |= 1u << i;
+            }
             dev->rffc507x_registers_local[i] = rffc507x_regs_default[i];
             dev->rffc500x_registers_remote[i] = rffc507x_regs_default[i];
         }
@@ -562,7 +735,10 @@ int fobos_rffc507x_init(struct fobos_dev_t * dev)
 //==============================================================================
 #define FOBOS_RFFC507X_LO_MAX 5400
 #define FOBOS_RFFC507X_REF_FREQ 25
-int fobos_rffc507x_set_lo_frequency(struct fobos_dev_t * dev, int lo_freq_mhz, uint64_t * tune_freq_hz)
+static const uint8_t fobos_rffc507x_pll_regs[FOBOS_RFFC507X_PLL_REGS] = { 0x00, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11 };
+//==============================================================================
+// the fobos_rffc507x_pll_regs values for lo_freq_mhz, the other bits as in registers
+static void fobos_rffc507x_pll(const uint16_t * registers, int lo_freq_mhz, uint16_t * pll, uint64_t * tune_freq_hz)
 {
     uint32_t lodiv;
     uint16_t fvco;
@@ -594,10 +770,11 @@ int fobos_rffc507x_set_lo_frequency(struct fobos_dev_t * dev, int lo_freq_mhz, u
         pllcpl = 2;
     }
 
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 0); // enbl = 0
-    fobos_rffc507x_commit(dev, 0);
-
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x00], 2, 0, pllcpl);
+    for (int i = 0; i < FOBOS_RFFC507X_PLL_REGS; i++)
+    {
+        pll[i] = registers[fobos_rffc507x_pll_regs[i]];
+    }
+    fobos_rffc507x_register_modify(&pll[0], 2, 0, pllcpl);
 
     uint64_t tmp_n = ((uint64_t)fvco << 29ULL) / ((uint64_t)fbkdiv * FOBOS_RFFC507X_REF_FREQ);
     n = tmp_n >> 29ULL;
@@ -610,22 +787,54 @@ int fobos_rffc507x_set_lo_frequency(struct fobos_dev_t * dev, int lo_freq_mhz, u
         *tune_freq_hz = freq_hz;
     }
     // Path 1
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0C], 6,  4, n_lo);        // p1lodiv
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0C], 15, 7, n);           // p1n
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0C], 3,  2, fbkdiv >> 1); // p1presc
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0D], 15, 0, p1nmsb);      // p1nmsb
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0E], 15, 8, p1nlsb);      // p1nlsb
+    fobos_rffc507x_register_modify(&pll[1], 6,  4, n_lo);        // p1lodiv
+    fobos_rffc507x_register_modify(&pll[1], 15, 7, n);           // p1n
+    fobos_rffc507x_register_modify(&pll[1], 3,  2, fbkdiv >> 1); // p1presc
+    fobos_rffc507x_register_modify(&pll[2], 15, 0, p1nmsb);      // p1nmsb
+    fobos_rffc507x_register_modify(&pll[3], 15, 8, p1nlsb);      // p1nlsb
     // Path 2
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0F], 6, 4, n_lo);         // p2lodiv
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0F], 15, 7, n);           // p1n
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x0F], 3, 2, fbkdiv >> 1);  // p1presc
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x10], 15, 0, p1nmsb);      // p1nmsb
-    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x11], 15, 8, p1nlsb);      // p1nlsb
+    fobos_rffc507x_register_modify(&pll[4], 6, 4, n_lo);         // p2lodiv
+    fobos_rffc507x_register_modify(&pll[4], 15, 7, n);           // p1n
+    fobos_rffc507x_register_modify(&pll[4], 3, 2, fbkdiv >> 1);  // p1presc
+    fobos_rffc507x_register_modify(&pll[5], 15, 0, p1nmsb);      // p1nmsb
+    fobos_rffc507x_register_modify(&pll[6], 15, 8, p1nlsb);      // p1nlsb
+}
+//==============================================================================
+// the pll relocks on enbl going high, nothing is written while it runs with pll already
+static void fobos_rffc507x_set_pll(struct fobos_dev_t * dev, const uint16_t * pll)
+{
+    int changed = (((dev->rffc500x_registers_remote[0x15] >> 14) & 1) == 0) || (dev->rffc507x_stale != 0);
+    for (int i = 0; i < FOBOS_RFFC507X_PLL_REGS; i++)
+    {
+        changed |= (dev->rffc500x_registers_remote[fobos_rffc507x_pll_regs[i]] != pll[i]);
+    }
+    if (!changed)
+    {
+        return;
+    }
+    fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 0); // enbl = 0
+    fobos_rffc507x_commit(dev, 0);
 
+    for (int i = 0; i < FOBOS_RFFC507X_PLL_REGS; i++)
+    {
+        dev->rffc507x_registers_local[fobos_rffc507x_pll_regs[i]] = pll[i];
+    }
     fobos_rffc507x_commit(dev, 0);
 
     fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 1); // enbl = 1
     fobos_rffc507x_commit(dev, 0);
+}
+//==============================================================================
+int fobos_rffc507x_set_lo_frequency(struct fobos_dev_t * dev, int lo_freq_mhz, uint64_t * tune_freq_hz)
+{
+    uint16_t pll[FOBOS_RFFC507X_PLL_REGS];
+    uint64_t freq_hz;
+    fobos_rffc507x_pll(dev->rffc507x_registers_local, lo_freq_mhz, pll, &freq_hz);
+    if (tune_freq_hz)
+    {
+        *tune_freq_hz = freq_hz;
+    }
+    fobos_rffc507x_set_pll(dev, pll);
 #ifdef FOBOS_PRINT_DEBUG
     double ff = (double)freq_hz;
     printf_internal("rffc507x lo_freq_mhz = %d %f\n", lo_freq_mhz, ff);
@@ -776,7 +985,7 @@ int fobos_fx3_command(struct fobos_dev_t * dev, uint8_t code, uint16_t value, ui
     {
         return result;
     }
-    result = libusb_control_transfer(dev->libusb_devh, CTRLO, code, value, index, 0, 0, CTRL_TIMEOUT);
+    result = fobos_control(dev, CTRLO, code, value, index, 0, 0);
     return result;
 }
 //==============================================================================
@@ -787,9 +996,200 @@ int fobos_rx_set_user_gpo(struct fobos_dev_t * dev, uint8_t value)
 //==============================================================================
 int fobos_rx_set_dev_gpo(struct fobos_dev_t * dev, uint16_t value)
 {
+    if (dev->rx_batch)
+    {
+        // gpo changes in a row are one write
+        dev->rx_batch_gpo = 1;
+        dev->rx_batch_gpo_value = value;
+        return 0;
+    }
     return fobos_fx3_command(dev, 0xE4, value, 0);
 }
 //==============================================================================
+// libusb transport, ctx is the fobos_dev_t
+//==============================================================================
+static int fobos_usb_control(void * ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index, unsigned char * data, uint16_t length, unsigned int timeout_ms)
+{
+    struct fobos_dev_t * dev = (struct fobos_dev_t *)ctx;
+    return libusb_control_transfer(dev->libusb_devh, request_type, request, value, index, data, length, timeout_ms);
+}
+//==============================================================================
+static int fobos_usb_submit(void * ctx, struct libusb_transfer * transfer)
+{
+    (void)ctx;
+    return libusb_submit_transfer(transfer);
+}
+//==============================================================================
+static int fobos_usb_cancel(void * ctx, struct libusb_transfer * transfer)
+{
+    (void)ctx;
+    return libusb_cancel_transfer(transfer);
+}
+//==============================================================================
+static int fobos_usb_handle_events(void * ctx, struct timeval * tv, int * completed)
+{
+    struct fobos_dev_t * dev = (struct fobos_dev_t *)ctx;
+    return libusb_handle_events_timeout_completed(dev->libusb_ctx, tv, completed);
+}
+//==============================================================================
+static void fobos_usb_close(void * ctx)
+{
+    struct fobos_dev_t * dev = (struct fobos_dev_t *)ctx;
+    libusb_close(dev->libusb_devh);
+    libusb_exit(dev->libusb_ctx);
+    dev->libusb_devh = NULL;
+    dev->libusb_ctx = NULL;
+}
+//==============================================================================
+static const struct fobos_transport_ops fobos_usb_ops =
+{
+    "libusb",
+    fobos_usb_control,
+    fobos_usb_submit,
+    fobos_usb_cancel,
+    fobos_usb_handle_events,
+    fobos_usb_close
+};
+//==============================================================================
+// the state every freshly opened device is brought to
+static int fobos_rx_open_init(struct fobos_dev_t * dev)
+{
+    dev->dev_gpo = 0;
+    dev->rx_scale_re = 1.0f / 32768.0f;
+    fobos_iq_correction_init(&dev->rx_correction[0]);
+    dev->rx_correction_seq = 0;
+    fobos_iq_estimator_init(&dev->rx_estimator, FOBOS_ESTIMATOR_K);
+    dev->rx_estimator_retune = 0;
+    dev->rx_format = FOBOS_FORMAT_FC32;
+    dev->rx_convert = fobos_convert_select();
+    dev->rx_workers = 0;
+    fobos_mutex_init(&dev->rx_estimator_lock);
+    fobos_mutex_init(&dev->rx_config_lock);
+    fobos_mutex_init(&dev->rx_record_lock);
+    dev->rx_decimation = 1;
+    dev->rx_decim = NULL;
+    dev->rx_channels = 1;
+    dev->rx_pfb = NULL;
+    dev->rx_psd = NULL;
+    dev->rx_psd_block = NULL;
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("transport: %s, conversion kernel: %s\n", dev->ops->name, dev->rx_convert->name);
+#endif // FOBOS_PRINT_DEBUG
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    bitset(dev->dev_gpo, FOBOS_DEV_CLKSEL);
+    bitset(dev->dev_gpo, FOBOS_DEV_LNA_LP_SHD);
+    bitset(dev->dev_gpo, FOBOS_DEV_LNA_HP_SHD);
+    bitset(dev->dev_gpo, FOBOS_DEV_ADC_NCS);
+    bitset(dev->dev_gpo, FOBOS_DEV_ADC_SCK);
+    bitset(dev->dev_gpo, FOBOS_DEV_ADC_SDI);
+    bitset(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
+    fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+    fobos_si5351c_init(dev);
+    fobos_max2830_init(dev);
+    fobos_rffc507x_init(dev);
+    fobos_rffc507x_set_lo_frequency(dev, 2375, 0);
+    fobos_max2830_set_frequency(dev, 2475000000.0, 0);
+    fobos_rx_set_samplerate(dev, 10000000.0, 0);
+    return 0;
+}
+//==============================================================================
+static int fobos_rx_open_sim(struct fobos_dev_t ** out_dev, uint32_t index, const struct fobos_sim_config * config)
+{
+    if (index != 0)
+    {
+        return -1;
+    }
+    struct fobos_dev_t * dev = (struct fobos_dev_t*)malloc(sizeof(struct fobos_dev_t));
+    if (NULL == dev)
+    {
+        return -ENOMEM;
+    }
+    memset(dev, 0, sizeof(struct fobos_dev_t));
+    dev->ops = &fobos_sim_ops;
+    dev->transport = fobos_sim_open(config);
+    if (!dev->transport)
+    {
+        free(dev);
+        return -ENOMEM;
+    }
+    strcpy(dev->manufacturer, "RigExpert");
+    strcpy(dev->product, "Fobos SDR simulator");
+    strcpy(dev->serial, FOBOS_SIM_SERIAL);
+    fobos_rx_open_init(dev);
+    *out_dev = dev;
+    return 0;
+}
+//==============================================================================
+// the recording a device fobos_rx_open_replay() opened streams, NULL for others
+static struct fobos_replay * fobos_rx_replay(struct fobos_dev_t * dev)
+{
+    return (dev->ops == &fobos_sim_ops) ? fobos_sim_replay(dev->transport) : NULL;
+}
+//==============================================================================
+int fobos_rx_open_replay(struct fobos_dev_t ** out_dev, const char * path, int format, int paced, int repeat)
+{
+    if (!out_dev || !path)
+    {
+        return -7;
+    }
+    struct fobos_replay * replay = fobos_replay_open(path, format);
+    if (!replay)
+    {
+        return -7;
+    }
+    struct fobos_sim_config config;
+    fobos_sim_config_init(&config);
+    config.realtime = paced ? 1 : 0;
+    struct fobos_dev_t * dev = NULL;
+    int result = fobos_rx_open_sim(&dev, 0, &config);
+    if (result != 0)
+    {
+        fobos_replay_close(replay);
+        return result;
+    }
+    fobos_sim_set_replay(dev->transport, replay, repeat);
+    strcpy(dev->product, "Fobos SDR replay");
+    strcpy(dev->serial, "replay");
+    // the device as it was at the first capture, the band decides the word order
+    struct fobos_replay_info info;
+    fobos_replay_info(replay, &info);
+    struct fobos_iq_correction correction;
+    fobos_replay_correction(replay, &correction);
+    fobos_rx_set_iq_correction(dev, &correction);
+    if (info.samplerate > 0.0)
+    {
+        fobos_rx_set_samplerate(dev, info.samplerate, 0);
+    }
+    fobos_rx_set_direct_sampling(dev, info.direct_sampling ? 1 : 0);
+    if (info.frequency > 0.0)
+    {
+        fobos_rx_set_frequency(dev, info.frequency, 0);
+    }
+    fobos_rx_set_lna_gain(dev, info.lna_gain);
+    fobos_rx_set_vga_gain(dev, info.vga_gain);
+    *out_dev = dev;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_get_replay_info(struct fobos_dev_t * dev, struct fobos_replay_info * info)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!info || !fobos_rx_replay(dev))
+    {
+        return -7;
+    }
+    fobos_replay_info(fobos_rx_replay(dev), info);
+    return 0;
+}
+//==============================================================================
 int fobos_rx_open(struct fobos_dev_t ** out_dev, uint32_t index)
 {
     int result = 0;
@@ -800,6 +1200,11 @@ int fobos_rx_open(struct fobos_dev_t ** out_dev, uint32_t index)
     ssize_t cnt;
     uint32_t device_count = 0;
     struct libusb_device_descriptor dd;
+    const struct fobos_sim_config * sim_config = fobos_sim_active();
+    if (sim_config)
+    {
+        return fobos_rx_open_sim(out_dev, index, sim_config);
+    }
     dev = (struct fobos_dev_t*)malloc(sizeof(struct fobos_dev_t));
     if (NULL == dev)
     {
@@ -838,31 +1243,11 @@ int fobos_rx_open(struct fobos_dev_t ** out_dev, uint32_t index)
             result = libusb_claim_interface(dev->libusb_devh, 0);
             if (result == 0)
             {
+                dev->ops = &fobos_usb_ops;
+                dev->transport = dev;
+                libusb_free_device_list(dev_list, 1);
                 *out_dev = dev;
-                //======================================================================
-                dev->dev_gpo = 0;
-                dev->rx_scale_re = 1.0f / 32768.0f;
-                dev->rx_scale_im = 1.0f / 32768.0f;
-                dev->rx_dc_re = 0.25f;
-                dev->rx_dc_im = 0.25f;
-                if (fobos_check(dev) == 0)
-                {
-                    bitset(dev->dev_gpo, FOBOS_DEV_CLKSEL);
-                    bitset(dev->dev_gpo, FOBOS_DEV_LNA_LP_SHD);
-                    bitset(dev->dev_gpo, FOBOS_DEV_LNA_HP_SHD);
-                    bitset(dev->dev_gpo, FOBOS_DEV_ADC_NCS);
-                    bitset(dev->dev_gpo, FOBOS_DEV_ADC_SCK);
-                    bitset(dev->dev_gpo, FOBOS_DEV_ADC_SDI);
-                    bitset(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
-                    fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-                    fobos_si5351c_init(dev);
-                    fobos_max2830_init(dev);
-                    fobos_rffc507x_init(dev);
-                    fobos_rffc507x_set_lo_frequency(dev, 2375, 0);
-                    fobos_max2830_set_frequency(dev, 2475000000.0, 0);
-                    fobos_rx_set_samplerate(dev, 10000000.0, 0);
-                    return 0;
-                }
+                return fobos_rx_open_init(dev);
             }
             else
             {
@@ -916,14 +1301,25 @@ int fobos_rx_close(struct fobos_dev_t * dev)
     bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
     bitset(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
     fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+    fobos_rx_stop_recording(dev);
+    fobos_history_destroy(dev->rx_history);
+    dev->rx_history = NULL;
     // disable rffc507x
     fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 0); // enbl = 0
     fobos_rffc507x_commit(dev, 0);
     // disable clocks
     fobos_rffc507x_clock(dev, 0);
     fobos_max2830_clock(dev, 0);
-    libusb_close(dev->libusb_devh);
-    libusb_exit(dev->libusb_ctx);
+    dev->ops->close(dev->transport);
+    fobos_mutex_destroy(&dev->rx_estimator_lock);
+    fobos_mutex_destroy(&dev->rx_config_lock);
+    fobos_mutex_destroy(&dev->rx_record_lock);
+    free(dev->rx_hops);
+    fobos_decim_destroy(dev->rx_decim);
+    fobos_pfb_destroy(dev->rx_pfb);
+    fobos_psd_destroy(dev->rx_psd);
+    free(dev->rx_psd_block);
+    fobos_pool_destroy(dev->rx_parts);
     free(dev);
     return 0;
 }
@@ -969,531 +1365,1930 @@ int fobos_rx_get_board_info(struct fobos_dev_t * dev, char * hw_revision, char *
 #define FOBOS_MIN_HP_FREQ_MHZ (2550)
 #define FOBOS_MAX_HP_FREQ_MHZ (6550)
 //==============================================================================
-int fobos_rx_set_frequency(struct fobos_dev_t * dev, double value, double * actual)
+// the registers and switches of the lo at value Hz, -5 out of range
+static int fobos_rx_plan_make(struct fobos_dev_t * dev, double value, struct fobos_rx_plan * plan)
 {
-    int result = fobos_check(dev);
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%f);\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG    
-    if (result != 0)
-    {
-        return result;
-    }
-    result = 0;
-    if (dev->rx_frequency != value)
-    {
-        double rx_frequency = 0.0;
+    uint32_t RFFC5071_freq_mhz;
+    uint64_t RFFC5071_freq_hz_actual;
 
-        uint32_t RFFC5071_freq_mhz;
-        uint64_t RFFC5071_freq_hz_actual;
+    uint64_t freq = (uint64_t)value;
 
-        uint64_t freq = (uint64_t)value;
+    uint32_t freq_mhz = freq / 1000000;
+    double max2830_freq = 0.0;
+    double max2830_freq_actual = 0.0;
 
-        uint32_t freq_mhz = freq / 1000000;
-        double max2830_freq = 0.0;
-        double max2830_freq_actual = 0.0;
-
-        if (freq_mhz < FOBOS_MAX_LP_FREQ_MHZ)
+    memset(plan, 0, sizeof(*plan));
+    plan->value = value;
+    if (freq_mhz < FOBOS_MAX_LP_FREQ_MHZ)
+    {
+        plan->band = 1;
+        // set_preselect(lowpass);
+        bitset(plan->gpo, FOBOS_DEV_PRESEL_V1);
+        // enable lowpass lna, shut down highpass lna
+        bitset(plan->gpo, FOBOS_DEV_LNA_HP_SHD);
+        // set_if_filter(high);
+        bitset(plan->gpo, FOBOS_DEV_IF_V2);
+        // turn on max2830 ant1 (main) input, turn off ant2 (aux) input
+        plan->gpo_mask = (1 << FOBOS_DEV_PRESEL_V1) | (1 << FOBOS_DEV_PRESEL_V2) | (1 << FOBOS_DEV_LNA_LP_SHD) | (1 << FOBOS_DEV_LNA_HP_SHD) |
+                         (1 << FOBOS_DEV_IF_V1) | (1 << FOBOS_DEV_IF_V2) | (1 << FOBOS_MAX2830_ANTSEL);
+        int upcon = 0;
+        if (upcon)
         {
-            if (dev->rx_frequency_band != 1)
-            {
-                dev->rx_frequency_band = 1;
-                // set_preselect(lowpass);
-                bitset(dev->dev_gpo, FOBOS_DEV_PRESEL_V1);
-                bitclear(dev->dev_gpo, FOBOS_DEV_PRESEL_V2);
-                // enable lowpass lna
-                bitclear(dev->dev_gpo, FOBOS_DEV_LNA_LP_SHD);
-                // shut down highpass lna
-                bitset(dev->dev_gpo, FOBOS_DEV_LNA_HP_SHD);
-                // set_if_filter(high);
-                bitclear(dev->dev_gpo, FOBOS_DEV_IF_V1);
-                bitset(dev->dev_gpo, FOBOS_DEV_IF_V2);
-                // turn on max2830 ant1 (main) input, turn off ant2 (aux) input
-                bitclear(dev->dev_gpo, FOBOS_MAX2830_ANTSEL);
-                // commit dev_gpo value
-                fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-                // enable rffc507x clock
-                fobos_rffc507x_clock(dev, 1);
-            }
-            int upcon = 0;
-            if (upcon)
-            {
-                dev->rx_swap_iq = 1;
-                // set frequencies
-                uint32_t max2830_mhz = 2450;
-                RFFC5071_freq_mhz = max2830_mhz + freq_mhz;
-                RFFC5071_freq_mhz = (RFFC5071_freq_mhz / 5) * 5; // spures prevention
-                fobos_rffc507x_set_lo_frequency(dev, RFFC5071_freq_mhz, &RFFC5071_freq_hz_actual);
-                max2830_freq = (double)(RFFC5071_freq_hz_actual - freq);
-                fobos_max2830_set_frequency(dev, max2830_freq, &max2830_freq_actual);
-                rx_frequency = RFFC5071_freq_hz_actual - max2830_freq_actual;
-            }
-            else
-            {
-                dev->rx_swap_iq = 0;
-                // set frequencies
-                uint32_t max2830_mhz = 2400;
-                RFFC5071_freq_mhz = max2830_mhz - freq_mhz;
-                RFFC5071_freq_mhz = (RFFC5071_freq_mhz / 5) * 5; // spures prevention
-                fobos_rffc507x_set_lo_frequency(dev, RFFC5071_freq_mhz, &RFFC5071_freq_hz_actual);
-                max2830_freq = (double)(RFFC5071_freq_hz_actual + freq);
-                fobos_max2830_set_frequency(dev, max2830_freq, &max2830_freq_actual);
-                rx_frequency = max2830_freq_actual - RFFC5071_freq_hz_actual;
-            }
-            result = 0;
+            plan->swap_iq = 1;
+            // set frequencies
+            uint32_t max2830_mhz = 2450;
+            RFFC5071_freq_mhz = max2830_mhz + freq_mhz;
+            RFFC5071_freq_mhz = (RFFC5071_freq_mhz / 5) * 5; // spures prevention
+            fobos_rffc507x_pll(dev->rffc507x_registers_local, RFFC5071_freq_mhz, plan->rffc507x, &RFFC5071_freq_hz_actual);
+            max2830_freq = (double)(RFFC5071_freq_hz_actual - freq);
+            fobos_max2830_divider(max2830_freq, plan->max2830, &max2830_freq_actual);
+            plan->frequency = RFFC5071_freq_hz_actual - max2830_freq_actual;
         }
-        else if ((freq_mhz >= FOBOS_MIN_BP_FREQ_MHZ) && (freq_mhz <= FOBOS_MAX_BP_FREQ_MHZ))
+        else
         {
-            if (dev->rx_frequency_band != 2)
-            {
-                dev->rx_frequency_band = 2;
-                // set_preselect(bypass);
-                bitclear(dev->dev_gpo, FOBOS_DEV_PRESEL_V1);
-                bitclear(dev->dev_gpo, FOBOS_DEV_PRESEL_V2);
-                // shut down both lnas
-                bitclear(dev->dev_gpo, FOBOS_DEV_LNA_LP_SHD);
-                bitclear(dev->dev_gpo, FOBOS_DEV_LNA_HP_SHD);
-                // set_invert_iq(false);
-                dev->rx_swap_iq = 0;
-                // set_if_filter(none);
-                bitclear(dev->dev_gpo, FOBOS_DEV_IF_V1);
-                bitclear(dev->dev_gpo, FOBOS_DEV_IF_V2);
-                // turn on max2830 ant2 (diversity) input
-                bitset(dev->dev_gpo, FOBOS_MAX2830_ANTSEL);
-                // commit dev_gpo value
-                fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-                // disable rffc507x
-                fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[21], 14, 14, 0); // enbl = 0
-                fobos_rffc507x_commit(dev, 0);
-                // disable rffc507x clock
-                fobos_rffc507x_clock(dev, 0);
-            }
-            // set frequency direct to max2830
-            max2830_freq = value;
-            fobos_max2830_set_frequency(dev, max2830_freq, &max2830_freq_actual);
-            rx_frequency = max2830_freq_actual;
-            result = 0;
-        }
-        else if ((freq_mhz >= FOBOS_MIN_HP_FREQ_MHZ) && (freq_mhz <= FOBOS_MAX_HP_FREQ_MHZ))
-        {
-            // set_preselect(hipass);
-            bitclear(dev->dev_gpo, FOBOS_DEV_PRESEL_V1);
-            bitset(dev->dev_gpo, FOBOS_DEV_PRESEL_V2);
-            // set_invert_iq(true);
-            dev->rx_swap_iq = 1;
-            uint32_t max2830_mhz = 2350;
-            if ((freq_mhz >= 4550) && (freq_mhz <= 4750))
-            {
-                // set_if_filter(high);
-                bitclear(dev->dev_gpo, FOBOS_DEV_IF_V1);
-                bitset(dev->dev_gpo, FOBOS_DEV_IF_V2);
-                max2830_mhz = 2450;
-            }
-            else
-            {
-                // set_if_filter(low);
-                bitset(dev->dev_gpo, FOBOS_DEV_IF_V1);
-                bitclear(dev->dev_gpo, FOBOS_DEV_IF_V2);
-                max2830_mhz = 2350;
-            }
-            // turn on max2830 ant1 (main) input
-            bitclear(dev->dev_gpo, FOBOS_MAX2830_ANTSEL);
-            // commit dev_gpo value
-            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-            if (dev->rx_frequency_band != 3)
-            {
-                dev->rx_frequency_band = 3;
-
-                // enable rffc507x clock
-                fobos_rffc507x_clock(dev, 1);
-            }
-            RFFC5071_freq_mhz = freq_mhz - max2830_mhz;
-            fobos_rffc507x_set_lo_frequency(dev, RFFC5071_freq_mhz, &RFFC5071_freq_hz_actual);
-            max2830_freq = (double)(freq - RFFC5071_freq_hz_actual);
-            fobos_max2830_set_frequency(dev, max2830_freq, &max2830_freq_actual);
-            rx_frequency = max2830_freq_actual + RFFC5071_freq_hz_actual;
-            result = 0;
+            plan->swap_iq = 0;
+            // set frequencies
+            uint32_t max2830_mhz = 2400;
+            RFFC5071_freq_mhz = max2830_mhz - freq_mhz;
+            RFFC5071_freq_mhz = (RFFC5071_freq_mhz / 5) * 5; // spures prevention
+            fobos_rffc507x_pll(dev->rffc507x_registers_local, RFFC5071_freq_mhz, plan->rffc507x, &RFFC5071_freq_hz_actual);
+            max2830_freq = (double)(RFFC5071_freq_hz_actual + freq);
+            fobos_max2830_divider(max2830_freq, plan->max2830, &max2830_freq_actual);
+            plan->frequency = max2830_freq_actual - RFFC5071_freq_hz_actual;
         }
-        else
+        return 0;
+    }
+    if ((freq_mhz >= FOBOS_MIN_BP_FREQ_MHZ) && (freq_mhz <= FOBOS_MAX_BP_FREQ_MHZ))
+    {
+        plan->band = 2;
+        // set_preselect(bypass), shut down both lnas, set_if_filter(none);
+        // turn on max2830 ant2 (diversity) input
+        bitset(plan->gpo, FOBOS_MAX2830_ANTSEL);
+        plan->gpo_mask = (1 << FOBOS_DEV_PRESEL_V1) | (1 << FOBOS_DEV_PRESEL_V2) | (1 << FOBOS_DEV_LNA_LP_SHD) | (1 << FOBOS_DEV_LNA_HP_SHD) |
+                         (1 << FOBOS_DEV_IF_V1) | (1 << FOBOS_DEV_IF_V2) | (1 << FOBOS_MAX2830_ANTSEL);
+        // set_invert_iq(false);
+        plan->swap_iq = 0;
+        // set frequency direct to max2830
+        fobos_max2830_divider(value, plan->max2830, &max2830_freq_actual);
+        plan->frequency = max2830_freq_actual;
+        return 0;
+    }
+    if ((freq_mhz >= FOBOS_MIN_HP_FREQ_MHZ) && (freq_mhz <= FOBOS_MAX_HP_FREQ_MHZ))
+    {
+        plan->band = 3;
+        // set_preselect(hipass);
+        bitset(plan->gpo, FOBOS_DEV_PRESEL_V2);
+        // set_invert_iq(true);
+        plan->swap_iq = 1;
+        uint32_t max2830_mhz = 2350;
+        if ((freq_mhz >= 4550) && (freq_mhz <= 4750))
         {
-            result = -5;
+            // set_if_filter(high);
+            bitset(plan->gpo, FOBOS_DEV_IF_V2);
+            max2830_mhz = 2450;
         }
-        if (result == 0)
+        else
         {
-            dev->rx_frequency = rx_frequency;
-            if (actual)
-            {
-                *actual = rx_frequency;
-            }
+            // set_if_filter(low);
+            bitset(plan->gpo, FOBOS_DEV_IF_V1);
+            max2830_mhz = 2350;
         }
+        // turn on max2830 ant1 (main) input, the lnas stay as they are
+        plan->gpo_mask = (1 << FOBOS_DEV_PRESEL_V1) | (1 << FOBOS_DEV_PRESEL_V2) |
+                         (1 << FOBOS_DEV_IF_V1) | (1 << FOBOS_DEV_IF_V2) | (1 << FOBOS_MAX2830_ANTSEL);
+        RFFC5071_freq_mhz = freq_mhz - max2830_mhz;
+        fobos_rffc507x_pll(dev->rffc507x_registers_local, RFFC5071_freq_mhz, plan->rffc507x, &RFFC5071_freq_hz_actual);
+        max2830_freq = (double)(freq - RFFC5071_freq_hz_actual);
+        fobos_max2830_divider(max2830_freq, plan->max2830, &max2830_freq_actual);
+        plan->frequency = max2830_freq_actual + RFFC5071_freq_hz_actual;
+        return 0;
     }
-    return result;
+    return -5;
 }
 //==============================================================================
-int fobos_rx_set_direct_sampling(struct fobos_dev_t * dev, unsigned int enabled)
+// the cached plan of value, made on a miss, NULL out of range
+static const struct fobos_rx_plan * fobos_rx_plan_get(struct fobos_dev_t * dev, double value)
 {
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%d);\n", __FUNCTION__, enabled);
-#endif // FOBOS_PRINT_DEBUG
-    int result = fobos_check(dev);
-    if (result != 0)
+    uint64_t key = (uint64_t)value * 0x9E3779B97F4A7C15ULL;
+    struct fobos_rx_plan * plan = &dev->rx_plans[(key >> 32) & (FOBOS_RX_PLANS - 1)];
+    if ((plan->band != 0) && (plan->value == value))
     {
-        return result;
+        return plan;
     }
-    result = 0;
-    if (dev->rx_direct_sampling != enabled)
+    if (fobos_rx_plan_make(dev, value, plan) != 0)
     {
-        if (enabled)
+        return NULL;
+    }
+    return plan;
+}
+//==============================================================================
+// only what differs from the state the device is in goes over usb: the gpo,
+// the clocks on a band change, the rffc507x pll, the max2830 divider
+static void fobos_rx_plan_apply(struct fobos_dev_t * dev, const struct fobos_rx_plan * plan)
+{
+    int band_change = (dev->rx_frequency_band != plan->band);
+    if (band_change || (plan->band == 3))
+    {
+        uint16_t gpo = (dev->dev_gpo & ~plan->gpo_mask) | plan->gpo;
+        if (gpo != dev->dev_gpo)
         {
-            bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
-            bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            bitclear(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
+            dev->dev_gpo = gpo;
+            // commit dev_gpo value
             fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-            // disable clocks
-            fobos_rffc507x_clock(dev, 0);
-            fobos_max2830_clock(dev, 0);
+        }
+    }
+    if (band_change)
+    {
+        dev->rx_frequency_band = plan->band;
+        if (plan->band == 2)
+        {
             // disable rffc507x
             fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 0); // enbl = 0
             fobos_rffc507x_commit(dev, 0);
+            // disable rffc507x clock
+            fobos_rffc507x_clock(dev, 0);
         }
         else
         {
-            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A0);
-            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            if (dev->rx_lpf_idx > 2)
-            {
-                dev->rx_lpf_idx = 2;
-            }
-            if (dev->rx_lpf_idx & 1)
-            {
-                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            }
-            if (dev->rx_lpf_idx & 2)
-            {
-                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
-            }
-            bitset(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
-            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-            // enable clocks
+            // enable rffc507x clock
             fobos_rffc507x_clock(dev, 1);
-            fobos_max2830_clock(dev, 1);
-            // enable rffc507x
-            fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 1); // enbl = 1
-            fobos_rffc507x_commit(dev, 0);
         }
-        dev->rx_direct_sampling = enabled;
     }
-    return result;
+    dev->rx_swap_iq = plan->swap_iq;
+    if (plan->band != 2)
+    {
+        fobos_rffc507x_set_pll(dev, plan->rffc507x);
+    }
+    fobos_max2830_set_divider(dev, plan->max2830);
 }
 //==============================================================================
-int fobos_rx_set_lna_gain(struct fobos_dev_t * dev, unsigned int value)
+// tunes the analog lo, the mixer is left as is
+static int fobos_rx_set_lo(struct fobos_dev_t * dev, double value, double * actual)
 {
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%d)\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG
     int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%f);\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG    
     if (result != 0)
     {
         return result;
     }
     result = 0;
-    if (value > 3) value = 3;
-    if (value != dev->rx_lna_gain)
+    if ((dev->rx_frequency != value) || dev->rx_lo_stale)
     {
-        dev->rx_lna_gain = value;
-        int lna_gain = dev->rx_lna_gain & 0x0003;
-        int vga_gain = dev->rx_vga_gain & 0x001F;
-        fobos_max2830_write_reg(dev, 11, (lna_gain << 5) | vga_gain);
+        dev->rx_lo_stale = 0;
+        dev->rx_estimator_retune = 1;
+        const struct fobos_rx_plan * plan = fobos_rx_plan_get(dev, value);
+        if (!plan)
+        {
+            return -5;
+        }
+        uint64_t t0 = fobos_time_us();
+        fobos_rx_plan_apply(dev, plan);
+        fobos_hist_add(&dev->rx_stats.retune_time, fobos_time_us() - t0);
+        dev->rx_frequency = plan->frequency;
+        if (actual)
+        {
+            *actual = plan->frequency;
+        }
     }
     return result;
 }
 //==============================================================================
-int fobos_rx_set_vga_gain(struct fobos_dev_t * dev, unsigned int value)
+// the mixer shifts offset Hz to 0 from the next sample the device sends on,
+// returns the offset it really shifts
+static double fobos_rx_set_nco(struct fobos_dev_t * dev, double offset)
 {
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%d)\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG
-    int result = fobos_check(dev);
-    if (result != 0)
+    uint32_t seq = dev->rx_nco_seq;
+    const struct fobos_rx_nco * current = &dev->rx_nco[seq % 3];
+    struct fobos_rx_nco * next = &dev->rx_nco[(seq + 1) % 3];
+    uint64_t sample = dev->rx_sample_counter;
+    // phase continuous: the new oscillator starts where the old one is
+    next->phase = current->phase + current->nco.step * (uint32_t)(sample - current->sample);
+    next->sample = sample;
+    fobos_nco_make(&next->nco, -offset / dev->rx_samplerate);
+    fobos_barrier();
+    dev->rx_nco_seq = seq + 1;
+    dev->rx_nco_offset = offset;
+    return -(double)(int32_t)next->nco.step * dev->rx_samplerate / 4294967296.0;
+}
+//==============================================================================
+// the lo to value - rx_if_offset unless digital, the mixer the rest of the way
+static int fobos_rx_tune(struct fobos_dev_t * dev, double value, int digital, double * actual)
+{
+    double lo = dev->rx_frequency;
+    if (!digital)
     {
-        return result;
+        int result = fobos_rx_set_lo(dev, value - dev->rx_if_offset, &lo);
+        if (result != 0)
+        {
+            return result;
+        }
+        lo = dev->rx_frequency;
     }
-    result = 0;
-    if (value > 15) value = 15;
-    if (value != dev->rx_vga_gain)
+    dev->rx_center = value;
+    double offset = 0.0;
+    if (dev->rx_auto_if || (dev->rx_if_offset != 0.0))
     {
-        dev->rx_vga_gain = value;
-        int lna_gain = dev->rx_lna_gain & 0x0003;
-        int vga_gain = dev->rx_vga_gain & 0x001F;
-        fobos_max2830_write_reg(dev, 11, (lna_gain << 5) | vga_gain);
+        offset = fobos_rx_set_nco(dev, value - lo);
     }
-    return result;
+    else if (dev->rx_nco_offset != 0.0)
+    {
+        fobos_rx_set_nco(dev, 0.0);
+    }
+    dev->rx_center_actual = lo + offset;
+    if (actual)
+    {
+        *actual = lo + offset;
+    }
+    return 0;
 }
 //==============================================================================
-const double fobos_sample_rates[] =
+// how far the mixer alone may move the center: the decimated band stays inside
+// the pass band of the decimation filters at the input rate
+static double fobos_rx_nco_span(struct fobos_dev_t * dev)
 {
-    80000000.0,
-    50000000.0,
-    40000000.0,
-    32000000.0,
-    25000000.0,
-    20000000.0,
-    16000000.0,
-    12500000.0,
-    10000000.0,
-    8000000.0,
-    6400000.0,
-    6250000.0,
-    5000000.0,
-    4000000.0
-};
+    return FOBOS_DECIM_PASS * dev->rx_samplerate * (1.0 - 1.0 / dev->rx_decimation);
+}
 //==============================================================================
-int fobos_rx_get_samplerates(struct fobos_dev_t * dev, double * values, unsigned int * count)
+int fobos_rx_set_frequency(struct fobos_dev_t * dev, double value, double * actual)
 {
     int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%f);\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
     if (result != 0)
     {
         return result;
     }
-    result = 0;
-    if (count)
+    // within the span no usb traffic at all: no pll relock, no dc step
+    int digital = dev->rx_auto_if && (dev->rx_frequency != 0.0) &&
+        (fabs(value - dev->rx_frequency) <= fobos_rx_nco_span(dev));
+    return fobos_rx_tune(dev, value, digital, actual);
+}
+//==============================================================================
+int fobos_rx_prepare_frequencies(struct fobos_dev_t * dev, const double * values, uint32_t count)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
     {
-        *count = sizeof(fobos_sample_rates) / sizeof(fobos_sample_rates[0]);
-        if (values)
+        return result;
+    }
+    if (!values && (count > 0))
+    {
+        return -7;
+    }
+    // the event thread may be tuning
+    fobos_mutex_lock(&dev->rx_config_lock);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // the lo fobos_rx_tune() goes to
+        if (!fobos_rx_plan_get(dev, values[i] - dev->rx_if_offset))
         {
-            memcpy(values, fobos_sample_rates, sizeof(fobos_sample_rates));
+            result = -5;
         }
     }
+    fobos_mutex_unlock(&dev->rx_config_lock);
     return result;
 }
 //==============================================================================
-const uint32_t fobos_p1s[] =
+// the lo range of fobos_rx_plan_make()
+static int fobos_rx_lo_supported(double value)
 {
-    10, 16, 20, 25, 32, 40, 50, 64, 80, 100, 125, 128, 160, 200
-};
+    return (value >= 0.0) && ((uint64_t)value / 1000000 <= FOBOS_MAX_HP_FREQ_MHZ);
+}
 //==============================================================================
-int fobos_rx_set_samplerate(struct fobos_dev_t * dev, double value, double * actual)
+static int fobos_rx_clock_source(struct fobos_dev_t * dev)
 {
-    int result = fobos_check(dev);
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%f)\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG
-    if (result != 0)
+    return ((dev->dev_gpo >> FOBOS_DEV_CLKSEL) & 1) ? 0 : 1;
+}
+//==============================================================================
+// the fields of config that differ from the current ones, in this order: clock source, direct
+// sampling, auto if, if offset, frequency, gains; the caller holds rx_config_lock
+static void fobos_rx_config_run(struct fobos_dev_t * dev, const struct fobos_rx_config * config)
+{
+    int result = 0;
+    dev->rx_batch = 1;
+    if (config->clock_source != fobos_rx_clock_source(dev))
     {
-        return result;
+        result = fobos_rx_set_clk_source(dev, config->clock_source);
     }
-    result = 0;
-    uint32_t p1 = 0;
-    size_t count = sizeof(fobos_sample_rates) / sizeof(fobos_sample_rates[0]);
-    double df_min = fobos_sample_rates[0];
-    size_t i_min = 0;
-    for (size_t i = 0; i < count; i++)
+    if ((result == 0) && (config->direct_sampling != dev->rx_direct_sampling))
     {
-        double df = fabs(value - fobos_sample_rates[i]);
-        if (df < df_min)
-        {
-            df_min = df;
-            i_min = i;
-        }
+        result = fobos_rx_set_direct_sampling(dev, config->direct_sampling);
     }
-    p1 = fobos_p1s[i_min] * 128 - 512;
-    fobos_si5351c_config_msynth(dev, 2, p1, 0, 1, 0);
-    fobos_si5351c_config_msynth(dev, 3, p1, 0, 1, 0);
-    value = fobos_sample_rates[i_min];
     if (result == 0)
     {
-        int rx_lpf_idx = dev->rx_lpf_idx;
-        if (value < 13000000.0)
-        {
-            rx_lpf_idx = 0;
-        }
-        else if (value < 26000000.0)
-        {
-            rx_lpf_idx = 1;
-        }
-        else
-        {
-            rx_lpf_idx = 2;
-        }
-        if (!dev->rx_direct_sampling)
-        {
-            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A0);
-            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            if (rx_lpf_idx & 1)
-            {
-                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            }
-            if (rx_lpf_idx & 2)
-            {
-                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
-            }
-            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-        }
-        dev->rx_lpf_idx = rx_lpf_idx;
-        int rx_bw_idx = dev->rx_bw_idx;
-        if (value < 15000000.0)
-        {
-            rx_bw_idx = 0;
-        }
-        else if (value < 17000000.0)
+        dev->rx_auto_if = config->auto_if != 0;
+    }
+    if ((result == 0) && (config->if_offset != dev->rx_if_offset))
+    {
+        // the lo moves, the center stays
+        result = fobos_rx_set_if_offset(dev, config->if_offset);
+    }
+    if ((result == 0) && (config->frequency != dev->rx_center))
+    {
+        result = fobos_rx_set_frequency(dev, config->frequency, 0);
+    }
+    if (result == 0)
+    {
+        // both gains are in one register
+        dev->rx_lna_gain = config->lna_gain > 3 ? 3 : config->lna_gain;
+        dev->rx_vga_gain = config->vga_gain > 15 ? 15 : config->vga_gain;
+        fobos_max2830_update_reg(dev, 11, ((dev->rx_lna_gain & 0x0003) << 5) | (dev->rx_vga_gain & 0x001F));
+    }
+    dev->rx_batch = 0;
+    if (dev->rx_batch_gpo)
+    {
+        dev->rx_batch_gpo = 0;
+        fobos_rx_set_dev_gpo(dev, dev->rx_batch_gpo_value);
+    }
+    dev->rx_config_batches++;
+    dev->rx_config_result = result;
+}
+//==============================================================================
+// the batch waiting for the event thread, if any
+static void fobos_rx_config_flush(struct fobos_dev_t * dev)
+{
+    fobos_mutex_lock(&dev->rx_config_lock);
+    if (dev->rx_config_pending)
+    {
+        dev->rx_config_pending = 0;
+        fobos_rx_config_run(dev, &dev->rx_config);
+    }
+    fobos_mutex_unlock(&dev->rx_config_lock);
+}
+//==============================================================================
+// from the first hop on at the next stream start or right away
+static void fobos_rx_hops_restart(struct fobos_dev_t * dev)
+{
+    dev->rx_hop = dev->rx_hops_count - 1;
+    dev->rx_hop_next = dev->rx_sample_counter;
+}
+//==============================================================================
+// the next hop of the schedule: the event thread between two transfers, when the sample
+// counter reached rx_hop_next
+static void fobos_rx_hop(struct fobos_dev_t * dev)
+{
+    fobos_mutex_lock(&dev->rx_config_lock);
+    if (dev->rx_hops_count > 0)
+    {
+        uint32_t hop = (dev->rx_hop + 1) % dev->rx_hops_count;
+        const struct fobos_rx_hop * next = &dev->rx_hops[hop];
+        struct fobos_rx_hop_event * event = &dev->rx_hop_events[dev->rx_hop_events_count % FOBOS_RX_HOP_EVENTS];
+        double lo = dev->rx_frequency;
+        event->hop = hop;
+        event->settle_sample = dev->rx_sample_counter;
+        event->result = fobos_rx_set_frequency(dev, next->frequency, &event->frequency);
+        event->dwell_sample = event->settle_sample;
+        if (dev->rx_frequency != lo)
         {
-            rx_bw_idx = 1;
+            // the device fills the transfer in flight while the lo moves, the pll locks after that
+            event->dwell_sample += dev->transfer_buf_size / 4 + next->settle;
         }
-        else if (value < 30000000.0)
+        if (event->result != 0)
         {
-            rx_bw_idx = 2;
+            event->frequency = dev->rx_center_actual;
         }
-        else
+        dev->rx_hop = hop;
+        dev->rx_hop_next = event->dwell_sample + next->dwell;
+        fobos_barrier();
+        dev->rx_hop_events_count++;
+    }
+    fobos_mutex_unlock(&dev->rx_config_lock);
+}
+//==============================================================================
+int fobos_rx_set_hops(struct fobos_dev_t * dev, const struct fobos_rx_hop * hops, uint32_t count)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, count);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if ((!hops && (count > 0)) || (count > FOBOS_RX_MAX_HOPS))
+    {
+        return -7;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (hops[i].dwell == 0)
         {
-            rx_bw_idx = 3;
+            return -7;
         }
-        if (dev->rx_bw_idx != rx_bw_idx)
+    }
+    struct fobos_rx_hop * copy = NULL;
+    if (count > 0)
+    {
+        copy = (struct fobos_rx_hop *)malloc(count * sizeof(struct fobos_rx_hop));
+        if (!copy)
         {
-            dev->rx_bw_idx = rx_bw_idx;
-            fobos_max2830_write_reg(dev, 8, rx_bw_idx | 0x3420);
+            return -ENOMEM;
         }
-#ifdef FOBOS_PRINT_DEBUG
-        printf_internal("lpf_idx =  %i bw_idx = %i\n", rx_lpf_idx, rx_bw_idx);
-#endif // FOBOS_PRINT_DEBUG
-        dev->rx_samplerate = value;
-        if (actual)
+        memcpy(copy, hops, count * sizeof(struct fobos_rx_hop));
+    }
+    fobos_mutex_lock(&dev->rx_config_lock);
+    for (uint32_t i = 0; (i < count) && (result == 0); i++)
+    {
+        // the plans of the lo as well, a hop only writes registers
+        if (!fobos_rx_plan_get(dev, copy[i].frequency - dev->rx_if_offset))
         {
-            *actual = dev->rx_samplerate;
+            result = -5;
         }
     }
-    return result;
+    if (result == 0)
+    {
+        free(dev->rx_hops);
+        dev->rx_hops = copy;
+        dev->rx_hops_count = count;
+        fobos_rx_hops_restart(dev);
+        copy = NULL;
+    }
+    fobos_mutex_unlock(&dev->rx_config_lock);
+    free(copy);
+    return result;
+}
+//==============================================================================
+int fobos_rx_read_hop_events(struct fobos_dev_t * dev, uint32_t * seq, struct fobos_rx_hop_event * events, uint32_t max)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!seq || (!events && (max > 0)))
+    {
+        return -7;
+    }
+    uint32_t published = dev->rx_hop_events_count;
+    if (*seq == published)
+    {
+        return 0;
+    }
+    fobos_mutex_lock(&dev->rx_config_lock);
+    published = dev->rx_hop_events_count;
+    if (published - *seq > FOBOS_RX_HOP_EVENTS)
+    {
+        // the older ones are overwritten already
+        *seq = published - FOBOS_RX_HOP_EVENTS;
+    }
+    uint32_t count = 0;
+    while ((*seq != published) && (count < max))
+    {
+        events[count++] = dev->rx_hop_events[*seq % FOBOS_RX_HOP_EVENTS];
+        (*seq)++;
+    }
+    fobos_mutex_unlock(&dev->rx_config_lock);
+    return (int)count;
+}
+//==============================================================================
+int fobos_rx_get_config(struct fobos_dev_t * dev, struct fobos_rx_config * config)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!config)
+    {
+        return -7;
+    }
+    fobos_mutex_lock(&dev->rx_config_lock);
+    if (dev->rx_config_pending)
+    {
+        *config = dev->rx_config;
+    }
+    else
+    {
+        config->frequency = dev->rx_center;
+        config->lna_gain = dev->rx_lna_gain;
+        config->vga_gain = dev->rx_vga_gain;
+        config->direct_sampling = dev->rx_direct_sampling;
+        config->clock_source = fobos_rx_clock_source(dev);
+        config->if_offset = dev->rx_if_offset;
+        config->auto_if = dev->rx_auto_if;
+    }
+    config->actual_frequency = dev->rx_center_actual;
+    config->batches = dev->rx_config_batches;
+    config->result = dev->rx_config_result;
+    config->pending = dev->rx_config_pending;
+    fobos_mutex_unlock(&dev->rx_config_lock);
+    return 0;
+}
+//==============================================================================
+int fobos_rx_apply_config(struct fobos_dev_t * dev, const struct fobos_rx_config * config)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s()\n", __FUNCTION__);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!config || (config->direct_sampling & ~1) || (config->clock_source & ~1) || (config->auto_if & ~1))
+    {
+        return -7;
+    }
+    fobos_mutex_lock(&dev->rx_config_lock);
+    if (!(fabs(config->if_offset) < dev->rx_samplerate / 2.0))
+    {
+        result = -7;
+    }
+    else if (((config->frequency != dev->rx_center) || (config->if_offset != dev->rx_if_offset)) &&
+             !fobos_rx_lo_supported(config->frequency - config->if_offset))
+    {
+        result = -5;
+    }
+    else if (FOBOS_IDDLE == dev->rx_async_status)
+    {
+        dev->rx_config_pending = 0;
+        fobos_rx_config_run(dev, config);
+        result = dev->rx_config_result;
+    }
+    else
+    {
+        // a batch not run yet is replaced, config has all of its fields
+        dev->rx_config = *config;
+        dev->rx_config_pending = 1;
+    }
+    fobos_mutex_unlock(&dev->rx_config_lock);
+    return result;
+}
+//==============================================================================
+int fobos_rx_set_if_offset(struct fobos_dev_t * dev, double value)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%f);\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!(fabs(value) < dev->rx_samplerate / 2.0))
+    {
+        return -7;
+    }
+    if (value == dev->rx_if_offset)
+    {
+        return 0;
+    }
+    dev->rx_if_offset = value;
+    if (dev->rx_center == 0.0)
+    {
+        return 0;
+    }
+    // the lo moves, the center stays
+    return fobos_rx_tune(dev, dev->rx_center, 0, 0);
+}
+//==============================================================================
+int fobos_rx_set_auto_if(struct fobos_dev_t * dev, int enabled)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d);\n", __FUNCTION__, enabled);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    dev->rx_auto_if = enabled != 0;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_direct_sampling(struct fobos_dev_t * dev, unsigned int enabled)
+{
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d);\n", __FUNCTION__, enabled);
+#endif // FOBOS_PRINT_DEBUG
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    result = 0;
+    if (dev->rx_direct_sampling != enabled)
+    {
+        if (enabled)
+        {
+            bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            bitclear(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
+            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+            // disable clocks
+            fobos_rffc507x_clock(dev, 0);
+            fobos_max2830_clock(dev, 0);
+            // disable rffc507x
+            fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 0); // enbl = 0
+            fobos_rffc507x_commit(dev, 0);
+        }
+        else
+        {
+            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            if (dev->rx_lpf_idx > 2)
+            {
+                dev->rx_lpf_idx = 2;
+            }
+            if (dev->rx_lpf_idx & 1)
+            {
+                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            }
+            if (dev->rx_lpf_idx & 2)
+            {
+                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            }
+            bitset(dev->dev_gpo, FOBOS_DEV_NENBL_HF);
+            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+            // enable clocks
+            fobos_rffc507x_clock(dev, 1);
+            fobos_max2830_clock(dev, 1);
+            // enable rffc507x
+            fobos_rffc507x_register_modify(&dev->rffc507x_registers_local[0x15], 14, 14, 1); // enbl = 1
+            fobos_rffc507x_commit(dev, 0);
+        }
+        dev->rx_direct_sampling = enabled;
+    }
+    return result;
+}
+//==============================================================================
+int fobos_rx_set_lna_gain(struct fobos_dev_t * dev, unsigned int value)
+{
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    result = 0;
+    if (value > 3) value = 3;
+    if (value != dev->rx_lna_gain)
+    {
+        dev->rx_lna_gain = value;
+        int lna_gain = dev->rx_lna_gain & 0x0003;
+        int vga_gain = dev->rx_vga_gain & 0x001F;
+        fobos_max2830_write_reg(dev, 11, (lna_gain << 5) | vga_gain);
+    }
+    return result;
+}
+//==============================================================================
+int fobos_rx_set_vga_gain(struct fobos_dev_t * dev, unsigned int value)
+{
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    result = 0;
+    if (value > 15) value = 15;
+    if (value != dev->rx_vga_gain)
+    {
+        dev->rx_vga_gain = value;
+        int lna_gain = dev->rx_lna_gain & 0x0003;
+        int vga_gain = dev->rx_vga_gain & 0x001F;
+        fobos_max2830_write_reg(dev, 11, (lna_gain << 5) | vga_gain);
+    }
+    return result;
+}
+//==============================================================================
+const double fobos_sample_rates[] =
+{
+    80000000.0,
+    50000000.0,
+    40000000.0,
+    32000000.0,
+    25000000.0,
+    20000000.0,
+    16000000.0,
+    12500000.0,
+    10000000.0,
+    8000000.0,
+    6400000.0,
+    6250000.0,
+    5000000.0,
+    4000000.0
+};
+//==============================================================================
+int fobos_rx_get_samplerates(struct fobos_dev_t * dev, double * values, unsigned int * count)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    result = 0;
+    if (count)
+    {
+        *count = sizeof(fobos_sample_rates) / sizeof(fobos_sample_rates[0]);
+        if (values)
+        {
+            memcpy(values, fobos_sample_rates, sizeof(fobos_sample_rates));
+        }
+    }
+    return result;
+}
+//==============================================================================
+const uint32_t fobos_p1s[] =
+{
+    10, 16, 20, 25, 32, 40, 50, 64, 80, 100, 125, 128, 160, 200
+};
+//==============================================================================
+int fobos_rx_set_samplerate(struct fobos_dev_t * dev, double value, double * actual)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%f)\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    result = 0;
+    uint32_t p1 = 0;
+    size_t count = sizeof(fobos_sample_rates) / sizeof(fobos_sample_rates[0]);
+    double df_min = fobos_sample_rates[0];
+    size_t i_min = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        double df = fabs(value - fobos_sample_rates[i]);
+        if (df < df_min)
+        {
+            df_min = df;
+            i_min = i;
+        }
+    }
+    p1 = fobos_p1s[i_min] * 128 - 512;
+    // the event thread may be running a batch or a hop, both write dev_gpo as well
+    fobos_mutex_lock(&dev->rx_config_lock);
+    fobos_si5351c_config_msynth(dev, 2, p1, 0, 1, 0);
+    fobos_si5351c_config_msynth(dev, 3, p1, 0, 1, 0);
+    value = fobos_sample_rates[i_min];
+    if (result == 0)
+    {
+        int rx_lpf_idx = dev->rx_lpf_idx;
+        if (value < 13000000.0)
+        {
+            rx_lpf_idx = 0;
+        }
+        else if (value < 26000000.0)
+        {
+            rx_lpf_idx = 1;
+        }
+        else
+        {
+            rx_lpf_idx = 2;
+        }
+        if (!dev->rx_direct_sampling)
+        {
+            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            if (rx_lpf_idx & 1)
+            {
+                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            }
+            if (rx_lpf_idx & 2)
+            {
+                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            }
+            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+        }
+        dev->rx_lpf_idx = rx_lpf_idx;
+        int rx_bw_idx = dev->rx_bw_idx;
+        if (value < 15000000.0)
+        {
+            rx_bw_idx = 0;
+        }
+        else if (value < 17000000.0)
+        {
+            rx_bw_idx = 1;
+        }
+        else if (value < 30000000.0)
+        {
+            rx_bw_idx = 2;
+        }
+        else
+        {
+            rx_bw_idx = 3;
+        }
+        if (dev->rx_bw_idx != rx_bw_idx)
+        {
+            dev->rx_bw_idx = rx_bw_idx;
+            fobos_max2830_write_reg(dev, 8, rx_bw_idx | 0x3420);
+        }
+#ifdef FOBOS_PRINT_DEBUG
+        printf_internal("lpf_idx =  %i bw_idx = %i\n", rx_lpf_idx, rx_bw_idx);
+#endif // FOBOS_PRINT_DEBUG
+        dev->rx_samplerate = value;
+        if (dev->rx_nco_offset != 0.0)
+        {
+            fobos_rx_set_nco(dev, dev->rx_nco_offset);
+        }
+        if (actual)
+        {
+            *actual = dev->rx_samplerate;
+        }
+    }
+    fobos_mutex_unlock(&dev->rx_config_lock);
+    return result;
+}
+//==============================================================================
+int fobos_rx_set_lpf(struct fobos_dev_t * dev, int value)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (value < 0) value = 0;
+    if (value > 2) value = 2;
+    if (dev->rx_lpf_idx != value)
+    {
+        if (!dev->rx_direct_sampling)
+        {
+            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            if (value & 1)
+            {
+                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
+            }
+            if (value & 2)
+            {
+                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+            }
+            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+        }
+        dev->rx_lpf_idx = value;
+    }
+    return result;
+}
+//==============================================================================
+int fobos_rx_set_clk_source(struct fobos_dev_t * dev, int value)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, value);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (value)
+    {
+        bitclear(dev->dev_gpo, FOBOS_DEV_CLKSEL);
+    }
+    else
+    {
+        bitset(dev->dev_gpo, FOBOS_DEV_CLKSEL);
+    }
+    result = fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+    return result;
+}
+//==============================================================================
+unsigned int fobos_rx_sample_size(int format)
+{
+    switch (format)
+    {
+        case FOBOS_FORMAT_FC32: return 2 * sizeof(float);
+        case FOBOS_FORMAT_SC16: return 2 * sizeof(int16_t);
+        case FOBOS_FORMAT_SC8:  return 2 * sizeof(int8_t);
+        case FOBOS_FORMAT_FC16: return 2 * sizeof(uint16_t);
+        case FOBOS_FORMAT_RAW:  return 2 * sizeof(int16_t);
+        default:                return 0;
+    }
+}
+//==============================================================================
+// monotonic time, us
+uint64_t fobos_time_us(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000ull + (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000ull / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+#endif
+}
+//==============================================================================
+void fobos_hist_add(struct fobos_hist * hist, uint64_t value_us)
+{
+    unsigned int bin = 0;
+    while ((value_us >> bin) && (bin < FOBOS_HIST_BINS - 1))
+    {
+        bin++;
+    }
+    hist->bins[bin]++;
+    hist->count++;
+    hist->sum_us += value_us;
+    if (value_us > hist->max_us)
+    {
+        hist->max_us = value_us;
+    }
+}
+//==============================================================================
+int fobos_rx_get_stats(struct fobos_dev_t * dev, struct fobos_rx_stats * stats)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!stats)
+    {
+        return -7;
+    }
+    memcpy(stats, &dev->rx_stats, sizeof(*stats));
+    return 0;
+}
+//==============================================================================
+int fobos_rx_get_sample_index(struct fobos_dev_t * dev, uint64_t * index)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!index)
+    {
+        return -7;
+    }
+    *index = dev->rx_cb_sample;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_reset_stats(struct fobos_dev_t * dev)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    memset(&dev->rx_stats, 0, sizeof(dev->rx_stats));
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_sample_format(struct fobos_dev_t * dev, int format)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, format);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (fobos_rx_sample_size(format) == 0)
+    {
+        return -7;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    dev->rx_format = format;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_workers(struct fobos_dev_t * dev, uint32_t count)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, count);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (count > FOBOS_MAX_WORKERS)
+    {
+        return -7;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    dev->rx_workers = count;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_decimation(struct fobos_dev_t * dev, uint32_t decimation)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, decimation);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!fobos_decim_supported(decimation) || ((decimation > 1) && dev->rx_pfb))
+    {
+        return -7;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    struct fobos_decim * decim = NULL;
+    if (decimation > 1)
+    {
+        decim = fobos_decim_create(decimation, dev->rx_convert);
+        if (!decim)
+        {
+            return -ENOMEM;
+        }
+    }
+    fobos_decim_destroy(dev->rx_decim);
+    dev->rx_decim = decim;
+    dev->rx_decimation = decimation;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_channels(struct fobos_dev_t * dev, uint32_t channels, int oversample)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d, %d)\n", __FUNCTION__, channels, oversample);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (((channels != 1) && !fobos_pfb_supported(channels)) || ((channels > 1) && dev->rx_decim))
+    {
+        return -7;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    struct fobos_pfb * pfb = NULL;
+    if (channels > 1)
+    {
+        pfb = fobos_pfb_create(channels, oversample, dev->rx_convert);
+        if (!pfb)
+        {
+            return -ENOMEM;
+        }
+    }
+    fobos_pfb_destroy(dev->rx_pfb);
+    dev->rx_pfb = pfb;
+    dev->rx_channels = channels;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_psd(struct fobos_dev_t * dev, uint32_t size, int window, uint32_t overlap, uint32_t averages)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d, %d, %d, %d)\n", __FUNCTION__, size, window, overlap, averages);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if ((size != 0) && ((size < 16) || !fobos_fft_supported(size) || (window < 0) || (window >= FOBOS_WINDOW_COUNT) ||
+        (overlap >= size) || (averages == 0)))
+    {
+        return -7;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    struct fobos_psd * psd = NULL;
+    float * block = NULL;
+    if (size > 0)
+    {
+        psd = fobos_psd_create(size, window, dev->rx_convert);
+        block = (float *)malloc(2 * size * sizeof(float));
+        if (!psd || !block)
+        {
+            fobos_psd_destroy(psd);
+            free(block);
+            return -ENOMEM;
+        }
+    }
+    fobos_psd_destroy(dev->rx_psd);
+    free(dev->rx_psd_block);
+    dev->rx_psd = psd;
+    dev->rx_psd_block = block;
+    dev->rx_psd_len = 0;
+    dev->rx_psd_hop = size - overlap;
+    dev->rx_psd_averages = averages;
+    dev->rx_psd_next = 0;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_get_iq_correction(struct fobos_dev_t * dev, struct fobos_iq_correction * correction)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (correction == NULL)
+    {
+        return -7;
+    }
+    // seqlock read, retried if the writer published meanwhile: the next publish overwrites
+    // the slot read before it moves the counter on
+    for (;;)
+    {
+        uint32_t seq = dev->rx_correction_seq;
+        fobos_barrier();
+        *correction = dev->rx_correction[seq & 1];
+        fobos_barrier();
+        if (dev->rx_correction_seq == seq)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+//==============================================================================
+// the seqlock write, rx_estimator_lock held
+static void fobos_rx_publish_iq_correction(struct fobos_dev_t * dev, const struct fobos_iq_correction * correction)
+{
+    uint32_t seq = dev->rx_correction_seq;
+    dev->rx_correction[(seq + 1) & 1] = *correction;
+    fobos_barrier();
+    dev->rx_correction_seq = seq + 1;
+}
+//==============================================================================
+int fobos_rx_set_iq_correction(struct fobos_dev_t * dev, const struct fobos_iq_correction * correction)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (correction == NULL)
+    {
+        return -7;
+    }
+    fobos_mutex_lock(&dev->rx_estimator_lock);
+    fobos_rx_publish_iq_correction(dev, correction);
+    fobos_mutex_unlock(&dev->rx_estimator_lock);
+    return 0;
+}
+//==============================================================================
+// fobos_rx_update_iq_estimate() with rx_estimator_lock held
+static void fobos_rx_iq_estimate(struct fobos_dev_t * dev, const void * raw, uint32_t count)
+{
+    struct fobos_convert_sums sums;
+    memset(&sums, 0, sizeof(sums));
+    dev->rx_convert->sums((const int16_t *)raw, count, &sums);
+    if (dev->rx_estimator_retune)
+    {
+        dev->rx_estimator_retune = 0;
+        fobos_iq_estimator_retune(&dev->rx_estimator);
+    }
+    fobos_iq_estimator_update(&dev->rx_estimator, &sums);
+    struct fobos_iq_correction correction;
+    if (fobos_iq_estimator_get(&dev->rx_estimator, &correction) == 0)
+    {
+        fobos_rx_publish_iq_correction(dev, &correction);
+    }
+}
+//==============================================================================
+int fobos_rx_update_iq_estimate(struct fobos_dev_t * dev, const void * raw, uint32_t count)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    // the calibration on the event thread and a FOBOS_FORMAT_RAW consumer may both feed it
+    // around a stream restart
+    fobos_mutex_lock(&dev->rx_estimator_lock);
+    fobos_rx_iq_estimate(dev, raw, count);
+    fobos_mutex_unlock(&dev->rx_estimator_lock);
+    return 0;
+}
+//==============================================================================
+#define FOBOS_SWAP_IQ_HW 1
+// output units of format per raw lsb
+static float fobos_rx_format_scale(struct fobos_dev_t * dev, int format)
+{
+    if (format == FOBOS_FORMAT_SC16)
+    {
+        return 1.0f;
+    }
+    if (format == FOBOS_FORMAT_SC8)
+    {
+        return 1.0f / 64.0f;
+    }
+    return dev->rx_direct_sampling ? 1.0f / 32786.0f : dev->rx_scale_re;
+}
+//==============================================================================
+// the kernel parameters of scale from the current iq correction
+static void fobos_rx_convert_params(struct fobos_dev_t * dev, float scale, struct fobos_convert_params * params)
+{
+    struct fobos_iq_correction correction;
+    fobos_rx_get_iq_correction(dev, &correction);
+    if (dev->rx_direct_sampling)
+    {
+        // two independent inputs, not an iq pair
+        correction.gain = 1.0f;
+        correction.phase = 0.0f;
+    }
+    fobos_convert_params_make(params, &correction, scale, dev->rx_swap_iq ^ FOBOS_SWAP_IQ_HW);
+}
+//==============================================================================
+#define FOBOS_NCO_CHUNK 1024    // complex samples mixed at a time
+// the current and the previous oscillator, the writer fills the third slot and reuses
+// the previous one only after publishing, so any change means retry; returns 1 if the
+// samples from stream sample index sample on go through the mixer
+static int fobos_rx_get_nco(struct fobos_dev_t * dev, struct fobos_rx_nco nco[2], uint64_t sample)
+{
+    for (;;)
+    {
+        uint32_t seq = dev->rx_nco_seq;
+        fobos_barrier();
+        nco[0] = dev->rx_nco[seq % 3];
+        nco[1] = dev->rx_nco[(seq + 2) % 3];
+        fobos_barrier();
+        if (dev->rx_nco_seq == seq)
+        {
+            break;
+        }
+    }
+    return nco[0].nco.step || (nco[1].nco.step && (sample < nco[0].sample));
+}
+//==============================================================================
+// the oscillator of stream sample s, n cut to the samples it is for
+static const struct fobos_rx_nco * fobos_rx_nco_at(const struct fobos_rx_nco nco[2], uint64_t s, uint32_t * n)
+{
+    // nco[0] is the current one, nco[1] the one before for the samples it was not yet for
+    if (s >= nco[0].sample)
+    {
+        return &nco[0];
+    }
+    if (nco[0].sample - s < *n)
+    {
+        *n = (uint32_t)(nco[0].sample - s);
+    }
+    return &nco[1];
+}
+//==============================================================================
+// the mixer on count raw samples from stream sample index sample on: the corrected samples
+// as float, rotated, then stored in format or, with decimation, fed to the filters
+static int fobos_rx_mix(struct fobos_dev_t * dev, const struct fobos_rx_nco nco[2], const struct fobos_convert_params * params, const int16_t * raw, void * dst, uint32_t count, int format, uint64_t sample)
+{
+    float scratch[2 * FOBOS_NCO_CHUNK];
+    int16_t mixed[2 * FOBOS_NCO_CHUNK];
+    uint8_t * out = (uint8_t *)dst;
+    size_t sample_size = fobos_rx_sample_size(format);
+    float scale = fobos_rx_format_scale(dev, format);
+    size_t produced = 0;
+    uint32_t done = 0;
+    while (done < count)
+    {
+        uint64_t s = sample + done;
+        uint32_t n = count - done;
+        if (n > FOBOS_NCO_CHUNK)
+        {
+            n = FOBOS_NCO_CHUNK;
+        }
+        const struct fobos_rx_nco * e = fobos_rx_nco_at(nco, s, &n);
+        uint32_t phase = e->phase + e->nco.step * (uint32_t)(s - e->sample);
+        float * iq = (!dev->rx_decim && (format == FOBOS_FORMAT_FC32)) ? (float *)(out + produced * sample_size) : scratch;
+        dev->rx_convert->convert[FOBOS_FORMAT_FC32](params, raw + 2 * done, iq, n);
+        if (dev->rx_decim)
+        {
+            dev->rx_convert->nco(&e->nco, phase, iq, mixed, n);
+            produced += fobos_decim_run_iq(dev->rx_decim, scale * 0.25f, mixed, n, out + produced * sample_size, format);
+        }
+        else
+        {
+            dev->rx_convert->nco(&e->nco, phase, iq, NULL, n);
+            if (iq == scratch)
+            {
+                fobos_convert_pack(iq, out + produced * sample_size, n, format);
+            }
+            produced += n;
+        }
+        done += n;
+    }
+    return (int)produced;
+}
+//==============================================================================
+// a part of a conversion the consumer of a FOBOS_FORMAT_RAW stream spread over the workers
+struct fobos_rx_part
+{
+    const int16_t * raw;
+    void * dst;
+    uint32_t count;
+    int format;
+    uint64_t sample;
+    int mixing;
+    struct fobos_rx_nco nco[2];
+    struct fobos_convert_params params;
+};
+//==============================================================================
+// without the filters every sample converts on its own, the mixer phase follows from the
+// sample index, so the parts need nothing from each other
+static void fobos_rx_part_work(void * ctx, void * data)
+{
+    struct fobos_dev_t * dev = (struct fobos_dev_t *)ctx;
+    struct fobos_rx_part * part = (struct fobos_rx_part *)data;
+    if (part->mixing)
+    {
+        fobos_rx_mix(dev, part->nco, &part->params, part->raw, part->dst, part->count, part->format, part->sample);
+    }
+    else
+    {
+        dev->rx_convert->convert[part->format](&part->params, part->raw, part->dst, part->count);
+    }
+}
+//==============================================================================
+static void fobos_rx_part_release(void * ctx, void * data)
+{
+    (void)ctx;
+    (void)data;
+}
+//==============================================================================
+// count samples split over rx_workers, the caller waits for all of them; 0 if the caller
+// converts them itself: no workers, too few samples, or the event thread converts
+static int fobos_rx_split(struct fobos_dev_t * dev, const struct fobos_rx_nco * nco, const struct fobos_convert_params * params, const int16_t * raw, void * dst, uint32_t count, int format, uint64_t sample)
+{
+    // the stream workers call fobos_rx_decimate() themselves
+    if ((dev->rx_format != FOBOS_FORMAT_RAW) || (dev->rx_workers < 2))
+    {
+        return 0;
+    }
+    uint32_t parts = count / FOBOS_PART_MIN;
+    if (parts > dev->rx_workers)
+    {
+        parts = dev->rx_workers;
+    }
+    if (parts < 2)
+    {
+        return 0;
+    }
+    // created on the first use, by the one thread that converts
+    if (dev->rx_parts && (dev->rx_parts_workers != dev->rx_workers))
+    {
+        fobos_pool_destroy(dev->rx_parts);
+        dev->rx_parts = NULL;
+    }
+    if (!dev->rx_parts)
+    {
+        dev->rx_parts = fobos_pool_create(dev->rx_workers, dev->rx_workers, sizeof(struct fobos_rx_part), fobos_rx_part_work, fobos_rx_part_release, dev);
+        if (!dev->rx_parts)
+        {
+            return 0;
+        }
+        dev->rx_parts_workers = dev->rx_workers;
+    }
+    size_t sample_size = fobos_rx_sample_size(format);
+    // whole cache lines of output
+    uint32_t step = ((count / parts) + 63) & ~63u;
+    uint32_t done = 0;
+    while (done < count)
+    {
+        struct fobos_rx_part * part = (struct fobos_rx_part *)fobos_pool_acquire(dev->rx_parts);
+        if (!part)
+        {
+            // not with parts <= slots, the previous call drained them all
+            break;
+        }
+        part->raw = raw + 2 * done;
+        part->dst = (uint8_t *)dst + done * sample_size;
+        part->count = (count - done < step) ? count - done : step;
+        part->format = format;
+        part->sample = sample + done;
+        part->mixing = (nco != NULL);
+        if (nco)
+        {
+            part->nco[0] = nco[0];
+            part->nco[1] = nco[1];
+        }
+        part->params = *params;
+        fobos_pool_commit(dev->rx_parts);
+        done += part->count;
+    }
+    fobos_pool_drain(dev->rx_parts);
+    return done == count;
+}
+//==============================================================================
+int fobos_rx_convert(struct fobos_dev_t * dev, const void * raw, void * dst, uint32_t count, int format)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if ((format < 0) || (format >= FOBOS_FORMAT_COUNT))
+    {
+        return -7;
+    }
+    struct fobos_convert_params params;
+    fobos_rx_convert_params(dev, fobos_rx_format_scale(dev, format), &params);
+    if (!fobos_rx_split(dev, NULL, &params, (const int16_t *)raw, dst, count, format, 0))
+    {
+        dev->rx_convert->convert[format](&params, (const int16_t *)raw, dst, count);
+    }
+    return 0;
+}
+//==============================================================================
+int fobos_rx_decimate(struct fobos_dev_t * dev, const void * raw, void * dst, uint32_t count, int format, uint64_t sample)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if ((format < 0) || (format >= FOBOS_FORMAT_COUNT))
+    {
+        return -7;
+    }
+    struct fobos_rx_nco nco[2];
+    int mixing = fobos_rx_get_nco(dev, nco, sample);
+    struct fobos_convert_params params;
+    // the chain takes 4 per raw lsb, the decimated samples get the format scale afterwards
+    fobos_rx_convert_params(dev, (mixing && dev->rx_decim) ? 4.0f : fobos_rx_format_scale(dev, format), &params);
+    if (!dev->rx_decim && fobos_rx_split(dev, mixing ? nco : NULL, &params, (const int16_t *)raw, dst, count, format, sample))
+    {
+        return (int)count;
+    }
+    if (mixing)
+    {
+        return fobos_rx_mix(dev, nco, &params, (const int16_t *)raw, dst, count, format, sample);
+    }
+    if (!dev->rx_decim)
+    {
+        dev->rx_convert->convert[format](&params, (const int16_t *)raw, dst, count);
+        return (int)count;
+    }
+    return (int)fobos_decim_run(dev->rx_decim, &params, (const int16_t *)raw, count, dst, format);
+}
+//==============================================================================
+// the channelizer on count raw samples from stream sample index sample on: the corrected
+// samples as float, rotated if the mixer is on, then filtered, output i of channel k goes
+// to item i * stride of dst[k]
+static int fobos_rx_pfb(struct fobos_dev_t * dev, const int16_t * raw, void * const * dst, size_t stride, uint32_t count, int format, uint64_t sample)
+{
+    float iq[2 * FOBOS_NCO_CHUNK];
+    struct fobos_rx_nco nco[2];
+    int mixing = fobos_rx_get_nco(dev, nco, sample);
+    struct fobos_convert_params params;
+    fobos_rx_convert_params(dev, fobos_rx_format_scale(dev, format), &params);
+    size_t produced = 0;
+    uint32_t done = 0;
+    while (done < count)
+    {
+        uint64_t s = sample + done;
+        uint32_t n = count - done;
+        if (n > FOBOS_NCO_CHUNK)
+        {
+            n = FOBOS_NCO_CHUNK;
+        }
+        const struct fobos_rx_nco * e = mixing ? fobos_rx_nco_at(nco, s, &n) : NULL;
+        dev->rx_convert->convert[FOBOS_FORMAT_FC32](&params, raw + 2 * done, iq, n);
+        if (e)
+        {
+            dev->rx_convert->nco(&e->nco, e->phase + e->nco.step * (uint32_t)(s - e->sample), iq, NULL, n);
+        }
+        produced += fobos_pfb_run(dev->rx_pfb, iq, n, dst, produced, stride, format);
+        done += n;
+    }
+    return (int)produced;
+}
+//==============================================================================
+int fobos_rx_channelize(struct fobos_dev_t * dev, const void * raw, void * const * dst, uint32_t count, int format, uint64_t sample)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if ((format < 0) || (format >= FOBOS_FORMAT_COUNT) || !dev->rx_pfb || !dst)
+    {
+        return -7;
+    }
+    return fobos_rx_pfb(dev, (const int16_t *)raw, dst, 1, count, format, sample);
+}
+//==============================================================================
+int fobos_rx_psd(struct fobos_dev_t * dev, const void * raw, uint32_t count, float * dst, uint64_t sample)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!dev->rx_psd || !raw || !dst)
+    {
+        return -7;
+    }
+    if (sample != dev->rx_psd_next)
+    {
+        // a dropped transfer, no block spans the gap
+        dev->rx_psd_len = 0;
+        fobos_psd_reset(dev->rx_psd);
+    }
+    dev->rx_psd_next = sample + count;
+    struct fobos_rx_nco nco[2];
+    int mixing = fobos_rx_get_nco(dev, nco, sample);
+    struct fobos_convert_params params;
+    fobos_rx_convert_params(dev, fobos_rx_format_scale(dev, FOBOS_FORMAT_FC32), &params);
+    uint32_t size = fobos_psd_size(dev->rx_psd);
+    int rows = 0;
+    uint32_t done = 0;
+    while (done < count)
+    {
+        uint64_t s = sample + done;
+        uint32_t n = count - done;
+        if (n > size - dev->rx_psd_len)
+        {
+            n = size - dev->rx_psd_len;
+        }
+        const struct fobos_rx_nco * e = mixing ? fobos_rx_nco_at(nco, s, &n) : NULL;
+        // converted straight into the block while the raw samples are still in cache
+        float * iq = dev->rx_psd_block + 2 * dev->rx_psd_len;
+        dev->rx_convert->convert[FOBOS_FORMAT_FC32](&params, (const int16_t *)raw + 2 * done, iq, n);
+        if (e)
+        {
+            dev->rx_convert->nco(&e->nco, e->phase + e->nco.step * (uint32_t)(s - e->sample), iq, NULL, n);
+        }
+        dev->rx_psd_len += n;
+        done += n;
+        if (dev->rx_psd_len == size)
+        {
+            fobos_psd_add(dev->rx_psd, dev->rx_psd_block);
+            if (fobos_psd_count(dev->rx_psd) == dev->rx_psd_averages)
+            {
+                fobos_psd_read(dev->rx_psd, dst + (size_t)rows * size);
+                fobos_psd_reset(dev->rx_psd);
+                rows++;
+            }
+            // the overlap starts the next block
+            uint32_t overlap = size - dev->rx_psd_hop;
+            memmove(dev->rx_psd_block, dev->rx_psd_block + 2 * dev->rx_psd_hop, 2 * overlap * sizeof(float));
+            dev->rx_psd_len = overlap;
+        }
+    }
+    return rows;
+}
+//==============================================================================
+// the hardware description of the SigMF metadata
+static void fobos_rx_hw(struct fobos_dev_t * dev, char * hw, size_t size)
+{
+    snprintf(hw, size, "%s %s, serial %s", dev->manufacturer, dev->product, dev->serial);
+}
+//==============================================================================
+#define FOBOS_RECORD_BUFFER_MS 500.0
+int fobos_rx_start_recording(struct fobos_dev_t * dev, const char * path, uint64_t preallocate, double buffer_ms)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%s)\n", __FUNCTION__, path ? path : "");
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!path || !path[0] || (buffer_ms < 0.0))
+    {
+        return -7;
+    }
+    if (buffer_ms == 0.0)
+    {
+        buffer_ms = FOBOS_RECORD_BUFFER_MS;
+    }
+    fobos_mutex_lock(&dev->rx_record_lock);
+    if (dev->rx_record)
+    {
+        fobos_mutex_unlock(&dev->rx_record_lock);
+        return -5;
+    }
+    size_t buffer = (size_t)(dev->rx_samplerate * 4.0 * buffer_ms * 0.001);
+    dev->rx_record = fobos_record_open(path, preallocate, buffer, 0);
+    memset(&dev->rx_record_status, 0, sizeof(dev->rx_record_status));
+    // the first transfer starts the first capture
+    dev->rx_record_capture.samplerate = 0.0;
+    result = dev->rx_record ? 0 : -ENOMEM;
+    fobos_mutex_unlock(&dev->rx_record_lock);
+    return result;
+}
+//==============================================================================
+int fobos_rx_stop_recording(struct fobos_dev_t * dev)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    fobos_mutex_lock(&dev->rx_record_lock);
+    struct fobos_record * record = dev->rx_record;
+    if (record)
+    {
+        fobos_record_status(record, &dev->rx_record_status);
+        dev->rx_record_status.active = 0;
+    }
+    dev->rx_record = NULL;
+    fobos_mutex_unlock(&dev->rx_record_lock);
+    if (!record)
+    {
+        return -7;
+    }
+    // the event thread goes on streaming while the queue drains
+    char hw[3 * LIBUSB_DDESCRIPTOR_LEN + 16];
+    fobos_rx_hw(dev, hw, sizeof(hw));
+    result = fobos_record_close(record, hw);
+    fobos_mutex_lock(&dev->rx_record_lock);
+    if (result == 0)
+    {
+        dev->rx_record_status.written = dev->rx_record_status.bytes;
+    }
+    dev->rx_record_status.error = result;
+    fobos_mutex_unlock(&dev->rx_record_lock);
+    return result;
+}
+//==============================================================================
+int fobos_rx_get_recording(struct fobos_dev_t * dev, struct fobos_rx_recording * status)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!status)
+    {
+        return -7;
+    }
+    fobos_mutex_lock(&dev->rx_record_lock);
+    if (dev->rx_record)
+    {
+        fobos_record_status(dev->rx_record, status);
+    }
+    else
+    {
+        *status = dev->rx_record_status;
+    }
+    fobos_mutex_unlock(&dev->rx_record_lock);
+    return 0;
+}
+//==============================================================================
+int fobos_rx_set_history(struct fobos_dev_t * dev, uint64_t size)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%llu)\n", __FUNCTION__, (unsigned long long)size);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    struct fobos_history * history = NULL;
+    if (size > 0)
+    {
+        history = fobos_history_create(size);
+        if (!history)
+        {
+            return -ENOMEM;
+        }
+    }
+    // waits for the snapshot being written
+    fobos_history_destroy(dev->rx_history);
+    dev->rx_history = history;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_trigger_snapshot(struct fobos_dev_t * dev, const char * path, uint64_t sample, uint64_t pre, uint64_t post)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%s)\n", __FUNCTION__, path ? path : "");
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    if (!dev->rx_history)
+    {
+        return -7;
+    }
+    char hw[3 * LIBUSB_DDESCRIPTOR_LEN + 16];
+    fobos_rx_hw(dev, hw, sizeof(hw));
+    return fobos_history_snapshot(dev->rx_history, path, sample, pre, post, hw);
 }
 //==============================================================================
-int fobos_rx_set_lpf(struct fobos_dev_t * dev, int value)
+int fobos_rx_get_snapshot(struct fobos_dev_t * dev, struct fobos_rx_snapshot * status)
 {
     int result = fobos_check(dev);
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%d)\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG
     if (result != 0)
     {
         return result;
     }
-    if (value < 0) value = 0;
-    if (value > 2) value = 2;
-    if (dev->rx_lpf_idx != value)
+    if (!status)
     {
-        if (!dev->rx_direct_sampling)
+        return -7;
+    }
+    memset(status, 0, sizeof(*status));
+    if (dev->rx_history)
+    {
+        fobos_history_status(dev->rx_history, status);
+    }
+    return 0;
+}
+//==============================================================================
+// the settings a transfer of size bytes completing now was received with, sample - its
+// stream index
+static void fobos_rx_capture(struct fobos_dev_t * dev, size_t size, uint64_t sample, struct fobos_record_capture * capture)
+{
+    memset(capture, 0, sizeof(*capture));
+    capture->global_index = sample;
+    capture->frequency = dev->rx_frequency;
+    capture->samplerate = dev->rx_samplerate;
+    capture->lna_gain = dev->rx_lna_gain;
+    capture->vga_gain = dev->rx_vga_gain;
+    capture->direct_sampling = dev->rx_direct_sampling;
+    capture->swap_iq = dev->rx_swap_iq ^ FOBOS_SWAP_IQ_HW;
+    fobos_rx_get_iq_correction(dev, &capture->correction);
+    struct timespec now;
+    if (timespec_get(&now, TIME_UTC) != 0)
+    {
+        // the transfer completed, its first sample is a transfer older
+        capture->time = (double)now.tv_sec + now.tv_nsec * 1E-9 - (size / 4) / capture->samplerate;
+    }
+}
+//==============================================================================
+// the event thread: a completed transfer as the device sent it, sample - its stream
+// index, into the history and the recording; retunes, gain changes and gaps start a
+// new capture
+static void fobos_rx_record_transfer(struct fobos_dev_t * dev, const void * data, size_t size, uint64_t sample)
+{
+    struct fobos_record_capture capture;
+    if (dev->rx_history)
+    {
+        fobos_rx_capture(dev, size, sample, &capture);
+        fobos_history_push(dev->rx_history, data, &capture);
+    }
+    fobos_mutex_lock(&dev->rx_record_lock);
+    struct fobos_record * record = dev->rx_record;
+    if (record)
+    {
+        struct fobos_record_capture * last = &dev->rx_record_capture;
+        if (!dev->rx_history)
         {
-            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A0);
-            bitclear(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            if (value & 1)
-            {
-                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A1);
-            }
-            if (value & 2)
+            fobos_rx_capture(dev, size, sample, &capture);
+        }
+        if ((last->samplerate == 0.0) || (sample != dev->rx_record_next) || !fobos_record_capture_equal(&capture, last))
+        {
+            if ((last->samplerate != 0.0) && (sample > dev->rx_record_next))
             {
-                bitset(dev->dev_gpo, FOBOS_DEV_LPF_A0);
+                fobos_record_gap(record, sample - dev->rx_record_next);
             }
-            fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+            fobos_record_set_capture(record, &capture);
+            *last = capture;
+        }
+        // a dropped transfer leaves rx_record_next behind, the next one is a gap
+        if (fobos_record_write(record, data, size) == 0)
+        {
+            dev->rx_record_next = sample + size / 4;
         }
-        dev->rx_lpf_idx = value;
     }
-    return result;
+    fobos_mutex_unlock(&dev->rx_record_lock);
 }
 //==============================================================================
-int fobos_rx_set_clk_source(struct fobos_dev_t * dev, int value)
+void fobos_rx_proceed_rx_buff(struct fobos_dev_t * dev, void * data, size_t size)
 {
-    int result = fobos_check(dev);
-#ifdef FOBOS_PRINT_DEBUG
-    printf_internal("%s(%d)\n", __FUNCTION__, value);
-#endif // FOBOS_PRINT_DEBUG
-    if (result != 0)
+    size_t complex_samples_count = size / 4;
+    if (dev->rx_format == FOBOS_FORMAT_RAW)
     {
-        return result;
+        // the consumer converts the samples itself by fobos_rx_convert() or fobos_rx_decimate()
+        if (dev->rx_cb)
+        {
+            dev->rx_cb_sample = dev->rx_sample_counter;
+            dev->rx_cb((float *)data, complex_samples_count, dev->rx_cb_ctx);
+        }
+        return;
     }
-    if (value)
+    // a decimated part of every buffer keeps the dc & iq correction up to date
+    fobos_rx_update_iq_estimate(dev, data, complex_samples_count < FOBOS_ESTIMATOR_LEN ? complex_samples_count : FOBOS_ESTIMATOR_LEN);
+    int count;
+    if (dev->rx_pfb)
     {
-        bitclear(dev->dev_gpo, FOBOS_DEV_CLKSEL);
+        // the channels interleaved, sample i of channel k to item i * channels + k
+        void * dst[FOBOS_PFB_MAX_CHANNELS];
+        for (uint32_t k = 0; k < dev->rx_channels; k++)
+        {
+            dst[k] = (uint8_t *)dev->rx_buff + k * fobos_rx_sample_size(dev->rx_format);
+        }
+        count = fobos_rx_pfb(dev, (const int16_t *)data, dst, dev->rx_channels, (uint32_t)complex_samples_count, dev->rx_format, dev->rx_sample_counter) * dev->rx_channels;
     }
     else
     {
-        bitset(dev->dev_gpo, FOBOS_DEV_CLKSEL);
+        count = fobos_rx_decimate(dev, data, dev->rx_buff, complex_samples_count, dev->rx_format, dev->rx_sample_counter);
+    }
+    if (dev->rx_cb && (count > 0))
+    {
+        dev->rx_cb_sample = dev->rx_sample_counter;
+        dev->rx_cb(dev->rx_buff, (uint32_t)count, dev->rx_cb_ctx);
     }
-    result = fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
-    return result;
 }
 //==============================================================================
-#define FOBOS_SWAP_IQ_HW 1
-void fobos_rx_proceed_rx_buff(struct fobos_dev_t * dev, void * data, size_t size)
+// a transfer handed to the conversion workers
+struct fobos_rx_job
 {
-    size_t complex_samples_count = size / 4;
-    int16_t * psample = (int16_t *)data;
-    float sample = 0.0f;
-    float scale_re = dev->rx_scale_re;
-    float scale_im = dev->rx_scale_im;
-    if (dev->rx_direct_sampling)
+    struct libusb_transfer * transfer;
+    void * out;
+    uint64_t sample;
+    uint32_t count;
+    int resubmit_error;
+    uint64_t time_us;
+};
+//==============================================================================
+// any worker: convert, then give the transfer straight back to the usb side
+static void fobos_rx_job_work(void * ctx, void * data)
+{
+    struct fobos_dev_t * dev = (struct fobos_dev_t *)ctx;
+    struct fobos_rx_job * job = (struct fobos_rx_job *)data;
+    uint64_t t0 = fobos_time_us();
+    job->count = (uint32_t)job->transfer->actual_length / 4;
+    // a busy estimator just misses this buffer
+    if (fobos_mutex_trylock(&dev->rx_estimator_lock))
     {
-        scale_re = 1.0f / 32786.0f;
-        scale_im = 1.0f / 32786.0f;
+        fobos_rx_iq_estimate(dev, job->transfer->buffer, job->count < FOBOS_ESTIMATOR_LEN ? job->count : FOBOS_ESTIMATOR_LEN);
+        fobos_mutex_unlock(&dev->rx_estimator_lock);
     }
-    float k = 0.001f;
-    float dc_re = dev->rx_dc_re;
-    float dc_im = dev->rx_dc_im;
-
-    float * dst_re = dev->rx_buff;
-    float * dst_im = dev->rx_buff + 1;
-    int rx_swap_iq = dev->rx_swap_iq ^ FOBOS_SWAP_IQ_HW;
-    if (rx_swap_iq)
+    fobos_rx_decimate(dev, job->transfer->buffer, job->out, job->count, dev->rx_format, job->sample);
+    job->resubmit_error = dev->ops->submit(dev->transport, job->transfer) < 0;
+    job->time_us = fobos_time_us() - t0;
+}
+//==============================================================================
+// in transfer order, one job at a time
+static void fobos_rx_job_release(void * ctx, void * data)
+{
+    struct fobos_dev_t * dev = (struct fobos_dev_t *)ctx;
+    struct fobos_rx_job * job = (struct fobos_rx_job *)data;
+    if (dev->rx_cb)
     {
-        dst_re = dev->rx_buff + 1;
-        dst_im = dev->rx_buff;
+        dev->rx_cb_sample = job->sample;
+        dev->rx_cb((float *)job->out, job->count, dev->rx_cb_ctx);
     }
-    size_t chunks_count = complex_samples_count / 8;
-    for (size_t i = 0; i < chunks_count; i++)
+    fobos_hist_add(&dev->rx_stats.buffer_time, job->time_us);
+    if (job->resubmit_error)
     {
-        // 0
-        sample = (psample[0] & 0x3FFF) * scale_re;
-        dc_re += k * (sample - dc_re);
-        dst_re[0] = sample - dc_re;
-
-        sample = (psample[1] & 0x3FFF) * scale_im;
-        dc_im += k * (sample - dc_im);
-        dst_im[0] = sample - dc_im;
-
-        // 1
-        dst_re[2] = (psample[2] & 0x3FFF) * scale_re - dc_re;
-        dst_im[2] = (psample[3] & 0x3FFF) * scale_im - dc_im;
-
-        // 2
-        dst_re[4] = (psample[4] & 0x3FFF) * scale_re - dc_re;
-        dst_im[4] = (psample[5] & 0x3FFF) * scale_im - dc_im;
-
-        // 3
-        dst_re[6] = (psample[6] & 0x3FFF) * scale_re - dc_re;
-        dst_im[6] = (psample[7] & 0x3FFF) * scale_im - dc_im;
-
-        // 4
-        dst_re[8] = (psample[8] & 0x3FFF) * scale_re - dc_re;
-        dst_im[8] = (psample[9] & 0x3FFF) * scale_im - dc_im;
-
-        // 5
-        dst_re[10] = (psample[10] & 0x3FFF) * scale_re - dc_re;
-        dst_im[10] = (psample[11] & 0x3FFF) * scale_im - dc_im;
-
-        // 6
-        dst_re[12] = (psample[12] & 0x3FFF) * scale_re - dc_re;
-        dst_im[12] = (psample[13] & 0x3FFF) * scale_im - dc_im;
-
-        // 7
-        dst_re[14] = (psample[14] & 0x3FFF) * scale_re - dc_re;
-        dst_im[14] = (psample[15] & 0x3FFF) * scale_im - dc_im;
-
-        dst_re += 16;
-        dst_im += 16;
-        psample +=16;
+        dev->rx_stats.resubmit_errors++;
     }
-    dev->rx_dc_re = dc_re;
-    dev->rx_dc_im = dc_im;
-    if (dev->rx_cb)
+}
+//==============================================================================
+// twice the transfers in flight: a converted buffer may wait for an earlier
+// one while its transfer already completed again
+static int fobos_rx_start_workers(struct fobos_dev_t * dev, uint32_t buf_length)
+{
+    size_t out_size = (size_t)buf_length * fobos_rx_sample_size(dev->rx_format);
+    dev->rx_pool = fobos_pool_create(dev->rx_workers, dev->transfer_buf_count * 2, sizeof(struct fobos_rx_job), fobos_rx_job_work, fobos_rx_job_release, dev);
+    if (!dev->rx_pool)
+    {
+        return -ENOMEM;
+    }
+    uint32_t jobs_count = fobos_pool_jobs_count(dev->rx_pool);
+    dev->rx_pool_buff = (uint8_t *)malloc(jobs_count * out_size);
+    if (!dev->rx_pool_buff)
+    {
+        fobos_pool_destroy(dev->rx_pool);
+        dev->rx_pool = NULL;
+        return -ENOMEM;
+    }
+    for (uint32_t i = 0; i < jobs_count; i++)
     {
-        dev->rx_cb(dev->rx_buff, complex_samples_count, dev->rx_cb_ctx);
+        struct fobos_rx_job * job = (struct fobos_rx_job *)fobos_pool_job(dev->rx_pool, i);
+        job->out = dev->rx_pool_buff + i * out_size;
     }
+    return 0;
+}
+//==============================================================================
+static void fobos_rx_stop_workers(struct fobos_dev_t * dev)
+{
+    fobos_pool_destroy(dev->rx_pool);
+    dev->rx_pool = NULL;
+    free(dev->rx_pool_buff);
+    dev->rx_pool_buff = NULL;
 }
 //==============================================================================
 void fobos_rx_proceed_calibration(struct fobos_dev_t * dev, void * data, uint32_t size)
@@ -1502,68 +3297,20 @@ void fobos_rx_proceed_calibration(struct fobos_dev_t * dev, void * data, uint32_
     printf_internal("%s(%d)\n", __FUNCTION__, size);
 #endif // FOBOS_PRINT_DEBUG
     size_t complex_samples_count = size / 4;
-
-    int64_t summ_re = 0ll;
-    int64_t summ_im = 0ll;
-    int16_t * psample = (int16_t *)data;
-    float * dst_re = dev->rx_buff;
-    float * dst_im = dev->rx_buff + 1;
-    for (size_t i = 0; i < complex_samples_count; i++)
-    {
-        int16_t re = *psample;
-        re &= 0x3FFF;
-        *dst_re = re;
-        summ_re += re;
-        dst_re += 2;
-        psample++;
-        int16_t im = *psample;
-        im &= 0x3FFF;
-        *dst_im = im;
-        summ_im += im;
-        dst_im += 2;
-        psample++;
-    }
-    float dc_re = (float)summ_re / (float)complex_samples_count;
-    float dc_im = (float)summ_im / (float)complex_samples_count;
-
-    psample = (int16_t *)data;
-    dst_re = dev->rx_buff;
-    dst_im = dev->rx_buff + 1;
-    double avg_abs_re = 0.0;
-    double avg_abs_im = 0.0;
-    for (size_t i = 0; i < complex_samples_count; i++)
-    {
-        *dst_re -= dc_re;
-        float re = fabsf(*dst_re);
-        dst_re += 2;
-        *dst_im -= dc_im;
-        float im = fabsf(*dst_im);
-        dst_im += 2;
-        avg_abs_re += re;
-        avg_abs_im += im;
-    }
-
-    if ((avg_abs_re > 0.0f) && (avg_abs_im > 0.0f))
+    // one pass over the raw samples, exact integer sums, no rx_buff involved
+    fobos_mutex_lock(&dev->rx_estimator_lock);
+    if (dev->rx_calibration_pos == 0)
     {
-        avg_abs_re /= (double)complex_samples_count;
-        avg_abs_im /= (double)complex_samples_count;
-        float scale_re = 1.0f / 32786.0f;
-        float scale_im = scale_re * avg_abs_re / avg_abs_im;
+        fobos_iq_estimator_init(&dev->rx_estimator, FOBOS_ESTIMATOR_K);
+        dev->rx_scale_re = 1.0f / 32786.0f;
+    }
+    fobos_rx_iq_estimate(dev, data, (uint32_t)complex_samples_count);
+    fobos_mutex_unlock(&dev->rx_estimator_lock);
 #ifdef FOBOS_PRINT_DEBUG
-        printf_internal("[%d] im/re scale = %f\n", dev->rx_calibration_pos, scale_im / scale_re);
+    struct fobos_iq_correction correction;
+    fobos_rx_get_iq_correction(dev, &correction);
+    printf_internal("[%d] im/re gain = %f phase = %f\n", dev->rx_calibration_pos, correction.gain, correction.phase);
 #endif // FOBOS_PRINT_DEBUG
-        if (dev->rx_calibration_pos == 0)
-        {
-            dev->rx_scale_re = scale_re;
-            dev->rx_scale_im = scale_im;
-        }
-        else
-        {
-            float k = 0.1f;
-            dev->rx_scale_re += k * (scale_re - dev->rx_scale_re);
-            dev->rx_scale_im += k * (scale_im - dev->rx_scale_im);
-        }
-    }
 }
 //==============================================================================
 int fobos_rx_set_calibration(struct fobos_dev_t * dev, int state)
@@ -1630,10 +3377,12 @@ int fobos_rx_set_calibration(struct fobos_dev_t * dev, int state)
             break;
             case 2:
             {
+                // the dc of the rf path differs from the calibration one
+                dev->rx_estimator_retune = 1;
                 double f = dev->rx_frequency;
                 dev->rx_frequency = 0.0;
                 dev->rx_frequency_band = 0;
-                fobos_rx_set_frequency(dev, f, 0);
+                fobos_rx_set_lo(dev, f, 0);
                 if (dev->rx_direct_sampling)
                 {
                     dev->rx_direct_sampling = 0;
@@ -1676,9 +3425,13 @@ int fobos_alloc_buffers(struct fobos_dev_t *dev)
         memset(dev->transfer_buf, 0, dev->transfer_buf_count * sizeof(unsigned char*));
     }
 #if defined(ENABLE_ZEROCOPY) && defined (__linux__) && LIBUSB_API_VERSION >= 0x01000105
-    printf_internal("Allocating %d zero-copy buffers\n", dev->transfer_buf_count);
-    dev->use_zerocopy = 1;
-    for (i = 0; i < dev->transfer_buf_count; ++i)
+    // usbfs memory only exists for a real device
+    dev->use_zerocopy = (dev->ops == &fobos_usb_ops);
+    if (dev->use_zerocopy)
+    {
+        printf_internal("Allocating %d zero-copy buffers\n", dev->transfer_buf_count);
+    }
+    for (i = 0; dev->use_zerocopy && (i < dev->transfer_buf_count); ++i)
     {
         dev->transfer_buf[i] = libusb_dev_mem_alloc(dev->libusb_devh, dev->transfer_buf_size);
         if (dev->transfer_buf[i])
@@ -1774,35 +3527,71 @@ static void LIBUSB_CALL _libusb_callback(struct libusb_transfer *transfer)
     struct fobos_dev_t *dev = (struct fobos_dev_t *)transfer->user_data;
     if (LIBUSB_TRANSFER_COMPLETED == transfer->status)
     {
+        uint64_t t0 = fobos_time_us();
+        if (dev->rx_stats_last_us)
+        {
+            fobos_hist_add(&dev->rx_stats.usb_interval, t0 - dev->rx_stats_last_us);
+        }
+        dev->rx_stats_last_us = t0;
         if (transfer->actual_length == (int)dev->transfer_buf_size)
         {
             dev->rx_buff_counter++;
+            dev->rx_stats.buffers++;
+            if ((dev->rx_calibration_state != 1) || (dev->rx_calibration_pos >= 4))
+            {
+                // as the device sent it, ahead of any conversion or drop
+                fobos_rx_record_transfer(dev, transfer->buffer, transfer->actual_length, dev->rx_sample_counter);
+            }
             if ((dev->rx_calibration_state == 1) && (dev->rx_calibration_pos < 4))
             {
                 fobos_rx_proceed_calibration(dev, transfer->buffer, transfer->actual_length);
                 dev->rx_calibration_pos++;
             }
+            else if (dev->rx_pool && (FOBOS_RUNNING == dev->rx_async_status))
+            {
+                // the workers convert and resubmit, this thread only queues the transfer
+                struct fobos_rx_job * job = (struct fobos_rx_job *)fobos_pool_acquire(dev->rx_pool);
+                if (job)
+                {
+                    job->transfer = transfer;
+                    job->sample = dev->rx_sample_counter;
+                    dev->rx_sample_counter += dev->transfer_buf_size / 4;
+                    fobos_pool_commit(dev->rx_pool);
+                    dev->transfer_errors = 0;
+                    return;
+                }
+                // every converted buffer still waits for the consumer, drop this one
+                dev->rx_stats.worker_drops++;
+                dev->rx_sample_counter += dev->transfer_buf_size / 4;
+            }
             else
             {
-                //ULONGLONG t0, t1;
-                //QueryPerformanceCounter(&t0);
                 fobos_rx_proceed_rx_buff(dev, transfer->buffer, transfer->actual_length);
-                //QueryPerformanceCounter(&t1);
-                //double dt = (t1 - t0);
-                //printf("%f\n", dt);
+                fobos_hist_add(&dev->rx_stats.buffer_time, fobos_time_us() - t0);
+                dev->rx_sample_counter += dev->transfer_buf_size / 4;
             }
         }
         else
         {
             printf_internal("E");
             dev->rx_failures++;
+            dev->rx_stats.rx_failures++;
+            // the device sent a whole transfer, the rest of it is lost
+            if ((dev->rx_calibration_state != 1) || (dev->rx_calibration_pos >= 4))
+            {
+                dev->rx_sample_counter += dev->transfer_buf_size / 4;
+            }
+        }
+        if (dev->ops->submit(dev->transport, transfer) < 0)
+        {
+            dev->rx_stats.resubmit_errors++;
         }
-        libusb_submit_transfer(transfer);
         dev->transfer_errors = 0;
     }
     else if (LIBUSB_TRANSFER_CANCELLED != transfer->status)
     {
         printf_internal("transfer->status = %d\n", transfer->status);
+        dev->rx_stats.transfer_errors++;
 #ifndef _WIN32
         if (LIBUSB_TRANSFER_ERROR == transfer->status)
         {
@@ -1838,13 +3627,39 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
     result = 0;
     struct timeval tv0 = { 0, 0 };
     struct timeval tv1 = { 1, 0 };
+    fobos_mutex_lock(&dev->rx_config_lock);
     dev->rx_async_status = FOBOS_STARTING;
+    dev->rx_sample_counter = 0;
+    fobos_rx_hops_restart(dev);
+    fobos_mutex_unlock(&dev->rx_config_lock);
     dev->rx_async_cancel = 0;
     dev->rx_buff_counter = 0;
+    dev->rx_stats_last_us = 0;
+    dev->rx_cb_sample = 0;
+    // the sample index restarts, so does the mixer
+    fobos_rx_set_nco(dev, dev->rx_nco_offset);
     dev->rx_cb = cb;
     dev->rx_cb_ctx = ctx;
     dev->rx_calibration_state = 0;
-    fobos_rx_set_calibration(dev, 1); // start calibration
+    if (!fobos_rx_replay(dev))
+    {
+        // a replay has no calibration signal, the recording has the correction
+        fobos_rx_set_calibration(dev, 1); // start calibration
+    }
+    if (dev->rx_decim)
+    {
+        fobos_decim_reset(dev->rx_decim);
+    }
+    if (dev->rx_pfb)
+    {
+        fobos_pfb_reset(dev->rx_pfb);
+    }
+    if (dev->rx_psd)
+    {
+        fobos_psd_reset(dev->rx_psd);
+        dev->rx_psd_len = 0;
+        dev->rx_psd_next = 0;
+    }
     if (buf_count == 0)
     {
         buf_count = FOBOS_DEF_BUF_COUNT;
@@ -1871,8 +3686,30 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
     {
         return result;
     }
+    if (dev->rx_history)
+    {
+        fobos_history_start(dev->rx_history, dev->transfer_buf_size);
+    }
 
-    dev->rx_buff = (float*)malloc(buf_length * 2 * sizeof(float));
+    if (dev->rx_format != FOBOS_FORMAT_RAW)
+    {
+        size_t out_length = buf_length;
+        if (dev->rx_pfb)
+        {
+            // every channel gets up to one sample per decimation inputs, rounded up
+            out_length = (buf_length / fobos_pfb_decimation(dev->rx_pfb) + 1) * dev->rx_channels;
+        }
+        dev->rx_buff = (float*)malloc(out_length * fobos_rx_sample_size(dev->rx_format));
+        if (dev->rx_workers && (dev->rx_decim || dev->rx_pfb))
+        {
+            // the filters carry their history from one buffer to the next
+            printf_internal("Filtering in the event thread, %d conversion workers not started\n", dev->rx_workers);
+        }
+        else if (dev->rx_workers && (fobos_rx_start_workers(dev, buf_length) != 0))
+        {
+            printf_internal("Failed to start %d conversion workers, converting in the event thread\n", dev->rx_workers);
+        }
+    }
 
     fobos_fx3_command(dev, 0xE1, 1, 0);        // start fx
 
@@ -1890,7 +3727,7 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
             (void *)dev,
             LIBUSB_BULK_TIMEOUT);
 
-        result = libusb_submit_transfer(dev->transfer[i]);
+        result = dev->ops->submit(dev->transport, dev->transfer[i]);
         if (result < 0)
         {
             printf_internal("Failed to submit transfer #%i, err %i\n", i, result);
@@ -1909,8 +3746,17 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
                 fobos_rx_set_calibration(dev, 2);
             }
         }
+        if (dev->rx_config_pending)
+        {
+            // between two transfers, the usb traffic of the batch does not meet the callbacks
+            fobos_rx_config_flush(dev);
+        }
+        if (dev->rx_hops_count && (dev->rx_calibration_state != 1) && (dev->rx_sample_counter >= dev->rx_hop_next))
+        {
+            fobos_rx_hop(dev);
+        }
 
-        result = libusb_handle_events_timeout_completed(dev->libusb_ctx, &tv1, &dev->rx_async_cancel);
+        result = dev->ops->handle_events(dev->transport, &tv1, &dev->rx_async_cancel);
         if (result < 0)
         {
             printf_internal("libusb_handle_events_timeout_completed returned: %d\n", result);
@@ -1927,6 +3773,11 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
         if (FOBOS_CANCELING == dev->rx_async_status)
         {
             printf_internal("FOBOS_CANCELING \n");
+            if (dev->rx_pool)
+            {
+                // the workers hand back the transfers they hold, then all of them can be cancelled
+                fobos_pool_drain(dev->rx_pool);
+            }
             dev->rx_async_status = FOBOS_IDDLE;
             if (!dev->transfer)
             {
@@ -1939,8 +3790,8 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
 
                 if (LIBUSB_TRANSFER_CANCELLED != dev->transfer[i]->status)
                 {
-                    result = libusb_cancel_transfer(dev->transfer[i]);
-                    libusb_handle_events_timeout_completed(dev->libusb_ctx, &tv1, NULL);
+                    result = dev->ops->cancel(dev->transport, dev->transfer[i]);
+                    dev->ops->handle_events(dev->transport, &tv1, NULL);
                     if (result < 0)
                     {
                         printf_internal("libusb_cancel_transfer returned: %d\n", result);
@@ -1951,18 +3802,34 @@ int fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, u
             }
             if (dev->dev_lost || FOBOS_IDDLE == dev->rx_async_status)
             {
-                libusb_handle_events_timeout_completed(dev->libusb_ctx, &tv0, NULL);
+                dev->ops->handle_events(dev->transport, &tv0, NULL);
                 break;
             }
         }
     }
     fobos_fx3_command(dev, 0xE1, 0, 0);       // stop fx
+    if (dev->rx_history)
+    {
+        fobos_history_stop(dev->rx_history);
+    }
+    if (dev->rx_pool)
+    {
+        fobos_rx_stop_workers(dev);
+    }
     fobos_free_buffers(dev);
     free(dev->rx_buff);
     dev->rx_buff = NULL;
     bitset(dev->dev_gpo, FOBOS_DEV_ADC_SDI);
     fobos_rx_set_dev_gpo(dev, dev->dev_gpo);
+    fobos_mutex_lock(&dev->rx_config_lock);
+    if (dev->rx_config_pending)
+    {
+        // queued too late for the stream
+        dev->rx_config_pending = 0;
+        fobos_rx_config_run(dev, &dev->rx_config);
+    }
     dev->rx_async_status = FOBOS_IDDLE;
+    fobos_mutex_unlock(&dev->rx_config_lock);
     dev->rx_async_cancel = 0;
     return result;
 }
@@ -1985,6 +3852,260 @@ int fobos_rx_cancel_async(struct fobos_dev_t * dev)
     return 0;
 }
 //==============================================================================
+// sweep: the hop schedule holds the lo steps of a row rising, then falling, so the
+// band switches and the long jump back happen once per row, not once per step
+struct fobos_sweep
+{
+    struct fobos_dev_t * dev;
+    fobos_sweep_cb_t cb;
+    void * ctx;
+    uint32_t count;                 // rows wanted, 0 - until cancelled
+    uint32_t rows;                  // rows called back
+    uint32_t steps;
+    uint32_t kept;                  // middle bins of a step spectrum that go to the row
+    uint32_t averages;
+    uint32_t dwell;                 // samples of a step, averages blocks
+    double start;                   // the center of the first bin of the row
+    double bin_hz;
+    struct fobos_psd * psd;
+    float * block;                  // fft size complex, filled across callbacks
+    uint32_t block_len;
+    uint64_t next;                  // sample index following the block
+    float * spectrum;               // fft size
+    float * row;                    // steps * kept
+    uint32_t seq;                   // hop events read
+    struct fobos_rx_hop_event event;
+    int measuring;                  // event is the step the samples go to
+    int result;
+};
+//==============================================================================
+// steps and the bins every one of them keeps at the current sample rate
+static int fobos_rx_sweep_plan(struct fobos_dev_t * dev, const struct fobos_sweep_config * config, uint32_t * steps, uint32_t * kept)
+{
+    if (!config || (config->fft_size < 16) || !fobos_fft_supported(config->fft_size) ||
+        (config->window < 0) || (config->window >= FOBOS_WINDOW_COUNT) || (config->averages == 0) ||
+        !(config->usable > 0.0) || (config->usable > 1.0) || !(config->stop > config->start))
+    {
+        return -7;
+    }
+    // the spectra are taken straight from the converted transfers
+    if ((dev->rx_decimation != 1) || (dev->rx_channels != 1))
+    {
+        return -7;
+    }
+    *kept = 2 * (uint32_t)(config->fft_size * config->usable / 2.0);
+    if (*kept == 0)
+    {
+        return -7;
+    }
+    double step_hz = *kept * dev->rx_samplerate / config->fft_size;
+    double count = ceil((config->stop - config->start) / step_hz);
+    if (2.0 * count > FOBOS_RX_MAX_HOPS)
+    {
+        return -7;
+    }
+    *steps = (uint32_t)count;
+    return 0;
+}
+//==============================================================================
+int fobos_rx_get_sweep_bins(struct fobos_dev_t * dev, const struct fobos_sweep_config * config, uint32_t * bins)
+{
+    int result = fobos_check(dev);
+    if (result != 0)
+    {
+        return result;
+    }
+    uint32_t steps;
+    uint32_t kept;
+    if (!bins)
+    {
+        return -7;
+    }
+    result = fobos_rx_sweep_plan(dev, config, &steps, &kept);
+    if (result == 0)
+    {
+        *bins = steps * kept;
+    }
+    return result;
+}
+//==============================================================================
+// the step of the current hop is over, measured or lost to a dropped transfer
+static void fobos_rx_sweep_step_done(struct fobos_sweep * sweep, int measured)
+{
+    uint32_t hop = sweep->event.hop;
+    uint32_t step = (hop < sweep->steps) ? hop : 2 * sweep->steps - 1 - hop;
+    if (measured)
+    {
+        uint32_t size = fobos_psd_size(sweep->psd);
+        fobos_psd_read(sweep->psd, sweep->spectrum);
+        memcpy(sweep->row + (size_t)step * sweep->kept, sweep->spectrum + size / 2 - sweep->kept / 2, sweep->kept * sizeof(float));
+    }
+    sweep->measuring = 0;
+    // the last step of either pass completes a row, a lost step keeps its previous bins
+    if ((hop == sweep->steps - 1) || (hop == 2 * sweep->steps - 1))
+    {
+        sweep->cb(sweep->row, sweep->steps * sweep->kept, sweep->start, sweep->bin_hz, sweep->rows, sweep->ctx);
+        sweep->rows++;
+        if (sweep->count && (sweep->rows >= sweep->count))
+        {
+            fobos_rx_cancel_async(sweep->dev);
+        }
+    }
+}
+//==============================================================================
+static void fobos_rx_sweep_callback(float * buf, uint32_t buf_length, void * ctx)
+{
+    struct fobos_sweep * sweep = (struct fobos_sweep *)ctx;
+    if ((sweep->result != 0) || (sweep->count && (sweep->rows >= sweep->count)))
+    {
+        return;
+    }
+    uint32_t size = fobos_psd_size(sweep->psd);
+    uint64_t first = 0;
+    if (fobos_rx_get_sample_index(sweep->dev, &first) != 0)
+    {
+        // the buffer can not be placed against the dwell of the step, skip it
+        return;
+    }
+    uint64_t end = first + buf_length;
+    uint64_t pos = first;
+    while (pos < end)
+    {
+        if (!sweep->measuring)
+        {
+            if (fobos_rx_read_hop_events(sweep->dev, &sweep->seq, &sweep->event, 1) != 1)
+            {
+                break;
+            }
+            if (sweep->event.result != 0)
+            {
+                sweep->result = sweep->event.result;
+                fobos_rx_cancel_async(sweep->dev);
+                return;
+            }
+            sweep->measuring = 1;
+            sweep->block_len = 0;
+            fobos_psd_reset(sweep->psd);
+        }
+        // the pll settles
+        if (pos < sweep->event.dwell_sample)
+        {
+            pos = sweep->event.dwell_sample;
+            if (pos >= end)
+            {
+                break;
+            }
+        }
+        if ((sweep->block_len > 0) && (pos != sweep->next))
+        {
+            // a dropped transfer split the block
+            sweep->block_len = 0;
+        }
+        if (pos + (size - sweep->block_len) > sweep->event.dwell_sample + sweep->dwell)
+        {
+            fobos_rx_sweep_step_done(sweep, fobos_psd_count(sweep->psd) > 0);
+            continue;
+        }
+        uint32_t n = size - sweep->block_len;
+        if (n > end - pos)
+        {
+            n = (uint32_t)(end - pos);
+        }
+        memcpy(sweep->block + 2 * sweep->block_len, buf + 2 * (pos - first), 2 * n * sizeof(float));
+        sweep->block_len += n;
+        pos += n;
+        sweep->next = pos;
+        if (sweep->block_len == size)
+        {
+            fobos_psd_add(sweep->psd, sweep->block);
+            sweep->block_len = 0;
+            if (fobos_psd_count(sweep->psd) == sweep->averages)
+            {
+                fobos_rx_sweep_step_done(sweep, 1);
+            }
+        }
+    }
+}
+//==============================================================================
+int fobos_rx_sweep(struct fobos_dev_t * dev, const struct fobos_sweep_config * config, fobos_sweep_cb_t cb, void * ctx, uint32_t count)
+{
+    int result = fobos_check(dev);
+#ifdef FOBOS_PRINT_DEBUG
+    printf_internal("%s(%d)\n", __FUNCTION__, count);
+#endif // FOBOS_PRINT_DEBUG
+    if (result != 0)
+    {
+        return result;
+    }
+    struct fobos_sweep sweep;
+    memset(&sweep, 0, sizeof(sweep));
+    if (!cb)
+    {
+        return -7;
+    }
+    result = fobos_rx_sweep_plan(dev, config, &sweep.steps, &sweep.kept);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (FOBOS_IDDLE != dev->rx_async_status)
+    {
+        return -5;
+    }
+    sweep.dev = dev;
+    sweep.cb = cb;
+    sweep.ctx = ctx;
+    sweep.count = count;
+    sweep.averages = config->averages;
+    sweep.dwell = config->fft_size * config->averages;
+    sweep.start = config->start;
+    sweep.bin_hz = dev->rx_samplerate / config->fft_size;
+    sweep.psd = fobos_psd_create(config->fft_size, config->window, dev->rx_convert);
+    sweep.block = (float *)malloc(2 * config->fft_size * sizeof(float));
+    sweep.spectrum = (float *)malloc(config->fft_size * sizeof(float));
+    sweep.row = (float *)malloc((size_t)sweep.steps * sweep.kept * sizeof(float));
+    struct fobos_rx_hop * hops = (struct fobos_rx_hop *)malloc(2 * sweep.steps * sizeof(struct fobos_rx_hop));
+    if (!sweep.psd || !sweep.block || !sweep.spectrum || !sweep.row || !hops)
+    {
+        result = -ENOMEM;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < sweep.steps; i++)
+        {
+            // the kept bins of step i follow those of step i - 1 in the row
+            hops[i].frequency = config->start + ((double)i * sweep.kept + sweep.kept / 2) * sweep.bin_hz;
+            hops[i].dwell = sweep.dwell;
+            hops[i].settle = config->settle;
+            hops[2 * sweep.steps - 1 - i] = hops[i];
+        }
+        for (size_t b = 0; b < (size_t)sweep.steps * sweep.kept; b++)
+        {
+            sweep.row[b] = FOBOS_PSD_FLOOR_DB;
+        }
+        result = fobos_rx_set_hops(dev, hops, 2 * sweep.steps);
+    }
+    if (result == 0)
+    {
+        int format = dev->rx_format;
+        dev->rx_format = FOBOS_FORMAT_FC32;
+        sweep.seq = dev->rx_hop_events_count;
+        result = fobos_rx_read_async(dev, fobos_rx_sweep_callback, &sweep, 0, FOBOS_SWEEP_BUF_LENGTH);
+        dev->rx_format = format;
+        fobos_rx_set_hops(dev, NULL, 0);
+        if (result == 0)
+        {
+            result = sweep.result;
+        }
+    }
+    free(hops);
+    free(sweep.row);
+    free(sweep.spectrum);
+    free(sweep.block);
+    fobos_psd_destroy(sweep.psd);
+    return result;
+}
+//==============================================================================
 const char * fobos_rx_error_name(int error)
 {
     switch (error)
@@ -1993,6 +4114,7 @@ const char * fobos_rx_error_name(int error)
         case -1:   return "No device spesified, dev == NUL";
         case -2:   return "Device is not open, please use fobos_rx_open() first";
         case -5:   return "Device is not ready for reading";
+        case -7:   return "Invalid parameter value";
         default:   return "Unknown error";
     }
 }
@@ -12,6 +12,7 @@
 //  2024.04.08
 //==============================================================================
 #ifndef LIB_FOBOS_H
+#define LIB_FOBOS_H
 #include <stdint.h>
 #ifdef __cplusplus
 extern "C"
@@ -25,7 +26,165 @@ extern "C"
 #define API_EXPORT
 #endif // _WIN32
     struct fobos_dev_t;
+    // buf holds buf_length complex samples in the format set by fobos_rx_set_sample_format()
     typedef void(*fobos_rx_cb_t)(float *buf, uint32_t buf_length, void *ctx);
+    // rx sample formats
+    enum fobos_sample_format
+    {
+        FOBOS_FORMAT_FC32 = 0,  // complex float, +-1.0 full scale (default)
+        FOBOS_FORMAT_SC16,      // complex int16, raw 14 bit, dc removed
+        FOBOS_FORMAT_SC8,       // complex int8, upper 8 of 14 bits, dc removed
+        FOBOS_FORMAT_FC16,      // complex IEEE half float, +-1.0 full scale
+        FOBOS_FORMAT_COUNT,     // number of converted formats
+        FOBOS_FORMAT_RAW = 0x10 // usb transfers as is, 2 x int16, 14 bit offset binary
+    };
+    // dc offset and iq imbalance correction of the raw samples
+    struct fobos_iq_correction
+    {
+        float dc_re;        // raw units, 8192 - mid scale
+        float dc_im;
+        float gain;         // im / re amplitude ratio
+        float phase;        // im vs re quadrature error, radians
+    };
+    // log2 histogram of durations: bins[0] < 1 us, bins[i] 2^(i-1) .. 2^i us, the last bin is open
+#define FOBOS_HIST_BINS 24
+    struct fobos_hist
+    {
+        uint64_t count;
+        uint64_t sum_us;
+        uint64_t max_us;
+        uint64_t bins[FOBOS_HIST_BINS];
+    };
+    // rx streaming counters, accumulated over all fobos_rx_read_async() runs
+    struct fobos_rx_stats
+    {
+        uint64_t buffers;               // completed full size transfers
+        uint64_t rx_failures;           // short transfers, dropped
+        uint64_t transfer_errors;       // failed transfers
+        uint64_t resubmit_errors;       // failed libusb_submit_transfer() of a completed transfer
+        uint64_t worker_drops;          // transfers dropped, every conversion worker buffer was waiting for the consumer
+        struct fobos_hist usb_interval; // between two completed transfers, the usb jitter
+        struct fobos_hist buffer_time;  // conversion and user callback of one transfer
+        uint64_t control_transfers;     // vendor requests, tuning, gains, switches; since fobos_rx_open() or a reset
+        struct fobos_hist retune_time;  // lo changes of fobos_rx_set_frequency()
+    };
+    // rx settings applied as one batch, see fobos_rx_apply_config()
+    struct fobos_rx_config
+    {
+        double frequency;           // Hz, as fobos_rx_set_frequency()
+        unsigned int lna_gain;      // as fobos_rx_set_lna_gain()
+        unsigned int vga_gain;      // as fobos_rx_set_vga_gain()
+        int direct_sampling;        // 0, 1
+        int clock_source;           // 0 - internal, 1 - external
+        double if_offset;           // Hz, as fobos_rx_set_if_offset()
+        int auto_if;                // 0, 1, as fobos_rx_set_auto_if()
+        // filled in by fobos_rx_get_config(), ignored by fobos_rx_apply_config()
+        double actual_frequency;    // the center tuned to, Hz
+        uint32_t batches;           // applied since fobos_rx_open()
+        int result;                 // of the last applied batch, 0 or the error of the step that failed
+        int pending;                // 1 - a batch waits for the streaming thread
+    };
+    // one hop of a schedule, see fobos_rx_set_hops()
+#define FOBOS_RX_MAX_HOPS 1024
+    struct fobos_rx_hop
+    {
+        double frequency;           // Hz, as fobos_rx_set_frequency()
+        uint32_t dwell;             // device samples the frequency is held, > 0
+        uint32_t settle;            // device samples the pll is given to lock after a retune
+    };
+    // where a hop landed in the stream, sample indices as fobos_rx_get_sample_index()
+    struct fobos_rx_hop_event
+    {
+        uint64_t settle_sample;     // the first sample after the retune was issued
+        uint64_t dwell_sample;      // the first sample of the dwell, at the new frequency
+        double frequency;           // the center reached, Hz
+        uint32_t hop;               // index into the schedule
+        int result;                 // of the retune, the old frequency stays if it failed
+    };
+    // power spectrum sweep, see fobos_rx_sweep()
+    struct fobos_sweep_config
+    {
+        double start;               // Hz, the center of the first bin
+        double stop;                // Hz, the bins go on to this one at least
+        uint32_t fft_size;          // power of 2, 16 .. 65536
+        int window;                 // enum fobos_window of fobos_psd.h
+        uint32_t averages;          // spectra averaged per step, >= 1
+        uint32_t settle;            // samples the pll is given to lock after every retune
+        double usable;              // middle fraction of every step spectrum kept, the band edges roll off
+    };
+    // a row of bins in dB full scale, bin k centered at start_hz + k * bin_hz, sweep counts the rows
+    typedef void(*fobos_sweep_cb_t)(const float * power_db, uint32_t bins, double start_hz, double bin_hz, uint32_t sweep, void * ctx);
+    // raw recording state, see fobos_rx_start_recording()
+    enum fobos_record_backend
+    {
+        FOBOS_RECORD_BACKEND_NONE = 0,
+        FOBOS_RECORD_BACKEND_URING,     // the event thread submits the writes, no thread
+        FOBOS_RECORD_BACKEND_THREAD     // a writer thread
+    };
+    struct fobos_rx_recording
+    {
+        int active;                 // 1 - transfers are being recorded
+        int backend;                // enum fobos_record_backend
+        int direct;                 // 1 - O_DIRECT, 0 - through the page cache
+        int error;                  // 0 or the first write error (-errno), nothing is written after it
+        uint64_t bytes;             // taken into the data file
+        uint64_t written;           // of them on disk
+        uint64_t transfers;         // recorded
+        uint64_t dropped;           // transfers every write buffer was queued for
+        uint64_t gaps;              // lost sample annotations
+        uint32_t captures;          // metadata segments: stream start, retunes, gain changes, gaps
+    };
+    // the raw history of fobos_rx_set_history() and the snapshot taken of it last
+#define FOBOS_SNAPSHOT_NOW UINT64_MAX   // fobos_rx_trigger_snapshot() at the sample expected next
+    struct fobos_rx_snapshot
+    {
+        int active;                 // 1 - a snapshot is being written
+        int error;                  // 0 or the first write error (-errno) of the snapshot
+        uint64_t history_start;     // stream index of the oldest sample held
+        uint64_t history_end;       // of the sample expected next
+        uint64_t start;             // window of the snapshot, stream indices, [start, end)
+        uint64_t end;
+        uint64_t samples;           // of the window taken into the data file so far
+        uint64_t gaps;              // lost sample annotations: transfers lost, or overwritten before written
+        uint32_t snapshots;         // taken since the history was set
+    };
+    // recordings fobos_rx_open_replay() plays back
+    enum fobos_replay_format
+    {
+        FOBOS_REPLAY_AUTO = 0,      // SigMF by its datatype, else by the extension: .cf32 .fc32, .cs16 .sc16 .ci16, raw
+        FOBOS_REPLAY_RAW,           // the transfers as the device sent them, cu16_le of fobos_rx_start_recording()
+        FOBOS_REPLAY_SC16,          // ci16_le, FOBOS_FORMAT_SC16 samples
+        FOBOS_REPLAY_FC32           // cf32_le, FOBOS_FORMAT_FC32 samples
+    };
+    struct fobos_replay_info
+    {
+        int format;                 // enum fobos_replay_format, never FOBOS_REPLAY_AUTO
+        double samplerate;          // Hz, 0 - the recording does not tell
+        double frequency;           // the lo of the first capture, Hz, 0 - the recording does not tell
+        unsigned int lna_gain;      // of the first capture
+        unsigned int vga_gain;
+        int direct_sampling;
+        uint32_t captures;          // SigMF captures, 1 for a file without metadata
+        uint64_t samples;           // complex samples in the recording
+        uint64_t position;          // of the next sample replayed
+        uint32_t loops;             // times the replay went back to the start
+    };
+    // simulated device for hardware free streaming and tests, see fobos_sim_enable()
+    struct fobos_sim_config
+    {
+        double tone_hz[2];          // offsets from the center frequency
+        double tone_level[2];       // amplitudes, 1.0 - full scale
+        double noise_level;         // rms per component, 1.0 - full scale
+        double dc_re;               // 1.0 - full scale, the adc channels as in fobos_iq_correction
+        double dc_im;
+        double gain;                // im / re adc channel amplitude ratio
+        double phase;               // im vs re adc channel quadrature error, radians
+        int realtime;               // 1 - transfers complete at the sample rate, 0 - as fast as possible
+        double jitter_us;           // transfers complete up to jitter_us late
+        double short_rate;          // probability of a short transfer
+        uint64_t lost_after;        // transfers until the device disappears, 0 - never
+        uint32_t seed;              // noise, jitter and short transfer random sequence
+    };
     //==========================================================================
     // obtain the software info
     API_EXPORT int CALL_CONV fobos_rx_get_api_info(char * lib_version, char * drv_version);
@@ -37,10 +196,65 @@ extern "C"
     API_EXPORT int CALL_CONV fobos_rx_open(struct fobos_dev_t ** out_dev, uint32_t index);
     // close device
     API_EXPORT int CALL_CONV fobos_rx_close(struct fobos_dev_t * dev);
+    // open a recording as a device: path of a SigMF recording (its .sigmf-meta, .sigmf-data or
+    // their common base) or of a headerless file of format; the file is memory mapped and
+    // fobos_rx_read_async() streams it in transfers through the same conversion, estimator and
+    // decimation as the hardware; the settings act on a simulated device and do not change the
+    // samples, the first capture sets the frequency, sample rate, gains, direct sampling and iq
+    // correction; sc16 and fc32 samples are quantized to the 14 bit adc codes; paced - transfers
+    // complete at the sample rate, 0 - as fast as they are resubmitted; repeat - the replay goes
+    // on from the start at the end, 0 - the device is gone at the end: fobos_rx_read_async()
+    // returns, the tail short of a transfer is not replayed
+    API_EXPORT int CALL_CONV fobos_rx_open_replay(struct fobos_dev_t ** out_dev, const char * path, int format, int paced, int repeat);
+    // the recording of a device fobos_rx_open_replay() opened and how far it got, -7 for others
+    API_EXPORT int CALL_CONV fobos_rx_get_replay_info(struct fobos_dev_t * dev, struct fobos_replay_info * info);
     // get the board info
     API_EXPORT int CALL_CONV fobos_rx_get_board_info(struct fobos_dev_t * dev, char * hw_revision, char * fw_version, char * manufacturer, char * product, char * serial);
-    // set rx frequency, Hz
+    // set rx frequency, Hz: the center of the converted samples, the analog lo goes to value minus
+    // the if offset and the mixer of the conversion shifts the rest, actual includes the mixer
     API_EXPORT int CALL_CONV fobos_rx_set_frequency(struct fobos_dev_t * dev, double value, double * actual);
+    // compute the register plans of count rx frequencies ahead, with the current if offset, for a
+    // scan: fobos_rx_set_frequency() to one of them goes straight to the usb writes; any retune
+    // writes only the registers and switches that differ from the current ones, within one 5 MHz
+    // rffc507x step of the low band that is the max2830 divider alone; up to 1024 plans are kept,
+    // a later frequency may evict an earlier one; -5 if any is out of range, the others are made
+    API_EXPORT int CALL_CONV fobos_rx_prepare_frequencies(struct fobos_dev_t * dev, const double * values, uint32_t count);
+    // obtain the rx settings: the queued batch if one waits, the current ones otherwise
+    API_EXPORT int CALL_CONV fobos_rx_get_config(struct fobos_dev_t * dev, struct fobos_rx_config * config);
+    // change the fields of config that differ from the current settings in one ordered batch
+    // (clock source, direct sampling, auto if, if offset, frequency, gains; the gpo changes in a
+    // row are one write),
+    // safe from any thread: not streaming it runs right away and returns its result, streaming
+    // it is queued and returns 0, the event thread of fobos_rx_read_async() runs it between two
+    // transfers and a newer batch replaces one still queued; fobos_rx_get_config() tells when it
+    // ran and how; -5 frequency out of range, -7 invalid; the single setters act right away
+    // from the calling thread instead
+    API_EXPORT int CALL_CONV fobos_rx_apply_config(struct fobos_dev_t * dev, const struct fobos_rx_config * config);
+    // hop through count frequencies over and over while streaming, NULL / 0 stops: the event thread
+    // retunes between two transfers once the sample counter reached the end of the dwell, so
+    // a dwell runs up to one transfer longer; a retune of the analog lo lands within the transfer in
+    // flight, the dwell starts one transfer plus settle samples after it, a retune by the mixer
+    // (auto if) is exact to the sample; the register plans are made here, a hop only writes;
+    // while a schedule runs it owns the frequency; -5 a frequency out of range, -7 invalid
+    API_EXPORT int CALL_CONV fobos_rx_set_hops(struct fobos_dev_t * dev, const struct fobos_rx_hop * hops, uint32_t count);
+    // copy up to max hop events published after *seq (0 - from the first one) and advance it,
+    // returns the count copied; the last 256 are kept, a slower reader skips the older ones
+    API_EXPORT int CALL_CONV fobos_rx_read_hop_events(struct fobos_dev_t * dev, uint32_t * seq, struct fobos_rx_hop_event * events, uint32_t max);
+    // step the lo across config start .. stop at the current sample rate and call cb with the
+    // averaged spectra of all steps stitched together, rising and falling in turns, so every
+    // band switch happens once per row; blocks like fobos_rx_read_async() until count rows
+    // (0 - until fobos_rx_cancel_async()), replaces the hop schedule, needs decimation and
+    // channels 1 and at most FOBOS_RX_MAX_HOPS / 2 steps
+    API_EXPORT int CALL_CONV fobos_rx_sweep(struct fobos_dev_t * dev, const struct fobos_sweep_config * config, fobos_sweep_cb_t cb, void * ctx, uint32_t count);
+    // the bins of every row fobos_rx_sweep() would call back with at the current sample rate
+    API_EXPORT int CALL_CONV fobos_rx_get_sweep_bins(struct fobos_dev_t * dev, const struct fobos_sweep_config * config, uint32_t * bins);
+    // tune the analog lo value Hz (|value| < samplerate / 2) away from the rx frequency, e.g. to
+    // move the dc spur and the iq image out of the band, the mixer brings the center back to 0 Hz;
+    // 0 (default) - no mixer, the lo is the center
+    API_EXPORT int CALL_CONV fobos_rx_set_if_offset(struct fobos_dev_t * dev, double value);
+    // 1 - fobos_rx_set_frequency() within 0.4 * samplerate * (1 - 1 / decimation) of the lo only
+    // moves the mixer: no usb traffic, no pll relock, phase continuous; 0 (default) - always retune
+    API_EXPORT int CALL_CONV fobos_rx_set_auto_if(struct fobos_dev_t * dev, int enabled);
     // set rx direct sampling mode:  0 - disabled (default),  1 - enabled
     API_EXPORT int CALL_CONV fobos_rx_set_direct_sampling(struct fobos_dev_t * dev, unsigned int enabled);
     // low noise amplifier 0..2
@@ -53,10 +267,95 @@ extern "C"
     API_EXPORT int CALL_CONV fobos_rx_set_samplerate(struct fobos_dev_t * dev, double value, double * actual);
     // set hardware low pass filter (0 .. 2)
     API_EXPORT int CALL_CONV fobos_rx_set_lpf(struct fobos_dev_t * dev, int value);
+    // set rx sample format (enum fobos_sample_format), only while not streaming
+    API_EXPORT int CALL_CONV fobos_rx_set_sample_format(struct fobos_dev_t * dev, int format);
+    // obtain the size of one complex sample of the format, bytes
+    API_EXPORT unsigned int CALL_CONV fobos_rx_sample_size(int format);
+    // conversion threads (0 .. 16) of the converted formats: the usb event thread only queues
+    // completed transfers, the workers convert them in parallel and resubmit them at once, the
+    // callback runs on a worker thread, one buffer at a time in transfer order;
+    // in FOBOS_FORMAT_RAW the event thread converts nothing, instead fobos_rx_convert() and
+    // fobos_rx_decimate() without decimation split longer buffers over 2 or more workers and
+    // return when all parts are done, called from one thread at a time;
+    // decimation and channels filter in one thread, the filters carry their state from one
+    // transfer to the next; 0 - no workers (default), not while streaming
+    API_EXPORT int CALL_CONV fobos_rx_set_workers(struct fobos_dev_t * dev, uint32_t count);
+    // convert count raw samples (FOBOS_FORMAT_RAW) to format using the current iq correction
+    API_EXPORT int CALL_CONV fobos_rx_convert(struct fobos_dev_t * dev, const void * raw, void * dst, uint32_t count, int format);
+    // decimation of the converted formats: 1 (default), 2, 4 .. 64 halfband stages times 1, 3
+    // or 5 by a final fir, on the integer samples before the conversion, 80 % of the output band
+    // pass, aliases attenuated by 72 dB; the callback gets about buf_length / decimation samples
+    // and conversion workers are not used; -7 with the channelizer on, not while streaming
+    API_EXPORT int CALL_CONV fobos_rx_set_decimation(struct fobos_dev_t * dev, uint32_t decimation);
+    // as fobos_rx_convert() through the mixer and the decimation filters, sample - index of the first
+    // raw sample (see fobos_rx_get_sample_index()) for the mixer phase, FOBOS_FORMAT_RAW consumers
+    // call it in stream order from one thread, returns the count of samples written to dst or an error
+    API_EXPORT int CALL_CONV fobos_rx_decimate(struct fobos_dev_t * dev, const void * raw, void * dst, uint32_t count, int format, uint64_t sample);
+    // channelizer of the converted formats: the band split into channels = 2, 4 .. 1024 equally
+    // spaced channels by a polyphase filterbank and an fft, channel k centered k * samplerate /
+    // channels off the center, the upper half of them below it, each at samplerate / channels or,
+    // oversample, at 2 * samplerate / channels; the callback gets the channels interleaved, one
+    // sample of every channel per item group, conversion workers are not used; 1 (default) - off,
+    // -7 with a decimation, not while streaming
+    API_EXPORT int CALL_CONV fobos_rx_set_channels(struct fobos_dev_t * dev, uint32_t channels, int oversample);
+    // as fobos_rx_decimate() through the channelizer, channel k to dst[k], returns the count of
+    // samples written to every channel or an error, -7 without fobos_rx_set_channels()
+    API_EXPORT int CALL_CONV fobos_rx_channelize(struct fobos_dev_t * dev, const void * raw, void * const * dst, uint32_t count, int format, uint64_t sample);
+    // averaged power spectrum of the stream for FOBOS_FORMAT_RAW consumers: blocks of size = 16 ..
+    // 65536 (2^n) corrected and mixed samples, consecutive blocks share overlap samples, windowed
+    // (enum fobos_window), |X|^2 averaged over averages blocks per row, each row size bins in dB
+    // full scale, dc centered as fobos_psd_read(); size 0 - off (default), not while streaming
+    API_EXPORT int CALL_CONV fobos_rx_set_psd(struct fobos_dev_t * dev, uint32_t size, int window, uint32_t overlap, uint32_t averages);
+    // feeds count raw samples in stream order from the stream sample index sample on, as
+    // fobos_rx_decimate(), a gap in the indices drops the partial row; writes the rows completed
+    // to dst, at most count / (size - overlap) / averages + 1 of them, returns their count or an
+    // error, -7 without fobos_rx_set_psd()
+    API_EXPORT int CALL_CONV fobos_rx_psd(struct fobos_dev_t * dev, const void * raw, uint32_t count, float * dst, uint64_t sample);
+    // record the raw transfers the device sends from now on to path + ".sigmf-data" as they are,
+    // 4 bytes per sample, by aligned O_DIRECT writes queued through io_uring (a writer thread where
+    // io_uring is not available), the file reserved for preallocate bytes up front, buffer_ms of
+    // samples queued at most (0 - 500 ms), a transfer finding no free buffer is dropped; while
+    // streaming or not, -5 if a recording runs
+    API_EXPORT int CALL_CONV fobos_rx_start_recording(struct fobos_dev_t * dev, const char * path, uint64_t preallocate, double buffer_ms);
+    // writes what is queued and path + ".sigmf-meta": rate, and for every capture the frequency, gains
+    // and iq correction, a new capture on every retune, gain change and gap, an annotation with the
+    // lost samples count for every gap; returns 0 or the first write error, -7 if none runs
+    API_EXPORT int CALL_CONV fobos_rx_stop_recording(struct fobos_dev_t * dev);
+    // the running recording or the last one stopped
+    API_EXPORT int CALL_CONV fobos_rx_get_recording(struct fobos_dev_t * dev, struct fobos_rx_recording * status);
+    // keep the last size bytes of raw transfers (4 per sample) in memory for fobos_rx_trigger_snapshot(),
+    // 0 - none; not while streaming (-5), -ENOMEM if it can not be allocated
+    API_EXPORT int CALL_CONV fobos_rx_set_history(struct fobos_dev_t * dev, uint64_t size);
+    // write the window [sample - pre, sample + post) of the stream (sample indices as
+    // fobos_rx_get_sample_index(), FOBOS_SNAPSHOT_NOW - the sample expected next) to path +
+    // ".sigmf-data" and ".sigmf-meta" from a writer thread while streaming goes on: the part the
+    // history no longer holds is cut off, the part not received yet is waited for until the stream
+    // stops; -7 without a history, -5 while the previous snapshot is being written
+    API_EXPORT int CALL_CONV fobos_rx_trigger_snapshot(struct fobos_dev_t * dev, const char * path, uint64_t sample, uint64_t pre, uint64_t post);
+    // the history and the snapshot being written or written last
+    API_EXPORT int CALL_CONV fobos_rx_get_snapshot(struct fobos_dev_t * dev, struct fobos_rx_snapshot * status);
+    // obtain the iq correction applied by the conversion
+    API_EXPORT int CALL_CONV fobos_rx_get_iq_correction(struct fobos_dev_t * dev, struct fobos_iq_correction * correction);
+    // replace the iq correction, the estimator keeps tracking from it
+    API_EXPORT int CALL_CONV fobos_rx_set_iq_correction(struct fobos_dev_t * dev, const struct fobos_iq_correction * correction);
+    // feed count raw samples to the dc & iq imbalance estimator and publish the new correction,
+    // done internally for the converted formats, FOBOS_FORMAT_RAW consumers call it from one
+    // (preferably low priority) thread with a decimated part of the stream
+    API_EXPORT int CALL_CONV fobos_rx_update_iq_estimate(struct fobos_dev_t * dev, const void * raw, uint32_t count);
+    // obtain the rx streaming counters, a snapshot taken while streaming may be slightly inconsistent
+    API_EXPORT int CALL_CONV fobos_rx_get_stats(struct fobos_dev_t * dev, struct fobos_rx_stats * stats);
+    // zero the rx streaming counters
+    API_EXPORT int CALL_CONV fobos_rx_reset_stats(struct fobos_dev_t * dev);
+    // add a duration to a histogram, us
+    API_EXPORT void CALL_CONV fobos_hist_add(struct fobos_hist * hist, uint64_t value_us);
     // statr the iq rx streaming
     API_EXPORT int CALL_CONV fobos_rx_read_async(struct fobos_dev_t * dev, fobos_rx_cb_t cb, void *ctx, uint32_t buf_count, uint32_t buf_length);
     // stop the iq rx streaming
     API_EXPORT int CALL_CONV fobos_rx_cancel_async(struct fobos_dev_t * dev);
+    // from the rx callback: index of the first sample of its buffer, counted from the start of the
+    // stream in device samples (before any decimation), the samples of dropped and short transfers
+    // count too, a gap is a loss
+    API_EXPORT int CALL_CONV fobos_rx_get_sample_index(struct fobos_dev_t * dev, uint64_t * index);
     // set user general purpose output bits (0x00 .. 0x3f)
     API_EXPORT int CALL_CONV fobos_rx_set_user_gpo(struct fobos_dev_t * dev, uint8_t value);
     // clock source: 0 - internal (default), 1- extrnal
@@ -65,6 +364,12 @@ extern "C"
     API_EXPORT int CALL_CONV fobos_max2830_set_frequency(struct fobos_dev_t * dev, double value, double * actual);
     // explicitly set rffc507x frequency, MHz (25 .. 5400)
     API_EXPORT int CALL_CONV fobos_rffc507x_set_lo_frequency(struct fobos_dev_t * dev, int lo_freq_mhz, uint64_t * tune_freq_hz);
+    // defaults: a -20 dBFS tone at +1 MHz, -50 dBFS noise, small dc and iq errors, real time
+    API_EXPORT void CALL_CONV fobos_sim_config_init(struct fobos_sim_config * config);
+    // replace the hardware by one simulated device (index 0), NULL returns to the hardware,
+    // affects subsequent fobos_rx_get_device_count(), fobos_rx_list_devices() and fobos_rx_open();
+    // the FOBOS_SIM environment variable set to 1 enables the defaults
+    API_EXPORT int CALL_CONV fobos_sim_enable(const struct fobos_sim_config * config);
     // obtain error text by code
     API_EXPORT const char * CALL_CONV fobos_rx_error_name(int error);
     //==========================================================================
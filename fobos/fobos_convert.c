@@ -0,0 +1,1618 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Raw int16 -> output sample format conversion kernels
+//==============================================================================
+// All kernels must produce output bit-identical to the scalar ones.
+// The kernels only apply the fixed correction of fobos_convert_params, the dc
+// and iq imbalance are estimated elsewhere (fobos_iq_estimator) and published
+// between calls.
+// Build with -ffp-contract=off so that mul + add is never fused.
+//==============================================================================
+#include <math.h>
+#include <string.h>
+#include "fobos_convert.h"
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FOBOS_CONVERT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define FOBOS_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define FOBOS_TARGET(x) __attribute__((target(x)))
+#else
+#define FOBOS_TARGET(x)
+#endif
+//==============================================================================
+#define FOBOS_SAMPLE_MASK 0x3FFF
+#define FOBOS_MID_SCALE 8192.0f
+#define FOBOS_MAX_PHASE 0.5 // radians, larger estimates are clipped
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+//==============================================================================
+static int fobos_convert_always(void)
+{
+    return 1;
+}
+//==============================================================================
+void fobos_iq_correction_init(struct fobos_iq_correction * correction)
+{
+    correction->dc_re = FOBOS_MID_SCALE;
+    correction->dc_im = FOBOS_MID_SCALE;
+    correction->gain = 1.0f;
+    correction->phase = 0.0f;
+}
+//==============================================================================
+// re = scale * (x - dc_re)
+// im = scale * ((y - dc_im) / (gain * cos(phase)) - tan(phase) * (x - dc_re))
+void fobos_convert_params_make(struct fobos_convert_params * params, const struct fobos_iq_correction * correction, float scale, int swap_iq)
+{
+    double gain = correction->gain > 0.0f ? correction->gain : 1.0;
+    double phase = correction->phase;
+    float re_x = scale;
+    float im_y = (float)(scale / (gain * cos(phase)));
+    float im_x = (float)(-scale * tan(phase));
+    float re_offset = -re_x * correction->dc_re;
+    float im_offset = -(im_y * correction->dc_im + im_x * correction->dc_re);
+    if (swap_iq)
+    {
+        params->a[0] = im_x;
+        params->b[0] = im_y;
+        params->offset[0] = im_offset;
+        params->a[1] = 0.0f;
+        params->b[1] = re_x;
+        params->offset[1] = re_offset;
+    }
+    else
+    {
+        params->a[0] = re_x;
+        params->b[0] = 0.0f;
+        params->offset[0] = re_offset;
+        params->a[1] = im_y;
+        params->b[1] = im_x;
+        params->offset[1] = im_offset;
+    }
+}
+//==============================================================================
+void fobos_iq_estimator_init(struct fobos_iq_estimator * estimator, double k)
+{
+    memset(estimator, 0, sizeof(*estimator));
+    estimator->k = k;
+}
+//==============================================================================
+void fobos_iq_estimator_retune(struct fobos_iq_estimator * estimator)
+{
+    estimator->mean_updates = 0;
+}
+//==============================================================================
+static double fobos_iq_estimator_weight(double k, uint32_t updates)
+{
+    double w = 1.0 / (double)(updates + 1);
+    return w > k ? w : k;
+}
+//==============================================================================
+void fobos_iq_estimator_update(struct fobos_iq_estimator * estimator, const struct fobos_convert_sums * sums)
+{
+    if (sums->count < 2)
+    {
+        return;
+    }
+    double n = (double)sums->count;
+    double mean_re = (double)sums->sum_re / n;
+    double mean_im = (double)sums->sum_im / n;
+    // exact integer sums, the moments about the block mean lose nothing in double
+    double var_re = (double)sums->sum2_re / n - mean_re * mean_re;
+    double var_im = (double)sums->sum2_im / n - mean_im * mean_im;
+    double cov = (double)sums->sum_re_im / n - mean_re * mean_im;
+    double w = fobos_iq_estimator_weight(estimator->k, estimator->mean_updates);
+    estimator->mean_re += w * (mean_re - estimator->mean_re);
+    estimator->mean_im += w * (mean_im - estimator->mean_im);
+    w = fobos_iq_estimator_weight(estimator->k, estimator->updates);
+    estimator->var_re += w * (var_re - estimator->var_re);
+    estimator->var_im += w * (var_im - estimator->var_im);
+    estimator->cov += w * (cov - estimator->cov);
+    estimator->mean_updates++;
+    estimator->updates++;
+}
+//==============================================================================
+int fobos_iq_estimator_get(const struct fobos_iq_estimator * estimator, struct fobos_iq_correction * correction)
+{
+    if (estimator->updates == 0)
+    {
+        return -1;
+    }
+    correction->dc_re = (float)estimator->mean_re;
+    correction->dc_im = (float)estimator->mean_im;
+    correction->gain = 1.0f;
+    correction->phase = 0.0f;
+    if ((estimator->var_re > 0.0) && (estimator->var_im > 0.0))
+    {
+        // im = gain * (sin(phase) * re + cos(phase) * q) for a circular signal
+        double rho = estimator->cov / sqrt(estimator->var_re * estimator->var_im);
+        double phase = asin(rho < -1.0 ? -1.0 : (rho > 1.0 ? 1.0 : rho));
+        if (phase > FOBOS_MAX_PHASE) phase = FOBOS_MAX_PHASE;
+        if (phase < -FOBOS_MAX_PHASE) phase = -FOBOS_MAX_PHASE;
+        correction->gain = (float)sqrt(estimator->var_im / estimator->var_re);
+        correction->phase = (float)phase;
+    }
+    return 0;
+}
+//==============================================================================
+// float -> half, round to nearest even, same result as the F16C instructions
+// for all finite values (F. Giesen, float_to_half_fast3_rtne)
+#define FOBOS_HALF_F32_INFTY (255u << 23)
+#define FOBOS_HALF_F16_MAX ((127u + 16u) << 23)
+#define FOBOS_HALF_DENORM_MAGIC (((127u - 15u) + (23u - 10u) + 1u) << 23)
+#define FOBOS_HALF_NORMAL_MIN (113u << 23)
+#define FOBOS_HALF_BIAS (((uint32_t)(15 - 127) << 23) + 0xfffu)
+uint16_t fobos_float_to_half(float value)
+{
+    uint32_t u;
+    uint32_t o;
+    memcpy(&u, &value, sizeof(u));
+    uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+    if (u >= FOBOS_HALF_F16_MAX)
+    {
+        o = (u > FOBOS_HALF_F32_INFTY) ? 0x7e00 : 0x7c00;
+    }
+    else if (u < FOBOS_HALF_NORMAL_MIN)
+    {
+        uint32_t magic_u = FOBOS_HALF_DENORM_MAGIC;
+        float f;
+        float magic;
+        memcpy(&f, &u, sizeof(f));
+        memcpy(&magic, &magic_u, sizeof(magic));
+        f += magic;
+        memcpy(&o, &f, sizeof(o));
+        o -= FOBOS_HALF_DENORM_MAGIC;
+    }
+    else
+    {
+        uint32_t mant_odd = (u >> 13) & 1;
+        u += FOBOS_HALF_BIAS;
+        u += mant_odd;
+        o = u >> 13;
+    }
+    return (uint16_t)(o | (sign >> 16));
+}
+//==============================================================================
+// the correction of one complex sample shared by all kernels, the vector
+// kernels evaluate the very same expression in the very same order
+static inline void fobos_convert_apply(const struct fobos_convert_params * params, const int16_t * src, float out[2])
+{
+    float x = (float)(src[0] & FOBOS_SAMPLE_MASK);
+    float y = (float)(src[1] & FOBOS_SAMPLE_MASK);
+    out[0] = (x * params->a[0] + y * params->b[0]) + params->offset[0];
+    out[1] = (y * params->a[1] + x * params->b[1]) + params->offset[1];
+}
+//==============================================================================
+static inline int16_t fobos_convert_sat16(float value)
+{
+    long v = lrintf(value);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    return (int16_t)v;
+}
+//==============================================================================
+static inline int8_t fobos_convert_sat8(float value)
+{
+    long v = lrintf(value);
+    if (v > 127) v = 127;
+    if (v < -128) v = -128;
+    return (int8_t)v;
+}
+//==============================================================================
+// scalar reference kernels
+//==============================================================================
+static void fobos_convert_scalar_fc32(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    float * out = (float *)dst;
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        fobos_convert_apply(params, src, out);
+        src += 2;
+        out += 2;
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_sc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int16_t * out = (int16_t *)dst;
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        float v[2];
+        fobos_convert_apply(params, src, v);
+        out[0] = fobos_convert_sat16(v[0]);
+        out[1] = fobos_convert_sat16(v[1]);
+        src += 2;
+        out += 2;
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_sc8(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int8_t * out = (int8_t *)dst;
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        float v[2];
+        fobos_convert_apply(params, src, v);
+        out[0] = fobos_convert_sat8(v[0]);
+        out[1] = fobos_convert_sat8(v[1]);
+        src += 2;
+        out += 2;
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_fc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    uint16_t * out = (uint16_t *)dst;
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        float v[2];
+        fobos_convert_apply(params, src, v);
+        out[0] = fobos_float_to_half(v[0]);
+        out[1] = fobos_float_to_half(v[1]);
+        src += 2;
+        out += 2;
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_sums(const int16_t * src, size_t complex_samples_count, struct fobos_convert_sums * sums)
+{
+    uint64_t sum_re = 0;
+    uint64_t sum_im = 0;
+    uint64_t sum2_re = 0;
+    uint64_t sum2_im = 0;
+    uint64_t sum_re_im = 0;
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        uint32_t re = src[0] & FOBOS_SAMPLE_MASK;
+        uint32_t im = src[1] & FOBOS_SAMPLE_MASK;
+        sum_re += re;
+        sum_im += im;
+        sum2_re += re * re;
+        sum2_im += im * im;
+        sum_re_im += re * im;
+        src += 2;
+    }
+    sums->count += complex_samples_count;
+    sums->sum_re += (int64_t)sum_re;
+    sums->sum_im += (int64_t)sum_im;
+    sums->sum2_re += sum2_re;
+    sums->sum2_im += sum2_im;
+    sums->sum_re_im += sum_re_im;
+}
+//==============================================================================
+static inline int16_t fobos_fir_sat16(int32_t acc)
+{
+    acc >>= 15;
+    if (acc > 32767) acc = 32767;
+    if (acc < -32768) acc = -32768;
+    return (int16_t)acc;
+}
+//==============================================================================
+// the two samples of every tap pair as pointers and the pair of coefficients as
+// one int32 (coeff[1] high), so the vector loops do no table walks
+static void fobos_fir_prepare(const struct fobos_fir * fir, const int16_t * const * phases, const int16_t ** a, const int16_t ** b, int32_t * c)
+{
+    for (uint32_t i = 0; i < fir->pairs_count; i++)
+    {
+        const struct fobos_fir_pair * pair = &fir->pairs[i];
+        a[i] = phases[pair->phase[0]] + 2 * pair->offset[0];
+        b[i] = phases[pair->phase[1]] + 2 * pair->offset[1];
+        c[i] = (int32_t)(((uint32_t)(uint16_t)pair->coeff[1] << 16) | (uint16_t)pair->coeff[0]);
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_fir(const struct fobos_fir * fir, const int16_t * const * phases, int16_t * dst, size_t complex_samples_count)
+{
+    for (size_t n = 0; n < complex_samples_count; n++)
+    {
+        int32_t acc_re = 1 << 14;
+        int32_t acc_im = 1 << 14;
+        for (uint32_t i = 0; i < fir->pairs_count; i++)
+        {
+            const struct fobos_fir_pair * pair = &fir->pairs[i];
+            for (int k = 0; k < 2; k++)
+            {
+                const int16_t * x = phases[pair->phase[k]] + 2 * (n + pair->offset[k]);
+                acc_re += pair->coeff[k] * x[0];
+                acc_im += pair->coeff[k] * x[1];
+            }
+        }
+        dst[0] = fobos_fir_sat16(acc_re);
+        dst[1] = fobos_fir_sat16(acc_im);
+        dst += 2;
+    }
+}
+//==============================================================================
+// the tail of a vector fir, phases moved on to the first sample left
+static void fobos_fir_tail(const struct fobos_fir * fir, const int16_t * const * phases, int16_t * dst, size_t done, size_t complex_samples_count)
+{
+    const int16_t * tail[FOBOS_FIR_MAX_DECIMATION];
+    for (uint32_t p = 0; p < fir->decimation; p++)
+    {
+        tail[p] = phases[p] + 2 * done;
+    }
+    fobos_convert_scalar_fir(fir, tail, dst + 2 * done, complex_samples_count - done);
+}
+//==============================================================================
+// one complex sample of a non kernel path in format
+static inline void fobos_convert_store(const float v[2], void * dst, size_t i, int format)
+{
+    switch (format)
+    {
+        case FOBOS_FORMAT_FC32:
+            ((float *)dst)[2 * i] = v[0];
+            ((float *)dst)[2 * i + 1] = v[1];
+            break;
+        case FOBOS_FORMAT_SC16:
+            ((int16_t *)dst)[2 * i] = fobos_convert_sat16(v[0]);
+            ((int16_t *)dst)[2 * i + 1] = fobos_convert_sat16(v[1]);
+            break;
+        case FOBOS_FORMAT_SC8:
+            ((int8_t *)dst)[2 * i] = fobos_convert_sat8(v[0]);
+            ((int8_t *)dst)[2 * i + 1] = fobos_convert_sat8(v[1]);
+            break;
+        case FOBOS_FORMAT_FC16:
+            ((uint16_t *)dst)[2 * i] = fobos_float_to_half(v[0]);
+            ((uint16_t *)dst)[2 * i + 1] = fobos_float_to_half(v[1]);
+            break;
+    }
+}
+//==============================================================================
+// raw = filtered / 4 + mid scale folded into the params, then as fobos_convert_apply()
+void fobos_convert_filtered(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count, int format)
+{
+    struct fobos_convert_params p;
+    for (int k = 0; k < 2; k++)
+    {
+        p.a[k] = params->a[k] * 0.25f;
+        p.b[k] = params->b[k] * 0.25f;
+        p.offset[k] = params->offset[k] + FOBOS_MID_SCALE * (params->a[k] + params->b[k]);
+    }
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        float x = (float)src[0];
+        float y = (float)src[1];
+        float v[2];
+        v[0] = (x * p.a[0] + y * p.b[0]) + p.offset[0];
+        v[1] = (y * p.a[1] + x * p.b[1]) + p.offset[1];
+        fobos_convert_store(v, dst, i, format);
+        src += 2;
+    }
+}
+//==============================================================================
+void fobos_convert_pack(const float * src, void * dst, size_t complex_samples_count, int format)
+{
+    for (size_t i = 0; i < complex_samples_count; i++)
+    {
+        fobos_convert_store(src + 2 * i, dst, i, format);
+    }
+}
+//==============================================================================
+// e^(j 2 pi phase / 2^32) = coarse[phase >> 22] * fine[(phase >> 12) & 1023] for the phase
+// rounded to 20 bits, times 1 + j d for the 12 bit rest d (|d| <= 3e-6 rad): the error
+// d^2 / 2 is far below the float rounding
+#define FOBOS_NCO_TABLE_BITS 10
+#define FOBOS_NCO_TABLE_SIZE (1 << FOBOS_NCO_TABLE_BITS)
+static float fobos_nco_coarse[2 * FOBOS_NCO_TABLE_SIZE];
+static float fobos_nco_fine[2 * FOBOS_NCO_TABLE_SIZE];
+static volatile int fobos_nco_tables_ready = 0;
+//==============================================================================
+static void fobos_nco_tables(void)
+{
+    if (fobos_nco_tables_ready)
+    {
+        return;
+    }
+    // every caller writes the very same values, a race is harmless
+    for (int i = 0; i < FOBOS_NCO_TABLE_SIZE; i++)
+    {
+        double coarse = 2.0 * M_PI * i / FOBOS_NCO_TABLE_SIZE;
+        double fine = coarse / FOBOS_NCO_TABLE_SIZE;
+        fobos_nco_coarse[2 * i] = (float)cos(coarse);
+        fobos_nco_coarse[2 * i + 1] = (float)sin(coarse);
+        fobos_nco_fine[2 * i] = (float)cos(fine);
+        fobos_nco_fine[2 * i + 1] = (float)sin(fine);
+    }
+    fobos_nco_tables_ready = 1;
+}
+//==============================================================================
+void fobos_nco_make(struct fobos_nco * nco, double frequency)
+{
+    fobos_nco_tables();
+    frequency -= floor(frequency);
+    nco->step = (uint32_t)(uint64_t)llround(frequency * 4294967296.0);
+    for (int k = 0; k < FOBOS_NCO_BLOCK; k++)
+    {
+        uint32_t phase = nco->step * (uint32_t)k;
+        double angle = 2.0 * M_PI * phase / 4294967296.0;
+        nco->rot[2 * k] = (float)cos(angle);
+        nco->rot[2 * k + 1] = (float)sin(angle);
+    }
+}
+//==============================================================================
+// the phasor at the start of a block, shared by all nco kernels
+static inline void fobos_nco_phasor(uint32_t phase, float w[2])
+{
+    uint32_t index = (phase + (1u << 11)) >> 12;
+    const float * c = fobos_nco_coarse + 2 * (index >> FOBOS_NCO_TABLE_BITS);
+    const float * f = fobos_nco_fine + 2 * (index & (FOBOS_NCO_TABLE_SIZE - 1));
+    float u0 = c[0] * f[0] - c[1] * f[1];
+    float u1 = c[0] * f[1] + c[1] * f[0];
+    float d = (float)(int32_t)(phase - (index << 12)) * (float)(2.0 * M_PI / 4294967296.0);
+    w[0] = u0 - u1 * d;
+    w[1] = u1 + u0 * d;
+}
+//==============================================================================
+static void fobos_convert_scalar_nco(const struct fobos_nco * nco, uint32_t phase, float * iq, int16_t * sc16, size_t complex_samples_count)
+{
+    for (size_t n = 0; n < complex_samples_count; n += FOBOS_NCO_BLOCK)
+    {
+        float w[2];
+        fobos_nco_phasor(phase, w);
+        size_t len = complex_samples_count - n;
+        if (len > FOBOS_NCO_BLOCK)
+        {
+            len = FOBOS_NCO_BLOCK;
+        }
+        for (size_t k = 0; k < len; k++)
+        {
+            const float * r = nco->rot + 2 * k;
+            float p0 = w[0] * r[0] - w[1] * r[1];
+            float p1 = w[0] * r[1] + w[1] * r[0];
+            float x = iq[0];
+            float y = iq[1];
+            float re = x * p0 - y * p1;
+            float im = x * p1 + y * p0;
+            if (sc16)
+            {
+                sc16[0] = fobos_convert_sat16(re);
+                sc16[1] = fobos_convert_sat16(im);
+                sc16 += 2;
+            }
+            else
+            {
+                iq[0] = re;
+                iq[1] = im;
+            }
+            iq += 2;
+        }
+        phase += nco->step * FOBOS_NCO_BLOCK;
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_pfb(const float * taps, const float * x, float * u, size_t width, size_t segments_count)
+{
+    for (size_t i = 0; i < width; i++)
+    {
+        u[i] = taps[i] * x[i];
+    }
+    for (size_t j = 1; j < segments_count; j++)
+    {
+        const float * t = taps + j * width;
+        const float * v = x + j * width;
+        for (size_t i = 0; i < width; i++)
+        {
+            u[i] = u[i] + t[i] * v[i];
+        }
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_fft(const float * w, float * x, size_t half, size_t size)
+{
+    for (size_t start = 0; start < size; start += 2 * half)
+    {
+        float * a = x + 2 * start;
+        float * b = a + 2 * half;
+        for (size_t j = 0; j < half; j++)
+        {
+            float re = b[2 * j] * w[2 * j] - b[2 * j + 1] * w[2 * j + 1];
+            float im = b[2 * j] * w[2 * j + 1] + b[2 * j + 1] * w[2 * j];
+            b[2 * j] = a[2 * j] - re;
+            b[2 * j + 1] = a[2 * j + 1] - im;
+            a[2 * j] = a[2 * j] + re;
+            a[2 * j + 1] = a[2 * j + 1] + im;
+        }
+    }
+}
+//==============================================================================
+static void fobos_convert_scalar_power(const float * y, float * power, size_t complex_samples_count)
+{
+    for (size_t k = 0; k < complex_samples_count; k++)
+    {
+        power[k] = power[k] + (y[2 * k] * y[2 * k] + y[2 * k + 1] * y[2 * k + 1]);
+    }
+}
+#ifdef FOBOS_CONVERT_X86
+//==============================================================================
+#if defined(__GNUC__) || defined(__clang__)
+static int fobos_convert_has_sse2(void)
+{
+    return __builtin_cpu_supports("sse2");
+}
+static int fobos_convert_has_avx2(void)
+{
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+}
+static int fobos_convert_has_avx512(void)
+{
+    return __builtin_cpu_supports("avx512f");
+}
+#else
+static int fobos_convert_cpuid(int leaf, int subleaf, int reg, int bit)
+{
+    int regs[4];
+    __cpuidex(regs, leaf, subleaf);
+    return (regs[reg] >> bit) & 1;
+}
+static int fobos_convert_os_saves(unsigned long long mask)
+{
+    if (!fobos_convert_cpuid(1, 0, 2, 27)) // osxsave
+    {
+        return 0;
+    }
+    return (_xgetbv(0) & mask) == mask;
+}
+static int fobos_convert_has_sse2(void)
+{
+    return fobos_convert_cpuid(1, 0, 3, 26);
+}
+static int fobos_convert_has_avx2(void)
+{
+    return fobos_convert_os_saves(0x06) && fobos_convert_cpuid(7, 0, 1, 5) && fobos_convert_cpuid(1, 0, 2, 29);
+}
+static int fobos_convert_has_avx512(void)
+{
+    return fobos_convert_os_saves(0xE6) && fobos_convert_cpuid(7, 0, 1, 16);
+}
+#endif
+//==============================================================================
+// sse2
+//==============================================================================
+// a (re, im) pair broadcast to all pairs of a vector
+static inline double fobos_convert_pair(float re, float im)
+{
+    float pair[2] = { re, im };
+    double result;
+    memcpy(&result, pair, sizeof(result));
+    return result;
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static inline __m128 fobos_sse2_apply(__m128 v, __m128 a, __m128 b, __m128 offset)
+{
+    __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v, a), _mm_mul_ps(swapped, b)), offset);
+}
+//==============================================================================
+// 8 corrected complex samples
+FOBOS_TARGET("sse2")
+static inline void fobos_sse2_chunk(const int16_t * src, const __m128 p[3], __m128 v[4])
+{
+    const __m128i mask = _mm_set1_epi16(FOBOS_SAMPLE_MASK);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i raw0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)src), mask);
+    __m128i raw1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + 8)), mask);
+    v[0] = fobos_sse2_apply(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw0, zero)), p[0], p[1], p[2]);
+    v[1] = fobos_sse2_apply(_mm_cvtepi32_ps(_mm_unpackhi_epi16(raw0, zero)), p[0], p[1], p[2]);
+    v[2] = fobos_sse2_apply(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw1, zero)), p[0], p[1], p[2]);
+    v[3] = fobos_sse2_apply(_mm_cvtepi32_ps(_mm_unpackhi_epi16(raw1, zero)), p[0], p[1], p[2]);
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static inline void fobos_sse2_params(const struct fobos_convert_params * params, __m128 p[3])
+{
+    p[0] = _mm_castpd_ps(_mm_set1_pd(fobos_convert_pair(params->a[0], params->a[1])));
+    p[1] = _mm_castpd_ps(_mm_set1_pd(fobos_convert_pair(params->b[0], params->b[1])));
+    p[2] = _mm_castpd_ps(_mm_set1_pd(fobos_convert_pair(params->offset[0], params->offset[1])));
+}
+//==============================================================================
+// vector form of fobos_float_to_half(), halves are sign extended to int32
+FOBOS_TARGET("sse2")
+static inline __m128i fobos_sse2_half(__m128 value)
+{
+    __m128i u = _mm_castps_si128(value);
+    __m128i sign = _mm_and_si128(u, _mm_set1_epi32((int32_t)0x80000000u));
+    u = _mm_xor_si128(u, sign);
+    __m128i magic = _mm_set1_epi32(FOBOS_HALF_DENORM_MAGIC);
+    __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(u), _mm_castsi128_ps(magic))), magic);
+    __m128i mant_odd = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+    __m128i normal = _mm_add_epi32(u, _mm_set1_epi32((int32_t)FOBOS_HALF_BIAS));
+    normal = _mm_srli_epi32(_mm_add_epi32(normal, mant_odd), 13);
+    __m128i is_denorm = _mm_cmplt_epi32(u, _mm_set1_epi32(FOBOS_HALF_NORMAL_MIN));
+    __m128i o = _mm_or_si128(_mm_and_si128(is_denorm, denorm), _mm_andnot_si128(is_denorm, normal));
+    __m128i is_big = _mm_cmpgt_epi32(u, _mm_set1_epi32(FOBOS_HALF_F16_MAX - 1));
+    __m128i is_nan = _mm_cmpgt_epi32(u, _mm_set1_epi32(FOBOS_HALF_F32_INFTY));
+    __m128i big = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x0200)));
+    o = _mm_or_si128(_mm_and_si128(is_big, big), _mm_andnot_si128(is_big, o));
+    o = _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+    return _mm_srai_epi32(_mm_slli_epi32(o, 16), 16);
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_fc32(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    float * out = (float *)dst;
+    __m128 p[3];
+    fobos_sse2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m128 v[4];
+        fobos_sse2_chunk(src, p, v);
+        _mm_storeu_ps(out + 0, v[0]);
+        _mm_storeu_ps(out + 4, v[1]);
+        _mm_storeu_ps(out + 8, v[2]);
+        _mm_storeu_ps(out + 12, v[3]);
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_fc32(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_sc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int16_t * out = (int16_t *)dst;
+    __m128 p[3];
+    fobos_sse2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m128 v[4];
+        fobos_sse2_chunk(src, p, v);
+        _mm_storeu_si128((__m128i *)out, _mm_packs_epi32(_mm_cvtps_epi32(v[0]), _mm_cvtps_epi32(v[1])));
+        _mm_storeu_si128((__m128i *)(out + 8), _mm_packs_epi32(_mm_cvtps_epi32(v[2]), _mm_cvtps_epi32(v[3])));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_sc8(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int8_t * out = (int8_t *)dst;
+    __m128 p[3];
+    fobos_sse2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m128 v[4];
+        fobos_sse2_chunk(src, p, v);
+        __m128i lo = _mm_packs_epi32(_mm_cvtps_epi32(v[0]), _mm_cvtps_epi32(v[1]));
+        __m128i hi = _mm_packs_epi32(_mm_cvtps_epi32(v[2]), _mm_cvtps_epi32(v[3]));
+        _mm_storeu_si128((__m128i *)out, _mm_packs_epi16(lo, hi));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc8(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_fc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    uint16_t * out = (uint16_t *)dst;
+    __m128 p[3];
+    fobos_sse2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m128 v[4];
+        fobos_sse2_chunk(src, p, v);
+        _mm_storeu_si128((__m128i *)out, _mm_packs_epi32(fobos_sse2_half(v[0]), fobos_sse2_half(v[1])));
+        _mm_storeu_si128((__m128i *)(out + 8), _mm_packs_epi32(fobos_sse2_half(v[2]), fobos_sse2_half(v[3])));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_fc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+// up to 8 squares of 14 bit samples fit a 32 bit lane, then the lanes are widened
+#define FOBOS_SUMS_STEPS 8
+FOBOS_TARGET("sse2")
+static inline __m128i fobos_sse2_widen(__m128i sum, __m128i acc)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_add_epi64(sum, _mm_add_epi64(_mm_unpacklo_epi32(acc, zero), _mm_unpackhi_epi32(acc, zero)));
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_sums(const int16_t * src, size_t complex_samples_count, struct fobos_convert_sums * sums)
+{
+    const __m128i mask = _mm_set1_epi32(FOBOS_SAMPLE_MASK);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum[5] = { zero, zero, zero, zero, zero };
+    size_t blocks_count = complex_samples_count / 4;
+    while (blocks_count > 0)
+    {
+        size_t steps = blocks_count < FOBOS_SUMS_STEPS ? blocks_count : FOBOS_SUMS_STEPS;
+        __m128i acc[5] = { zero, zero, zero, zero, zero };
+        for (size_t i = 0; i < steps; i++)
+        {
+            __m128i raw = _mm_loadu_si128((const __m128i *)src);
+            __m128i re = _mm_and_si128(raw, mask);
+            __m128i im = _mm_and_si128(_mm_srli_epi32(raw, 16), mask);
+            acc[0] = _mm_add_epi32(acc[0], re);
+            acc[1] = _mm_add_epi32(acc[1], im);
+            acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(re, re));
+            acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(im, im));
+            acc[4] = _mm_add_epi32(acc[4], _mm_madd_epi16(re, im));
+            src += 8;
+        }
+        for (int j = 0; j < 5; j++)
+        {
+            sum[j] = fobos_sse2_widen(sum[j], acc[j]);
+        }
+        blocks_count -= steps;
+    }
+    uint64_t lanes[5][2];
+    for (int j = 0; j < 5; j++)
+    {
+        _mm_storeu_si128((__m128i *)lanes[j], sum[j]);
+    }
+    size_t done = complex_samples_count & ~(size_t)3;
+    sums->count += done;
+    sums->sum_re += (int64_t)(lanes[0][0] + lanes[0][1]);
+    sums->sum_im += (int64_t)(lanes[1][0] + lanes[1][1]);
+    sums->sum2_re += lanes[2][0] + lanes[2][1];
+    sums->sum2_im += lanes[3][0] + lanes[3][1];
+    sums->sum_re_im += lanes[4][0] + lanes[4][1];
+    fobos_convert_scalar_sums(src, complex_samples_count - done, sums);
+}
+//==============================================================================
+// a tap pair multiplies interleaved (x[a], x[b]) int16 pairs: re and im of two complex
+// samples per 32 bit lane group of unpacklo, the next two of unpackhi
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_fir(const struct fobos_fir * fir, const int16_t * const * phases, int16_t * dst, size_t complex_samples_count)
+{
+    const int16_t * a[FOBOS_FIR_MAX_TAPS / 2];
+    const int16_t * b[FOBOS_FIR_MAX_TAPS / 2];
+    int32_t c[FOBOS_FIR_MAX_TAPS / 2];
+    fobos_fir_prepare(fir, phases, a, b, c);
+    const uint32_t pairs_count = fir->pairs_count;
+    const __m128i round = _mm_set1_epi32(1 << 14);
+    size_t blocks_count = complex_samples_count / 4;
+    for (size_t n = 0; n < blocks_count * 4; n += 4)
+    {
+        __m128i lo = round;
+        __m128i hi = round;
+        for (uint32_t i = 0; i < pairs_count; i++)
+        {
+            __m128i ci = _mm_set1_epi32(c[i]);
+            __m128i x = _mm_loadu_si128((const __m128i *)(a[i] + 2 * n));
+            __m128i y = _mm_loadu_si128((const __m128i *)(b[i] + 2 * n));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x, y), ci));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x, y), ci));
+        }
+        _mm_storeu_si128((__m128i *)(dst + 2 * n), _mm_packs_epi32(_mm_srai_epi32(lo, 15), _mm_srai_epi32(hi, 15)));
+    }
+    fobos_fir_tail(fir, phases, dst, blocks_count * 4, complex_samples_count);
+}
+//==============================================================================
+// (a0 b0 - a1 b1, a0 b1 + a1 b0) per complex lane pair, a - b computed as a + (-b)
+FOBOS_TARGET("sse2")
+static inline __m128 fobos_sse2_cmul(__m128 a, __m128 b)
+{
+    const __m128 sign = _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+    __m128 re = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 im = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 swapped = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_mul_ps(re, b), _mm_xor_ps(_mm_mul_ps(im, swapped), sign));
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_nco(const struct fobos_nco * nco, uint32_t phase, float * iq, int16_t * sc16, size_t complex_samples_count)
+{
+    size_t blocks_count = complex_samples_count / FOBOS_NCO_BLOCK;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        float w[2];
+        fobos_nco_phasor(phase, w);
+        __m128 wv = _mm_setr_ps(w[0], w[1], w[0], w[1]);
+        __m128 v[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m128 p = fobos_sse2_cmul(wv, _mm_loadu_ps(nco->rot + 4 * k));
+            v[k] = fobos_sse2_cmul(_mm_loadu_ps(iq + 4 * k), p);
+        }
+        if (sc16)
+        {
+            _mm_storeu_si128((__m128i *)sc16, _mm_packs_epi32(_mm_cvtps_epi32(v[0]), _mm_cvtps_epi32(v[1])));
+            _mm_storeu_si128((__m128i *)(sc16 + 8), _mm_packs_epi32(_mm_cvtps_epi32(v[2]), _mm_cvtps_epi32(v[3])));
+            sc16 += 2 * FOBOS_NCO_BLOCK;
+        }
+        else
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                _mm_storeu_ps(iq + 4 * k, v[k]);
+            }
+        }
+        iq += 2 * FOBOS_NCO_BLOCK;
+        phase += nco->step * FOBOS_NCO_BLOCK;
+    }
+    fobos_convert_scalar_nco(nco, phase, iq, sc16, complex_samples_count % FOBOS_NCO_BLOCK);
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_pfb(const float * taps, const float * x, float * u, size_t width, size_t segments_count)
+{
+    for (size_t i = 0; i < width; i += 4)
+    {
+        __m128 acc = _mm_mul_ps(_mm_loadu_ps(taps + i), _mm_loadu_ps(x + i));
+        for (size_t j = 1; j < segments_count; j++)
+        {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(taps + j * width + i), _mm_loadu_ps(x + j * width + i)));
+        }
+        _mm_storeu_ps(u + i, acc);
+    }
+}
+//==============================================================================
+// two butterflies a vector, the first stage (half = 1) by the scalar kernel
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_fft(const float * w, float * x, size_t half, size_t size)
+{
+    if (half < 2)
+    {
+        fobos_convert_scalar_fft(w, x, half, size);
+        return;
+    }
+    for (size_t start = 0; start < size; start += 2 * half)
+    {
+        float * a = x + 2 * start;
+        float * b = a + 2 * half;
+        for (size_t j = 0; j < 2 * half; j += 4)
+        {
+            __m128 t = fobos_sse2_cmul(_mm_loadu_ps(b + j), _mm_loadu_ps(w + j));
+            __m128 v = _mm_loadu_ps(a + j);
+            _mm_storeu_ps(b + j, _mm_sub_ps(v, t));
+            _mm_storeu_ps(a + j, _mm_add_ps(v, t));
+        }
+    }
+}
+//==============================================================================
+FOBOS_TARGET("sse2")
+static void fobos_convert_sse2_power(const float * y, float * power, size_t complex_samples_count)
+{
+    size_t blocks_count = complex_samples_count / 4;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        __m128 v0 = _mm_loadu_ps(y + 8 * i);
+        __m128 v1 = _mm_loadu_ps(y + 8 * i + 4);
+        v0 = _mm_mul_ps(v0, v0);
+        v1 = _mm_mul_ps(v1, v1);
+        __m128 re = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(power + 4 * i, _mm_add_ps(_mm_loadu_ps(power + 4 * i), _mm_add_ps(re, im)));
+    }
+    fobos_convert_scalar_power(y + 8 * blocks_count, power + 4 * blocks_count, complex_samples_count % 4);
+}
+//==============================================================================
+// avx2 + f16c
+//==============================================================================
+// gcc leaves out vzeroupper ahead of a tail call, the kernels that finish in sse
+// or scalar code clear the upper halves themselves, else every sse instruction
+// after them, log10f() of the caller included, pays for the dirty ymm state
+FOBOS_TARGET("avx2")
+static inline __m256 fobos_avx2_apply(__m256 v, __m256 a, __m256 b, __m256 offset)
+{
+    __m256 swapped = _mm256_permute_ps(v, 0xB1);
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v, a), _mm256_mul_ps(swapped, b)), offset);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static inline void fobos_avx2_chunk(const int16_t * src, const __m256 p[3], __m256 v[2])
+{
+    const __m128i mask = _mm_set1_epi16(FOBOS_SAMPLE_MASK);
+    __m128i raw0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)src), mask);
+    __m128i raw1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + 8)), mask);
+    v[0] = fobos_avx2_apply(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw0)), p[0], p[1], p[2]);
+    v[1] = fobos_avx2_apply(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw1)), p[0], p[1], p[2]);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static inline void fobos_avx2_params(const struct fobos_convert_params * params, __m256 p[3])
+{
+    p[0] = _mm256_castpd_ps(_mm256_set1_pd(fobos_convert_pair(params->a[0], params->a[1])));
+    p[1] = _mm256_castpd_ps(_mm256_set1_pd(fobos_convert_pair(params->b[0], params->b[1])));
+    p[2] = _mm256_castpd_ps(_mm256_set1_pd(fobos_convert_pair(params->offset[0], params->offset[1])));
+}
+//==============================================================================
+// 16 saturated int16 in the sample order
+FOBOS_TARGET("avx2")
+static inline __m256i fobos_avx2_sc16(const __m256 v[2])
+{
+    __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(v[0]), _mm256_cvtps_epi32(v[1]));
+    return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_fc32(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    float * out = (float *)dst;
+    __m256 p[3];
+    fobos_avx2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m256 v[2];
+        fobos_avx2_chunk(src, p, v);
+        _mm256_storeu_ps(out + 0, v[0]);
+        _mm256_storeu_ps(out + 8, v[1]);
+        src += 16;
+        out += 16;
+    }
+    _mm256_zeroupper();
+    fobos_convert_scalar_fc32(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_sc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int16_t * out = (int16_t *)dst;
+    __m256 p[3];
+    fobos_avx2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m256 v[2];
+        fobos_avx2_chunk(src, p, v);
+        _mm256_storeu_si256((__m256i *)out, fobos_avx2_sc16(v));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_sc8(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int8_t * out = (int8_t *)dst;
+    __m256 p[3];
+    fobos_avx2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m256 v[2];
+        fobos_avx2_chunk(src, p, v);
+        __m256i w = fobos_avx2_sc16(v);
+        _mm_storeu_si128((__m128i *)out, _mm_packs_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc8(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx2,f16c")
+static void fobos_convert_avx2_fc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    uint16_t * out = (uint16_t *)dst;
+    __m256 p[3];
+    fobos_avx2_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m256 v[2];
+        fobos_avx2_chunk(src, p, v);
+        _mm_storeu_si128((__m128i *)out, _mm256_cvtps_ph(v[0], _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128((__m128i *)(out + 8), _mm256_cvtps_ph(v[1], _MM_FROUND_TO_NEAREST_INT));
+        src += 16;
+        out += 16;
+    }
+    _mm256_zeroupper();
+    fobos_convert_scalar_fc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static inline __m256i fobos_avx2_widen(__m256i sum, __m256i acc)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    return _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_unpacklo_epi32(acc, zero), _mm256_unpackhi_epi32(acc, zero)));
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_sums(const int16_t * src, size_t complex_samples_count, struct fobos_convert_sums * sums)
+{
+    const __m256i mask = _mm256_set1_epi32(FOBOS_SAMPLE_MASK);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum[5] = { zero, zero, zero, zero, zero };
+    size_t blocks_count = complex_samples_count / 8;
+    while (blocks_count > 0)
+    {
+        size_t steps = blocks_count < FOBOS_SUMS_STEPS ? blocks_count : FOBOS_SUMS_STEPS;
+        __m256i acc[5] = { zero, zero, zero, zero, zero };
+        for (size_t i = 0; i < steps; i++)
+        {
+            __m256i raw = _mm256_loadu_si256((const __m256i *)src);
+            __m256i re = _mm256_and_si256(raw, mask);
+            __m256i im = _mm256_and_si256(_mm256_srli_epi32(raw, 16), mask);
+            acc[0] = _mm256_add_epi32(acc[0], re);
+            acc[1] = _mm256_add_epi32(acc[1], im);
+            acc[2] = _mm256_add_epi32(acc[2], _mm256_madd_epi16(re, re));
+            acc[3] = _mm256_add_epi32(acc[3], _mm256_madd_epi16(im, im));
+            acc[4] = _mm256_add_epi32(acc[4], _mm256_madd_epi16(re, im));
+            src += 16;
+        }
+        for (int j = 0; j < 5; j++)
+        {
+            sum[j] = fobos_avx2_widen(sum[j], acc[j]);
+        }
+        blocks_count -= steps;
+    }
+    uint64_t lanes[5][4];
+    for (int j = 0; j < 5; j++)
+    {
+        _mm256_storeu_si256((__m256i *)lanes[j], sum[j]);
+    }
+    size_t done = complex_samples_count & ~(size_t)7;
+    sums->count += done;
+    sums->sum_re += (int64_t)(lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3]);
+    sums->sum_im += (int64_t)(lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3]);
+    sums->sum2_re += lanes[2][0] + lanes[2][1] + lanes[2][2] + lanes[2][3];
+    sums->sum2_im += lanes[3][0] + lanes[3][1] + lanes[3][2] + lanes[3][3];
+    sums->sum_re_im += lanes[4][0] + lanes[4][1] + lanes[4][2] + lanes[4][3];
+    _mm256_zeroupper();
+    fobos_convert_scalar_sums(src, complex_samples_count - done, sums);
+}
+//==============================================================================
+// as the sse2 one per 128 bit lane: unpack and pack stay within the lanes, so the
+// low lane holds complex samples 0..3 and the high lane 4..7 throughout
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_fir(const struct fobos_fir * fir, const int16_t * const * phases, int16_t * dst, size_t complex_samples_count)
+{
+    const int16_t * a[FOBOS_FIR_MAX_TAPS / 2];
+    const int16_t * b[FOBOS_FIR_MAX_TAPS / 2];
+    int32_t c[FOBOS_FIR_MAX_TAPS / 2];
+    fobos_fir_prepare(fir, phases, a, b, c);
+    const uint32_t pairs_count = fir->pairs_count;
+    const __m256i round = _mm256_set1_epi32(1 << 14);
+    size_t blocks_count = complex_samples_count / 8;
+    for (size_t n = 0; n < blocks_count * 8; n += 8)
+    {
+        __m256i lo = round;
+        __m256i hi = round;
+        for (uint32_t i = 0; i < pairs_count; i++)
+        {
+            __m256i ci = _mm256_set1_epi32(c[i]);
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a[i] + 2 * n));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b[i] + 2 * n));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(x, y), ci));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(x, y), ci));
+        }
+        _mm256_storeu_si256((__m256i *)(dst + 2 * n), _mm256_packs_epi32(_mm256_srai_epi32(lo, 15), _mm256_srai_epi32(hi, 15)));
+    }
+    _mm256_zeroupper();
+    fobos_fir_tail(fir, phases, dst, blocks_count * 8, complex_samples_count);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static inline __m256 fobos_avx2_cmul(__m256 a, __m256 b)
+{
+    const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi64x(0x80000000));
+    __m256 re = _mm256_moveldup_ps(a);
+    __m256 im = _mm256_movehdup_ps(a);
+    __m256 swapped = _mm256_permute_ps(b, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_add_ps(_mm256_mul_ps(re, b), _mm256_xor_ps(_mm256_mul_ps(im, swapped), sign));
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_nco(const struct fobos_nco * nco, uint32_t phase, float * iq, int16_t * sc16, size_t complex_samples_count)
+{
+    const __m256 rot0 = _mm256_loadu_ps(nco->rot);
+    const __m256 rot1 = _mm256_loadu_ps(nco->rot + 8);
+    size_t blocks_count = complex_samples_count / FOBOS_NCO_BLOCK;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        float w[2];
+        fobos_nco_phasor(phase, w);
+        __m256 wv = _mm256_castpd_ps(_mm256_set1_pd(fobos_convert_pair(w[0], w[1])));
+        __m256 v[2];
+        v[0] = fobos_avx2_cmul(_mm256_loadu_ps(iq), fobos_avx2_cmul(wv, rot0));
+        v[1] = fobos_avx2_cmul(_mm256_loadu_ps(iq + 8), fobos_avx2_cmul(wv, rot1));
+        if (sc16)
+        {
+            _mm256_storeu_si256((__m256i *)sc16, fobos_avx2_sc16(v));
+            sc16 += 2 * FOBOS_NCO_BLOCK;
+        }
+        else
+        {
+            _mm256_storeu_ps(iq, v[0]);
+            _mm256_storeu_ps(iq + 8, v[1]);
+        }
+        iq += 2 * FOBOS_NCO_BLOCK;
+        phase += nco->step * FOBOS_NCO_BLOCK;
+    }
+    fobos_convert_scalar_nco(nco, phase, iq, sc16, complex_samples_count % FOBOS_NCO_BLOCK);
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_pfb(const float * taps, const float * x, float * u, size_t width, size_t segments_count)
+{
+    size_t blocks_count = width / 8;
+    for (size_t i = 0; i < blocks_count * 8; i += 8)
+    {
+        __m256 acc = _mm256_mul_ps(_mm256_loadu_ps(taps + i), _mm256_loadu_ps(x + i));
+        for (size_t j = 1; j < segments_count; j++)
+        {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(taps + j * width + i), _mm256_loadu_ps(x + j * width + i)));
+        }
+        _mm256_storeu_ps(u + i, acc);
+    }
+    if (width % 8)
+    {
+        // the 4 floats left of two channels
+        size_t i = blocks_count * 8;
+        __m128 acc = _mm_mul_ps(_mm_loadu_ps(taps + i), _mm_loadu_ps(x + i));
+        for (size_t j = 1; j < segments_count; j++)
+        {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(taps + j * width + i), _mm_loadu_ps(x + j * width + i)));
+        }
+        _mm_storeu_ps(u + i, acc);
+    }
+}
+//==============================================================================
+// four butterflies a vector, the stages of fewer by the sse2 kernel
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_fft(const float * w, float * x, size_t half, size_t size)
+{
+    if (half < 4)
+    {
+        fobos_convert_sse2_fft(w, x, half, size);
+        return;
+    }
+    for (size_t start = 0; start < size; start += 2 * half)
+    {
+        float * a = x + 2 * start;
+        float * b = a + 2 * half;
+        for (size_t j = 0; j < 2 * half; j += 8)
+        {
+            __m256 t = fobos_avx2_cmul(_mm256_loadu_ps(b + j), _mm256_loadu_ps(w + j));
+            __m256 v = _mm256_loadu_ps(a + j);
+            _mm256_storeu_ps(b + j, _mm256_sub_ps(v, t));
+            _mm256_storeu_ps(a + j, _mm256_add_ps(v, t));
+        }
+    }
+}
+//==============================================================================
+FOBOS_TARGET("avx2")
+static void fobos_convert_avx2_power(const float * y, float * power, size_t complex_samples_count)
+{
+    size_t blocks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        __m256 v0 = _mm256_loadu_ps(y + 16 * i);
+        __m256 v1 = _mm256_loadu_ps(y + 16 * i + 8);
+        v0 = _mm256_mul_ps(v0, v0);
+        v1 = _mm256_mul_ps(v1, v1);
+        // samples 0 1 4 5 | 2 3 6 7 within the lanes, then in order
+        __m256 re = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_add_ps(re, im)), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(power + 8 * i, _mm256_add_ps(_mm256_loadu_ps(power + 8 * i), sum));
+    }
+    _mm256_zeroupper();
+    fobos_convert_sse2_power(y + 16 * blocks_count, power + 8 * blocks_count, complex_samples_count % 8);
+}
+//==============================================================================
+// avx512
+//==============================================================================
+FOBOS_TARGET("avx512f")
+static inline __m512 fobos_avx512_chunk(const int16_t * src, const __m512 p[3])
+{
+    const __m256i mask = _mm256_set1_epi16(FOBOS_SAMPLE_MASK);
+    __m256i raw = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)src), mask);
+    __m512 v = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(raw));
+    __m512 swapped = _mm512_permute_ps(v, 0xB1);
+    return _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(v, p[0]), _mm512_mul_ps(swapped, p[1])), p[2]);
+}
+//==============================================================================
+FOBOS_TARGET("avx512f")
+static inline void fobos_avx512_params(const struct fobos_convert_params * params, __m512 p[3])
+{
+    p[0] = _mm512_castpd_ps(_mm512_set1_pd(fobos_convert_pair(params->a[0], params->a[1])));
+    p[1] = _mm512_castpd_ps(_mm512_set1_pd(fobos_convert_pair(params->b[0], params->b[1])));
+    p[2] = _mm512_castpd_ps(_mm512_set1_pd(fobos_convert_pair(params->offset[0], params->offset[1])));
+}
+//==============================================================================
+FOBOS_TARGET("avx512f")
+static void fobos_convert_avx512_fc32(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    float * out = (float *)dst;
+    __m512 p[3];
+    fobos_avx512_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        _mm512_storeu_ps(out, fobos_avx512_chunk(src, p));
+        src += 16;
+        out += 16;
+    }
+    _mm256_zeroupper();
+    fobos_convert_scalar_fc32(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx512f")
+static void fobos_convert_avx512_sc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int16_t * out = (int16_t *)dst;
+    __m512 p[3];
+    fobos_avx512_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m512i v = _mm512_cvtps_epi32(fobos_avx512_chunk(src, p));
+        _mm256_storeu_si256((__m256i *)out, _mm512_cvtsepi32_epi16(v));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx512f")
+static void fobos_convert_avx512_sc8(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int8_t * out = (int8_t *)dst;
+    __m512 p[3];
+    fobos_avx512_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        __m512i v = _mm512_cvtps_epi32(fobos_avx512_chunk(src, p));
+        _mm_storeu_si128((__m128i *)out, _mm512_cvtsepi32_epi8(v));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc8(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+FOBOS_TARGET("avx512f")
+static void fobos_convert_avx512_fc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    uint16_t * out = (uint16_t *)dst;
+    __m512 p[3];
+    fobos_avx512_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        _mm256_storeu_si256((__m256i *)out, _mm512_cvtps_ph(fobos_avx512_chunk(src, p), _MM_FROUND_TO_NEAREST_INT));
+        src += 16;
+        out += 16;
+    }
+    _mm256_zeroupper();
+    fobos_convert_scalar_fc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+#endif // FOBOS_CONVERT_X86
+//==============================================================================
+#ifdef FOBOS_CONVERT_NEON
+//==============================================================================
+static inline float32x4_t fobos_neon_pair(float re, float im)
+{
+    const float pair[4] = { re, im, re, im };
+    return vld1q_f32(pair);
+}
+//==============================================================================
+static inline float32x4_t fobos_neon_apply(uint32x4_t raw, const float32x4_t p[3])
+{
+    float32x4_t v = vcvtq_f32_u32(raw);
+    float32x4_t swapped = vrev64q_f32(v);
+    // separate mul and add, vmla/vfma would break the bit exactness
+    return vaddq_f32(vaddq_f32(vmulq_f32(v, p[0]), vmulq_f32(swapped, p[1])), p[2]);
+}
+//==============================================================================
+static inline void fobos_neon_chunk(const int16_t * src, const float32x4_t p[3], float32x4_t v[4])
+{
+    const uint16x8_t mask = vdupq_n_u16(FOBOS_SAMPLE_MASK);
+    uint16x8_t raw0 = vandq_u16(vld1q_u16((const uint16_t *)src), mask);
+    uint16x8_t raw1 = vandq_u16(vld1q_u16((const uint16_t *)(src + 8)), mask);
+    v[0] = fobos_neon_apply(vmovl_u16(vget_low_u16(raw0)), p);
+    v[1] = fobos_neon_apply(vmovl_u16(vget_high_u16(raw0)), p);
+    v[2] = fobos_neon_apply(vmovl_u16(vget_low_u16(raw1)), p);
+    v[3] = fobos_neon_apply(vmovl_u16(vget_high_u16(raw1)), p);
+}
+//==============================================================================
+static inline void fobos_neon_params(const struct fobos_convert_params * params, float32x4_t p[3])
+{
+    p[0] = fobos_neon_pair(params->a[0], params->a[1]);
+    p[1] = fobos_neon_pair(params->b[0], params->b[1]);
+    p[2] = fobos_neon_pair(params->offset[0], params->offset[1]);
+}
+//==============================================================================
+static void fobos_convert_neon_fc32(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    float * out = (float *)dst;
+    float32x4_t p[3];
+    fobos_neon_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        float32x4_t v[4];
+        fobos_neon_chunk(src, p, v);
+        vst1q_f32(out + 0, v[0]);
+        vst1q_f32(out + 4, v[1]);
+        vst1q_f32(out + 8, v[2]);
+        vst1q_f32(out + 12, v[3]);
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_fc32(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+static void fobos_convert_neon_sums(const int16_t * src, size_t complex_samples_count, struct fobos_convert_sums * sums)
+{
+    const uint16x8_t mask = vdupq_n_u16(FOBOS_SAMPLE_MASK);
+    uint64x2_t sum_re = vdupq_n_u64(0);
+    uint64x2_t sum_im = vdupq_n_u64(0);
+    uint64x2_t sum2_re = vdupq_n_u64(0);
+    uint64x2_t sum2_im = vdupq_n_u64(0);
+    uint64x2_t sum_re_im = vdupq_n_u64(0);
+    size_t blocks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        uint16x8x2_t raw = vld2q_u16((const uint16_t *)src);
+        uint16x8_t re = vandq_u16(raw.val[0], mask);
+        uint16x8_t im = vandq_u16(raw.val[1], mask);
+        sum_re = vpadalq_u32(sum_re, vpaddlq_u16(re));
+        sum_im = vpadalq_u32(sum_im, vpaddlq_u16(im));
+        sum2_re = vpadalq_u32(sum2_re, vmull_u16(vget_low_u16(re), vget_low_u16(re)));
+        sum2_re = vpadalq_u32(sum2_re, vmull_u16(vget_high_u16(re), vget_high_u16(re)));
+        sum2_im = vpadalq_u32(sum2_im, vmull_u16(vget_low_u16(im), vget_low_u16(im)));
+        sum2_im = vpadalq_u32(sum2_im, vmull_u16(vget_high_u16(im), vget_high_u16(im)));
+        sum_re_im = vpadalq_u32(sum_re_im, vmull_u16(vget_low_u16(re), vget_low_u16(im)));
+        sum_re_im = vpadalq_u32(sum_re_im, vmull_u16(vget_high_u16(re), vget_high_u16(im)));
+        src += 16;
+    }
+    size_t done = blocks_count * 8;
+    sums->count += done;
+    sums->sum_re += (int64_t)(vgetq_lane_u64(sum_re, 0) + vgetq_lane_u64(sum_re, 1));
+    sums->sum_im += (int64_t)(vgetq_lane_u64(sum_im, 0) + vgetq_lane_u64(sum_im, 1));
+    sums->sum2_re += vgetq_lane_u64(sum2_re, 0) + vgetq_lane_u64(sum2_re, 1);
+    sums->sum2_im += vgetq_lane_u64(sum2_im, 0) + vgetq_lane_u64(sum2_im, 1);
+    sums->sum_re_im += vgetq_lane_u64(sum_re_im, 0) + vgetq_lane_u64(sum_re_im, 1);
+    fobos_convert_scalar_sums(src, complex_samples_count - done, sums);
+}
+//==============================================================================
+static void fobos_convert_neon_fir(const struct fobos_fir * fir, const int16_t * const * phases, int16_t * dst, size_t complex_samples_count)
+{
+    const int16_t * a[FOBOS_FIR_MAX_TAPS / 2];
+    const int16_t * b[FOBOS_FIR_MAX_TAPS / 2];
+    int32_t c[FOBOS_FIR_MAX_TAPS / 2];
+    fobos_fir_prepare(fir, phases, a, b, c);
+    const uint32_t pairs_count = fir->pairs_count;
+    size_t blocks_count = complex_samples_count / 4;
+    for (size_t n = 0; n < blocks_count * 4; n += 4)
+    {
+        int32x4_t lo = vdupq_n_s32(1 << 14);
+        int32x4_t hi = vdupq_n_s32(1 << 14);
+        for (uint32_t i = 0; i < pairs_count; i++)
+        {
+            int16x8_t x = vld1q_s16(a[i] + 2 * n);
+            int16x8_t y = vld1q_s16(b[i] + 2 * n);
+            lo = vmlal_n_s16(lo, vget_low_s16(x), (int16_t)c[i]);
+            hi = vmlal_n_s16(hi, vget_high_s16(x), (int16_t)c[i]);
+            lo = vmlal_n_s16(lo, vget_low_s16(y), (int16_t)(c[i] >> 16));
+            hi = vmlal_n_s16(hi, vget_high_s16(y), (int16_t)(c[i] >> 16));
+        }
+        vst1q_s16(dst + 2 * n, vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 15)), vqmovn_s32(vshrq_n_s32(hi, 15))));
+    }
+    fobos_fir_tail(fir, phases, dst, blocks_count * 4, complex_samples_count);
+}
+//==============================================================================
+#ifdef __aarch64__
+// vcvtnq (round to nearest even) and the half conversion need armv8
+static inline int16x8_t fobos_neon_sc16(float32x4_t lo, float32x4_t hi)
+{
+    return vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)), vqmovn_s32(vcvtnq_s32_f32(hi)));
+}
+//==============================================================================
+static void fobos_convert_neon_sc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int16_t * out = (int16_t *)dst;
+    float32x4_t p[3];
+    fobos_neon_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        float32x4_t v[4];
+        fobos_neon_chunk(src, p, v);
+        vst1q_s16(out, fobos_neon_sc16(v[0], v[1]));
+        vst1q_s16(out + 8, fobos_neon_sc16(v[2], v[3]));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc16(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+static void fobos_convert_neon_sc8(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    int8_t * out = (int8_t *)dst;
+    float32x4_t p[3];
+    fobos_neon_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        float32x4_t v[4];
+        fobos_neon_chunk(src, p, v);
+        vst1q_s8(out, vcombine_s8(vqmovn_s16(fobos_neon_sc16(v[0], v[1])), vqmovn_s16(fobos_neon_sc16(v[2], v[3]))));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_sc8(params, src, out, complex_samples_count % 8);
+}
+//==============================================================================
+static void fobos_convert_neon_fc16(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count)
+{
+    float16_t * out = (float16_t *)dst;
+    float32x4_t p[3];
+    fobos_neon_params(params, p);
+    size_t chunks_count = complex_samples_count / 8;
+    for (size_t i = 0; i < chunks_count; i++)
+    {
+        float32x4_t v[4];
+        fobos_neon_chunk(src, p, v);
+        vst1q_f16(out, vcombine_f16(vcvt_f16_f32(v[0]), vcvt_f16_f32(v[1])));
+        vst1q_f16(out + 8, vcombine_f16(vcvt_f16_f32(v[2]), vcvt_f16_f32(v[3])));
+        src += 16;
+        out += 16;
+    }
+    fobos_convert_scalar_fc16(params, src, (uint16_t *)out, complex_samples_count % 8);
+}
+#else
+#define fobos_convert_neon_sc16 fobos_convert_scalar_sc16
+#define fobos_convert_neon_sc8 fobos_convert_scalar_sc8
+#define fobos_convert_neon_fc16 fobos_convert_scalar_fc16
+#endif
+//==============================================================================
+// separate mul and add as in the scalar kernel, the sign by a multiply with -1
+static inline float32x4_t fobos_neon_cmul(float32x4_t a, float32x4_t b)
+{
+    const float sign[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+    float32x4x2_t parts = vtrnq_f32(a, a);
+    float32x4_t t = vmulq_f32(vmulq_f32(parts.val[1], vrev64q_f32(b)), vld1q_f32(sign));
+    return vaddq_f32(vmulq_f32(parts.val[0], b), t);
+}
+//==============================================================================
+static void fobos_convert_neon_nco(const struct fobos_nco * nco, uint32_t phase, float * iq, int16_t * sc16, size_t complex_samples_count)
+{
+    size_t blocks_count = complex_samples_count / FOBOS_NCO_BLOCK;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        float w[2];
+        fobos_nco_phasor(phase, w);
+        float32x4_t wv = fobos_neon_pair(w[0], w[1]);
+        float32x4_t v[4];
+        for (int k = 0; k < 4; k++)
+        {
+            float32x4_t p = fobos_neon_cmul(wv, vld1q_f32(nco->rot + 4 * k));
+            v[k] = fobos_neon_cmul(vld1q_f32(iq + 4 * k), p);
+        }
+#ifdef __aarch64__
+        if (sc16)
+        {
+            vst1q_s16(sc16, fobos_neon_sc16(v[0], v[1]));
+            vst1q_s16(sc16 + 8, fobos_neon_sc16(v[2], v[3]));
+            sc16 += 2 * FOBOS_NCO_BLOCK;
+            iq += 2 * FOBOS_NCO_BLOCK;
+            phase += nco->step * FOBOS_NCO_BLOCK;
+            continue;
+        }
+#endif
+        // armv7 has no round to nearest even conversion, the scalar rounding then
+        float tmp[2 * FOBOS_NCO_BLOCK];
+        float * f = sc16 ? tmp : iq;
+        for (int k = 0; k < 4; k++)
+        {
+            vst1q_f32(f + 4 * k, v[k]);
+        }
+        if (sc16)
+        {
+            fobos_convert_pack(tmp, sc16, FOBOS_NCO_BLOCK, FOBOS_FORMAT_SC16);
+            sc16 += 2 * FOBOS_NCO_BLOCK;
+        }
+        iq += 2 * FOBOS_NCO_BLOCK;
+        phase += nco->step * FOBOS_NCO_BLOCK;
+    }
+    fobos_convert_scalar_nco(nco, phase, iq, sc16, complex_samples_count % FOBOS_NCO_BLOCK);
+}
+//==============================================================================
+static void fobos_convert_neon_pfb(const float * taps, const float * x, float * u, size_t width, size_t segments_count)
+{
+    for (size_t i = 0; i < width; i += 4)
+    {
+        float32x4_t acc = vmulq_f32(vld1q_f32(taps + i), vld1q_f32(x + i));
+        for (size_t j = 1; j < segments_count; j++)
+        {
+            acc = vaddq_f32(acc, vmulq_f32(vld1q_f32(taps + j * width + i), vld1q_f32(x + j * width + i)));
+        }
+        vst1q_f32(u + i, acc);
+    }
+}
+//==============================================================================
+static void fobos_convert_neon_fft(const float * w, float * x, size_t half, size_t size)
+{
+    if (half < 2)
+    {
+        fobos_convert_scalar_fft(w, x, half, size);
+        return;
+    }
+    for (size_t start = 0; start < size; start += 2 * half)
+    {
+        float * a = x + 2 * start;
+        float * b = a + 2 * half;
+        for (size_t j = 0; j < 2 * half; j += 4)
+        {
+            float32x4_t t = fobos_neon_cmul(vld1q_f32(b + j), vld1q_f32(w + j));
+            float32x4_t v = vld1q_f32(a + j);
+            vst1q_f32(b + j, vsubq_f32(v, t));
+            vst1q_f32(a + j, vaddq_f32(v, t));
+        }
+    }
+}
+//==============================================================================
+static void fobos_convert_neon_power(const float * y, float * power, size_t complex_samples_count)
+{
+    size_t blocks_count = complex_samples_count / 4;
+    for (size_t i = 0; i < blocks_count; i++)
+    {
+        float32x4x2_t v = vld2q_f32(y + 8 * i);
+        float32x4_t sum = vaddq_f32(vmulq_f32(v.val[0], v.val[0]), vmulq_f32(v.val[1], v.val[1]));
+        vst1q_f32(power + 4 * i, vaddq_f32(vld1q_f32(power + 4 * i), sum));
+    }
+    fobos_convert_scalar_power(y + 8 * blocks_count, power + 4 * blocks_count, complex_samples_count % 4);
+}
+//==============================================================================
+#endif // FOBOS_CONVERT_NEON
+//==============================================================================
+static const struct fobos_convert_kernel fobos_convert_table[] =
+{
+    { "scalar", fobos_convert_always, { fobos_convert_scalar_fc32, fobos_convert_scalar_sc16, fobos_convert_scalar_sc8, fobos_convert_scalar_fc16 }, fobos_convert_scalar_sums, fobos_convert_scalar_fir, fobos_convert_scalar_nco, fobos_convert_scalar_pfb, fobos_convert_scalar_fft, fobos_convert_scalar_power },
+#ifdef FOBOS_CONVERT_X86
+    { "sse2", fobos_convert_has_sse2, { fobos_convert_sse2_fc32, fobos_convert_sse2_sc16, fobos_convert_sse2_sc8, fobos_convert_sse2_fc16 }, fobos_convert_sse2_sums, fobos_convert_sse2_fir, fobos_convert_sse2_nco, fobos_convert_sse2_pfb, fobos_convert_sse2_fft, fobos_convert_sse2_power },
+    { "avx2", fobos_convert_has_avx2, { fobos_convert_avx2_fc32, fobos_convert_avx2_sc16, fobos_convert_avx2_sc8, fobos_convert_avx2_fc16 }, fobos_convert_avx2_sums, fobos_convert_avx2_fir, fobos_convert_avx2_nco, fobos_convert_avx2_pfb, fobos_convert_avx2_fft, fobos_convert_avx2_power },
+    { "avx512", fobos_convert_has_avx512, { fobos_convert_avx512_fc32, fobos_convert_avx512_sc16, fobos_convert_avx512_sc8, fobos_convert_avx512_fc16 }, fobos_convert_avx2_sums, fobos_convert_avx2_fir, fobos_convert_avx2_nco, fobos_convert_avx2_pfb, fobos_convert_avx2_fft, fobos_convert_avx2_power },
+#endif
+#ifdef FOBOS_CONVERT_NEON
+    { "neon", fobos_convert_always, { fobos_convert_neon_fc32, fobos_convert_neon_sc16, fobos_convert_neon_sc8, fobos_convert_neon_fc16 }, fobos_convert_neon_sums, fobos_convert_neon_fir, fobos_convert_neon_nco, fobos_convert_neon_pfb, fobos_convert_neon_fft, fobos_convert_neon_power },
+#endif
+};
+//==============================================================================
+const struct fobos_convert_kernel * fobos_convert_kernels(unsigned int * count)
+{
+    if (count)
+    {
+        *count = sizeof(fobos_convert_table) / sizeof(fobos_convert_table[0]);
+    }
+    return fobos_convert_table;
+}
+//==============================================================================
+const struct fobos_convert_kernel * fobos_convert_select(void)
+{
+    // the table is ordered from the slowest to the fastest kernel
+    size_t count = sizeof(fobos_convert_table) / sizeof(fobos_convert_table[0]);
+    for (size_t i = count; i > 0; i--)
+    {
+        if (fobos_convert_table[i - 1].supported())
+        {
+            return &fobos_convert_table[i - 1];
+        }
+    }
+    return &fobos_convert_table[0];
+}
+//==============================================================================
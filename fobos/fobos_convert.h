@@ -0,0 +1,148 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Raw int16 -> output sample format conversion kernels
+//==============================================================================
+#ifndef LIB_FOBOS_CONVERT_H
+#define LIB_FOBOS_CONVERT_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    // fixed 2x2 correction plus offset applied by every kernel, in output units,
+    // k = 0 for the even (re) and k = 1 for the odd (im) output item:
+    // out[k] = a[k] * in[k] + b[k] * in[1 - k] + offset[k], in[] are the raw 14 bit samples,
+    // the integer formats are rounded to nearest even and saturated
+    struct fobos_convert_params
+    {
+        float a[2];
+        float b[2];
+        float offset[2];
+    };
+    // converts complex_samples_count raw samples to the kernel output format
+    typedef void(*fobos_convert_fn_t)(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count);
+    // exact integer moments of the 14 bit samples, accumulated across calls
+    struct fobos_convert_sums
+    {
+        uint64_t count;
+        int64_t sum_re;
+        int64_t sum_im;
+        uint64_t sum2_re;   // sum of squares
+        uint64_t sum2_im;
+        uint64_t sum_re_im; // sum of re * im
+    };
+    // exponentially smoothed second order statistics of the raw samples
+    struct fobos_iq_estimator
+    {
+        double k;           // smoothing factor per update
+        uint32_t updates;   // since init, the first updates are weighted 1/n
+        uint32_t mean_updates; // since init or retune
+        double mean_re;
+        double mean_im;
+        double var_re;
+        double var_im;
+        double cov;
+    };
+    // adds all complex_samples_count raw samples to the sums in a single pass
+    typedef void(*fobos_sums_fn_t)(const int16_t * src, size_t complex_samples_count, struct fobos_convert_sums * sums);
+    //==========================================================================
+    // decimating fir of the decimation chain on signed complex int16 samples, Q15 taps,
+    // the nonzero taps go in pairs, a single one pairs with a zero coefficient:
+    // out[n] = sat16((sum of coeff[k] * phases[phase[k]][n + offset[k]] + (1 << 14)) >> 15),
+    // phases[p][i] = in[decimation * i + p] are the polyphase components of the input
+#define FOBOS_FIR_MAX_TAPS 128
+#define FOBOS_FIR_MAX_DECIMATION 8
+    struct fobos_fir_pair
+    {
+        uint16_t phase[2];
+        uint16_t offset[2];
+        int16_t coeff[2];
+    };
+    struct fobos_fir
+    {
+        uint32_t decimation;
+        uint32_t taps_count;
+        uint32_t pairs_count;
+        struct fobos_fir_pair pairs[FOBOS_FIR_MAX_TAPS / 2];
+    };
+    typedef void(*fobos_fir_fn_t)(const struct fobos_fir * fir, const int16_t * const * phases, int16_t * dst, size_t complex_samples_count);
+    //==========================================================================
+    // numerically controlled oscillator of the digital down converter, the phase is a
+    // uint32 accumulator (2^32 per turn) and never drifts; the phasor is looked up once per
+    // FOBOS_NCO_BLOCK samples and rotated by rot[] for the samples in between:
+    // iq[n] *= e^(j 2 pi (phase + step * n) / 2^32), complex products as (a0 b0 - a1 b1, a0 b1 + a1 b0),
+    // in place or, for the decimation chain, to sc16 rounded and saturated as the sc16 kernels
+#define FOBOS_NCO_BLOCK 8
+    struct fobos_nco
+    {
+        uint32_t step;                      // phase increment per sample
+        float rot[2 * FOBOS_NCO_BLOCK];     // e^(j 2 pi step k / 2^32)
+    };
+    // sc16 NULL - in place, else iq is left as is
+    typedef void(*fobos_nco_fn_t)(const struct fobos_nco * nco, uint32_t phase, float * iq, int16_t * sc16, size_t complex_samples_count);
+    //==========================================================================
+    // polyphase sum of the channelizer, every real tap twice for the re and im items:
+    // u[i] = taps[i] * x[i] + taps[width + i] * x[width + i] + ... over segments_count
+    // segments of width floats, added up in that order, width a multiple of 4
+    typedef void(*fobos_pfb_fn_t)(const float * taps, const float * x, float * u, size_t width, size_t segments_count);
+    //==========================================================================
+    // one radix 2 stage of the fft on size complex in place, the groups of 2 * half samples
+    // each: t = b[j] * w[j], b[j] = a[j] - t, a[j] = a[j] + t with b = a + half, j < half
+    typedef void(*fobos_fft_fn_t)(const float * w, float * x, size_t half, size_t size);
+    //==========================================================================
+    // power spectrum accumulation: power[k] = power[k] + (y[k].re * y[k].re + y[k].im * y[k].im)
+    typedef void(*fobos_power_fn_t)(const float * y, float * power, size_t complex_samples_count);
+    //==========================================================================
+    struct fobos_convert_kernel
+    {
+        const char * name;
+        int (*supported)(void);
+        fobos_convert_fn_t convert[FOBOS_FORMAT_COUNT]; // indexed by enum fobos_sample_format
+        fobos_sums_fn_t sums;
+        fobos_fir_fn_t fir;
+        fobos_nco_fn_t nco;
+        fobos_pfb_fn_t pfb;
+        fobos_fft_fn_t fft;
+        fobos_power_fn_t power;
+    };
+    //==========================================================================
+    // obtain the table of all compiled kernels, the scalar reference is the first one
+    API_EXPORT const struct fobos_convert_kernel * CALL_CONV fobos_convert_kernels(unsigned int * count);
+    // obtain the fastest kernel supported by the running cpu
+    API_EXPORT const struct fobos_convert_kernel * CALL_CONV fobos_convert_select(void);
+    // build the kernel parameters from the iq correction, scale - output units per raw lsb,
+    // swap_iq puts re to the odd output item
+    API_EXPORT void CALL_CONV fobos_convert_params_make(struct fobos_convert_params * params, const struct fobos_iq_correction * correction, float scale, int swap_iq);
+    // mid scale dc, no iq imbalance
+    API_EXPORT void CALL_CONV fobos_iq_correction_init(struct fobos_iq_correction * correction);
+    API_EXPORT void CALL_CONV fobos_iq_estimator_init(struct fobos_iq_estimator * estimator, double k);
+    API_EXPORT void CALL_CONV fobos_iq_estimator_update(struct fobos_iq_estimator * estimator, const struct fobos_convert_sums * sums);
+    // the dc jumps on retune, the next mean update is taken as is
+    API_EXPORT void CALL_CONV fobos_iq_estimator_retune(struct fobos_iq_estimator * estimator);
+    // returns 0 if the correction was updated, -1 while there is no estimate yet
+    API_EXPORT int CALL_CONV fobos_iq_estimator_get(const struct fobos_iq_estimator * estimator, struct fobos_iq_correction * correction);
+    // round to nearest even float -> IEEE half conversion used by all fc16 kernels
+    API_EXPORT uint16_t CALL_CONV fobos_float_to_half(float value);
+    // converts the output of the decimation chain: signed, centered, 4 per raw lsb,
+    // with the params built for the raw samples, same rounding as the kernels
+    API_EXPORT void CALL_CONV fobos_convert_filtered(const struct fobos_convert_params * params, const int16_t * src, void * dst, size_t complex_samples_count, int format);
+    // fc32 to any format with the rounding of the kernels
+    API_EXPORT void CALL_CONV fobos_convert_pack(const float * src, void * dst, size_t complex_samples_count, int format);
+    // the oscillator of frequency cycles per sample, the step is rounded to 2^-32
+    API_EXPORT void CALL_CONV fobos_nco_make(struct fobos_nco * nco, double frequency);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_CONVERT_H
@@ -0,0 +1,417 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Decimation chain: cascaded halfband filters, then an optional final fir,
+//  on the integer samples ahead of the output format conversion
+//==============================================================================
+// The raw 14 bit samples enter the chain centered and scaled to 4 per lsb, the
+// extra bits keep the processing gain of the filters. Every stage keeps its
+// fir history, so a stream may be fed in pieces of any length. A complex int16
+// sample moves as one uint32 between the stages.
+//==============================================================================
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_decim.h"
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+//==============================================================================
+#define FOBOS_DECIM_CHUNK 4096      // raw samples filtered at a time
+#define FOBOS_DECIM_MAX_STAGES (FOBOS_DECIM_MAX_HALFBANDS + 1)
+//==============================================================================
+// the input samples not consumed yet, the fir history first, go straight into the
+// polyphase components: sample j to phases[j % decimation][j / decimation]
+struct fobos_decim_stage
+{
+    struct fobos_fir fir;
+    size_t len;
+    uint32_t * phases[FOBOS_FIR_MAX_DECIMATION];
+};
+//==============================================================================
+struct fobos_decim
+{
+    uint32_t decimation;
+    uint32_t stages_count;
+    struct fobos_decim_stage stages[FOBOS_DECIM_MAX_STAGES];
+    uint32_t * tmp[2];              // stage outputs, FOBOS_DECIM_CHUNK complex samples each
+    fobos_fir_fn_t fir;
+};
+//==============================================================================
+static int fobos_decim_factor(uint32_t decimation, uint32_t * halfbands, uint32_t * m)
+{
+    if (decimation == 0)
+    {
+        return -1;
+    }
+    *halfbands = 0;
+    while (((decimation & 1) == 0) && (*halfbands < FOBOS_DECIM_MAX_HALFBANDS))
+    {
+        decimation >>= 1;
+        (*halfbands)++;
+    }
+    *m = decimation;
+    return ((decimation == 1) || (decimation == 3) || (decimation == 5)) ? 0 : -1;
+}
+//==============================================================================
+int fobos_decim_supported(uint32_t decimation)
+{
+    uint32_t halfbands;
+    uint32_t m;
+    return fobos_decim_factor(decimation, &halfbands, &m) == 0;
+}
+//==============================================================================
+// modified bessel function of the first kind, order 0
+static double fobos_decim_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++)
+    {
+        double f = x / (2.0 * k);
+        term *= f * f;
+        sum += term;
+        if (term < sum * 1E-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+//==============================================================================
+// kaiser windowed sinc, -6 dB at fc, symmetric about the middle, returns the dc gain
+static double fobos_decim_sinc(double * h, uint32_t taps_count, double fc, double attenuation_db)
+{
+    double beta = 0.1102 * (attenuation_db - 8.7);
+    double center = 0.5 * (taps_count - 1);
+    double sum = 0.0;
+    for (uint32_t t = 0; t < taps_count; t++)
+    {
+        double d = (double)t - center;
+        double x = d / center;
+        double sinc = (d == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * d) / (M_PI * d);
+        h[t] = sinc * fobos_decim_i0(beta * sqrt(1.0 - x * x)) / fobos_decim_i0(beta);
+        sum += h[t];
+    }
+    return sum;
+}
+//==============================================================================
+int fobos_decim_lowpass(float * taps, uint32_t taps_count, double cutoff, double attenuation_db)
+{
+    double * h = (double *)malloc(taps_count * sizeof(double));
+    if (!h)
+    {
+        return -1;
+    }
+    double sum = fobos_decim_sinc(h, taps_count, cutoff, attenuation_db);
+    for (uint32_t t = 0; t < taps_count; t++)
+    {
+        taps[t] = (float)(h[t] / sum);
+    }
+    free(h);
+    return 0;
+}
+//==============================================================================
+// the Q15 taps of a kaiser windowed sinc with attenuation_db, unity dc gain exactly,
+// so the dc correction of the output stays valid, the taps count if it fits
+static uint32_t fobos_decim_kaiser(int16_t * q, double pass, double stop, double attenuation_db)
+{
+    // kaiser: taps - 1 = (A - 7.95) / (14.36 * width), odd, symmetric about the center tap
+    uint32_t taps_count = ((uint32_t)ceil((attenuation_db - 7.95) / (14.36 * (stop - pass))) + 1) | 1;
+    if (taps_count > FOBOS_FIR_MAX_TAPS)
+    {
+        return 0;
+    }
+    uint32_t center = (taps_count - 1) / 2;
+    double h[FOBOS_FIR_MAX_TAPS];
+    double sum = fobos_decim_sinc(h, taps_count, 0.5 * (pass + stop), attenuation_db);
+    int32_t total = 0;
+    for (uint32_t t = 0; t < taps_count; t++)
+    {
+        q[t] = (int16_t)lrint(h[t] / sum * 32768.0);
+        total += q[t];
+    }
+    q[center] = (int16_t)(q[center] + 32768 - total);
+    return taps_count;
+}
+//==============================================================================
+// the worst attenuation of the symmetric Q15 taps from stop to the nyquist
+static double fobos_decim_stopband(const int16_t * q, uint32_t taps_count, double stop)
+{
+    const int points_count = 1024;
+    uint32_t center = (taps_count - 1) / 2;
+    double peak = 0.0;
+    for (int i = 0; i <= points_count; i++)
+    {
+        double f = stop + (0.5 - stop) * i / points_count;
+        double h = q[center];
+        for (uint32_t d = 1; d <= center; d++)
+        {
+            h += 2.0 * q[center + d] * cos(2.0 * M_PI * f * d);
+        }
+        h = fabs(h) / 32768.0;
+        peak = h > peak ? h : peak;
+    }
+    return peak > 0.0 ? -20.0 * log10(peak) : 1000.0;
+}
+//==============================================================================
+double fobos_decim_attenuation(const struct fobos_fir * fir, double stop)
+{
+    int16_t q[FOBOS_FIR_MAX_TAPS];
+    memset(q, 0, sizeof(q));
+    for (uint32_t i = 0; i < fir->pairs_count; i++)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            const struct fobos_fir_pair * pair = &fir->pairs[i];
+            q[pair->offset[k] * fir->decimation + pair->phase[k]] += pair->coeff[k];
+        }
+    }
+    return fobos_decim_stopband(q, fir->taps_count, stop);
+}
+//==============================================================================
+int fobos_decim_design(struct fobos_fir * fir, uint32_t decimation, double pass, double stop)
+{
+    if ((stop <= pass) || (decimation == 0) || (decimation > FOBOS_FIR_MAX_DECIMATION))
+    {
+        return -1;
+    }
+    // rounding the taps to Q15 lifts the stop band of a long fir by several dB, so the
+    // kaiser attenuation goes up until the rounded taps keep FOBOS_DECIM_STOP_DB + 3 dB,
+    // or the taps run out, then the best of the tried ones
+    int16_t q[FOBOS_FIR_MAX_TAPS];
+    int16_t best[FOBOS_FIR_MAX_TAPS];
+    uint32_t best_count = 0;
+    double best_db = 0.0;
+    for (double attenuation_db = FOBOS_DECIM_STOP_DB; ; attenuation_db += 2.0)
+    {
+        uint32_t taps_count = fobos_decim_kaiser(q, pass, stop, attenuation_db);
+        if (taps_count == 0)
+        {
+            break;
+        }
+        double db = fobos_decim_stopband(q, taps_count, stop);
+        if ((best_count == 0) || (db > best_db))
+        {
+            memcpy(best, q, taps_count * sizeof(int16_t));
+            best_count = taps_count;
+            best_db = db;
+        }
+        if (db >= FOBOS_DECIM_STOP_DB + 3.0)
+        {
+            break;
+        }
+    }
+    if ((best_count == 0) || (best_db < FOBOS_DECIM_STOP_DB))
+    {
+        return -1;
+    }
+    memset(fir, 0, sizeof(*fir));
+    fir->decimation = decimation;
+    fir->taps_count = best_count;
+    // the zero taps of a halfband are skipped, the rest go in pairs
+    for (uint32_t t = 0; t < best_count; t++)
+    {
+        if (best[t] == 0)
+        {
+            continue;
+        }
+        struct fobos_fir_pair * pair = &fir->pairs[fir->pairs_count];
+        int k = pair->coeff[0] != 0;
+        pair->phase[k] = (uint16_t)(t % decimation);
+        pair->offset[k] = (uint16_t)(t / decimation);
+        pair->coeff[k] = best[t];
+        if (k)
+        {
+            fir->pairs_count++;
+        }
+        else
+        {
+            pair->phase[1] = pair->phase[0];
+            pair->offset[1] = pair->offset[0];
+        }
+    }
+    if (fir->pairs[fir->pairs_count].coeff[0] != 0)
+    {
+        fir->pairs_count++;
+    }
+    return 0;
+}
+//==============================================================================
+void fobos_decim_destroy(struct fobos_decim * decim)
+{
+    if (!decim)
+    {
+        return;
+    }
+    for (uint32_t s = 0; s < FOBOS_DECIM_MAX_STAGES; s++)
+    {
+        for (uint32_t p = 0; p < FOBOS_FIR_MAX_DECIMATION; p++)
+        {
+            free(decim->stages[s].phases[p]);
+        }
+    }
+    free(decim->tmp[0]);
+    free(decim->tmp[1]);
+    free(decim);
+}
+//==============================================================================
+struct fobos_decim * fobos_decim_create(uint32_t decimation, const struct fobos_convert_kernel * kernel)
+{
+    uint32_t halfbands;
+    uint32_t m;
+    if ((fobos_decim_factor(decimation, &halfbands, &m) != 0) || (decimation == 1) || !kernel)
+    {
+        return NULL;
+    }
+    struct fobos_decim * decim = (struct fobos_decim *)calloc(1, sizeof(struct fobos_decim));
+    if (!decim)
+    {
+        return NULL;
+    }
+    decim->decimation = decimation;
+    decim->fir = kernel->fir;
+    // the input rate of a stage in output rate units, every stage keeps the
+    // pass band and stops what would alias into it at its own output rate
+    double rate = decimation;
+    int result = 0;
+    for (uint32_t j = 0; j < halfbands; j++)
+    {
+        result |= fobos_decim_design(&decim->stages[decim->stages_count++].fir, 2, FOBOS_DECIM_PASS / rate, (rate * 0.5 - FOBOS_DECIM_PASS) / rate);
+        rate *= 0.5;
+    }
+    if (m > 1)
+    {
+        result |= fobos_decim_design(&decim->stages[decim->stages_count++].fir, m, FOBOS_DECIM_PASS / rate, (1.0 - FOBOS_DECIM_PASS) / rate);
+    }
+    decim->tmp[0] = (uint32_t *)malloc(FOBOS_DECIM_CHUNK * sizeof(uint32_t));
+    decim->tmp[1] = (uint32_t *)malloc(FOBOS_DECIM_CHUNK * sizeof(uint32_t));
+    if (!decim->tmp[0] || !decim->tmp[1])
+    {
+        result = -1;
+    }
+    for (uint32_t s = 0; s < decim->stages_count; s++)
+    {
+        struct fobos_decim_stage * stage = &decim->stages[s];
+        // the history, up to decimation - 1 samples short of an output and a chunk
+        size_t capacity = FOBOS_FIR_MAX_TAPS + FOBOS_FIR_MAX_DECIMATION + FOBOS_DECIM_CHUNK;
+        for (uint32_t p = 0; p < stage->fir.decimation; p++)
+        {
+            stage->phases[p] = (uint32_t *)calloc(capacity / stage->fir.decimation + 1, sizeof(uint32_t));
+            result |= stage->phases[p] ? 0 : -1;
+        }
+    }
+    if (result != 0)
+    {
+        fobos_decim_destroy(decim);
+        return NULL;
+    }
+    fobos_decim_reset(decim);
+    return decim;
+}
+//==============================================================================
+void fobos_decim_reset(struct fobos_decim * decim)
+{
+    for (uint32_t s = 0; s < decim->stages_count; s++)
+    {
+        struct fobos_decim_stage * stage = &decim->stages[s];
+        stage->len = stage->fir.taps_count - 1;
+        for (uint32_t p = 0; p < stage->fir.decimation; p++)
+        {
+            memset(stage->phases[p], 0, (stage->len / stage->fir.decimation + 1) * sizeof(uint32_t));
+        }
+    }
+}
+//==============================================================================
+// appends count complex samples and filters all it can, returns the outputs count
+static size_t fobos_decim_stage_run(struct fobos_decim * decim, struct fobos_decim_stage * stage, const void * in, size_t count, int raw, uint32_t * out)
+{
+    uint32_t decimation = stage->fir.decimation;
+    const uint8_t * src = (const uint8_t *)in;
+    // phase by phase, input sample i goes to phase (len + i) % decimation
+    for (uint32_t q = 0; q < decimation; q++)
+    {
+        size_t j = stage->len + q;
+        uint32_t * dst = stage->phases[j % decimation] + j / decimation;
+        for (size_t i = q; i < count; i += decimation)
+        {
+            uint32_t x;
+            memcpy(&x, src + 4 * i, sizeof(x));
+            if (raw)
+            {
+                // ((x & 0x3FFF) - 8192) * 4 of both halves: the offset binary msb flipped
+                x = ((x << 2) & 0xFFFCFFFCu) ^ 0x80008000u;
+            }
+            *dst++ = x;
+        }
+    }
+    stage->len += count;
+    uint32_t taps_count = stage->fir.taps_count;
+    if (stage->len < taps_count)
+    {
+        return 0;
+    }
+    size_t out_count = (stage->len - taps_count) / decimation + 1;
+    decim->fir(&stage->fir, (const int16_t * const *)stage->phases, (int16_t *)out, out_count);
+    // every phase drops out_count samples, the history and the spare ones move up
+    stage->len -= out_count * decimation;
+    for (uint32_t p = 0; p < decimation; p++)
+    {
+        size_t left = (stage->len - p + decimation - 1) / decimation;
+        memmove(stage->phases[p], stage->phases[p] + out_count, left * sizeof(uint32_t));
+    }
+    return out_count;
+}
+//==============================================================================
+static size_t fobos_decim_feed(struct fobos_decim * decim, const struct fobos_convert_params * params, const int16_t * src, int raw, size_t count, void * dst, int format)
+{
+    uint8_t * out = (uint8_t *)dst;
+    size_t sample_size = fobos_rx_sample_size(format);
+    size_t produced = 0;
+    while (count > 0)
+    {
+        size_t n = count < FOBOS_DECIM_CHUNK ? count : FOBOS_DECIM_CHUNK;
+        const void * in = src;
+        size_t m = n;
+        for (uint32_t s = 0; (s < decim->stages_count) && (m > 0); s++)
+        {
+            uint32_t * stage_out = decim->tmp[s & 1];
+            m = fobos_decim_stage_run(decim, &decim->stages[s], in, m, raw && (s == 0), stage_out);
+            in = stage_out;
+        }
+        if (m > 0)
+        {
+            fobos_convert_filtered(params, (const int16_t *)in, out + produced * sample_size, m, format);
+            produced += m;
+        }
+        src += 2 * n;
+        count -= n;
+    }
+    return produced;
+}
+//==============================================================================
+size_t fobos_decim_run(struct fobos_decim * decim, const struct fobos_convert_params * params, const int16_t * raw, size_t count, void * dst, int format)
+{
+    return fobos_decim_feed(decim, params, raw, 1, count, dst, format);
+}
+//==============================================================================
+size_t fobos_decim_run_iq(struct fobos_decim * decim, float scale, const int16_t * iq, size_t count, void * dst, int format)
+{
+    // the raw params of the identity: 4 * scale per raw lsb around mid scale
+    struct fobos_convert_params params;
+    for (int k = 0; k < 2; k++)
+    {
+        params.a[k] = 4.0f * scale;
+        params.b[k] = 0.0f;
+        params.offset[k] = -32768.0f * scale;
+    }
+    return fobos_decim_feed(decim, &params, iq, 0, count, dst, format);
+}
+//==============================================================================
\ No newline at end of file
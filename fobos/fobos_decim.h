@@ -0,0 +1,60 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Decimation chain: cascaded halfband filters, then an optional final fir,
+//  on the integer samples ahead of the output format conversion
+//==============================================================================
+#ifndef LIB_FOBOS_DECIM_H
+#define LIB_FOBOS_DECIM_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos_convert.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    // decimation = 2^n * m, n = 0..6 halfband stages, m = 1, 3 or 5 the final fir,
+    // the output keeps 80 % of its band, everything that would alias into it is
+    // attenuated by 72 dB at least, about what Q15 taps hold for the final fir
+#define FOBOS_DECIM_MAX_HALFBANDS 6
+#define FOBOS_DECIM_PASS 0.4    // pass band edge, output rate units
+#define FOBOS_DECIM_STOP_DB 72.0
+    struct fobos_decim;
+    // 1 if the decimation is supported, 1 itself means no filtering
+    API_EXPORT int CALL_CONV fobos_decim_supported(uint32_t decimation);
+    // filters with the fir of kernel, NULL if unsupported or out of memory
+    API_EXPORT struct fobos_decim * CALL_CONV fobos_decim_create(uint32_t decimation, const struct fobos_convert_kernel * kernel);
+    API_EXPORT void CALL_CONV fobos_decim_destroy(struct fobos_decim * decim);
+    // zero filter history, for a new stream
+    API_EXPORT void CALL_CONV fobos_decim_reset(struct fobos_decim * decim);
+    // filters count raw samples (FOBOS_FORMAT_RAW) and converts the decimated ones to format
+    // with params (built for the raw samples), returns the count written to dst, every
+    // decimation-th input sample of the stream from the first one on gives an output
+    API_EXPORT size_t CALL_CONV fobos_decim_run(struct fobos_decim * decim, const struct fobos_convert_params * params, const int16_t * raw, size_t count, void * dst, int format);
+    // as fobos_decim_run() for signed complex int16 samples already in the scale of the
+    // chain (4 per raw lsb, e.g. the mixer output), scale - output units per input lsb
+    API_EXPORT size_t CALL_CONV fobos_decim_run_iq(struct fobos_decim * decim, float scale, const int16_t * iq, size_t count, void * dst, int format);
+    // the fir of one stage: kaiser windowed sinc, pass and stop normalized to the input
+    // rate, unity dc gain, returns -1 if FOBOS_FIR_MAX_TAPS taps can not keep
+    // FOBOS_DECIM_STOP_DB from stop on
+    API_EXPORT int CALL_CONV fobos_decim_design(struct fobos_fir * fir, uint32_t decimation, double pass, double stop);
+    // float taps of a kaiser windowed sinc for filters outside the chain, -6 dB at cutoff
+    // (input rate units), unity dc gain, the transition is (attenuation_db - 7.95) /
+    // (14.36 * (taps_count - 1)) wide, any taps_count from 2 on, -1 if out of memory
+    API_EXPORT int CALL_CONV fobos_decim_lowpass(float * taps, uint32_t taps_count, double cutoff, double attenuation_db);
+    // the worst attenuation of the fir from stop to the input nyquist, dB
+    API_EXPORT double CALL_CONV fobos_decim_attenuation(const struct fobos_fir * fir, double stop);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_DECIM_H
+//==============================================================================
\ No newline at end of file
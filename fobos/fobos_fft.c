@@ -0,0 +1,122 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  FFT: radix 2 complex float transform of the channelizer and the spectra
+//==============================================================================
+#include <math.h>
+#include <stdlib.h>
+#include "fobos_fft.h"
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+//==============================================================================
+struct fobos_fft
+{
+    uint32_t size;
+    float * twiddle;                // e^(-j 2 pi k / size), size complex
+    float * stages;                 // the twiddles of every stage in order, size - 1 complex
+    uint32_t * reverse;             // bit reversed input index
+    fobos_fft_fn_t butterflies;
+};
+//==============================================================================
+int fobos_fft_supported(uint32_t size)
+{
+    return (size >= 2) && (size <= FOBOS_FFT_MAX_SIZE) && ((size & (size - 1)) == 0);
+}
+//==============================================================================
+void fobos_fft_destroy(struct fobos_fft * fft)
+{
+    if (!fft)
+    {
+        return;
+    }
+    free(fft->twiddle);
+    free(fft->stages);
+    free(fft->reverse);
+    free(fft);
+}
+//==============================================================================
+struct fobos_fft * fobos_fft_create(uint32_t size, const struct fobos_convert_kernel * kernel)
+{
+    if (!fobos_fft_supported(size) || !kernel)
+    {
+        return NULL;
+    }
+    struct fobos_fft * fft = (struct fobos_fft *)calloc(1, sizeof(struct fobos_fft));
+    if (!fft)
+    {
+        return NULL;
+    }
+    fft->size = size;
+    fft->butterflies = kernel->fft;
+    fft->twiddle = (float *)malloc(2 * size * sizeof(float));
+    fft->stages = (float *)malloc(2 * size * sizeof(float));
+    fft->reverse = (uint32_t *)malloc(size * sizeof(uint32_t));
+    if (!fft->twiddle || !fft->stages || !fft->reverse)
+    {
+        fobos_fft_destroy(fft);
+        return NULL;
+    }
+    uint32_t bits = 0;
+    while ((1u << bits) < size)
+    {
+        bits++;
+    }
+    for (uint32_t k = 0; k < size; k++)
+    {
+        fft->twiddle[2 * k] = (float)cos(2.0 * M_PI * k / size);
+        fft->twiddle[2 * k + 1] = (float)-sin(2.0 * M_PI * k / size);
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; b++)
+        {
+            r |= ((k >> b) & 1) << (bits - 1 - b);
+        }
+        fft->reverse[k] = r;
+    }
+    // the stage of half butterflies a group takes every size / (2 * half)-th twiddle,
+    // contiguous they load as vectors
+    float * w = fft->stages;
+    for (uint32_t half = 1; half < size; half <<= 1)
+    {
+        uint32_t step = size / (2 * half);
+        for (uint32_t j = 0; j < half; j++)
+        {
+            *w++ = fft->twiddle[2 * j * step];
+            *w++ = fft->twiddle[2 * j * step + 1];
+        }
+    }
+    return fft;
+}
+//==============================================================================
+uint32_t fobos_fft_size(const struct fobos_fft * fft)
+{
+    return fft->size;
+}
+//==============================================================================
+const float * fobos_fft_twiddles(const struct fobos_fft * fft)
+{
+    return fft->twiddle;
+}
+//==============================================================================
+// decimation in time: the bit reversed copy, then the butterflies in place stage by stage
+void fobos_fft_run(const struct fobos_fft * fft, const float * in, float * out)
+{
+    uint32_t n = fft->size;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        out[2 * fft->reverse[i]] = in[2 * i];
+        out[2 * fft->reverse[i] + 1] = in[2 * i + 1];
+    }
+    for (uint32_t half = 1; half < n; half <<= 1)
+    {
+        fft->butterflies(fft->stages + 2 * (half - 1), out, half, n);
+    }
+}
+//==============================================================================
\ No newline at end of file
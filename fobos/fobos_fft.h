@@ -0,0 +1,41 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  FFT: radix 2 complex float transform of the channelizer and the spectra
+//==============================================================================
+#ifndef LIB_FOBOS_FFT_H
+#define LIB_FOBOS_FFT_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos_convert.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    // size = 2^n, X[k] = sum over n of x[n] e^(-j 2 pi k n / size), unscaled
+#define FOBOS_FFT_MAX_SIZE 65536
+    struct fobos_fft;
+    // 1 if size is supported, a power of 2 from 2 to FOBOS_FFT_MAX_SIZE
+    API_EXPORT int CALL_CONV fobos_fft_supported(uint32_t size);
+    // with the butterflies of kernel, NULL if unsupported or out of memory
+    API_EXPORT struct fobos_fft * CALL_CONV fobos_fft_create(uint32_t size, const struct fobos_convert_kernel * kernel);
+    API_EXPORT void CALL_CONV fobos_fft_destroy(struct fobos_fft * fft);
+    API_EXPORT uint32_t CALL_CONV fobos_fft_size(const struct fobos_fft * fft);
+    // e^(-j 2 pi k / size), size complex
+    API_EXPORT const float * CALL_CONV fobos_fft_twiddles(const struct fobos_fft * fft);
+    // size complex samples in to out, in place is not supported
+    API_EXPORT void CALL_CONV fobos_fft_run(const struct fobos_fft * fft, const float * in, float * out);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_FFT_H
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,401 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  History: the last raw transfers kept in memory, snapshots of a window around
+//  a trigger written from it by a thread while the stream goes on
+//==============================================================================
+// The history is a ring of transfer sized slots, transfer n in slot n % slots,
+// with the capture it came with. The event thread copies a transfer into its
+// slot and only then counts it as written, so slot n holds transfer n while
+// written - slots < n < written. The snapshot thread copies the window out of
+// the slots into a fobos_record; it stays two slots clear of the one being
+// overwritten, a writer the disk holds back that long loses the oldest
+// transfers, annotated as a gap. The samples stay int16, 4 bytes per sample,
+// as the device sent them.
+//==============================================================================
+#define _CRT_SECURE_NO_WARNINGS
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_history.h"
+#include "fobos_thread.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+//==============================================================================
+struct fobos_history
+{
+    uint8_t * data;                 // slots_count transfers back to back
+    uint64_t size;                  // bytes of data
+    size_t transfer_size;           // bytes per slot
+    uint32_t slots_count;           // 0 - keeps nothing
+    struct fobos_record_capture * captures;     // of every slot
+    fobos_mutex_t lock;             // written, streaming and the snapshot state
+    fobos_cond_t cond;              // a transfer was written or the stream stopped
+    uint64_t written;               // transfers since the stream start
+    int streaming;
+    // snapshot
+    struct fobos_record * record;   // being written, NULL - none
+    char * hw;
+    fobos_mutex_t join_lock;        // thread_running, the stream and the user may both join
+    int thread_running;
+    fobos_thread_t thread;
+    struct fobos_rx_snapshot status;
+};
+//==============================================================================
+static void fobos_history_sleep_ms(unsigned int ms)
+{
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    usleep(ms * 1000);
+#endif
+}
+//==============================================================================
+struct fobos_history * fobos_history_create(uint64_t size)
+{
+    if ((size == 0) || (size > (uint64_t)SIZE_MAX))
+    {
+        return NULL;
+    }
+    struct fobos_history * history = (struct fobos_history *)calloc(1, sizeof(struct fobos_history));
+    if (!history)
+    {
+        return NULL;
+    }
+    // the pages are only touched as the transfers come
+    history->data = (uint8_t *)malloc((size_t)size);
+    if (!history->data)
+    {
+        free(history);
+        return NULL;
+    }
+    history->size = size;
+    fobos_mutex_init(&history->lock);
+    fobos_cond_init(&history->cond);
+    fobos_mutex_init(&history->join_lock);
+    return history;
+}
+//==============================================================================
+static void fobos_history_join(struct fobos_history * history)
+{
+    fobos_mutex_lock(&history->join_lock);
+    if (history->thread_running)
+    {
+        fobos_thread_join(history->thread);
+        history->thread_running = 0;
+    }
+    fobos_mutex_unlock(&history->join_lock);
+}
+//==============================================================================
+void fobos_history_destroy(struct fobos_history * history)
+{
+    if (!history)
+    {
+        return;
+    }
+    fobos_history_stop(history);
+    fobos_history_join(history);
+    fobos_mutex_destroy(&history->lock);
+    fobos_cond_destroy(&history->cond);
+    fobos_mutex_destroy(&history->join_lock);
+    free(history->hw);
+    free(history->captures);
+    free(history->data);
+    free(history);
+}
+//==============================================================================
+void fobos_history_start(struct fobos_history * history, size_t transfer_size)
+{
+    fobos_history_join(history);
+    uint64_t slots_count = (transfer_size > 0) ? history->size / transfer_size : 0;
+    if (slots_count > UINT32_MAX)
+    {
+        slots_count = UINT32_MAX;
+    }
+    if (slots_count < FOBOS_HISTORY_MIN_SLOTS)
+    {
+        slots_count = 0;
+    }
+    struct fobos_record_capture * captures = NULL;
+    if (slots_count > 0)
+    {
+        captures = (struct fobos_record_capture *)realloc(history->captures, (size_t)slots_count * sizeof(struct fobos_record_capture));
+        if (!captures)
+        {
+            slots_count = 0;
+        }
+    }
+    fobos_mutex_lock(&history->lock);
+    if (captures)
+    {
+        history->captures = captures;
+    }
+    history->transfer_size = transfer_size;
+    history->slots_count = (uint32_t)slots_count;
+    history->written = 0;
+    history->streaming = 1;
+    fobos_mutex_unlock(&history->lock);
+}
+//==============================================================================
+void fobos_history_push(struct fobos_history * history, const void * data, const struct fobos_record_capture * capture)
+{
+    if (history->slots_count == 0)
+    {
+        return;
+    }
+    // only this thread changes written
+    uint32_t slot = (uint32_t)(history->written % history->slots_count);
+    memcpy(history->data + (size_t)slot * history->transfer_size, data, history->transfer_size);
+    history->captures[slot] = *capture;
+    fobos_mutex_lock(&history->lock);
+    history->written++;
+    fobos_cond_signal(&history->cond);
+    fobos_mutex_unlock(&history->lock);
+}
+//==============================================================================
+void fobos_history_stop(struct fobos_history * history)
+{
+    fobos_mutex_lock(&history->lock);
+    history->streaming = 0;
+    fobos_cond_broadcast(&history->cond);
+    fobos_mutex_unlock(&history->lock);
+}
+//==============================================================================
+// the lock held: the oldest transfer the snapshot may still copy
+static uint64_t fobos_history_oldest(const struct fobos_history * history)
+{
+    uint64_t keep = history->slots_count - 2;
+    return (history->written > keep) ? history->written - keep : 0;
+}
+//==============================================================================
+static FOBOS_THREAD_PROC(fobos_history_writer, arg)
+{
+    struct fobos_history * history = (struct fobos_history *)arg;
+    struct fobos_record * record = history->record;
+    uint32_t slots_count = history->slots_count;
+    uint64_t transfer_samples = history->transfer_size / 4;
+    struct fobos_record_capture last;
+    last.samplerate = 0.0;          // no capture yet
+    uint64_t next = 0;              // stream index of the sample expected next
+    uint64_t seq = 0;
+    int error = 0;
+    fobos_mutex_lock(&history->lock);
+    uint64_t start = history->status.start;
+    uint64_t end = history->status.end;
+    for (;;)
+    {
+        while ((seq >= history->written) && history->streaming)
+        {
+            fobos_cond_wait(&history->cond, &history->lock);
+        }
+        if (seq >= history->written)
+        {
+            // the stream stopped short of the window end
+            break;
+        }
+        uint64_t oldest = fobos_history_oldest(history);
+        if (seq < oldest)
+        {
+            seq = oldest;
+        }
+        struct fobos_record_capture capture = history->captures[seq % slots_count];
+        fobos_mutex_unlock(&history->lock);
+        uint64_t first = capture.global_index;
+        if (first >= end)
+        {
+            fobos_mutex_lock(&history->lock);
+            break;
+        }
+        if (first + transfer_samples > start)
+        {
+            uint64_t lo = first > start ? first : start;
+            uint64_t hi = first + transfer_samples < end ? first + transfer_samples : end;
+            if ((last.samplerate == 0.0) || (lo != next) || !fobos_record_capture_equal(&capture, &last))
+            {
+                if ((last.samplerate != 0.0) && (lo > next))
+                {
+                    fobos_record_gap(record, lo - next);
+                    fobos_mutex_lock(&history->lock);
+                    history->status.gaps++;
+                    fobos_mutex_unlock(&history->lock);
+                }
+                if (capture.time != 0.0)
+                {
+                    capture.time += (double)(lo - first) / capture.samplerate;
+                }
+                capture.global_index = lo;
+                fobos_record_set_capture(record, &capture);
+                if (last.samplerate == 0.0)
+                {
+                    // the part before lo is no longer held
+                    fobos_mutex_lock(&history->lock);
+                    history->status.start = lo;
+                    fobos_mutex_unlock(&history->lock);
+                }
+                last = capture;
+            }
+            const uint8_t * src = history->data + (size_t)(seq % slots_count) * history->transfer_size + (size_t)(lo - first) * 4;
+            int result;
+            while ((result = fobos_record_write(record, src, (size_t)(hi - lo) * 4)) == -5)
+            {
+                // every write buffer is queued, the disk is behind
+                fobos_history_sleep_ms(1);
+                fobos_mutex_lock(&history->lock);
+                int lost = seq < fobos_history_oldest(history);
+                fobos_mutex_unlock(&history->lock);
+                if (lost)
+                {
+                    break;
+                }
+            }
+            if ((result != 0) && (result != -5))
+            {
+                error = result;
+                fobos_mutex_lock(&history->lock);
+                break;
+            }
+            if (result == 0)
+            {
+                next = hi;
+            }
+            fobos_mutex_lock(&history->lock);
+            if ((result == 0) && (history->written - seq >= slots_count))
+            {
+                // overwritten while being copied, the file has a torn transfer
+                error = -5;
+                break;
+            }
+            if (result == 0)
+            {
+                history->status.samples += hi - lo;
+            }
+            if (hi == end)
+            {
+                break;
+            }
+        }
+        else
+        {
+            fobos_mutex_lock(&history->lock);
+        }
+        seq++;
+    }
+    fobos_mutex_unlock(&history->lock);
+    int result = fobos_record_close(record, history->hw);
+    fobos_mutex_lock(&history->lock);
+    history->status.error = error ? error : result;
+    history->status.active = 0;
+    history->record = NULL;
+    fobos_mutex_unlock(&history->lock);
+    return 0;
+}
+//==============================================================================
+int fobos_history_snapshot(struct fobos_history * history, const char * path, uint64_t sample, uint64_t pre, uint64_t post, const char * hw)
+{
+    if (!path || !path[0])
+    {
+        return -7;
+    }
+    fobos_mutex_lock(&history->lock);
+    if (history->status.active)
+    {
+        fobos_mutex_unlock(&history->lock);
+        return -5;
+    }
+    if ((history->slots_count == 0) || (!history->streaming && (history->written == 0)))
+    {
+        fobos_mutex_unlock(&history->lock);
+        return -7;
+    }
+    if (sample == FOBOS_SNAPSHOT_NOW)
+    {
+        sample = 0;
+        if (history->written > 0)
+        {
+            sample = history->captures[(history->written - 1) % history->slots_count].global_index + history->transfer_size / 4;
+        }
+    }
+    uint64_t start = sample > pre ? sample - pre : 0;
+    uint64_t end = post < UINT64_MAX - sample ? sample + post : UINT64_MAX;
+    if (end <= start)
+    {
+        fobos_mutex_unlock(&history->lock);
+        return -7;
+    }
+    // taken, the writer of the previous one is done
+    history->status.active = 1;
+    fobos_mutex_unlock(&history->lock);
+    fobos_history_join(history);
+    free(history->hw);
+    history->hw = NULL;
+    if (hw)
+    {
+        size_t len = strlen(hw) + 1;
+        history->hw = (char *)malloc(len);
+        if (history->hw)
+        {
+            memcpy(history->hw, hw, len);
+        }
+    }
+    // a window the history could hold is reserved up front
+    uint64_t preallocate = (end - start <= history->size / 4) ? (end - start) * 4 : 0;
+    struct fobos_record * record = fobos_record_open(path, preallocate, FOBOS_HISTORY_BUFFER, 0);
+    fobos_mutex_lock(&history->lock);
+    history->record = record;
+    history->status.error = 0;
+    history->status.start = start;
+    history->status.end = end;
+    history->status.samples = 0;
+    history->status.gaps = 0;
+    if (record)
+    {
+        history->status.snapshots++;
+    }
+    history->status.active = record ? 1 : 0;
+    fobos_mutex_unlock(&history->lock);
+    if (!record)
+    {
+        return -ENOMEM;
+    }
+    if (fobos_thread_create(&history->thread, fobos_history_writer, history) != 0)
+    {
+        int result = fobos_record_close(record, history->hw);
+        fobos_mutex_lock(&history->lock);
+        history->record = NULL;
+        history->status.error = result ? result : -ENOMEM;
+        history->status.active = 0;
+        fobos_mutex_unlock(&history->lock);
+        return -ENOMEM;
+    }
+    fobos_mutex_lock(&history->join_lock);
+    history->thread_running = 1;
+    fobos_mutex_unlock(&history->join_lock);
+    return 0;
+}
+//==============================================================================
+void fobos_history_status(struct fobos_history * history, struct fobos_rx_snapshot * status)
+{
+    fobos_mutex_lock(&history->lock);
+    *status = history->status;
+    status->history_start = 0;
+    status->history_end = 0;
+    if ((history->slots_count > 0) && (history->written > 0))
+    {
+        uint64_t oldest = fobos_history_oldest(history);
+        uint64_t newest = history->written - 1;
+        status->history_start = history->captures[oldest % history->slots_count].global_index;
+        status->history_end = history->captures[newest % history->slots_count].global_index + history->transfer_size / 4;
+    }
+    fobos_mutex_unlock(&history->lock);
+}
+//==============================================================================
\ No newline at end of file
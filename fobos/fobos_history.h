@@ -0,0 +1,50 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  History: the last raw transfers kept in memory, snapshots of a window around
+//  a trigger written from it by a thread while the stream goes on
+//==============================================================================
+#ifndef LIB_FOBOS_HISTORY_H
+#define LIB_FOBOS_HISTORY_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos.h"
+#include "fobos_record.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+#define FOBOS_HISTORY_MIN_SLOTS 4                   // transfers, fewer keep nothing
+#define FOBOS_HISTORY_BUFFER (32 * 1024 * 1024)     // bytes the snapshot queues to the disk at most
+    struct fobos_history;
+    // size bytes of transfers, NULL on failure
+    struct fobos_history * fobos_history_create(uint64_t size);
+    // the stream stopped, waits for the snapshot being written
+    void fobos_history_destroy(struct fobos_history * history);
+    //=== the stream ===========================================================
+    // before the first transfer of a stream, transfer_size bytes each; waits for the snapshot of
+    // the previous one, the history restarts empty
+    void fobos_history_start(struct fobos_history * history, size_t transfer_size);
+    // the event thread: a completed transfer as the device sent it, capture - the settings it
+    // was received with, capture->global_index its first sample
+    void fobos_history_push(struct fobos_history * history, const void * data, const struct fobos_record_capture * capture);
+    // after the last transfer, a snapshot waiting for samples ends with those it has
+    void fobos_history_stop(struct fobos_history * history);
+    //=== any thread ===========================================================
+    // as fobos_rx_trigger_snapshot(), hw describes the device
+    int fobos_history_snapshot(struct fobos_history * history, const char * path, uint64_t sample, uint64_t pre, uint64_t post, const char * hw);
+    void fobos_history_status(struct fobos_history * history, struct fobos_rx_snapshot * status);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_HISTORY_H
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,173 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Channelizer: polyphase filterbank and fft, the band split into equally
+//  spaced channels, critically or 2x oversampled
+//==============================================================================
+// Channel k is the input shifted down by k / M (M channels) and filtered by the
+// prototype h, taken every D-th sample. With the newest input sample x[P] of an
+// output, v[p] = sum over t of h[p + t M] x[P - p - t M], then
+// y[k] = e^(-j 2 pi k P / M) * sum over p of v[p] e^(j 2 pi k p / M).
+// The kernel sums the L = M * FOBOS_PFB_TAPS input samples of the window
+// segment by segment with the time reversed taps, u[q] = v[M - 1 - q], so the
+// inner sum is e^(-j 2 pi k / M) * fft(u)[k]. With P = n D the first factor is 1
+// when critically sampled and (-1)^(k n) when 2x oversampled.
+//==============================================================================
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_pfb.h"
+#include "fobos_decim.h"
+#include "fobos_fft.h"
+//==============================================================================
+#define FOBOS_PFB_CHUNK 4096        // input samples appended at a time
+//==============================================================================
+struct fobos_pfb
+{
+    uint32_t channels;
+    uint32_t decimation;
+    uint32_t taps_count;            // channels * FOBOS_PFB_TAPS
+    float * taps;                   // time reversed, every tap twice
+    float * x;                      // the input not consumed yet, the window history first
+    size_t len;                     // complex samples in x
+    size_t next;                    // x index of the newest sample of the next output
+    uint64_t outputs;               // since reset
+    float * u;                      // polyphase sums, channels complex
+    float * y;                      // fft output, channels complex
+    struct fobos_fft * fft;
+    const float * twiddle;          // e^(-j 2 pi k / channels), channels complex
+    fobos_pfb_fn_t sum;
+};
+//==============================================================================
+int fobos_pfb_supported(uint32_t channels)
+{
+    return (channels >= 2) && (channels <= FOBOS_PFB_MAX_CHANNELS) && ((channels & (channels - 1)) == 0);
+}
+//==============================================================================
+void fobos_pfb_destroy(struct fobos_pfb * pfb)
+{
+    if (!pfb)
+    {
+        return;
+    }
+    free(pfb->taps);
+    free(pfb->x);
+    free(pfb->u);
+    free(pfb->y);
+    fobos_fft_destroy(pfb->fft);
+    free(pfb);
+}
+//==============================================================================
+struct fobos_pfb * fobos_pfb_create(uint32_t channels, int oversample, const struct fobos_convert_kernel * kernel)
+{
+    if (!fobos_pfb_supported(channels) || !kernel)
+    {
+        return NULL;
+    }
+    struct fobos_pfb * pfb = (struct fobos_pfb *)calloc(1, sizeof(struct fobos_pfb));
+    if (!pfb)
+    {
+        return NULL;
+    }
+    pfb->channels = channels;
+    pfb->decimation = oversample ? channels / 2 : channels;
+    pfb->taps_count = channels * FOBOS_PFB_TAPS;
+    pfb->sum = kernel->pfb;
+    uint32_t taps_count = pfb->taps_count;
+    float * h = (float *)malloc(taps_count * sizeof(float));
+    pfb->taps = (float *)malloc(2 * taps_count * sizeof(float));
+    pfb->x = (float *)malloc(2 * (taps_count + FOBOS_PFB_CHUNK) * sizeof(float));
+    pfb->u = (float *)malloc(2 * channels * sizeof(float));
+    pfb->y = (float *)malloc(2 * channels * sizeof(float));
+    pfb->fft = fobos_fft_create(channels, kernel);
+    if (!h || !pfb->taps || !pfb->x || !pfb->u || !pfb->y || !pfb->fft ||
+        (fobos_decim_lowpass(h, taps_count, 0.5 / channels, FOBOS_PFB_STOP_DB) != 0))
+    {
+        free(h);
+        fobos_pfb_destroy(pfb);
+        return NULL;
+    }
+    for (uint32_t t = 0; t < taps_count; t++)
+    {
+        pfb->taps[2 * t] = h[taps_count - 1 - t];
+        pfb->taps[2 * t + 1] = h[taps_count - 1 - t];
+    }
+    free(h);
+    pfb->twiddle = fobos_fft_twiddles(pfb->fft);
+    fobos_pfb_reset(pfb);
+    return pfb;
+}
+//==============================================================================
+void fobos_pfb_reset(struct fobos_pfb * pfb)
+{
+    // a window of zeros ahead of the first sample
+    pfb->len = pfb->taps_count - 1;
+    pfb->next = pfb->len;
+    pfb->outputs = 0;
+    memset(pfb->x, 0, 2 * pfb->len * sizeof(float));
+}
+//==============================================================================
+uint32_t fobos_pfb_decimation(const struct fobos_pfb * pfb)
+{
+    return pfb->decimation;
+}
+//==============================================================================
+size_t fobos_pfb_run(struct fobos_pfb * pfb, const float * iq, size_t count, void * const * dst, size_t offset, size_t stride, int format)
+{
+    uint32_t channels = pfb->channels;
+    size_t sample_size = fobos_rx_sample_size(format);
+    size_t produced = 0;
+    while (count > 0)
+    {
+        size_t n = count < FOBOS_PFB_CHUNK ? count : FOBOS_PFB_CHUNK;
+        memcpy(pfb->x + 2 * pfb->len, iq, 2 * n * sizeof(float));
+        pfb->len += n;
+        while (pfb->next < pfb->len)
+        {
+            pfb->sum(pfb->taps, pfb->x + 2 * (pfb->next + 1 - pfb->taps_count), pfb->u, 2 * channels, FOBOS_PFB_TAPS);
+            fobos_fft_run(pfb->fft, pfb->u, pfb->y);
+            // 2x oversampled, the odd channels of the odd outputs change sign
+            float sign = ((pfb->decimation != channels) && (pfb->outputs & 1)) ? -1.0f : 1.0f;
+            size_t item = (offset + produced) * stride * sample_size;
+            for (uint32_t k = 0; k < channels; k++)
+            {
+                const float * w = pfb->twiddle + 2 * k;
+                const float * y = pfb->y + 2 * k;
+                float v[2];
+                v[0] = y[0] * w[0] - y[1] * w[1];
+                v[1] = y[0] * w[1] + y[1] * w[0];
+                if (k & 1)
+                {
+                    v[0] *= sign;
+                    v[1] *= sign;
+                }
+                if (format == FOBOS_FORMAT_FC32)
+                {
+                    memcpy((uint8_t *)dst[k] + item, v, sizeof(v));
+                }
+                else
+                {
+                    fobos_convert_pack(v, (uint8_t *)dst[k] + item, 1, format);
+                }
+            }
+            produced++;
+            pfb->outputs++;
+            pfb->next += pfb->decimation;
+        }
+        // the window of the next output and what follows it move up
+        size_t drop = pfb->next + 1 - pfb->taps_count;
+        memmove(pfb->x, pfb->x + 2 * drop, 2 * (pfb->len - drop) * sizeof(float));
+        pfb->len -= drop;
+        pfb->next -= drop;
+        iq += 2 * n;
+        count -= n;
+    }
+    return produced;
+}
+//==============================================================================
\ No newline at end of file
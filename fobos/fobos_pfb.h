@@ -0,0 +1,52 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Channelizer: polyphase filterbank and fft, the band split into equally
+//  spaced channels, critically or 2x oversampled
+//==============================================================================
+#ifndef LIB_FOBOS_PFB_H
+#define LIB_FOBOS_PFB_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos_convert.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    // channels = 2^n, channel k is centered at k / channels of the input rate, the upper
+    // half of them (k >= channels / 2) at k / channels - 1, the prototype lowpass has
+    // FOBOS_PFB_TAPS taps per channel, is -6 dB at the channel edges, so neighbours add
+    // up flat, and attenuates FOBOS_PFB_STOP_DB from about 0.65 channel widths off center;
+    // critically sampled (decimation = channels) the channel edges alias, 2x oversampled
+    // (decimation = channels / 2) nothing from the stop band aliases into a channel
+#define FOBOS_PFB_MAX_CHANNELS 1024
+#define FOBOS_PFB_TAPS 16
+#define FOBOS_PFB_STOP_DB 72.0
+    struct fobos_pfb;
+    // 1 if channels is supported, a power of 2 from 2 to FOBOS_PFB_MAX_CHANNELS
+    API_EXPORT int CALL_CONV fobos_pfb_supported(uint32_t channels);
+    // sums with the pfb of kernel, NULL if unsupported or out of memory
+    API_EXPORT struct fobos_pfb * CALL_CONV fobos_pfb_create(uint32_t channels, int oversample, const struct fobos_convert_kernel * kernel);
+    API_EXPORT void CALL_CONV fobos_pfb_destroy(struct fobos_pfb * pfb);
+    // zero filter history, for a new stream
+    API_EXPORT void CALL_CONV fobos_pfb_reset(struct fobos_pfb * pfb);
+    // input samples per output sample of every channel
+    API_EXPORT uint32_t CALL_CONV fobos_pfb_decimation(const struct fobos_pfb * pfb);
+    // filters count complex float samples, every decimation-th input sample of the stream
+    // from the first one on gives one sample of every channel, output i of the call goes
+    // to item (offset + i) * stride of dst[k] in format, returns the samples per channel
+    API_EXPORT size_t CALL_CONV fobos_pfb_run(struct fobos_pfb * pfb, const float * iq, size_t count, void * const * dst, size_t offset, size_t stride, int format);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_PFB_H
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,196 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Worker pool: jobs run in parallel and are released in the order they
+//  were queued
+//==============================================================================
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_pool.h"
+#include "fobos_thread.h"
+//==============================================================================
+enum fobos_pool_state
+{
+    FOBOS_POOL_FREE = 0,
+    FOBOS_POOL_QUEUED,
+    FOBOS_POOL_DONE
+};
+//==============================================================================
+struct fobos_pool
+{
+    fobos_mutex_t lock;
+    fobos_cond_t work_cond;         // a job was queued or the pool stops
+    fobos_cond_t idle_cond;         // jobs were released
+    fobos_thread_t * threads;
+    uint32_t workers_count;
+    uint8_t * jobs;
+    size_t job_size;
+    int * states;
+    uint32_t jobs_count;
+    // sequence numbers, the slot of a job is seq % jobs_count
+    uint64_t head;                  // next job to queue
+    uint64_t next;                  // next job to hand to a worker
+    uint64_t tail;                  // next job to release
+    int releasing;                  // a worker runs the release callbacks
+    int stop;
+    fobos_pool_fn_t work;
+    fobos_pool_fn_t release;
+    void * ctx;
+};
+//==============================================================================
+static FOBOS_THREAD_PROC(fobos_pool_worker, arg)
+{
+    struct fobos_pool * pool = (struct fobos_pool *)arg;
+    fobos_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->stop && (pool->next == pool->head))
+        {
+            fobos_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        if (pool->next == pool->head)
+        {
+            break;
+        }
+        uint32_t slot = (uint32_t)(pool->next++ % pool->jobs_count);
+        fobos_mutex_unlock(&pool->lock);
+        pool->work(pool->ctx, pool->jobs + slot * pool->job_size);
+        fobos_mutex_lock(&pool->lock);
+        pool->states[slot] = FOBOS_POOL_DONE;
+        // one worker at a time releases every finished job at the tail, a job
+        // finished meanwhile is seen by the loop condition under the lock
+        if (!pool->releasing)
+        {
+            pool->releasing = 1;
+            while ((pool->tail != pool->head) && (pool->states[pool->tail % pool->jobs_count] == FOBOS_POOL_DONE))
+            {
+                uint32_t tail = (uint32_t)(pool->tail % pool->jobs_count);
+                fobos_mutex_unlock(&pool->lock);
+                pool->release(pool->ctx, pool->jobs + tail * pool->job_size);
+                fobos_mutex_lock(&pool->lock);
+                pool->states[tail] = FOBOS_POOL_FREE;
+                pool->tail++;
+            }
+            pool->releasing = 0;
+            fobos_cond_broadcast(&pool->idle_cond);
+        }
+    }
+    fobos_mutex_unlock(&pool->lock);
+    return 0;
+}
+//==============================================================================
+struct fobos_pool * fobos_pool_create(uint32_t workers_count, uint32_t jobs_count, size_t job_size, fobos_pool_fn_t work, fobos_pool_fn_t release, void * ctx)
+{
+    if ((workers_count == 0) || (jobs_count == 0) || (job_size == 0) || !work || !release)
+    {
+        return NULL;
+    }
+    struct fobos_pool * pool = (struct fobos_pool *)calloc(1, sizeof(struct fobos_pool));
+    if (!pool)
+    {
+        return NULL;
+    }
+    pool->jobs = (uint8_t *)calloc(jobs_count, job_size);
+    pool->states = (int *)calloc(jobs_count, sizeof(int));
+    pool->threads = (fobos_thread_t *)calloc(workers_count, sizeof(fobos_thread_t));
+    if (!pool->jobs || !pool->states || !pool->threads)
+    {
+        free(pool->jobs);
+        free(pool->states);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    pool->job_size = job_size;
+    pool->jobs_count = jobs_count;
+    pool->work = work;
+    pool->release = release;
+    pool->ctx = ctx;
+    fobos_mutex_init(&pool->lock);
+    fobos_cond_init(&pool->work_cond);
+    fobos_cond_init(&pool->idle_cond);
+    for (uint32_t i = 0; i < workers_count; i++)
+    {
+        if (fobos_thread_create(&pool->threads[i], fobos_pool_worker, pool) != 0)
+        {
+            break;
+        }
+        pool->workers_count++;
+    }
+    if (pool->workers_count == 0)
+    {
+        fobos_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+//==============================================================================
+void fobos_pool_destroy(struct fobos_pool * pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+    fobos_pool_drain(pool);
+    fobos_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    fobos_cond_broadcast(&pool->work_cond);
+    fobos_mutex_unlock(&pool->lock);
+    for (uint32_t i = 0; i < pool->workers_count; i++)
+    {
+        fobos_thread_join(pool->threads[i]);
+    }
+    fobos_cond_destroy(&pool->idle_cond);
+    fobos_cond_destroy(&pool->work_cond);
+    fobos_mutex_destroy(&pool->lock);
+    free(pool->jobs);
+    free(pool->states);
+    free(pool->threads);
+    free(pool);
+}
+//==============================================================================
+void * fobos_pool_job(struct fobos_pool * pool, uint32_t i)
+{
+    return (i < pool->jobs_count) ? pool->jobs + i * pool->job_size : NULL;
+}
+//==============================================================================
+uint32_t fobos_pool_jobs_count(const struct fobos_pool * pool)
+{
+    return pool->jobs_count;
+}
+//==============================================================================
+void * fobos_pool_acquire(struct fobos_pool * pool)
+{
+    fobos_mutex_lock(&pool->lock);
+    uint32_t slot = (uint32_t)(pool->head % pool->jobs_count);
+    int free_slot = (pool->head - pool->tail < pool->jobs_count) && (pool->states[slot] == FOBOS_POOL_FREE);
+    fobos_mutex_unlock(&pool->lock);
+    return free_slot ? pool->jobs + slot * pool->job_size : NULL;
+}
+//==============================================================================
+void fobos_pool_commit(struct fobos_pool * pool)
+{
+    fobos_mutex_lock(&pool->lock);
+    pool->states[pool->head % pool->jobs_count] = FOBOS_POOL_QUEUED;
+    pool->head++;
+    fobos_cond_signal(&pool->work_cond);
+    fobos_mutex_unlock(&pool->lock);
+}
+//==============================================================================
+void fobos_pool_drain(struct fobos_pool * pool)
+{
+    fobos_mutex_lock(&pool->lock);
+    while (pool->tail != pool->head)
+    {
+        fobos_cond_wait(&pool->idle_cond, &pool->lock);
+    }
+    fobos_mutex_unlock(&pool->lock);
+}
+//==============================================================================
\ No newline at end of file
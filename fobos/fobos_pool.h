@@ -0,0 +1,46 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Worker pool: jobs run in parallel and are released in the order they
+//  were queued
+//==============================================================================
+#ifndef LIB_FOBOS_POOL_H
+#define LIB_FOBOS_POOL_H
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    struct fobos_pool;
+    // work runs on any worker, concurrently with the other jobs; release runs
+    // once per job, strictly in queue order and never concurrently with itself
+    typedef void(*fobos_pool_fn_t)(void * ctx, void * job);
+    // jobs_count job slots of job_size bytes, zeroed, NULL on failure
+    struct fobos_pool * fobos_pool_create(uint32_t workers_count, uint32_t jobs_count, size_t job_size, fobos_pool_fn_t work, fobos_pool_fn_t release, void * ctx);
+    // releases every queued job and stops the workers
+    void fobos_pool_destroy(struct fobos_pool * pool);
+    // slot i, for setting up per slot resources
+    void * fobos_pool_job(struct fobos_pool * pool, uint32_t i);
+    uint32_t fobos_pool_jobs_count(const struct fobos_pool * pool);
+    //=== single producer ======================================================
+    // next free job slot or NULL when every slot is queued or not yet released
+    void * fobos_pool_acquire(struct fobos_pool * pool);
+    // queue the slot returned by fobos_pool_acquire()
+    void fobos_pool_commit(struct fobos_pool * pool);
+    // wait until every queued job was released
+    void fobos_pool_drain(struct fobos_pool * pool);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_POOL_H
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,134 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Power spectrum: windowed fft, |X|^2 averaged over any number of blocks
+//==============================================================================
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_psd.h"
+#include "fobos_fft.h"
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+//==============================================================================
+struct fobos_psd
+{
+    uint32_t size;
+    uint32_t count;                 // blocks since reset
+    struct fobos_fft * fft;
+    float * window;                 // divided by its sum, so a full scale tone is 0 dB, every value twice
+    float * x;                      // windowed block, size complex
+    float * y;                      // fft output, size complex
+    float * power;                  // sum of |y|^2 since reset, size
+    fobos_pfb_fn_t multiply;        // the window is a polyphase sum of one segment
+    fobos_power_fn_t accumulate;
+};
+//==============================================================================
+void fobos_psd_destroy(struct fobos_psd * psd)
+{
+    if (!psd)
+    {
+        return;
+    }
+    fobos_fft_destroy(psd->fft);
+    free(psd->window);
+    free(psd->x);
+    free(psd->y);
+    free(psd->power);
+    free(psd);
+}
+//==============================================================================
+struct fobos_psd * fobos_psd_create(uint32_t size, int window, const struct fobos_convert_kernel * kernel)
+{
+    if (!fobos_fft_supported(size) || (window < 0) || (window >= FOBOS_WINDOW_COUNT) || !kernel)
+    {
+        return NULL;
+    }
+    struct fobos_psd * psd = (struct fobos_psd *)calloc(1, sizeof(struct fobos_psd));
+    if (!psd)
+    {
+        return NULL;
+    }
+    psd->size = size;
+    psd->multiply = kernel->pfb;
+    psd->accumulate = kernel->power;
+    psd->fft = fobos_fft_create(size, kernel);
+    psd->window = (float *)malloc(2 * size * sizeof(float));
+    psd->x = (float *)malloc(2 * size * sizeof(float));
+    psd->y = (float *)malloc(2 * size * sizeof(float));
+    psd->power = (float *)malloc(size * sizeof(float));
+    if (!psd->fft || !psd->window || !psd->x || !psd->y || !psd->power)
+    {
+        fobos_psd_destroy(psd);
+        return NULL;
+    }
+    // periodic windows, the fft sees them repeat seamlessly
+    double sum = 0.0;
+    for (uint32_t n = 0; n < size; n++)
+    {
+        double t = 2.0 * M_PI * n / size;
+        double w = 1.0;
+        if (window == FOBOS_WINDOW_HANN)
+        {
+            w = 0.5 - 0.5 * cos(t);
+        }
+        else if (window == FOBOS_WINDOW_BLACKMAN_HARRIS)
+        {
+            w = 0.35875 - 0.48829 * cos(t) + 0.14128 * cos(2.0 * t) - 0.01168 * cos(3.0 * t);
+        }
+        psd->window[2 * n] = (float)w;
+        sum += w;
+    }
+    for (uint32_t n = 0; n < size; n++)
+    {
+        psd->window[2 * n] = (float)(psd->window[2 * n] / sum);
+        psd->window[2 * n + 1] = psd->window[2 * n];
+    }
+    fobos_psd_reset(psd);
+    return psd;
+}
+//==============================================================================
+uint32_t fobos_psd_size(const struct fobos_psd * psd)
+{
+    return psd->size;
+}
+//==============================================================================
+void fobos_psd_reset(struct fobos_psd * psd)
+{
+    psd->count = 0;
+    memset(psd->power, 0, psd->size * sizeof(float));
+}
+//==============================================================================
+uint32_t fobos_psd_count(const struct fobos_psd * psd)
+{
+    return psd->count;
+}
+//==============================================================================
+void fobos_psd_add(struct fobos_psd * psd, const float * iq)
+{
+    psd->multiply(psd->window, iq, psd->x, 2 * psd->size, 1);
+    fobos_fft_run(psd->fft, psd->x, psd->y);
+    psd->accumulate(psd->y, psd->power, psd->size);
+    psd->count++;
+}
+//==============================================================================
+void fobos_psd_read(const struct fobos_psd * psd, float * db)
+{
+    uint32_t size = psd->size;
+    float scale = psd->count ? 1.0f / psd->count : 0.0f;
+    for (uint32_t k = 0; k < size; k++)
+    {
+        // fft bin 0 is dc, it goes to the middle
+        float power = psd->power[(k + size / 2) & (size - 1)] * scale;
+        db[k] = (power > 1E-20f) ? 10.0f * log10f(power) : FOBOS_PSD_FLOOR_DB;
+    }
+}
+//==============================================================================
\ No newline at end of file
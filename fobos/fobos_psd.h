@@ -0,0 +1,53 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Power spectrum: windowed fft, |X|^2 averaged over any number of blocks
+//==============================================================================
+#ifndef LIB_FOBOS_PSD_H
+#define LIB_FOBOS_PSD_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos_convert.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    // size = 2^n as fobos_fft_supported(), the window is scaled so that a full scale
+    // tone on a bin center reads 0 dB whatever the window; bins are dc centered,
+    // bin k is at (k - size / 2) / size of the sample rate
+    enum fobos_window
+    {
+        FOBOS_WINDOW_RECT = 0,
+        FOBOS_WINDOW_HANN,
+        FOBOS_WINDOW_BLACKMAN_HARRIS,   // 4 term, -92 dB side lobes
+        FOBOS_WINDOW_COUNT
+    };
+#define FOBOS_PSD_FLOOR_DB -200.0f      // an empty or zero bin
+    struct fobos_psd;
+    // with the window, fft and power sums of kernel, NULL if size or window is unsupported
+    // or out of memory
+    API_EXPORT struct fobos_psd * CALL_CONV fobos_psd_create(uint32_t size, int window, const struct fobos_convert_kernel * kernel);
+    API_EXPORT void CALL_CONV fobos_psd_destroy(struct fobos_psd * psd);
+    API_EXPORT uint32_t CALL_CONV fobos_psd_size(const struct fobos_psd * psd);
+    // drops the accumulated blocks
+    API_EXPORT void CALL_CONV fobos_psd_reset(struct fobos_psd * psd);
+    // blocks accumulated since reset
+    API_EXPORT uint32_t CALL_CONV fobos_psd_count(const struct fobos_psd * psd);
+    // accumulates the spectrum of size complex float samples
+    API_EXPORT void CALL_CONV fobos_psd_add(struct fobos_psd * psd, const float * iq);
+    // the average of the blocks since reset, size bins in dB full scale
+    API_EXPORT void CALL_CONV fobos_psd_read(const struct fobos_psd * psd, float * db);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_PSD_H
+//==============================================================================
\ No newline at end of file
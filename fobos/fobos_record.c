@@ -0,0 +1,859 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Recorder: raw transfers to a SigMF data file by aligned direct writes,
+//  queued through io_uring or a writer thread, and the .sigmf-meta of them
+//==============================================================================
+// The producer copies the transfers into chunks of FOBOS_RECORD_CHUNK bytes, a
+// full chunk goes to the file at chunk index * FOBOS_RECORD_CHUNK. With io_uring
+// the producer submits the chunk and reaps the completions itself, no thread
+// and no syscall but the submission; without it a writer thread pwrite()s the
+// chunks in order. The last chunk is padded to FOBOS_RECORD_ALIGN and the file
+// trimmed to the data afterwards.
+//==============================================================================
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE                 // O_DIRECT, fallocate()
+#endif
+#define _CRT_SECURE_NO_WARNINGS
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fobos_record.h"
+#include "fobos_thread.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define FOBOS_RECORD_URING
+#endif
+#endif
+#endif
+//==============================================================================
+#ifdef _WIN32
+typedef HANDLE fobos_file_t;
+//==============================================================================
+static int fobos_file_open(const char * name, int direct, fobos_file_t * file)
+{
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | (direct ? FILE_FLAG_NO_BUFFERING : 0);
+    *file = CreateFileA(name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, flags, NULL);
+    return (*file == INVALID_HANDLE_VALUE) ? -EIO : 0;
+}
+//==============================================================================
+static int64_t fobos_file_pwrite(fobos_file_t file, const void * data, size_t size, uint64_t offset)
+{
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = (DWORD)offset;
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD written = 0;
+    return WriteFile(file, data, (DWORD)size, &written, &overlapped) ? (int64_t)written : -EIO;
+}
+//==============================================================================
+static void fobos_file_preallocate(fobos_file_t file, uint64_t size)
+{
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = (LONGLONG)size;
+    SetFileInformationByHandle(file, FileAllocationInfo, &info, sizeof(info));
+}
+//==============================================================================
+static int fobos_file_truncate(fobos_file_t file, uint64_t size)
+{
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)size;
+    return (SetFilePointerEx(file, end, NULL, FILE_BEGIN) && SetEndOfFile(file)) ? 0 : -EIO;
+}
+//==============================================================================
+static void fobos_file_close(fobos_file_t file)
+{
+    CloseHandle(file);
+}
+#else
+typedef int fobos_file_t;
+//==============================================================================
+static int fobos_file_open(const char * name, int direct, fobos_file_t * file)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (direct)
+    {
+        flags |= O_DIRECT;
+    }
+#endif
+    *file = open(name, flags, 0644);
+    if (*file < 0)
+    {
+        return -errno;
+    }
+#if defined(F_NOCACHE) && !defined(O_DIRECT)
+    if (direct && (fcntl(*file, F_NOCACHE, 1) != 0))
+    {
+        close(*file);
+        return -EINVAL;
+    }
+#endif
+    return 0;
+}
+//==============================================================================
+static int64_t fobos_file_pwrite(fobos_file_t file, const void * data, size_t size, uint64_t offset)
+{
+    ssize_t written = pwrite(file, data, size, (off_t)offset);
+    return (written < 0) ? -errno : (int64_t)written;
+}
+//==============================================================================
+static void fobos_file_preallocate(fobos_file_t file, uint64_t size)
+{
+#ifdef __linux__
+    // the extents only, no zeros written; a file system without it reserves nothing
+    (void)fallocate(file, 0, 0, (off_t)size);
+#else
+    (void)file;
+    (void)size;
+#endif
+}
+//==============================================================================
+static int fobos_file_truncate(fobos_file_t file, uint64_t size)
+{
+    return (ftruncate(file, (off_t)size) == 0) ? 0 : -errno;
+}
+//==============================================================================
+static void fobos_file_close(fobos_file_t file)
+{
+    close(file);
+}
+#endif
+//==============================================================================
+struct fobos_record_chunk
+{
+    uint8_t * data;
+    size_t len;                     // bytes filled
+    size_t done;                    // bytes written, a short write goes on from there
+    uint64_t offset;                // file offset of data[0]
+#ifdef FOBOS_RECORD_URING
+    struct iovec iov;               // of the write in flight
+#endif
+};
+//==============================================================================
+#ifdef FOBOS_RECORD_URING
+struct fobos_record_ring
+{
+    int fd;
+    void * sq_map;
+    size_t sq_map_size;
+    void * cq_map;
+    size_t cq_map_size;
+    struct io_uring_sqe * sqes;
+    size_t sqes_size;
+    unsigned * sq_tail;
+    unsigned * sq_mask;
+    unsigned * sq_array;
+    unsigned * cq_head;
+    unsigned * cq_tail;
+    unsigned * cq_mask;
+    struct io_uring_cqe * cqes;
+    uint32_t inflight;
+};
+#endif
+//==============================================================================
+struct fobos_record_gap
+{
+    uint64_t sample_start;
+    uint64_t lost;
+};
+//==============================================================================
+struct fobos_record
+{
+    char * path;                    // without the extension
+    fobos_file_t file;
+    int backend;                    // 1 - io_uring, 2 - writer thread
+    int direct;
+    uint8_t * memory;               // the chunk data, aligned
+    struct fobos_record_chunk * chunks;
+    uint32_t chunks_count;
+    struct fobos_record_chunk * fill;   // being filled by the producer, NULL - none
+    uint64_t offset;                // file offset of the next chunk
+    fobos_mutex_t lock;             // the free chunks, the queue, error and written
+    fobos_cond_t cond;              // a chunk was queued or the writer stops
+    uint32_t * free;
+    uint32_t free_count;
+    int error;
+    uint64_t written;
+    // writer thread: the queued chunks in file order
+    uint32_t * queue;
+    uint32_t queue_head;
+    uint32_t queue_len;
+    int stop;
+    int thread_running;
+    fobos_thread_t thread;
+#ifdef FOBOS_RECORD_URING
+    struct fobos_record_ring ring;
+#endif
+    // producer
+    uint64_t bytes;
+    uint64_t transfers;
+    uint64_t dropped;
+    struct fobos_record_capture * captures;
+    uint64_t * capture_starts;      // sample in the data file
+    uint32_t captures_count;
+    uint32_t captures_size;
+    struct fobos_record_gap * gaps;
+    uint32_t gaps_count;
+    uint32_t gaps_size;
+};
+//==============================================================================
+static void * fobos_record_alloc(size_t size)
+{
+#ifdef _WIN32
+    return _aligned_malloc(size, FOBOS_RECORD_ALIGN);
+#else
+    void * memory = NULL;
+    return (posix_memalign(&memory, FOBOS_RECORD_ALIGN, size) == 0) ? memory : NULL;
+#endif
+}
+//==============================================================================
+static void fobos_record_free(void * memory)
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+//==============================================================================
+// a chunk is written or failed, the writer thread or the reaping producer
+static void fobos_record_release(struct fobos_record * record, struct fobos_record_chunk * chunk, int result)
+{
+    fobos_mutex_lock(&record->lock);
+    if ((result < 0) && (record->error == 0))
+    {
+        record->error = result;
+    }
+    if (result >= 0)
+    {
+        record->written += chunk->len;
+    }
+    record->free[record->free_count++] = (uint32_t)(chunk - record->chunks);
+    fobos_cond_broadcast(&record->cond);
+    fobos_mutex_unlock(&record->lock);
+}
+//==============================================================================
+static int fobos_record_pwrite(struct fobos_record * record, struct fobos_record_chunk * chunk)
+{
+    while (chunk->done < chunk->len)
+    {
+        int64_t written = fobos_file_pwrite(record->file, chunk->data + chunk->done, chunk->len - chunk->done, chunk->offset + chunk->done);
+        if (written <= 0)
+        {
+            return written < 0 ? (int)written : -EIO;
+        }
+        chunk->done += (size_t)written;
+    }
+    return 0;
+}
+//==============================================================================
+static FOBOS_THREAD_PROC(fobos_record_writer, arg)
+{
+    struct fobos_record * record = (struct fobos_record *)arg;
+    fobos_mutex_lock(&record->lock);
+    for (;;)
+    {
+        while (!record->stop && (record->queue_len == 0))
+        {
+            fobos_cond_wait(&record->cond, &record->lock);
+        }
+        if (record->queue_len == 0)
+        {
+            break;
+        }
+        struct fobos_record_chunk * chunk = &record->chunks[record->queue[record->queue_head]];
+        record->queue_head = (record->queue_head + 1) % record->chunks_count;
+        record->queue_len--;
+        int failed = record->error;
+        fobos_mutex_unlock(&record->lock);
+        // after an error the chunks only go back to the free list
+        int result = failed ? failed : fobos_record_pwrite(record, chunk);
+        fobos_record_release(record, chunk, result);
+        fobos_mutex_lock(&record->lock);
+    }
+    fobos_mutex_unlock(&record->lock);
+    return 0;
+}
+//==============================================================================
+#ifdef FOBOS_RECORD_URING
+static void fobos_record_ring_close(struct fobos_record_ring * ring)
+{
+    if (ring->sqes)
+    {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_map && (ring->cq_map != ring->sq_map))
+    {
+        munmap(ring->cq_map, ring->cq_map_size);
+    }
+    if (ring->sq_map)
+    {
+        munmap(ring->sq_map, ring->sq_map_size);
+    }
+    if (ring->fd >= 0)
+    {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+//==============================================================================
+// 0 or -1 where io_uring is missing or not allowed
+static int fobos_record_ring_open(struct fobos_record_ring * ring, uint32_t entries)
+{
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0)
+    {
+        return -1;
+    }
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single = 0;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+    if (single && (ring->cq_map_size > ring->sq_map_size))
+    {
+        ring->sq_map_size = ring->cq_map_size;
+    }
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED)
+    {
+        ring->sq_map = NULL;
+        fobos_record_ring_close(ring);
+        return -1;
+    }
+    ring->cq_map = single ? ring->sq_map : mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_map == MAP_FAILED)
+    {
+        ring->cq_map = NULL;
+        fobos_record_ring_close(ring);
+        return -1;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        ring->sqes = NULL;
+        fobos_record_ring_close(ring);
+        return -1;
+    }
+    uint8_t * sq = (uint8_t *)ring->sq_map;
+    uint8_t * cq = (uint8_t *)ring->cq_map;
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+//==============================================================================
+// the rest of a chunk as one writev, at most chunks_count of them in flight, so
+// the submission queue always has room
+static int fobos_record_submit(struct fobos_record * record, struct fobos_record_chunk * chunk)
+{
+    struct fobos_record_ring * ring = &record->ring;
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe * sqe = &ring->sqes[index];
+    chunk->iov.iov_base = chunk->data + chunk->done;
+    chunk->iov.iov_len = chunk->len - chunk->done;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = record->file;
+    sqe->addr = (uint64_t)(uintptr_t)&chunk->iov;
+    sqe->len = 1;
+    sqe->off = chunk->offset + chunk->done;
+    sqe->user_data = (uint64_t)(chunk - record->chunks);
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->inflight++;
+    if (syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0) < 0)
+    {
+        // nothing was consumed, the entry is taken back
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+        ring->inflight--;
+        return -errno;
+    }
+    return 0;
+}
+//==============================================================================
+// the completions so far, wait - block until one more arrived
+static void fobos_record_reap(struct fobos_record * record, int wait)
+{
+    struct fobos_record_ring * ring = &record->ring;
+    if (wait && (ring->inflight > 0))
+    {
+        syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    }
+    unsigned head = *ring->cq_head;
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        const struct io_uring_cqe * cqe = &ring->cqes[head & *ring->cq_mask];
+        struct fobos_record_chunk * chunk = &record->chunks[cqe->user_data];
+        int res = cqe->res;
+        head++;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+        ring->inflight--;
+        if (res > 0)
+        {
+            chunk->done += (size_t)res;
+            if ((chunk->done < chunk->len) && (fobos_record_submit(record, chunk) == 0))
+            {
+                continue;
+            }
+        }
+        fobos_record_release(record, chunk, (res < 0) ? res : (chunk->done < chunk->len) ? -EIO : 0);
+    }
+}
+#endif
+//==============================================================================
+static void fobos_record_queue(struct fobos_record * record, struct fobos_record_chunk * chunk)
+{
+    chunk->done = 0;
+#ifdef FOBOS_RECORD_URING
+    if (record->backend == FOBOS_RECORD_BACKEND_URING)
+    {
+        int result = fobos_record_submit(record, chunk);
+        if (result != 0)
+        {
+            fobos_record_release(record, chunk, result);
+        }
+        return;
+    }
+#endif
+    fobos_mutex_lock(&record->lock);
+    record->queue[(record->queue_head + record->queue_len) % record->chunks_count] = (uint32_t)(chunk - record->chunks);
+    record->queue_len++;
+    fobos_cond_broadcast(&record->cond);
+    fobos_mutex_unlock(&record->lock);
+}
+//==============================================================================
+static void fobos_record_destroy(struct fobos_record * record)
+{
+    if (record->thread_running)
+    {
+        fobos_mutex_lock(&record->lock);
+        record->stop = 1;
+        fobos_cond_broadcast(&record->cond);
+        fobos_mutex_unlock(&record->lock);
+        fobos_thread_join(record->thread);
+    }
+#ifdef FOBOS_RECORD_URING
+    fobos_record_ring_close(&record->ring);
+#endif
+    fobos_mutex_destroy(&record->lock);
+    fobos_cond_destroy(&record->cond);
+    fobos_record_free(record->memory);
+    free(record->chunks);
+    free(record->free);
+    free(record->queue);
+    free(record->captures);
+    free(record->capture_starts);
+    free(record->gaps);
+    free(record->path);
+    free(record);
+}
+//==============================================================================
+struct fobos_record * fobos_record_open(const char * path, uint64_t preallocate, size_t buffer, int flags)
+{
+    if (!path || !path[0])
+    {
+        return NULL;
+    }
+    struct fobos_record * record = (struct fobos_record *)calloc(1, sizeof(struct fobos_record));
+    if (!record)
+    {
+        return NULL;
+    }
+    fobos_mutex_init(&record->lock);
+    fobos_cond_init(&record->cond);
+#ifdef FOBOS_RECORD_URING
+    record->ring.fd = -1;
+#endif
+    uint32_t chunks_count = (uint32_t)(buffer / FOBOS_RECORD_CHUNK);
+    if (chunks_count < FOBOS_RECORD_MIN_CHUNKS)
+    {
+        chunks_count = FOBOS_RECORD_MIN_CHUNKS;
+    }
+    size_t path_len = strlen(path);
+    record->path = (char *)malloc(path_len + 1);
+    record->memory = (uint8_t *)fobos_record_alloc((size_t)chunks_count * FOBOS_RECORD_CHUNK);
+    record->chunks = (struct fobos_record_chunk *)calloc(chunks_count, sizeof(struct fobos_record_chunk));
+    record->free = (uint32_t *)malloc(chunks_count * sizeof(uint32_t));
+    record->queue = (uint32_t *)malloc(chunks_count * sizeof(uint32_t));
+    if (!record->path || !record->memory || !record->chunks || !record->free || !record->queue)
+    {
+        fobos_record_destroy(record);
+        return NULL;
+    }
+    memcpy(record->path, path, path_len + 1);
+    record->chunks_count = chunks_count;
+    for (uint32_t i = 0; i < chunks_count; i++)
+    {
+        record->chunks[i].data = record->memory + (size_t)i * FOBOS_RECORD_CHUNK;
+        record->free[i] = chunks_count - 1 - i;
+    }
+    record->free_count = chunks_count;
+    char * name = (char *)malloc(path_len + sizeof(".sigmf-data"));
+    if (!name)
+    {
+        fobos_record_destroy(record);
+        return NULL;
+    }
+    sprintf(name, "%s.sigmf-data", path);
+    // a file system without direct io (tmpfs) gets buffered writes
+    record->direct = !(flags & FOBOS_RECORD_NO_DIRECT);
+    int result = fobos_file_open(name, record->direct, &record->file);
+    if ((result == -EINVAL) && record->direct)
+    {
+        record->direct = 0;
+        result = fobos_file_open(name, 0, &record->file);
+    }
+    free(name);
+    if (result != 0)
+    {
+        fobos_record_destroy(record);
+        return NULL;
+    }
+    if (preallocate > 0)
+    {
+        fobos_file_preallocate(record->file, preallocate);
+    }
+#ifdef FOBOS_RECORD_URING
+    if (!(flags & FOBOS_RECORD_NO_URING) && (fobos_record_ring_open(&record->ring, chunks_count) == 0))
+    {
+        record->backend = FOBOS_RECORD_BACKEND_URING;
+        return record;
+    }
+#endif
+    if (fobos_thread_create(&record->thread, fobos_record_writer, record) != 0)
+    {
+        fobos_file_close(record->file);
+        fobos_record_destroy(record);
+        return NULL;
+    }
+    record->thread_running = 1;
+    record->backend = FOBOS_RECORD_BACKEND_THREAD;
+    return record;
+}
+//==============================================================================
+int fobos_record_write(struct fobos_record * record, const void * data, size_t size)
+{
+#ifdef FOBOS_RECORD_URING
+    if (record->backend == FOBOS_RECORD_BACKEND_URING)
+    {
+        fobos_record_reap(record, 0);
+    }
+#endif
+    fobos_mutex_lock(&record->lock);
+    int error = record->error;
+    uint64_t space = (uint64_t)record->free_count * FOBOS_RECORD_CHUNK;
+    fobos_mutex_unlock(&record->lock);
+    if (error != 0)
+    {
+        return error;
+    }
+    // only this thread takes free chunks, the space can only grow meanwhile
+    if (record->fill)
+    {
+        space += FOBOS_RECORD_CHUNK - record->fill->len;
+    }
+    if (space < size)
+    {
+        record->dropped++;
+        return -5;
+    }
+    const uint8_t * src = (const uint8_t *)data;
+    size_t left = size;
+    while (left > 0)
+    {
+        if (!record->fill)
+        {
+            fobos_mutex_lock(&record->lock);
+            record->fill = &record->chunks[record->free[--record->free_count]];
+            fobos_mutex_unlock(&record->lock);
+            record->fill->len = 0;
+            record->fill->offset = record->offset;
+            record->offset += FOBOS_RECORD_CHUNK;
+        }
+        size_t n = FOBOS_RECORD_CHUNK - record->fill->len;
+        if (n > left)
+        {
+            n = left;
+        }
+        memcpy(record->fill->data + record->fill->len, src, n);
+        record->fill->len += n;
+        src += n;
+        left -= n;
+        if (record->fill->len == FOBOS_RECORD_CHUNK)
+        {
+            fobos_record_queue(record, record->fill);
+            record->fill = NULL;
+        }
+    }
+    record->bytes += size;
+    record->transfers++;
+    return 0;
+}
+//==============================================================================
+int fobos_record_capture_equal(const struct fobos_record_capture * a, const struct fobos_record_capture * b)
+{
+    return (a->frequency == b->frequency) && (a->samplerate == b->samplerate) &&
+        (a->lna_gain == b->lna_gain) && (a->vga_gain == b->vga_gain) &&
+        (a->direct_sampling == b->direct_sampling) && (a->swap_iq == b->swap_iq);
+}
+//==============================================================================
+int fobos_record_set_capture(struct fobos_record * record, const struct fobos_record_capture * capture)
+{
+    uint64_t start = record->bytes / 4;
+    uint32_t i = record->captures_count;
+    if ((i > 0) && (record->capture_starts[i - 1] == start))
+    {
+        i--;
+    }
+    else if (i == record->captures_size)
+    {
+        uint32_t size = record->captures_size ? 2 * record->captures_size : 16;
+        struct fobos_record_capture * captures = (struct fobos_record_capture *)realloc(record->captures, size * sizeof(struct fobos_record_capture));
+        if (captures)
+        {
+            record->captures = captures;
+        }
+        uint64_t * starts = (uint64_t *)realloc(record->capture_starts, size * sizeof(uint64_t));
+        if (starts)
+        {
+            record->capture_starts = starts;
+        }
+        if (!captures || !starts)
+        {
+            return -ENOMEM;
+        }
+        record->captures_size = size;
+    }
+    record->captures[i] = *capture;
+    record->capture_starts[i] = start;
+    record->captures_count = i + 1;
+    return 0;
+}
+//==============================================================================
+int fobos_record_gap(struct fobos_record * record, uint64_t lost)
+{
+    if (record->gaps_count == record->gaps_size)
+    {
+        uint32_t size = record->gaps_size ? 2 * record->gaps_size : 16;
+        struct fobos_record_gap * gaps = (struct fobos_record_gap *)realloc(record->gaps, size * sizeof(struct fobos_record_gap));
+        if (!gaps)
+        {
+            return -ENOMEM;
+        }
+        record->gaps = gaps;
+        record->gaps_size = size;
+    }
+    record->gaps[record->gaps_count].sample_start = record->bytes / 4;
+    record->gaps[record->gaps_count].lost = lost;
+    record->gaps_count++;
+    return 0;
+}
+//==============================================================================
+static void fobos_record_json_string(FILE * file, const char * value)
+{
+    fputc('"', file);
+    for (; *value; value++)
+    {
+        unsigned char c = (unsigned char)*value;
+        if ((c == '"') || (c == '\\'))
+        {
+            fprintf(file, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+//==============================================================================
+static void fobos_record_json_time(FILE * file, double time)
+{
+    time_t secs = (time_t)time;
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &secs);
+#else
+    gmtime_r(&secs, &utc);
+#endif
+    int ms = (int)((time - (double)secs) * 1000.0);
+    fprintf(file, "\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\"", utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, ms);
+}
+//==============================================================================
+// SigMF 1.0: the fobos: fields of a capture reproduce the conversion of its samples,
+// (word & 0x3FFF) - dc, im scaled by gain and rotated by phase, i and q swapped if swap_iq
+static int fobos_record_write_meta(const struct fobos_record * record, const char * hw)
+{
+    size_t path_len = strlen(record->path);
+    char * name = (char *)malloc(path_len + sizeof(".sigmf-meta"));
+    if (!name)
+    {
+        return -ENOMEM;
+    }
+    sprintf(name, "%s.sigmf-meta", record->path);
+    FILE * file = fopen(name, "w");
+    free(name);
+    if (!file)
+    {
+        return -errno;
+    }
+    double samplerate = record->captures_count ? record->captures[0].samplerate : 0.0;
+    fprintf(file, "{\n    \"global\": {\n");
+    fprintf(file, "        \"core:datatype\": \"cu16_le\",\n");
+    fprintf(file, "        \"core:sample_rate\": %.17g,\n", samplerate);
+    fprintf(file, "        \"core:version\": \"1.0.0\",\n");
+    fprintf(file, "        \"core:num_channels\": 1,\n");
+    fprintf(file, "        \"core:hw\": ");
+    fobos_record_json_string(file, hw ? hw : "");
+    fprintf(file, ",\n        \"core:recorder\": \"libfobos\",\n");
+    fprintf(file, "        \"core:extensions\": [{ \"name\": \"fobos\", \"version\": \"1.0.0\", \"optional\": true }],\n");
+    fprintf(file, "        \"fobos:sample_bits\": 14,\n");
+    fprintf(file, "        \"fobos:dropped_transfers\": %llu\n", (unsigned long long)record->dropped);
+    fprintf(file, "    },\n    \"captures\": [");
+    for (uint32_t i = 0; i < record->captures_count; i++)
+    {
+        const struct fobos_record_capture * c = &record->captures[i];
+        fprintf(file, "%s\n        {\n", i ? "," : "");
+        fprintf(file, "            \"core:sample_start\": %llu,\n", (unsigned long long)record->capture_starts[i]);
+        fprintf(file, "            \"core:global_index\": %llu,\n", (unsigned long long)c->global_index);
+        fprintf(file, "            \"core:frequency\": %.17g,\n", c->frequency);
+        if (c->time > 0.0)
+        {
+            fprintf(file, "            \"core:datetime\": ");
+            fobos_record_json_time(file, c->time);
+            fprintf(file, ",\n");
+        }
+        if (c->samplerate != samplerate)
+        {
+            fprintf(file, "            \"fobos:sample_rate\": %.17g,\n", c->samplerate);
+        }
+        fprintf(file, "            \"fobos:lna_gain\": %u,\n", c->lna_gain);
+        fprintf(file, "            \"fobos:vga_gain\": %u,\n", c->vga_gain);
+        fprintf(file, "            \"fobos:direct_sampling\": %d,\n", c->direct_sampling);
+        fprintf(file, "            \"fobos:swap_iq\": %d,\n", c->swap_iq);
+        fprintf(file, "            \"fobos:dc_re\": %.9g,\n", c->correction.dc_re);
+        fprintf(file, "            \"fobos:dc_im\": %.9g,\n", c->correction.dc_im);
+        fprintf(file, "            \"fobos:gain\": %.9g,\n", c->correction.gain);
+        fprintf(file, "            \"fobos:phase\": %.9g\n", c->correction.phase);
+        fprintf(file, "        }");
+    }
+    fprintf(file, "\n    ],\n    \"annotations\": [");
+    for (uint32_t i = 0; i < record->gaps_count; i++)
+    {
+        const struct fobos_record_gap * g = &record->gaps[i];
+        fprintf(file, "%s\n        {\n", i ? "," : "");
+        fprintf(file, "            \"core:sample_start\": %llu,\n", (unsigned long long)g->sample_start);
+        fprintf(file, "            \"core:label\": \"gap\",\n");
+        fprintf(file, "            \"core:comment\": \"%llu samples lost before this one\",\n", (unsigned long long)g->lost);
+        fprintf(file, "            \"fobos:lost_samples\": %llu\n", (unsigned long long)g->lost);
+        fprintf(file, "        }");
+    }
+    fprintf(file, "\n    ]\n}\n");
+    int result = ferror(file) ? -EIO : 0;
+    if (fclose(file) != 0)
+    {
+        result = -EIO;
+    }
+    return result;
+}
+//==============================================================================
+int fobos_record_close(struct fobos_record * record, const char * hw)
+{
+    if (!record)
+    {
+        return -7;
+    }
+    if (record->fill)
+    {
+        // direct writes only take whole blocks, the padding is cut off below
+        size_t len = (record->fill->len + FOBOS_RECORD_ALIGN - 1) / FOBOS_RECORD_ALIGN * FOBOS_RECORD_ALIGN;
+        memset(record->fill->data + record->fill->len, 0, len - record->fill->len);
+        record->fill->len = len;
+        fobos_record_queue(record, record->fill);
+        record->fill = NULL;
+    }
+#ifdef FOBOS_RECORD_URING
+    if (record->backend == FOBOS_RECORD_BACKEND_URING)
+    {
+        while (record->ring.inflight > 0)
+        {
+            fobos_record_reap(record, 1);
+        }
+    }
+#endif
+    fobos_mutex_lock(&record->lock);
+    while (record->free_count < record->chunks_count)
+    {
+        fobos_cond_wait(&record->cond, &record->lock);
+    }
+    int result = record->error;
+    fobos_mutex_unlock(&record->lock);
+    int truncated = fobos_file_truncate(record->file, record->bytes);
+    if (result == 0)
+    {
+        result = truncated;
+    }
+    fobos_file_close(record->file);
+    int meta = fobos_record_write_meta(record, hw);
+    if (result == 0)
+    {
+        result = meta;
+    }
+    fobos_record_destroy(record);
+    return result;
+}
+//==============================================================================
+void fobos_record_status(struct fobos_record * record, struct fobos_rx_recording * status)
+{
+    fobos_mutex_lock(&record->lock);
+    status->error = record->error;
+    status->written = record->written < record->bytes ? record->written : record->bytes;
+    fobos_mutex_unlock(&record->lock);
+    status->active = 1;
+    status->backend = record->backend;
+    status->direct = record->direct;
+    status->bytes = record->bytes;
+    status->transfers = record->transfers;
+    status->dropped = record->dropped;
+    status->gaps = record->gaps_count;
+    status->captures = record->captures_count;
+}
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,73 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Recorder: raw transfers to a SigMF data file by aligned direct writes,
+//  queued through io_uring or a writer thread, and the .sigmf-meta of them
+//==============================================================================
+#ifndef LIB_FOBOS_RECORD_H
+#define LIB_FOBOS_RECORD_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+    // the data file holds the transfers as the device sent them, cu16_le: 14 bit
+    // offset binary in the low bits, the fobos: fields of every capture say how
+    // fobos_rx_convert() turned them into samples, see fobos_record_write_meta()
+#define FOBOS_RECORD_ALIGN 4096                 // file offsets, lengths and buffers of direct writes
+#define FOBOS_RECORD_CHUNK (4 * 1024 * 1024)    // bytes per write
+#define FOBOS_RECORD_MIN_CHUNKS 4
+    enum fobos_record_flags
+    {
+        FOBOS_RECORD_NO_URING = 1,              // the writer thread even where io_uring works
+        FOBOS_RECORD_NO_DIRECT = 2              // through the page cache
+    };
+    // what the samples from a capture on were taken with
+    struct fobos_record_capture
+    {
+        uint64_t global_index;      // stream sample index of the first sample, fobos_rx_get_sample_index()
+        double frequency;           // the lo, the center of the raw samples, Hz
+        double samplerate;          // Hz
+        double time;                // unix time of the first sample, s, 0 - unknown
+        unsigned int lna_gain;
+        unsigned int vga_gain;
+        int direct_sampling;
+        int swap_iq;                // 1 - the second word of a pair is i
+        struct fobos_iq_correction correction;
+    };
+    // 1 - the same settings, global_index, time and correction aside
+    int fobos_record_capture_equal(const struct fobos_record_capture * a, const struct fobos_record_capture * b);
+    struct fobos_record;
+    // path + ".sigmf-data" created or truncated, preallocate bytes reserved up front,
+    // buffer bytes of chunks queued at most, NULL on failure
+    struct fobos_record * fobos_record_open(const char * path, uint64_t preallocate, size_t buffer, int flags);
+    //=== single producer ======================================================
+    // appends size bytes, all or nothing: 0, -5 every buffer is queued and the bytes are
+    // dropped, or the first write error, after which nothing is written any more
+    int fobos_record_write(struct fobos_record * record, const void * data, size_t size);
+    // the samples appended from now on, replaces a capture that got no samples
+    int fobos_record_set_capture(struct fobos_record * record, const struct fobos_record_capture * capture);
+    // an annotation at the current end of the data: lost samples the data skips
+    int fobos_record_gap(struct fobos_record * record, uint64_t lost);
+    //==========================================================================
+    // writes what is queued, trims the file to the data and writes path + ".sigmf-meta",
+    // hw describes the device; returns 0 or the first error
+    int fobos_record_close(struct fobos_record * record, const char * hw);
+    // a snapshot, any thread
+    void fobos_record_status(struct fobos_record * record, struct fobos_rx_recording * status);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_RECORD_H
+//==============================================================================
\ No newline at end of file
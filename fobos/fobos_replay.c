@@ -0,0 +1,561 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Replay: a memory mapped recording read back as the device would send it
+//==============================================================================
+// The data file is mapped read only and read front to back: the kernel is told
+// so, the window ahead of the reader is paged in and the one behind it let go,
+// so a recording larger than the memory streams at the disk rate. Raw samples
+// are copied, swapped pairwise where the capture had the other word order than
+// the device has now; sc16 and fc32 samples go back to 14 bit offset binary
+// codes, so the conversion sees them as it would see the adc.
+//==============================================================================
+#define _CRT_SECURE_NO_WARNINGS
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_replay.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+//==============================================================================
+#define FOBOS_REPLAY_MID 8192.0f            // the code of 0, 14 bit offset binary
+#define FOBOS_REPLAY_MAX 16383.0f
+#define FOBOS_REPLAY_FC32_SCALE 32768.0f    // raw lsb per FOBOS_FORMAT_FC32 unit
+//==============================================================================
+struct fobos_replay_capture
+{
+    uint64_t start;                 // sample index in the data file
+    int swap_iq;                    // raw recordings: 1 - the second word of a pair is i
+};
+struct fobos_replay
+{
+    int format;
+    size_t sample_size;             // bytes per complex sample in the file
+    const uint8_t * data;
+    uint64_t size;                  // bytes mapped
+    uint64_t samples;
+    volatile uint64_t position;
+    volatile uint32_t loops;
+    uint64_t advised;               // bytes paged in from the start on
+    uint32_t capture;               // of position
+    struct fobos_replay_capture * captures;
+    uint32_t captures_count;
+    double samplerate;
+    double frequency;
+    unsigned int lna_gain;
+    unsigned int vga_gain;
+    int direct_sampling;
+    struct fobos_iq_correction correction;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+//==============================================================================
+static size_t fobos_replay_sample_size(int format)
+{
+    return (format == FOBOS_REPLAY_FC32) ? 2 * sizeof(float) : 2 * sizeof(int16_t);
+}
+//==============================================================================
+static int fobos_replay_ends_with(const char * text, size_t len, const char * suffix)
+{
+    size_t suffix_len = strlen(suffix);
+    return (len >= suffix_len) && (memcmp(text + len - suffix_len, suffix, suffix_len) == 0);
+}
+//==============================================================================
+// the first len chars of path and ext, malloc()ed
+static char * fobos_replay_name(const char * path, size_t len, const char * ext)
+{
+    size_t ext_len = strlen(ext);
+    char * name = (char *)malloc(len + ext_len + 1);
+    if (name)
+    {
+        memcpy(name, path, len);
+        memcpy(name + len, ext, ext_len + 1);
+    }
+    return name;
+}
+//==============================================================================
+// the whole file as a string, NULL if there is none
+static char * fobos_replay_load(const char * name)
+{
+    FILE * file = fopen(name, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+    char * text = NULL;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        long len = ftell(file);
+        if ((len >= 0) && (fseek(file, 0, SEEK_SET) == 0))
+        {
+            text = (char *)malloc((size_t)len + 1);
+            if (text && (fread(text, 1, (size_t)len, file) == (size_t)len))
+            {
+                text[len] = 0;
+            }
+            else
+            {
+                free(text);
+                text = NULL;
+            }
+        }
+    }
+    fclose(file);
+    return text;
+}
+//==============================================================================
+// the value of "key" within begin .. end, NULL if it is not there; the text is
+// a string, a number may run past end
+static const char * fobos_replay_json_find(const char * begin, const char * end, const char * key)
+{
+    size_t key_len = strlen(key);
+    for (const char * p = begin; p + key_len + 2 <= end; p++)
+    {
+        if ((p[0] == '"') && (memcmp(p + 1, key, key_len) == 0) && (p[key_len + 1] == '"'))
+        {
+            const char * value = p + key_len + 2;
+            while ((value < end) && ((*value == ':') || (*value == ' ') || (*value == '\t') || (*value == '\r') || (*value == '\n')))
+            {
+                value++;
+            }
+            return value;
+        }
+    }
+    return NULL;
+}
+//==============================================================================
+static double fobos_replay_json_number(const char * begin, const char * end, const char * key, double value)
+{
+    const char * found = fobos_replay_json_find(begin, end, key);
+    return found ? strtod(found, NULL) : value;
+}
+//==============================================================================
+// the object starting at begin ('{') up to its '}', NULL if it does not end
+static const char * fobos_replay_json_object_end(const char * begin, const char * end)
+{
+    int depth = 0;
+    for (const char * p = begin; p < end; p++)
+    {
+        if (*p == '"')
+        {
+            for (p++; (p < end) && (*p != '"'); p++)
+            {
+                if (*p == '\\')
+                {
+                    p++;
+                }
+            }
+        }
+        else if (*p == '{')
+        {
+            depth++;
+        }
+        else if ((*p == '}') && (--depth == 0))
+        {
+            return p;
+        }
+    }
+    return NULL;
+}
+//==============================================================================
+static int fobos_replay_add_capture(struct fobos_replay * replay, uint64_t start, int swap_iq)
+{
+    struct fobos_replay_capture * captures = (struct fobos_replay_capture *)realloc(replay->captures, (replay->captures_count + 1) * sizeof(struct fobos_replay_capture));
+    if (!captures)
+    {
+        return -1;
+    }
+    replay->captures = captures;
+    replay->captures[replay->captures_count].start = start;
+    replay->captures[replay->captures_count].swap_iq = swap_iq;
+    replay->captures_count++;
+    return 0;
+}
+//==============================================================================
+// SigMF 1.0: the datatype and the rate of the global object, for every capture the
+// sample it starts at and the word order, the settings of the first one; the
+// fobos: fields are those of fobos_record_write_meta()
+static int fobos_replay_parse_meta(struct fobos_replay * replay, const char * text)
+{
+    const char * end = text + strlen(text);
+    const char * captures = fobos_replay_json_find(text, end, "captures");
+    const char * global_end = captures ? captures : end;
+    const char * datatype = fobos_replay_json_find(text, global_end, "core:datatype");
+    if (!datatype)
+    {
+        return -1;
+    }
+    if (strncmp(datatype, "\"cu16_le\"", 9) == 0)
+    {
+        replay->format = FOBOS_REPLAY_RAW;
+    }
+    else if (strncmp(datatype, "\"ci16_le\"", 9) == 0)
+    {
+        replay->format = FOBOS_REPLAY_SC16;
+    }
+    else if (strncmp(datatype, "\"cf32_le\"", 9) == 0)
+    {
+        replay->format = FOBOS_REPLAY_FC32;
+    }
+    else
+    {
+        return -1;
+    }
+    replay->samplerate = fobos_replay_json_number(text, global_end, "core:sample_rate", 0.0);
+    const char * p = captures;
+    while (p && (p < end) && (*p != ']'))
+    {
+        if (*p != '{')
+        {
+            p++;
+            continue;
+        }
+        const char * object_end = fobos_replay_json_object_end(p, end);
+        if (!object_end)
+        {
+            return -1;
+        }
+        uint64_t start = (uint64_t)fobos_replay_json_number(p, object_end, "core:sample_start", 0.0);
+        int swap_iq = (int)fobos_replay_json_number(p, object_end, "fobos:swap_iq", 1.0);
+        if (replay->captures_count == 0)
+        {
+            replay->frequency = fobos_replay_json_number(p, object_end, "core:frequency", 0.0);
+            replay->lna_gain = (unsigned int)fobos_replay_json_number(p, object_end, "fobos:lna_gain", 0.0);
+            replay->vga_gain = (unsigned int)fobos_replay_json_number(p, object_end, "fobos:vga_gain", 0.0);
+            replay->direct_sampling = (int)fobos_replay_json_number(p, object_end, "fobos:direct_sampling", 0.0);
+            replay->correction.dc_re = (float)fobos_replay_json_number(p, object_end, "fobos:dc_re", FOBOS_REPLAY_MID);
+            replay->correction.dc_im = (float)fobos_replay_json_number(p, object_end, "fobos:dc_im", FOBOS_REPLAY_MID);
+            replay->correction.gain = (float)fobos_replay_json_number(p, object_end, "fobos:gain", 1.0);
+            replay->correction.phase = (float)fobos_replay_json_number(p, object_end, "fobos:phase", 0.0);
+        }
+        if (((replay->captures_count > 0) && (start < replay->captures[replay->captures_count - 1].start)) ||
+            (fobos_replay_add_capture(replay, start, swap_iq) != 0))
+        {
+            return -1;
+        }
+        p = object_end + 1;
+    }
+    return 0;
+}
+//==============================================================================
+#ifdef _WIN32
+static int fobos_replay_map(struct fobos_replay * replay, const char * name)
+{
+    replay->file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (replay->file == INVALID_HANDLE_VALUE)
+    {
+        replay->file = NULL;
+        return -1;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(replay->file, &size) || (size.QuadPart <= 0))
+    {
+        return -1;
+    }
+    replay->mapping = CreateFileMappingA(replay->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!replay->mapping)
+    {
+        return -1;
+    }
+    replay->data = (const uint8_t *)MapViewOfFile(replay->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!replay->data)
+    {
+        return -1;
+    }
+    replay->size = (uint64_t)size.QuadPart;
+    return 0;
+}
+//==============================================================================
+static void fobos_replay_unmap(struct fobos_replay * replay)
+{
+    if (replay->data)
+    {
+        UnmapViewOfFile(replay->data);
+    }
+    if (replay->mapping)
+    {
+        CloseHandle(replay->mapping);
+    }
+    if (replay->file)
+    {
+        CloseHandle(replay->file);
+    }
+}
+//==============================================================================
+static void fobos_replay_advise(struct fobos_replay * replay, uint64_t offset)
+{
+    // FILE_FLAG_SEQUENTIAL_SCAN reads ahead
+    (void)replay;
+    (void)offset;
+}
+#else
+static int fobos_replay_map(struct fobos_replay * replay, const char * name)
+{
+    int file = open(name, O_RDONLY);
+    if (file < 0)
+    {
+        return -1;
+    }
+    struct stat st;
+    if ((fstat(file, &st) != 0) || (st.st_size <= 0))
+    {
+        close(file);
+        return -1;
+    }
+    void * data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, file, 0);
+    // the mapping holds the file
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        return -1;
+    }
+    replay->data = (const uint8_t *)data;
+    replay->size = (uint64_t)st.st_size;
+    (void)madvise(data, (size_t)replay->size, MADV_SEQUENTIAL);
+    return 0;
+}
+//==============================================================================
+static void fobos_replay_unmap(struct fobos_replay * replay)
+{
+    if (replay->data)
+    {
+        munmap((void *)replay->data, (size_t)replay->size);
+    }
+}
+//==============================================================================
+// the reader got to offset: the window after the one it is in is paged in, the
+// one before it is dropped from the mapping (it stays in the page cache)
+static void fobos_replay_advise(struct fobos_replay * replay, uint64_t offset)
+{
+    while ((replay->advised < replay->size) && (offset + FOBOS_REPLAY_AHEAD > replay->advised))
+    {
+        uint64_t len = replay->size - replay->advised;
+        if (len > FOBOS_REPLAY_AHEAD)
+        {
+            len = FOBOS_REPLAY_AHEAD;
+        }
+        (void)madvise((void *)(replay->data + replay->advised), (size_t)len, MADV_WILLNEED);
+        if (replay->advised >= 2 * (uint64_t)FOBOS_REPLAY_AHEAD)
+        {
+            (void)madvise((void *)(replay->data + replay->advised - 2 * (uint64_t)FOBOS_REPLAY_AHEAD), FOBOS_REPLAY_AHEAD, MADV_DONTNEED);
+        }
+        replay->advised += len;
+    }
+}
+#endif
+//==============================================================================
+void fobos_replay_close(struct fobos_replay * replay)
+{
+    if (!replay)
+    {
+        return;
+    }
+    fobos_replay_unmap(replay);
+    free(replay->captures);
+    free(replay);
+}
+//==============================================================================
+struct fobos_replay * fobos_replay_open(const char * path, int format)
+{
+    if (!path || !path[0] || (format < FOBOS_REPLAY_AUTO) || (format > FOBOS_REPLAY_FC32))
+    {
+        return NULL;
+    }
+    struct fobos_replay * replay = (struct fobos_replay *)calloc(1, sizeof(struct fobos_replay));
+    if (!replay)
+    {
+        return NULL;
+    }
+    replay->correction.dc_re = FOBOS_REPLAY_MID;
+    replay->correction.dc_im = FOBOS_REPLAY_MID;
+    replay->correction.gain = 1.0f;
+    size_t len = strlen(path);
+    size_t base = len;
+    if (fobos_replay_ends_with(path, len, ".sigmf-meta") || fobos_replay_ends_with(path, len, ".sigmf-data"))
+    {
+        base = len - strlen(".sigmf-meta");
+    }
+    char * name = fobos_replay_name(path, base, ".sigmf-meta");
+    char * meta = name ? fobos_replay_load(name) : NULL;
+    free(name);
+    int result = 0;
+    if (meta)
+    {
+        result = fobos_replay_parse_meta(replay, meta);
+        free(meta);
+        // the metadata decides, a format that does not match it is an error
+        if ((result == 0) && (format != FOBOS_REPLAY_AUTO) && (format != replay->format))
+        {
+            result = -1;
+        }
+        name = fobos_replay_name(path, base, ".sigmf-data");
+    }
+    else
+    {
+        replay->format = format;
+        if (format == FOBOS_REPLAY_AUTO)
+        {
+            if (fobos_replay_ends_with(path, len, ".cf32") || fobos_replay_ends_with(path, len, ".fc32"))
+            {
+                replay->format = FOBOS_REPLAY_FC32;
+            }
+            else if (fobos_replay_ends_with(path, len, ".cs16") || fobos_replay_ends_with(path, len, ".sc16") || fobos_replay_ends_with(path, len, ".ci16"))
+            {
+                replay->format = FOBOS_REPLAY_SC16;
+            }
+            else
+            {
+                replay->format = FOBOS_REPLAY_RAW;
+            }
+        }
+        name = fobos_replay_name(path, len, "");
+    }
+    if ((result != 0) || !name || (fobos_replay_map(replay, name) != 0))
+    {
+        free(name);
+        fobos_replay_close(replay);
+        return NULL;
+    }
+    free(name);
+    if (replay->captures_count == 0)
+    {
+        fobos_replay_add_capture(replay, 0, 1);
+    }
+    replay->sample_size = fobos_replay_sample_size(replay->format);
+    replay->samples = replay->size / replay->sample_size;
+    if (replay->format != FOBOS_REPLAY_RAW)
+    {
+        // corrected samples, around mid scale once quantized
+        replay->correction.dc_re = FOBOS_REPLAY_MID;
+        replay->correction.dc_im = FOBOS_REPLAY_MID;
+        replay->correction.gain = 1.0f;
+        replay->correction.phase = 0.0f;
+    }
+    if ((replay->samples == 0) || !replay->captures_count)
+    {
+        fobos_replay_close(replay);
+        return NULL;
+    }
+    return replay;
+}
+//==============================================================================
+void fobos_replay_correction(const struct fobos_replay * replay, struct fobos_iq_correction * correction)
+{
+    *correction = replay->correction;
+}
+//==============================================================================
+void fobos_replay_info(const struct fobos_replay * replay, struct fobos_replay_info * info)
+{
+    memset(info, 0, sizeof(*info));
+    info->format = replay->format;
+    info->samplerate = replay->samplerate;
+    info->frequency = replay->frequency;
+    info->lna_gain = replay->lna_gain;
+    info->vga_gain = replay->vga_gain;
+    info->direct_sampling = replay->direct_sampling;
+    info->captures = replay->captures_count;
+    info->samples = replay->samples;
+    info->position = replay->position;
+    info->loops = replay->loops;
+}
+//==============================================================================
+static inline int16_t fobos_replay_code(float value)
+{
+    value += FOBOS_REPLAY_MID;
+    value = value < 0.0f ? 0.0f : value;
+    value = value > FOBOS_REPLAY_MAX ? FOBOS_REPLAY_MAX : value;
+    return (int16_t)(value + 0.5f);
+}
+//==============================================================================
+uint32_t fobos_replay_read(struct fobos_replay * replay, int16_t * dst, uint32_t count, int swap_iq)
+{
+    if (replay->samples - replay->position < count)
+    {
+        return 0;
+    }
+    uint64_t sample = replay->position;
+    uint32_t left = count;
+    while (left > 0)
+    {
+        // the samples up to the next capture share one word order
+        uint32_t c = replay->capture;
+        uint64_t end = (c + 1 < replay->captures_count) ? replay->captures[c + 1].start : replay->samples;
+        if (sample >= end)
+        {
+            replay->capture++;
+            continue;
+        }
+        uint32_t n = (end - sample < left) ? (uint32_t)(end - sample) : left;
+        fobos_replay_advise(replay, (sample + n) * replay->sample_size);
+        const uint8_t * src = replay->data + sample * replay->sample_size;
+        if (replay->format == FOBOS_REPLAY_RAW)
+        {
+            if (replay->captures[c].swap_iq == swap_iq)
+            {
+                memcpy(dst, src, (size_t)n * replay->sample_size);
+            }
+            else
+            {
+                const int16_t * words = (const int16_t *)src;
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    dst[2 * i] = words[2 * i + 1];
+                    dst[2 * i + 1] = words[2 * i];
+                }
+            }
+        }
+        else
+        {
+            // i first in the file, the device order wanted
+            int first = swap_iq ? 1 : 0;
+            if (replay->format == FOBOS_REPLAY_SC16)
+            {
+                const int16_t * iq = (const int16_t *)src;
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    dst[2 * i + first] = fobos_replay_code((float)iq[2 * i]);
+                    dst[2 * i + 1 - first] = fobos_replay_code((float)iq[2 * i + 1]);
+                }
+            }
+            else
+            {
+                const float * iq = (const float *)src;
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    dst[2 * i + first] = fobos_replay_code(iq[2 * i] * FOBOS_REPLAY_FC32_SCALE);
+                    dst[2 * i + 1 - first] = fobos_replay_code(iq[2 * i + 1] * FOBOS_REPLAY_FC32_SCALE);
+                }
+            }
+        }
+        dst += 2 * (size_t)n;
+        sample += n;
+        left -= n;
+    }
+    replay->position = sample;
+    return count;
+}
+//==============================================================================
+void fobos_replay_rewind(struct fobos_replay * replay)
+{
+    replay->position = 0;
+    replay->capture = 0;
+    replay->advised = 0;
+    replay->loops++;
+}
+//==============================================================================
\ No newline at end of file
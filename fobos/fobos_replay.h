@@ -0,0 +1,43 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Replay: a memory mapped recording read back as the device would send it
+//==============================================================================
+#ifndef LIB_FOBOS_REPLAY_H
+#define LIB_FOBOS_REPLAY_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+#define FOBOS_REPLAY_AHEAD (16 * 1024 * 1024)   // bytes paged in ahead of the reader
+    struct fobos_replay;
+    // maps the data file, path as fobos_rx_open_replay(), NULL on failure
+    struct fobos_replay * fobos_replay_open(const char * path, int format);
+    void fobos_replay_close(struct fobos_replay * replay);
+    // the iq correction of the first capture, mid scale and no imbalance if it does not tell
+    void fobos_replay_correction(const struct fobos_replay * replay, struct fobos_iq_correction * correction);
+    // position and loops are a snapshot while another thread reads
+    void fobos_replay_info(const struct fobos_replay * replay, struct fobos_replay_info * info);
+    //=== single reader ========================================================
+    // the next count samples as raw words in the order of swap_iq (1 - the second word of a
+    // pair is i), all or nothing: count, or 0 with fewer left
+    uint32_t fobos_replay_read(struct fobos_replay * replay, int16_t * dst, uint32_t count, int swap_iq);
+    // from the first sample again
+    void fobos_replay_rewind(struct fobos_replay * replay);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_REPLAY_H
+//==============================================================================
\ No newline at end of file
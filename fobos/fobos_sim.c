@@ -0,0 +1,556 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Simulated device: answers the vendor requests of fobos.c and completes
+//  bulk IN transfers with synthetic 14 bit IQ at the programmed sample rate,
+//  or with the samples of a recording (fobos_replay.c)
+//==============================================================================
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fobos_transport.h"
+#include "fobos_thread.h"
+#include "fobos_replay.h"
+#ifdef _WIN32
+#include <libusb-1.0/libusb.h>
+#include <Windows.h>
+#else
+#include <libusb-1.0/libusb.h>
+#include <time.h>
+#endif
+//==============================================================================
+#define FOBOS_SIM_QUEUE_LEN 256             // transfers in flight
+#define FOBOS_SIM_PATTERN_LEN (1 << 20)     // complex samples, the signal repeats after this
+#define FOBOS_SIM_CLKIN 10000000.0          // si5351c reference, Hz
+#define FOBOS_SIM_SI5351C_ADDRESS 0x60
+#define FOBOS_SIM_FULL_SCALE 8192.0
+#define FOBOS_SIM_PRESEL_V1 0x0001          // dev_gpo preselector bits, the high band has only v2 set
+#define FOBOS_SIM_PRESEL_V2 0x0002
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+//==============================================================================
+struct fobos_sim
+{
+    struct fobos_sim_config config;
+    //=== vendor requests ======================================================
+    uint8_t si5351c[256];
+    uint8_t si5351c_addr;                   // register pointer of the i2c reads
+    uint16_t max2830[16];
+    uint16_t rffc507x[32];
+    uint16_t user_gpo;
+    uint16_t dev_gpo;
+    volatile int lost;
+    volatile int ended;                     // the replay is over: no bulk in, the vendor requests still answered
+    //=== bulk in ==============================================================
+    fobos_mutex_t lock;                     // the queue, conversion workers resubmit from their threads
+    struct libusb_transfer * queue[FOBOS_SIM_QUEUE_LEN];
+    int cancelled[FOBOS_SIM_QUEUE_LEN];
+    uint32_t queue_len;
+    uint64_t transfers;                     // completed since the stream start
+    uint64_t start_us;
+    double stream_us;                       // samples completed so far, in time
+    uint64_t next_us;                       // completion time of the queue head
+    uint32_t random;
+    //=== signal ===============================================================
+    int16_t * pattern;
+    double pattern_samplerate;
+    int pattern_inverted;
+    uint32_t pattern_pos;
+    struct fobos_replay * replay;           // instead of the pattern if set, owned
+    int replay_repeat;
+};
+//==============================================================================
+static int fobos_sim_state = -1;            // -1 - FOBOS_SIM not looked at yet, 0 - hardware, 1 - simulator
+static struct fobos_sim_config fobos_sim_config_value;
+//==============================================================================
+void fobos_sim_config_init(struct fobos_sim_config * config)
+{
+    memset(config, 0, sizeof(*config));
+    config->tone_hz[0] = 1000000.0;
+    config->tone_level[0] = 0.1;
+    config->noise_level = 0.003;
+    config->dc_re = 0.01;
+    config->dc_im = -0.005;
+    config->gain = 1.02;
+    config->phase = 0.01;
+    config->realtime = 1;
+    config->seed = 1;
+}
+//==============================================================================
+int fobos_sim_enable(const struct fobos_sim_config * config)
+{
+    if (config)
+    {
+        if ((config->gain <= 0.0) || (config->short_rate < 0.0) || (config->short_rate > 1.0) || (config->jitter_us < 0.0))
+        {
+            return -7;
+        }
+        fobos_sim_config_value = *config;
+        fobos_sim_state = 1;
+    }
+    else
+    {
+        fobos_sim_state = 0;
+    }
+    return 0;
+}
+//==============================================================================
+const struct fobos_sim_config * fobos_sim_active(void)
+{
+    if (fobos_sim_state < 0)
+    {
+        const char * env = getenv("FOBOS_SIM");
+        fobos_sim_state = (env && (strcmp(env, "1") == 0)) ? 1 : 0;
+        if (fobos_sim_state)
+        {
+            fobos_sim_config_init(&fobos_sim_config_value);
+        }
+    }
+    return fobos_sim_state ? &fobos_sim_config_value : NULL;
+}
+//==============================================================================
+static uint32_t fobos_sim_rand(struct fobos_sim * sim)
+{
+    // xorshift32
+    uint32_t x = sim->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->random = x;
+    return x;
+}
+//==============================================================================
+// uniform 0 .. 1
+static double fobos_sim_uniform(struct fobos_sim * sim)
+{
+    return (fobos_sim_rand(sim) >> 8) * (1.0 / 16777216.0);
+}
+//==============================================================================
+static void fobos_sim_sleep_us(uint64_t us)
+{
+#ifdef _WIN32
+    Sleep((DWORD)((us + 999) / 1000));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(us / 1000000);
+    ts.tv_nsec = (long)(us % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+#endif
+}
+//==============================================================================
+// the adc clock is multisynth #2 of the si5351c, pll a runs from the 10 MHz clkin,
+// both in the integer mode fobos.c programs: divider = (p1 + 512) / 128
+static double fobos_sim_samplerate(const struct fobos_sim * sim)
+{
+    const uint8_t * r = sim->si5351c;
+    uint32_t pll_p1 = ((r[26 + 2] & 0x03) << 16) | (r[26 + 3] << 8) | r[26 + 4];
+    uint32_t ms_p1 = ((r[42 + 16 + 2] & 0x03) << 16) | (r[42 + 16 + 3] << 8) | r[42 + 16 + 4];
+    double vco = FOBOS_SIM_CLKIN * (pll_p1 + 512) / 128.0;
+    return vco * 128.0 / (ms_p1 + 512);
+}
+//==============================================================================
+// the high band mixes down with the lo above the signal, its spectrum arrives
+// inverted and the driver swaps i and q once more
+static int fobos_sim_inverted(const struct fobos_sim * sim)
+{
+    return (sim->dev_gpo & (FOBOS_SIM_PRESEL_V1 | FOBOS_SIM_PRESEL_V2)) == FOBOS_SIM_PRESEL_V2;
+}
+//==============================================================================
+static int16_t fobos_sim_quantize(double value)
+{
+    long code = lrint(FOBOS_SIM_FULL_SCALE + FOBOS_SIM_FULL_SCALE * value);
+    if (code < 0) code = 0;
+    if (code > 0x3FFF) code = 0x3FFF;
+    return (int16_t)code;
+}
+//==============================================================================
+// one period of the signal, the tones are rounded to a whole number of cycles
+// per pattern so it repeats seamlessly; the adc delivers q first, the iq
+// imbalance is that of the second adc channel against the first one
+static int fobos_sim_render(struct fobos_sim * sim, double samplerate, int inverted)
+{
+    const struct fobos_sim_config * c = &sim->config;
+    if (!sim->pattern)
+    {
+        sim->pattern = (int16_t *)malloc(FOBOS_SIM_PATTERN_LEN * 2 * sizeof(int16_t));
+        if (!sim->pattern)
+        {
+            return -1;
+        }
+    }
+    double step[2];
+    for (int t = 0; t < 2; t++)
+    {
+        step[t] = 2.0 * M_PI * floor(c->tone_hz[t] * FOBOS_SIM_PATTERN_LEN / samplerate + 0.5) / FOBOS_SIM_PATTERN_LEN;
+    }
+    double sin_phase = sin(c->phase);
+    double cos_phase = cos(c->phase);
+    for (uint32_t i = 0; i < FOBOS_SIM_PATTERN_LEN; i++)
+    {
+        double re = 0.0;
+        double im = 0.0;
+        for (int t = 0; t < 2; t++)
+        {
+            // fmod keeps the argument small, i * step is exact enough in double
+            double arg = fmod(step[t] * i, 2.0 * M_PI);
+            re += c->tone_level[t] * cos(arg);
+            im += c->tone_level[t] * sin(arg);
+        }
+        if (c->noise_level > 0.0)
+        {
+            // box-muller, one gaussian pair per sample
+            double u1 = fobos_sim_uniform(sim) + 1.0 / 33554432.0;
+            double u2 = fobos_sim_uniform(sim);
+            double r = c->noise_level * sqrt(-2.0 * log(u1));
+            re += r * cos(2.0 * M_PI * u2);
+            im += r * sin(2.0 * M_PI * u2);
+        }
+        double first = inverted ? re : im;
+        double second = inverted ? im : re;
+        second = c->gain * (sin_phase * first + cos_phase * second);
+        sim->pattern[i * 2 + 0] = fobos_sim_quantize(first + c->dc_re);
+        sim->pattern[i * 2 + 1] = fobos_sim_quantize(second + c->dc_im);
+    }
+    sim->pattern_samplerate = samplerate;
+    sim->pattern_inverted = inverted;
+    sim->pattern_pos = 0;
+    return 0;
+}
+//==============================================================================
+void * fobos_sim_open(const struct fobos_sim_config * config)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)malloc(sizeof(struct fobos_sim));
+    if (!sim)
+    {
+        return NULL;
+    }
+    memset(sim, 0, sizeof(*sim));
+    sim->config = *config;
+    sim->random = config->seed ? config->seed : 1;
+    fobos_mutex_init(&sim->lock);
+    return sim;
+}
+//==============================================================================
+static void fobos_sim_close(void * ctx)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)ctx;
+    fobos_mutex_destroy(&sim->lock);
+    fobos_replay_close(sim->replay);
+    free(sim->pattern);
+    free(sim);
+}
+//==============================================================================
+static int fobos_sim_control(void * ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index, unsigned char * data, uint16_t length, unsigned int timeout_ms)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)ctx;
+    int in = (request_type & LIBUSB_ENDPOINT_IN) != 0;
+    (void)index;
+    (void)timeout_ms;
+    if (sim->lost)
+    {
+        return LIBUSB_ERROR_NO_DEVICE;
+    }
+    switch (request)
+    {
+        case 0xE1: // start / stop the stream
+            if (value)
+            {
+                // render up front, the first transfers are not delayed by it
+                double samplerate = fobos_sim_samplerate(sim);
+                if ((samplerate > 0.0) && ((sim->pattern_samplerate != samplerate) || (sim->pattern_inverted != fobos_sim_inverted(sim))))
+                {
+                    fobos_sim_render(sim, samplerate, fobos_sim_inverted(sim));
+                }
+                sim->transfers = 0;
+                sim->stream_us = 0.0;
+                sim->start_us = fobos_time_us();
+                sim->next_us = 0;
+            }
+            return 0;
+        case 0xE2: // adc spi, reads back zeros
+            if (in && data)
+            {
+                memset(data, 0, length);
+            }
+            return length;
+        case 0xE3:
+            sim->user_gpo = value;
+            return 0;
+        case 0xE4:
+            sim->dev_gpo = value;
+            return 0;
+        case 0xE5: // max2830: addr, data lo, data hi
+            if (in || (length != 3) || !data)
+            {
+                return LIBUSB_ERROR_PIPE;
+            }
+            sim->max2830[data[0] & 0x0F] = data[1] | (data[2] << 8);
+            return length;
+        case 0xE6: // rffc507x: write addr, data lo, data hi / read value = addr
+            if (in)
+            {
+                if ((length != 2) || !data)
+                {
+                    return LIBUSB_ERROR_PIPE;
+                }
+                data[0] = sim->rffc507x[value & 0x1F] & 0xFF;
+                data[1] = sim->rffc507x[value & 0x1F] >> 8;
+                return length;
+            }
+            if ((length != 3) || !data)
+            {
+                return LIBUSB_ERROR_PIPE;
+            }
+            sim->rffc507x[data[0] & 0x1F] = data[1] | (data[2] << 8);
+            return length;
+        case 0xE7: // i2c, value = address, the first byte written is the register pointer
+            if (value != FOBOS_SIM_SI5351C_ADDRESS)
+            {
+                return LIBUSB_ERROR_PIPE;
+            }
+            if (in)
+            {
+                for (uint16_t i = 0; i < length; i++)
+                {
+                    data[i] = sim->si5351c[sim->si5351c_addr++];
+                }
+                return length;
+            }
+            if (length > 0)
+            {
+                sim->si5351c_addr = data[0];
+                for (uint16_t i = 1; i < length; i++)
+                {
+                    sim->si5351c[sim->si5351c_addr++] = data[i];
+                }
+            }
+            return length;
+        default:
+            return LIBUSB_ERROR_PIPE;
+    }
+}
+//==============================================================================
+static int fobos_sim_submit(void * ctx, struct libusb_transfer * transfer)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)ctx;
+    int result = 0;
+    fobos_mutex_lock(&sim->lock);
+    if (sim->lost || sim->ended)
+    {
+        result = LIBUSB_ERROR_NO_DEVICE;
+    }
+    else if (sim->queue_len >= FOBOS_SIM_QUEUE_LEN)
+    {
+        result = LIBUSB_ERROR_BUSY;
+    }
+    else
+    {
+        sim->cancelled[sim->queue_len] = 0;
+        sim->queue[sim->queue_len++] = transfer;
+    }
+    fobos_mutex_unlock(&sim->lock);
+    return result;
+}
+//==============================================================================
+static int fobos_sim_cancel(void * ctx, struct libusb_transfer * transfer)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)ctx;
+    int result = LIBUSB_ERROR_NOT_FOUND;
+    fobos_mutex_lock(&sim->lock);
+    for (uint32_t i = 0; i < sim->queue_len; i++)
+    {
+        if (sim->queue[i] == transfer)
+        {
+            sim->cancelled[i] = 1;
+            result = 0;
+            break;
+        }
+    }
+    fobos_mutex_unlock(&sim->lock);
+    return result;
+}
+//==============================================================================
+// remove the transfer from the queue and run its callback, called and returns
+// with the lock held, the callback runs without it and may resubmit
+static void fobos_sim_complete(struct fobos_sim * sim, uint32_t i, enum libusb_transfer_status status, int actual_length)
+{
+    struct libusb_transfer * transfer = sim->queue[i];
+    sim->queue_len--;
+    memmove(&sim->queue[i], &sim->queue[i + 1], (sim->queue_len - i) * sizeof(sim->queue[0]));
+    memmove(&sim->cancelled[i], &sim->cancelled[i + 1], (sim->queue_len - i) * sizeof(sim->cancelled[0]));
+    transfer->status = status;
+    transfer->actual_length = actual_length;
+    fobos_mutex_unlock(&sim->lock);
+    transfer->callback(transfer);
+    fobos_mutex_lock(&sim->lock);
+}
+//==============================================================================
+// 0, or -1 at the end of a recording that does not repeat
+static int fobos_sim_fill(struct fobos_sim * sim, struct libusb_transfer * transfer, int length, int inverted)
+{
+    uint32_t count = (uint32_t)length / 4;
+    int16_t * dst = (int16_t *)transfer->buffer;
+    if (sim->replay)
+    {
+        // the device order is i first in the high band; no partial tail, it would
+        // end the stream with a short transfer
+        int swap_iq = !inverted;
+        if (fobos_replay_read(sim->replay, dst, count, swap_iq) == count)
+        {
+            return 0;
+        }
+        if (!sim->replay_repeat)
+        {
+            return -1;
+        }
+        fobos_replay_rewind(sim->replay);
+        return (fobos_replay_read(sim->replay, dst, count, swap_iq) == count) ? 0 : -1;
+    }
+    while (count > 0)
+    {
+        uint32_t chunk = FOBOS_SIM_PATTERN_LEN - sim->pattern_pos;
+        if (chunk > count)
+        {
+            chunk = count;
+        }
+        memcpy(dst, sim->pattern + sim->pattern_pos * 2, chunk * 2 * sizeof(int16_t));
+        dst += chunk * 2;
+        count -= chunk;
+        sim->pattern_pos = (sim->pattern_pos + chunk) % FOBOS_SIM_PATTERN_LEN;
+    }
+    return 0;
+}
+//==============================================================================
+static int fobos_sim_handle_events(void * ctx, struct timeval * tv, int * completed)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)ctx;
+    uint64_t deadline = fobos_time_us() + (uint64_t)tv->tv_sec * 1000000ull + (uint64_t)tv->tv_usec;
+    // like libusb, returns once a batch of events was handled: the cancellations,
+    // the device loss or one completed transfer
+    fobos_mutex_lock(&sim->lock);
+    for (;;)
+    {
+        if (completed && *completed)
+        {
+            break;
+        }
+        int handled = 0;
+        uint32_t i = 0;
+        while (i < sim->queue_len)
+        {
+            if (sim->cancelled[i] || sim->lost || sim->ended)
+            {
+                fobos_sim_complete(sim, i, sim->cancelled[i] ? LIBUSB_TRANSFER_CANCELLED : LIBUSB_TRANSFER_NO_DEVICE, 0);
+                handled++;
+            }
+            else
+            {
+                i++;
+            }
+        }
+        if (handled)
+        {
+            break;
+        }
+        if (sim->queue_len == 0)
+        {
+            // nothing in flight, a conversion worker may be about to resubmit
+            fobos_mutex_unlock(&sim->lock);
+            fobos_sim_sleep_us(100);
+            return 0;
+        }
+        uint64_t now = fobos_time_us();
+        double samplerate = fobos_sim_samplerate(sim);
+        if (!(samplerate > 0.0))
+        {
+            samplerate = 10000000.0;
+        }
+        // only this thread removes transfers, the head stays put while unlocked
+        struct libusb_transfer * transfer = sim->queue[0];
+        if (sim->next_us == 0)
+        {
+            uint64_t base = sim->config.realtime ? sim->start_us + (uint64_t)(sim->stream_us + (transfer->length / 4) * 1E6 / samplerate) : now;
+            sim->next_us = base + (uint64_t)(sim->config.jitter_us * fobos_sim_uniform(sim));
+        }
+        if (now < sim->next_us)
+        {
+            if (now >= deadline)
+            {
+                break;
+            }
+            uint64_t wake = sim->next_us < deadline ? sim->next_us : deadline;
+            // short sleeps, a cancel must not wait for a long transfer
+            fobos_mutex_unlock(&sim->lock);
+            fobos_sim_sleep_us((wake - now) < 1000 ? (wake - now) : 1000);
+            fobos_mutex_lock(&sim->lock);
+            continue;
+        }
+        int inverted = fobos_sim_inverted(sim);
+        if (!sim->replay && ((sim->pattern == NULL) || (sim->pattern_samplerate != samplerate) || (sim->pattern_inverted != inverted)))
+        {
+            if (fobos_sim_render(sim, samplerate, inverted) != 0)
+            {
+                fobos_mutex_unlock(&sim->lock);
+                return LIBUSB_ERROR_NO_MEM;
+            }
+        }
+        sim->next_us = 0;
+        sim->stream_us += (transfer->length / 4) * 1E6 / samplerate;
+        sim->transfers++;
+        if (sim->config.lost_after && (sim->transfers > sim->config.lost_after))
+        {
+            sim->lost = 1;
+            continue;
+        }
+        int length = transfer->length;
+        if ((sim->config.short_rate > 0.0) && (fobos_sim_uniform(sim) < sim->config.short_rate))
+        {
+            length = 512 * (length / 1024);
+        }
+        fobos_mutex_unlock(&sim->lock);
+        int filled = fobos_sim_fill(sim, transfer, length, inverted);
+        fobos_mutex_lock(&sim->lock);
+        if (filled != 0)
+        {
+            // the recording ended: the stream ends as on a lost device
+            sim->ended = 1;
+            continue;
+        }
+        fobos_sim_complete(sim, 0, LIBUSB_TRANSFER_COMPLETED, length);
+        break;
+    }
+    fobos_mutex_unlock(&sim->lock);
+    return 0;
+}
+//==============================================================================
+const struct fobos_transport_ops fobos_sim_ops =
+{
+    "simulator",
+    fobos_sim_control,
+    fobos_sim_submit,
+    fobos_sim_cancel,
+    fobos_sim_handle_events,
+    fobos_sim_close
+};
+//==============================================================================
+void fobos_sim_set_replay(void * ctx, struct fobos_replay * replay, int repeat)
+{
+    struct fobos_sim * sim = (struct fobos_sim *)ctx;
+    fobos_replay_close(sim->replay);
+    sim->replay = replay;
+    sim->replay_repeat = repeat;
+}
+//==============================================================================
+struct fobos_replay * fobos_sim_replay(void * ctx)
+{
+    return ((struct fobos_sim *)ctx)->replay;
+}
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,84 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Minimal portable threads for the driver internals: win32 or pthreads
+//==============================================================================
+#ifndef LIB_FOBOS_THREAD_H
+#define LIB_FOBOS_THREAD_H
+#ifdef _WIN32
+#include <Windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    //==========================================================================
+#ifdef _WIN32
+    typedef CRITICAL_SECTION fobos_mutex_t;
+    typedef CONDITION_VARIABLE fobos_cond_t;
+    typedef HANDLE fobos_thread_t;
+    typedef unsigned (__stdcall * fobos_thread_proc_t)(void * arg);
+#define FOBOS_THREAD_PROC(name, arg) unsigned __stdcall name(void * arg)
+    static inline void fobos_mutex_init(fobos_mutex_t * mutex) { InitializeCriticalSection(mutex); }
+    static inline void fobos_mutex_destroy(fobos_mutex_t * mutex) { DeleteCriticalSection(mutex); }
+    static inline void fobos_mutex_lock(fobos_mutex_t * mutex) { EnterCriticalSection(mutex); }
+    static inline int fobos_mutex_trylock(fobos_mutex_t * mutex) { return TryEnterCriticalSection(mutex) != 0; }
+    static inline void fobos_mutex_unlock(fobos_mutex_t * mutex) { LeaveCriticalSection(mutex); }
+    static inline void fobos_cond_init(fobos_cond_t * cond) { InitializeConditionVariable(cond); }
+    static inline void fobos_cond_destroy(fobos_cond_t * cond) { (void)cond; }
+    static inline void fobos_cond_wait(fobos_cond_t * cond, fobos_mutex_t * mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+    static inline void fobos_cond_signal(fobos_cond_t * cond) { WakeConditionVariable(cond); }
+    static inline void fobos_cond_broadcast(fobos_cond_t * cond) { WakeAllConditionVariable(cond); }
+    // 0 on success
+    static inline int fobos_thread_create(fobos_thread_t * thread, fobos_thread_proc_t proc, void * arg)
+    {
+        *thread = (HANDLE)_beginthreadex(NULL, 0, proc, arg, 0, NULL);
+        return *thread ? 0 : -1;
+    }
+    static inline void fobos_thread_join(fobos_thread_t thread)
+    {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+#else
+    typedef pthread_mutex_t fobos_mutex_t;
+    typedef pthread_cond_t fobos_cond_t;
+    typedef pthread_t fobos_thread_t;
+    typedef void * (*fobos_thread_proc_t)(void * arg);
+#define FOBOS_THREAD_PROC(name, arg) void * name(void * arg)
+    static inline void fobos_mutex_init(fobos_mutex_t * mutex) { pthread_mutex_init(mutex, NULL); }
+    static inline void fobos_mutex_destroy(fobos_mutex_t * mutex) { pthread_mutex_destroy(mutex); }
+    static inline void fobos_mutex_lock(fobos_mutex_t * mutex) { pthread_mutex_lock(mutex); }
+    static inline int fobos_mutex_trylock(fobos_mutex_t * mutex) { return pthread_mutex_trylock(mutex) == 0; }
+    static inline void fobos_mutex_unlock(fobos_mutex_t * mutex) { pthread_mutex_unlock(mutex); }
+    static inline void fobos_cond_init(fobos_cond_t * cond) { pthread_cond_init(cond, NULL); }
+    static inline void fobos_cond_destroy(fobos_cond_t * cond) { pthread_cond_destroy(cond); }
+    static inline void fobos_cond_wait(fobos_cond_t * cond, fobos_mutex_t * mutex) { pthread_cond_wait(cond, mutex); }
+    static inline void fobos_cond_signal(fobos_cond_t * cond) { pthread_cond_signal(cond); }
+    static inline void fobos_cond_broadcast(fobos_cond_t * cond) { pthread_cond_broadcast(cond); }
+    // 0 on success
+    static inline int fobos_thread_create(fobos_thread_t * thread, fobos_thread_proc_t proc, void * arg)
+    {
+        return pthread_create(thread, NULL, proc, arg);
+    }
+    static inline void fobos_thread_join(fobos_thread_t thread)
+    {
+        pthread_join(thread, NULL);
+    }
+#endif
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_THREAD_H
+//==============================================================================
\ No newline at end of file
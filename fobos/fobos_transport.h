@@ -0,0 +1,65 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /_   __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / __/   \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /____  /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/ _\__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Transport layer: the usb operations the driver performs on a device
+//==============================================================================
+#ifndef LIB_FOBOS_TRANSPORT_H
+#define LIB_FOBOS_TRANSPORT_H
+#include <stddef.h>
+#include <stdint.h>
+#include "fobos.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    struct libusb_transfer;
+    struct timeval;
+    //==========================================================================
+    // every call gets the ctx the transport was opened with, the return codes
+    // and the transfer life cycle are those of the libusb calls they replace
+    struct fobos_transport_ops
+    {
+        const char * name;
+        // libusb_control_transfer(): bytes transferred or LIBUSB_ERROR_*
+        int (*control)(void * ctx, uint8_t request_type, uint8_t request, uint16_t value, uint16_t index, unsigned char * data, uint16_t length, unsigned int timeout_ms);
+        // libusb_submit_transfer(), the transfer callback runs from handle_events()
+        int (*submit)(void * ctx, struct libusb_transfer * transfer);
+        // libusb_cancel_transfer(), the callback gets LIBUSB_TRANSFER_CANCELLED
+        int (*cancel)(void * ctx, struct libusb_transfer * transfer);
+        // libusb_handle_events_timeout_completed()
+        int (*handle_events)(void * ctx, struct timeval * tv, int * completed);
+        // release the device and ctx
+        void (*close)(void * ctx);
+    };
+    //==========================================================================
+    // monotonic time, us, fobos.c
+    uint64_t fobos_time_us(void);
+    //==========================================================================
+    // rx path of the transfer callback, fobos.c, size in bytes
+    void fobos_rx_proceed_rx_buff(struct fobos_dev_t * dev, void * data, size_t size);
+    void fobos_rx_proceed_calibration(struct fobos_dev_t * dev, void * data, uint32_t size);
+    //==========================================================================
+    // simulated device, fobos_sim.c
+    extern const struct fobos_transport_ops fobos_sim_ops;
+    // the active simulator configuration or NULL if hardware is used
+    const struct fobos_sim_config * fobos_sim_active(void);
+    // ctx for fobos_sim_ops, NULL on failure
+    void * fobos_sim_open(const struct fobos_sim_config * config);
+    // the samples of replay instead of the synthetic signal, the simulator owns it;
+    // with repeat unset the stream ends as on a lost device after the last transfer
+    struct fobos_replay;
+    void fobos_sim_set_replay(void * ctx, struct fobos_replay * replay, int repeat);
+    struct fobos_replay * fobos_sim_replay(void * ctx);
+    //==========================================================================
+#ifdef __cplusplus
+}
+#endif
+#endif // !LIB_FOBOS_TRANSPORT_H
+//==============================================================================
\ No newline at end of file
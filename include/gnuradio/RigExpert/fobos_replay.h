@@ -0,0 +1,89 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/             
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+
+#ifndef INCLUDED_RIGEXPERT_FOBOS_REPLAY_H
+#define INCLUDED_RIGEXPERT_FOBOS_REPLAY_H
+
+#include <gnuradio/RigExpert/api.h>
+#include <gnuradio/RigExpert/fobos_sdr.h>
+#include <string>
+
+namespace gr 
+{
+    namespace RigExpert 
+    {
+
+        /*!
+         * \brief A Fobos SDR recording played back as the device
+         * \ingroup RigExpert
+         *
+         */
+        class RIGEXPERT_API fobos_replay : virtual public fobos_sdr
+        {
+        public:
+            typedef std::shared_ptr<fobos_replay> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of RigExpert::fobos_replay.
+             *
+             * The recording is memory mapped, read ahead sequentially and
+             * streamed in usb sized transfers through the same conversion,
+             * dc & iq correction, decimation, channelizer and spectrum as
+             * fobos_sdr; the setters and get_stats() are those of fobos_sdr,
+             * they act on a simulated device and do not change the samples.
+             *
+             * path: a SigMF recording (.sigmf-meta, .sigmf-data or their
+             * base, fobos_sdr record_path) or a headerless file of format.
+             * format: 0 - by the SigMF datatype or the extension, 1 - raw
+             * (cu16_le, as recorded), 2 - complex int16, 3 - complex float32,
+             * the last two quantized to the 14 bit adc codes.
+             * samplerate_mhz, frequency_mhz: 0 - as recorded, a headerless
+             * file needs samplerate_mhz; the rate paces the replay and goes
+             * into the rx_rate tags, the frequency into the rx_freq tags.
+             * paced: true - at the sample rate as a device would, false - as
+             * fast as the flowgraph takes the samples, none dropped.
+             * repeat: false - the block is done at the end of the recording,
+             * the tail short of a transfer is not played.
+             * The rest as fobos_sdr; get_stats() adds replay_position,
+             * replay_samples and replay_loops.
+             */
+            static sptr make(   const std::string& path = "",
+                                int format = 0,
+                                double samplerate_mhz = 0.0,
+                                double frequency_mhz = 0.0,
+                                bool paced = true,
+                                bool repeat = false,
+                                int output_type = 0,
+                                double latency_ms = 10.0,
+                                double headroom_ms = 250.0,
+                                double stats_interval_ms = 0.0,
+                                int usb_cpu = -1,
+                                int work_cpu = -1,
+                                int rt_priority = 0,
+                                bool busy_poll = false,
+                                int decimation = 1,
+                                double if_offset_mhz = 0.0,
+                                bool auto_if = false,
+                                int channels = 1,
+                                bool oversample = false,
+                                int psd_size = 0,
+                                int psd_window = 2,
+                                double psd_overlap = 0.5,
+                                int psd_averages = 16,
+                                bool iq_output = true);
+        };
+
+    } // namespace RigExpert
+} // namespace gr
+
+#endif /* INCLUDED_RIGEXPERT_FOBOS_REPLAY_H */
+//==============================================================================
\ No newline at end of file
@@ -18,7 +18,9 @@
 #define INCLUDED_RIGEXPERT_FOBOS_SDR_H
 
 #include <gnuradio/RigExpert/api.h>
-#include <gnuradio/sync_block.h>
+#include <gnuradio/block.h>
+#include <string>
+#include <vector>
 
 namespace gr 
 {
@@ -30,7 +32,7 @@ namespace gr
          * \ingroup RigExpert
          *
          */
-        class RIGEXPERT_API fobos_sdr : virtual public gr::sync_block
+        class RIGEXPERT_API fobos_sdr : virtual public gr::block
         {
         public:
             typedef std::shared_ptr<fobos_sdr> sptr;
@@ -42,6 +44,81 @@ namespace gr
              * constructor is in a private implementation
              * class. RigExpert::fobos_sdr::make is the public interface for
              * creating new instances.
+             *
+             * output_type: 0 - complex float32, 1 - complex int16 (raw 14 bit),
+             * 2 - complex int8, 3 - complex float16 (two uint16 per item)
+             *
+             * latency_ms: the length of one usb transfer in time, the delay
+             * before the first sample of a transfer reaches work().
+             * headroom_ms: how long work() may stall before samples are
+             * dropped, sizes the ring between the usb thread and work().
+             * Both are converted to buffer sizes at the actual sample rate
+             * and re-applied by set_samplerate().
+             * stats_interval_ms: period of the get_stats() dictionary on the
+             * "stats" message port, 0 - never published.
+             * usb_cpu, work_cpu: core the usb event thread / the work() thread
+             * is pinned to, -1 - any core.
+             * rt_priority: SCHED_FIFO priority (1..99) of both threads, on
+             * Windows THREAD_PRIORITY_TIME_CRITICAL, 0 - default scheduling.
+             * A request the OS refuses is reported and ignored.
+             * busy_poll: work() spins on the ring instead of sleeping while it
+             * waits for samples, for isolated cores only: combined with
+             * rt_priority, work_cpu must not be shared with the usb thread.
+             * decimation: the output rate is samplerate / decimation, 2^n * 1,
+             * 3 or 5 up to 64 * 5, the chain keeps 80 % of the output band and
+             * attenuates everything that would alias into it by 72 dB.
+             * if_offset_mhz: the analog lo is tuned this far from frequency_mhz
+             * (|if_offset| < samplerate / 2) to keep the dc spur and the iq
+             * image off the center, a mixer in the conversion shifts the
+             * center back to 0 Hz, exact to samplerate / 2^32.
+             * auto_if: set_frequency() within 0.4 * samplerate * (1 - 1 /
+             * decimation) of the lo only moves the mixer, no usb traffic, no
+             * pll relock, the phase stays continuous.
+             * channels: 1 - one output, else 2^n up to 1024 output ports, the
+             * band split into equally spaced channels by a polyphase filterbank
+             * and an fft in the conversion, port k centered k * samplerate /
+             * channels above frequency_mhz, the upper half of the ports below
+             * it, each at samplerate / channels, not with decimation.
+             * oversample: the channels at 2 * samplerate / channels, so the
+             * channel edges do not alias.
+             * psd_size: 0 - off, else 16 .. 65536 (2^n), one more output port
+             * after the iq ports, float, the averaged power spectrum of the
+             * band in rows of psd_size bins back to back (stream_to_vector
+             * psd_size), dB full scale, dc in the middle, computed in work()
+             * right after the conversion of the same samples; every row is
+             * tagged psd_row (row index) and rx_freq (its center, Hz).
+             * psd_window: 0 - rectangular, 1 - Hann, 2 - Blackman-Harris.
+             * psd_overlap: 0 .. 0.95, the part of a block the next one repeats.
+             * psd_averages: blocks per row, a row every samplerate_mhz * 1e6 *
+             * (1 - psd_overlap) * psd_averages / psd_size samples.
+             * iq_output: false - the spectrum port only, the samples are not
+             * converted at all.
+             * record_path: not empty - the raw transfers as the device sends
+             * them are recorded to record_path.sigmf-data from the stream
+             * start on, record_path.sigmf-meta written when the recording
+             * stops (set_record_path(""), the block destroyed), a capture for
+             * every retune, gain change and gap, see fobos_rx_start_recording().
+             * record_prealloc_mb: the data file reserved up front, 0 - grows.
+             * history_s: 0 - off, else the last history_s seconds of raw
+             * transfers are kept in memory (4 bytes per sample, 10 s at 20
+             * MS/s is 800 MB), a message on the "trigger" port writes the
+             * window of snapshot_pre_s before the trigger to snapshot_post_s
+             * after it to a SigMF recording like record_path, from a thread
+             * while the stream goes on, see fobos_rx_trigger_snapshot().
+             * The message may be a dictionary of path (the recording, else
+             * snapshot_path plus the utc time), pre, post (s) and sample (a
+             * device rate stream index, else the newest sample).
+             * workers: 0 - work() converts on its own, else 2 .. 16 threads
+             * share the conversion of every transfer, without decimation and
+             * channels, see fobos_rx_set_workers().
+             *
+             * Stream tags, UHD compatible: rx_time (full secs, frac secs),
+             * rx_rate and rx_freq (Hz) on the first sample of the stream, of
+             * the first transfer after set_frequency() / set_samplerate() and
+             * of the first transfer after any lost one. rx_time counts samples
+             * from the host clock at the stream start, a gap in it is a loss.
+             * rx_rate is the output rate, after the decimation, every channel
+             * port gets its own rx_freq.
              */
             static sptr make(   int index = 0, 
                                 double frequency_mhz = 100.0, 
@@ -49,17 +126,97 @@ namespace gr
                                 int lna_gain = 0,
                                 int vga_gain = 0,
                                 int direct_sampling = 0,
-                                int clock_source = 0);
+                                int clock_source = 0,
+                                int output_type = 0,
+                                double latency_ms = 10.0,
+                                double headroom_ms = 250.0,
+                                double stats_interval_ms = 0.0,
+                                int usb_cpu = -1,
+                                int work_cpu = -1,
+                                int rt_priority = 0,
+                                bool busy_poll = false,
+                                int decimation = 1,
+                                double if_offset_mhz = 0.0,
+                                bool auto_if = false,
+                                int channels = 1,
+                                bool oversample = false,
+                                int psd_size = 0,
+                                int psd_window = 2,
+                                double psd_overlap = 0.5,
+                                int psd_averages = 16,
+                                bool iq_output = true,
+                                const std::string& record_path = "",
+                                int record_prealloc_mb = 0,
+                                double history_s = 0.0,
+                                double snapshot_pre_s = 1.0,
+                                double snapshot_post_s = 1.0,
+                                const std::string& snapshot_path = "fobos_snapshot",
+                                int workers = 0);
 
             /**
              * @brief Callback for setting parameters on-the-fly
              */
             virtual void set_frequency(double frequency_mhz) = 0;
             virtual void set_samplerate(double samplerate_mhz) = 0;
+            virtual void set_if_offset(double if_offset_mhz) = 0;
+            virtual void set_auto_if(bool auto_if) = 0;
             virtual void set_lna_gain(int lna_gain) = 0;
             virtual void set_vga_gain(int vga_gain) = 0;
             virtual void set_direct_sampling(int direct_sampling) = 0;
             virtual void set_clock_source(int clock_source) = 0;
+
+            /**
+             * @brief Computes the tuning register plans of a scan ahead
+             *
+             * set_frequency() to one of frequencies_mhz (with the current
+             * if offset) then goes straight to usb, any retune writes only
+             * the registers and switches that differ from the current ones.
+             */
+            virtual void prepare_frequencies(const std::vector<double>& frequencies_mhz) = 0;
+
+            /**
+             * @brief Hops through frequencies_mhz over and over
+             *
+             * Hop i waits settle_samples[i] for the pll to lock, then
+             * dwells dwell_samples[i] (device rate samples), empty lists
+             * stop hopping. The settle start is tagged rx_settle, the
+             * dwell start rx_freq and rx_hop, both with the hop index.
+             */
+            virtual void set_hops(const std::vector<double>& frequencies_mhz,
+                                  const std::vector<int>& dwell_samples,
+                                  const std::vector<int>& settle_samples) = 0;
+
+            /**
+             * @brief Starts or stops the raw recording
+             *
+             * Stops the recording running, if any, writing its metadata,
+             * then a path that is not empty starts a new one there.
+             */
+            virtual void set_record_path(const std::string& path) = 0;
+
+            /**
+             * @brief Runtime counters as a pmt dictionary
+             *
+             * overruns - usb transfers dropped on a full ring, buffers,
+             * rx_failures, transfer_errors, resubmit_errors, control_transfers
+             * (vendor requests: tuning, gains, switches) - driver counters,
+             * ring_slots, ring_filled, ring_high_water - ring occupancy,
+             * usb_interval, buffer_time, retune_time (driver), latency (usb callback to
+             * work()), convert_time (per work() slot) - histograms, each a
+             * dictionary of count, mean_us, max_us and bins (u64vector,
+             * bins[0] < 1 us, bins[i] 2^(i-1) .. 2^i us),
+             * usb_thread_cpu, usb_thread_priority, work_thread_cpu,
+             * work_thread_priority - the affinity and priority actually
+             * applied (-1 / 0 - none), busy_poll - the work() wait mode,
+             * record_active, record_bytes, record_written, record_dropped,
+             * record_gaps, record_error - the raw recording, running or
+             * stopped last, history_start, history_end - the stream indices
+             * the history holds, snapshot_active, snapshot_start,
+             * snapshot_end, snapshot_samples, snapshot_gaps, snapshot_error,
+             * snapshots - the snapshot being written or written last.
+             */
+            virtual pmt::pmt_t get_stats() = 0;
+            virtual void reset_stats() = 0;
         };
 
     } // namespace RigExpert
@@ -0,0 +1,81 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/             
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+
+#ifndef INCLUDED_RIGEXPERT_FOBOS_SWEEP_H
+#define INCLUDED_RIGEXPERT_FOBOS_SWEEP_H
+
+#include <gnuradio/RigExpert/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr 
+{
+    namespace RigExpert 
+    {
+
+        /*!
+         * \brief Wideband power spectrum sweep of a Fobos SDR
+         * \ingroup RigExpert
+         *
+         */
+        class RIGEXPERT_API fobos_sweep : virtual public gr::sync_block
+        {
+        public:
+            typedef std::shared_ptr<fobos_sweep> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of RigExpert::fobos_sweep.
+             *
+             * The driver steps the lo across start_mhz .. stop_mhz, averages
+             * `averages` windowed fft_size spectra at every step and stitches
+             * the middle `usable` fraction of them into one row, rising and
+             * falling in turns. Every output item is a row of bins() floats,
+             * dB full scale, bin k centered at start_frequency() + k *
+             * bin_width() Hz, tagged sweep_row (uint64, counts the rows, a gap
+             * is a row dropped because nobody read it).
+             *
+             * window: 0 - rectangular, 1 - Hann, 2 - Blackman-Harris.
+             * settle: device samples the pll is given to lock after every
+             * retune, on top of the usb transfer in flight while it moves.
+             * At most 512 steps: (stop - start) / (samplerate * usable).
+             */
+            static sptr make(   int index = 0, 
+                                double start_mhz = 50.0, 
+                                double stop_mhz = 6000.0,
+                                double samplerate_mhz = 20.0,
+                                int fft_size = 1024,
+                                int window = 2,
+                                int averages = 4,
+                                int settle = 2000,
+                                double usable = 0.75,
+                                int lna_gain = 0,
+                                int vga_gain = 0);
+
+            /**
+             * @brief The row layout
+             */
+            virtual int bins() const = 0;
+            virtual double start_frequency() const = 0;
+            virtual double bin_width() const = 0;
+
+            /**
+             * @brief Callback for setting parameters on-the-fly
+             */
+            virtual void set_lna_gain(int lna_gain) = 0;
+            virtual void set_vga_gain(int vga_gain) = 0;
+        };
+
+    } // namespace RigExpert
+} // namespace gr
+
+#endif /* INCLUDED_RIGEXPERT_FOBOS_SWEEP_H */
+
+//==============================================================================
\ No newline at end of file
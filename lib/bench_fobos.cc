@@ -0,0 +1,467 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//  Throughput benchmark of the driver and block hot paths
+//  usage: bench_fobos [seconds per case, 0.2 by default]
+//  GB/s counts the bytes the measured path reads plus the bytes it writes
+//==============================================================================
+#include <fobos/fobos.h>
+#include <fobos/fobos_psd.h>
+#include <fobos/fobos_transport.h>
+#include <gnuradio/RigExpert/fobos_sdr.h>
+#include "fobos_ring.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // every transfer length the block may plan, min_transfer_len .. max_transfer_len
+        static const uint32_t bench_transfer_lens[] = { 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576 };
+        static const char * bench_format_names[FOBOS_FORMAT_COUNT] = { "fc32", "sc16", "sc8", "fc16" };
+        static double bench_seconds = 0.2;
+        //======================================================================
+        struct bench_row
+        {
+            std::string path;
+            std::string format;
+            uint32_t transfer_len;
+            double ns_per_sample;
+            double msps;
+            double gbps;
+        };
+        static std::vector<bench_row> bench_rows;
+        //======================================================================
+        static void bench_report(const char * path, const char * format, uint32_t transfer_len, uint64_t samples, double seconds, size_t bytes_per_sample)
+        {
+            bench_row row;
+            row.path = path;
+            row.format = format;
+            row.transfer_len = transfer_len;
+            row.ns_per_sample = seconds * 1E9 / samples;
+            row.msps = samples / seconds * 1E-6;
+            row.gbps = samples * bytes_per_sample / seconds * 1E-9;
+            bench_rows.push_back(row);
+        }
+        //======================================================================
+        // fn returns the samples it processed, one untimed warm up call, then
+        // calls until bench_seconds elapsed, returns seconds
+        template <class F>
+        static double bench_run(F fn, uint64_t & samples)
+        {
+            fn();
+            samples = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            double elapsed = 0.0;
+            do
+            {
+                samples += fn();
+                elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            } while (elapsed < bench_seconds);
+            return elapsed;
+        }
+        //======================================================================
+        // 14 bit offset binary noise in the usb word layout
+        static std::vector<int16_t> bench_raw(size_t complex_samples_count)
+        {
+            std::vector<int16_t> raw(complex_samples_count * 2);
+            uint32_t state = 0x12345678;
+            for (size_t i = 0; i < raw.size(); i++)
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                raw[i] = (int16_t)(state & 0x3FFF);
+            }
+            return raw;
+        }
+        //======================================================================
+        // the rx path needs a running stream (rx_buff, calibration done), so the
+        // first user callback of a simulated stream measures it on the event thread
+        struct bench_driver_ctx
+        {
+            fobos_dev_t * dev;
+            int format;
+            uint32_t transfer_len;
+            std::vector<int16_t> raw;
+            bool nested;
+            bool done;
+        };
+        //======================================================================
+        static void bench_driver_callback(float * buf, uint32_t buf_length, void * ctx)
+        {
+            bench_driver_ctx * bench = static_cast<bench_driver_ctx*>(ctx);
+            if (bench->nested || bench->done)
+            {
+                return;
+            }
+            bench->nested = true;
+            void * raw = bench->raw.data();
+            const uint32_t size = bench->transfer_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW);
+            const uint32_t transfer_len = bench->transfer_len;
+            uint64_t samples = 0;
+            double seconds = bench_run([&]() { fobos_rx_proceed_rx_buff(bench->dev, raw, size); return transfer_len; }, samples);
+            bench_report("proceed_rx_buff", bench_format_names[bench->format], transfer_len, samples, seconds,
+                         fobos_rx_sample_size(FOBOS_FORMAT_RAW) + fobos_rx_sample_size(bench->format));
+            if (bench->format == FOBOS_FORMAT_FC32)
+            {
+                seconds = bench_run([&]() { fobos_rx_proceed_calibration(bench->dev, raw, size); return transfer_len; }, samples);
+                bench_report("proceed_calib", "raw", transfer_len, samples, seconds, fobos_rx_sample_size(FOBOS_FORMAT_RAW));
+            }
+            bench->nested = false;
+            bench->done = true;
+            fobos_rx_cancel_async(bench->dev);
+        }
+        //======================================================================
+        static void bench_driver()
+        {
+            fobos_dev_t * dev = nullptr;
+            if (fobos_rx_open(&dev, 0) != 0)
+            {
+                printf("bench_fobos: could not open the simulated device\n");
+                return;
+            }
+            for (int format = 0; format < FOBOS_FORMAT_COUNT; format++)
+            {
+                fobos_rx_set_sample_format(dev, format);
+                for (uint32_t transfer_len : bench_transfer_lens)
+                {
+                    bench_driver_ctx bench;
+                    bench.dev = dev;
+                    bench.format = format;
+                    bench.transfer_len = transfer_len;
+                    bench.raw = bench_raw(transfer_len);
+                    bench.nested = false;
+                    bench.done = false;
+                    fobos_rx_read_async(dev, bench_driver_callback, &bench, 4, transfer_len);
+                }
+            }
+            fobos_rx_close(dev);
+        }
+        //======================================================================
+        // the whole driver rx path with the conversion spread over the workers,
+        // delivered samples per second while the simulated device runs flat out,
+        // the simulator fills the transfers on the event thread and bounds the rate
+        struct bench_stream_ctx
+        {
+            fobos_dev_t * dev;
+            bool started;
+            uint64_t samples;
+            std::chrono::steady_clock::time_point t0;
+            double seconds;
+        };
+        //======================================================================
+        static void bench_stream_callback(float * buf, uint32_t buf_length, void * ctx)
+        {
+            bench_stream_ctx * bench = static_cast<bench_stream_ctx*>(ctx);
+            if (!bench->started)
+            {
+                bench->started = true;
+                bench->t0 = std::chrono::steady_clock::now();
+                return;
+            }
+            bench->samples += buf_length;
+            bench->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - bench->t0).count();
+            if (bench->seconds >= bench_seconds)
+            {
+                fobos_rx_cancel_async(bench->dev);
+            }
+        }
+        //======================================================================
+        static void bench_workers()
+        {
+            const uint32_t workers[] = { 0, 1, 2, 4, 8 };
+            const uint32_t transfer_len = 131072;
+            fobos_dev_t * dev = nullptr;
+            if (fobos_rx_open(&dev, 0) != 0)
+            {
+                printf("bench_fobos: could not open the simulated device\n");
+                return;
+            }
+            for (uint32_t count : workers)
+            {
+                fobos_rx_set_workers(dev, count);
+                bench_stream_ctx bench;
+                bench.dev = dev;
+                bench.started = false;
+                bench.samples = 0;
+                bench.seconds = 0.0;
+                fobos_rx_read_async(dev, bench_stream_callback, &bench, 16, transfer_len);
+                char path[32];
+                snprintf(path, sizeof(path), "rx_workers_%u", count);
+                bench_report(path, "fc32", transfer_len, bench.samples, bench.seconds,
+                             fobos_rx_sample_size(FOBOS_FORMAT_RAW) + fobos_rx_sample_size(FOBOS_FORMAT_FC32));
+            }
+            // a raw stream, the consumer's fobos_rx_decimate() splits a transfer over them
+            fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW);
+            std::vector<int16_t> raw = bench_raw(transfer_len);
+            std::vector<float> out(transfer_len * 2);
+            for (uint32_t count : workers)
+            {
+                fobos_rx_set_workers(dev, count);
+                uint64_t samples = 0;
+                double seconds = bench_run([&]()
+                {
+                    fobos_rx_decimate(dev, raw.data(), out.data(), transfer_len, FOBOS_FORMAT_FC32, samples);
+                    return transfer_len;
+                }, samples);
+                char path[32];
+                snprintf(path, sizeof(path), "raw_workers_%u", count);
+                bench_report(path, "fc32", transfer_len, samples, seconds,
+                             fobos_rx_sample_size(FOBOS_FORMAT_RAW) + fobos_rx_sample_size(FOBOS_FORMAT_FC32));
+            }
+            fobos_rx_close(dev);
+        }
+        //======================================================================
+        // fobos_rx_decimate() as work() calls it, without and with the mixer (1 MHz
+        // if offset), MS/s and GB/s count the input samples
+        static void bench_decimate()
+        {
+            const uint32_t decimations[] = { 1, 2, 4, 8, 10, 64, 320 };
+            const uint32_t transfer_len = 131072;
+            fobos_dev_t * dev = nullptr;
+            if (fobos_rx_open(&dev, 0) != 0)
+            {
+                printf("bench_fobos: could not open the simulated device\n");
+                return;
+            }
+            fobos_rx_set_frequency(dev, 100E6, nullptr);
+            std::vector<int16_t> raw = bench_raw(transfer_len);
+            std::vector<float> out(transfer_len * 2);
+            for (int mix = 0; mix < 2; mix++)
+            {
+                fobos_rx_set_if_offset(dev, mix ? 1E6 : 0.0);
+                for (uint32_t decimation : decimations)
+                {
+                    if (fobos_rx_set_decimation(dev, decimation) != 0)
+                    {
+                        continue;
+                    }
+                    uint64_t samples = 0;
+                    uint64_t sample = 0;
+                    double seconds = bench_run([&]()
+                    {
+                        fobos_rx_decimate(dev, raw.data(), out.data(), transfer_len, FOBOS_FORMAT_FC32, sample);
+                        sample += transfer_len;
+                        return transfer_len;
+                    }, samples);
+                    char path[32];
+                    snprintf(path, sizeof(path), mix ? "mix_decimate_%u" : "decimate_%u", decimation);
+                    bench_report(path, "fc32", transfer_len, samples, seconds,
+                                 fobos_rx_sample_size(FOBOS_FORMAT_RAW) + fobos_rx_sample_size(FOBOS_FORMAT_FC32) / decimation);
+                }
+            }
+            fobos_rx_close(dev);
+        }
+        //======================================================================
+        // fobos_rx_channelize() straight into per channel buffers, as work() does
+        static void bench_channelize()
+        {
+            const uint32_t channels_list[] = { 4, 16, 64, 256, 1024 };
+            const uint32_t transfer_len = 131072;
+            fobos_dev_t * dev = nullptr;
+            if (fobos_rx_open(&dev, 0) != 0)
+            {
+                printf("bench_fobos: could not open the simulated device\n");
+                return;
+            }
+            std::vector<int16_t> raw = bench_raw(transfer_len);
+            std::vector<float> out(transfer_len * 4 + 2 * 1024);
+            std::vector<void *> dst(1024);
+            for (int oversample = 0; oversample < 2; oversample++)
+            {
+                for (uint32_t channels : channels_list)
+                {
+                    if (fobos_rx_set_channels(dev, channels, oversample) != 0)
+                    {
+                        continue;
+                    }
+                    uint32_t decimation = oversample ? channels / 2 : channels;
+                    size_t per_channel = transfer_len / decimation + 1;
+                    for (uint32_t k = 0; k < channels; k++)
+                    {
+                        dst[k] = out.data() + 2 * k * per_channel;
+                    }
+                    uint64_t samples = 0;
+                    uint64_t sample = 0;
+                    double seconds = bench_run([&]()
+                    {
+                        fobos_rx_channelize(dev, raw.data(), dst.data(), transfer_len, FOBOS_FORMAT_FC32, sample);
+                        sample += transfer_len;
+                        return transfer_len;
+                    }, samples);
+                    char path[32];
+                    snprintf(path, sizeof(path), oversample ? "pfb2x_%u" : "pfb_%u", channels);
+                    bench_report(path, "fc32", transfer_len, samples, seconds,
+                                 fobos_rx_sample_size(FOBOS_FORMAT_RAW) + fobos_rx_sample_size(FOBOS_FORMAT_FC32) * channels / decimation);
+                }
+            }
+            fobos_rx_set_channels(dev, 1, 0);
+            fobos_rx_close(dev);
+        }
+        //======================================================================
+        // fobos_rx_psd() alone, as work() does with the iq output off: 50 % overlap, 16 averages
+        static void bench_psd()
+        {
+            const uint32_t sizes[] = { 256, 1024, 4096, 16384 };
+            const uint32_t transfer_len = 131072;
+            fobos_dev_t * dev = nullptr;
+            if (fobos_rx_open(&dev, 0) != 0)
+            {
+                printf("bench_fobos: could not open the simulated device\n");
+                return;
+            }
+            std::vector<int16_t> raw = bench_raw(transfer_len);
+            for (uint32_t size : sizes)
+            {
+                if (fobos_rx_set_psd(dev, size, FOBOS_WINDOW_BLACKMAN_HARRIS, size / 2, 16) != 0)
+                {
+                    continue;
+                }
+                std::vector<float> rows((transfer_len / (size / 2) / 16 + 1) * size);
+                uint64_t samples = 0;
+                uint64_t sample = 0;
+                double seconds = bench_run([&]()
+                {
+                    fobos_rx_psd(dev, raw.data(), transfer_len, rows.data(), sample);
+                    sample += transfer_len;
+                    return transfer_len;
+                }, samples);
+                char path[32];
+                snprintf(path, sizeof(path), "psd_%u", size);
+                bench_report(path, "db", transfer_len, samples, seconds, fobos_rx_sample_size(FOBOS_FORMAT_RAW));
+            }
+            fobos_rx_set_psd(dev, 0, 0, 0, 0);
+            fobos_rx_close(dev);
+        }
+        //======================================================================
+        // read_samples_callback() and work() as two threads: memcpy in, memcpy out
+        static void bench_ring()
+        {
+            const size_t slots_count = 16;
+            for (uint32_t transfer_len : bench_transfer_lens)
+            {
+                const size_t slot_size = transfer_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW);
+                fobos_ring ring(slots_count, slot_size);
+                std::vector<int16_t> src = bench_raw(transfer_len);
+                std::vector<int16_t> dst(src.size());
+                std::atomic<bool> running(true);
+                std::thread producer([&]()
+                {
+                    while (running)
+                    {
+                        void * slot = ring.write_slot();
+                        if (!slot)
+                        {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        memcpy(slot, src.data(), slot_size);
+                        ring.commit_write();
+                    }
+                });
+                uint64_t samples = 0;
+                double seconds = bench_run([&]()
+                {
+                    void * slot = nullptr;
+                    while ((slot = ring.read_slot()) == nullptr)
+                    {
+                        ring.wait_readable(std::chrono::milliseconds(100));
+                    }
+                    memcpy(dst.data(), slot, slot_size);
+                    ring.commit_read();
+                    return transfer_len;
+                }, samples);
+                running = false;
+                producer.join();
+                bench_report("ring_handoff", "raw", transfer_len, samples, seconds, 4 * fobos_rx_sample_size(FOBOS_FORMAT_RAW));
+            }
+        }
+        //======================================================================
+        // fobos_sdr_impl::general_work() fed by the simulated device as fast as it goes, the
+        // slower of the two sides sets the rate, the transfer length follows from
+        // latency_ms at 50 MS/s
+        static void bench_work()
+        {
+            const double samplerate_mhz = 50.0;
+            for (int format = 0; format < FOBOS_FORMAT_COUNT; format++)
+            {
+                for (uint32_t transfer_len : bench_transfer_lens)
+                {
+                    double latency_ms = (transfer_len + 64) / (samplerate_mhz * 1E3);
+                    fobos_sdr::sptr block = fobos_sdr::make(0, 100.0, samplerate_mhz, 0, 0, 0, 0, format, latency_ms, 100.0, 0.0);
+                    gr::block * general = block.get();
+                    std::vector<uint8_t> out(transfer_len * fobos_rx_sample_size(format));
+                    gr_vector_int ninput_items;
+                    gr_vector_const_void_star input_items;
+                    gr_vector_void_star output_items(1, out.data());
+                    // the stream starts with the calibration and the first pattern render
+                    for (int i = 0; (i < 50) && (general->general_work((int)transfer_len, ninput_items, input_items, output_items) <= 0); i++)
+                    {
+                    }
+                    uint64_t samples = 0;
+                    double seconds = bench_run([&]()
+                    {
+                        int produced = general->general_work((int)transfer_len, ninput_items, input_items, output_items);
+                        return (uint64_t)(produced > 0 ? produced : 0);
+                    }, samples);
+                    bench_report("work", bench_format_names[format], transfer_len, samples, seconds,
+                                 fobos_rx_sample_size(FOBOS_FORMAT_RAW) + fobos_rx_sample_size(format));
+                }
+            }
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
+//==============================================================================
+int main(int argc, char ** argv)
+{
+    using namespace gr::RigExpert;
+    if (argc > 1)
+    {
+        bench_seconds = atof(argv[1]);
+        if (bench_seconds <= 0.0)
+        {
+            printf("usage: %s [seconds per case]\n", argv[0]);
+            return 1;
+        }
+    }
+    struct fobos_sim_config config;
+    fobos_sim_config_init(&config);
+    config.realtime = 0;
+    if (fobos_sim_enable(&config) != 0)
+    {
+        printf("bench_fobos: could not enable the simulated device\n");
+        return 1;
+    }
+    bench_driver();
+    bench_workers();
+    bench_decimate();
+    bench_channelize();
+    bench_psd();
+    bench_ring();
+    bench_work();
+    fobos_sim_enable(NULL);
+    printf("\n%-16s %-6s %8s %10s %10s %8s\n", "path", "format", "transfer", "ns/sample", "MS/s", "GB/s");
+    for (const bench_row & row : bench_rows)
+    {
+        printf("%-16s %-6s %8u %10.3f %10.1f %8.2f\n", row.path.c_str(), row.format.c_str(), row.transfer_len, row.ns_per_sample, row.msps, row.gbps);
+    }
+    return 0;
+}
+//==============================================================================
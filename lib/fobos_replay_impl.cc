@@ -0,0 +1,130 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/             
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <stdexcept>
+#include "fobos_replay_impl.h"
+#include <gnuradio/io_signature.h>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        fobos_replay::sptr fobos_replay::make(  const std::string& path,
+                                                int format,
+                                                double samplerate_mhz,
+                                                double frequency_mhz,
+                                                bool paced,
+                                                bool repeat,
+                                                int output_type,
+                                                double latency_ms,
+                                                double headroom_ms,
+                                                double stats_interval_ms,
+                                                int usb_cpu,
+                                                int work_cpu,
+                                                int rt_priority,
+                                                bool busy_poll,
+                                                int decimation,
+                                                double if_offset_mhz,
+                                                bool auto_if,
+                                                int channels,
+                                                bool oversample,
+                                                int psd_size,
+                                                int psd_window,
+                                                double psd_overlap,
+                                                int psd_averages,
+                                                bool iq_output)
+        {
+            printf("make (%s, %d, %f, %f, %d, %d, %d, %f, %f, %f, %d, %d, %d, %d, %d, %f, %d, %d, %d, %d, %d, %f, %d, %d)\n", path.c_str(), format, samplerate_mhz, frequency_mhz, paced, repeat, output_type, latency_ms, headroom_ms, stats_interval_ms, usb_cpu, work_cpu, rt_priority, busy_poll, decimation, if_offset_mhz, auto_if, channels, oversample, psd_size, psd_window, psd_overlap, psd_averages, iq_output);
+            return gnuradio::make_block_sptr<fobos_replay_impl>(
+                                                path,
+                                                format,
+                                                samplerate_mhz,
+                                                frequency_mhz,
+                                                paced,
+                                                repeat,
+                                                output_type,
+                                                latency_ms,
+                                                headroom_ms,
+                                                stats_interval_ms,
+                                                usb_cpu,
+                                                work_cpu,
+                                                rt_priority,
+                                                busy_poll,
+                                                decimation,
+                                                if_offset_mhz,
+                                                auto_if,
+                                                channels,
+                                                oversample,
+                                                psd_size,
+                                                psd_window,
+                                                psd_overlap,
+                                                psd_averages,
+                                                iq_output);
+        }
+        //======================================================================
+        fobos_sdr_impl::replay_source fobos_replay_impl::source(const std::string& path, int format, bool paced, bool repeat)
+        {
+            if (path.empty())
+            {
+                throw std::invalid_argument("fobos_replay: path must not be empty");
+            }
+            if ((format < FOBOS_REPLAY_AUTO) || (format > FOBOS_REPLAY_FC32))
+            {
+                throw std::invalid_argument("fobos_replay: format must be 0..3");
+            }
+            replay_source replay;
+            replay.path = path;
+            replay.format = format;
+            replay.paced = paced;
+            replay.repeat = repeat;
+            return replay;
+        }
+        //======================================================================
+        // the virtual gr::block base is built here, the one fobos_sdr_impl names is skipped
+        fobos_replay_impl::fobos_replay_impl(   const std::string& path,
+                                                int format,
+                                                double samplerate_mhz,
+                                                double frequency_mhz,
+                                                bool paced,
+                                                bool repeat,
+                                                int output_type,
+                                                double latency_ms,
+                                                double headroom_ms,
+                                                double stats_interval_ms,
+                                                int usb_cpu,
+                                                int work_cpu,
+                                                int rt_priority,
+                                                bool busy_poll,
+                                                int decimation,
+                                                double if_offset_mhz,
+                                                bool auto_if,
+                                                int channels,
+                                                bool oversample,
+                                                int psd_size,
+                                                int psd_window,
+                                                double psd_overlap,
+                                                int psd_averages,
+                                                bool iq_output)
+            : gr::block("fobos_replay",
+                        gr::io_signature::make(0, 0, 0),
+                        outputs(channels, output_type, psd_size, iq_output)),
+              fobos_sdr_impl(0, frequency_mhz, samplerate_mhz, 0, 0, 0, 0,
+                             output_type, latency_ms, headroom_ms, stats_interval_ms,
+                             usb_cpu, work_cpu, rt_priority, busy_poll,
+                             decimation, if_offset_mhz, auto_if, channels, oversample,
+                             psd_size, psd_window, psd_overlap, psd_averages, iq_output,
+                             "", 0, 0.0, 1.0, 1.0, "", 0, source(path, format, paced, repeat))
+        {
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
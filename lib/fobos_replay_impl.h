@@ -0,0 +1,60 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/             
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+
+#ifndef INCLUDED_RIGEXPERT_FOBOS_REPLAY_IMPL_H
+#define INCLUDED_RIGEXPERT_FOBOS_REPLAY_IMPL_H
+
+#include <string>
+#include <gnuradio/RigExpert/fobos_replay.h>
+#include "fobos_sdr_impl.h"
+
+namespace gr 
+{
+    namespace RigExpert 
+    {
+        // fobos_sdr on a device fobos_rx_open_replay() opened, nothing else differs
+        class fobos_replay_impl : public fobos_replay, public fobos_sdr_impl
+        {
+        private:
+            static replay_source source(const std::string& path, int format, bool paced, bool repeat);
+        public:
+            fobos_replay_impl(  const std::string& path,
+                                int format,
+                                double samplerate_mhz,
+                                double frequency_mhz,
+                                bool paced,
+                                bool repeat,
+                                int output_type,
+                                double latency_ms,
+                                double headroom_ms,
+                                double stats_interval_ms,
+                                int usb_cpu,
+                                int work_cpu,
+                                int rt_priority,
+                                bool busy_poll,
+                                int decimation,
+                                double if_offset_mhz,
+                                bool auto_if,
+                                int channels,
+                                bool oversample,
+                                int psd_size,
+                                int psd_window,
+                                double psd_overlap,
+                                int psd_averages,
+                                bool iq_output);
+        };
+
+    } // namespace RigExpert
+} // namespace gr
+
+#endif /* INCLUDED_RIGEXPERT_FOBOS_REPLAY_IMPL_H */
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,114 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include "fobos_ring.h"
+#include <new>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define FOBOS_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define FOBOS_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define FOBOS_CPU_RELAX()
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        fobos_ring::fobos_ring(size_t slots_count, size_t slot_size)
+            : _head(0), _tail(0), _waiting(0), _slots_count(slots_count), _slot_size(slot_size)
+        {
+            if ((slots_count == 0) || (slots_count > 0x80000000u))
+            {
+                throw std::invalid_argument("fobos_ring: bad slots count");
+            }
+            _slots = new void*[_slots_count];
+            for (size_t i = 0; i < _slots_count; i++)
+            {
+                _slots[i] = ::operator new(_slot_size, std::align_val_t(cache_line));
+            }
+        }
+        //======================================================================
+        fobos_ring::~fobos_ring()
+        {
+            for (size_t i = 0; i < _slots_count; i++)
+            {
+                ::operator delete(_slots[i], std::align_val_t(cache_line));
+            }
+            delete[] _slots;
+        }
+        //======================================================================
+        bool fobos_ring::wait_readable(std::chrono::microseconds timeout)
+        {
+            uint32_t head = _head.load(std::memory_order_acquire);
+            if (head != _tail.load(std::memory_order_relaxed))
+            {
+                return true;
+            }
+            _waiting.store(1, std::memory_order_seq_cst);
+            // the producer may have published between the first check and the flag
+            head = _head.load(std::memory_order_seq_cst);
+            if (head == _tail.load(std::memory_order_relaxed))
+            {
+#ifdef __linux__
+                struct timespec ts;
+                ts.tv_sec = timeout.count() / 1000000;
+                ts.tv_nsec = (timeout.count() % 1000000) * 1000;
+                // returns at once if _head is no longer equal to head
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_head), FUTEX_WAIT_PRIVATE, head, &ts, nullptr, 0);
+#else
+                std::unique_lock<std::mutex> lock(_wait_mutex);
+                _wait_cond.wait_for(lock, timeout, [&] { return _head.load() != head; });
+#endif
+            }
+            _waiting.store(0, std::memory_order_relaxed);
+            return _head.load(std::memory_order_acquire) != _tail.load(std::memory_order_relaxed);
+        }
+        //======================================================================
+        bool fobos_ring::spin_readable(std::chrono::microseconds timeout)
+        {
+            const uint32_t tail = _tail.load(std::memory_order_relaxed);
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            for (uint32_t spins = 1; ; spins++)
+            {
+                if (_head.load(std::memory_order_acquire) != tail)
+                {
+                    return true;
+                }
+                // the clock costs more than a pause, look at it now and then
+                if (((spins % 1024) == 0) && (std::chrono::steady_clock::now() >= deadline))
+                {
+                    return false;
+                }
+                FOBOS_CPU_RELAX();
+            }
+        }
+        //======================================================================
+        void fobos_ring::wake()
+        {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_head), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+            _wait_cond.notify_one();
+#endif
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
@@ -0,0 +1,116 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+
+#ifndef INCLUDED_RIGEXPERT_FOBOS_RING_H
+#define INCLUDED_RIGEXPERT_FOBOS_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        /*!
+         * Single producer / single consumer ring of fixed size slots.
+         *
+         * The libusb event thread fills slots, the scheduler thread drains
+         * them. Neither side ever takes a lock the other one holds: head and
+         * tail are atomics on their own cache lines, and the producer only
+         * issues a futex wake (Linux) when the consumer announced that it is
+         * going to sleep.
+         */
+        class fobos_ring
+        {
+        public:
+            static const size_t cache_line = 64;
+
+            fobos_ring(size_t slots_count, size_t slot_size);
+            ~fobos_ring();
+            fobos_ring(const fobos_ring&) = delete;
+            fobos_ring& operator=(const fobos_ring&) = delete;
+
+            size_t slots_count() const { return _slots_count; }
+            size_t slot_size() const { return _slot_size; }
+            // number of filled slots, exact for both sides
+            size_t filled() const
+            {
+                return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+            }
+
+            //=== producer =====================================================
+            // next free slot or nullptr when the ring is full
+            void * write_slot()
+            {
+                uint32_t head = _head.load(std::memory_order_relaxed);
+                if (head - _tail.load(std::memory_order_acquire) >= _slots_count)
+                {
+                    return nullptr;
+                }
+                return _slots[head % _slots_count];
+            }
+            // publish the slot returned by write_slot()
+            void commit_write()
+            {
+                _head.fetch_add(1, std::memory_order_seq_cst);
+                if (_waiting.load(std::memory_order_seq_cst))
+                {
+                    wake();
+                }
+            }
+
+            //=== consumer =====================================================
+            // oldest filled slot or nullptr when the ring is empty
+            void * read_slot()
+            {
+                uint32_t tail = _tail.load(std::memory_order_relaxed);
+                if (_head.load(std::memory_order_acquire) == tail)
+                {
+                    return nullptr;
+                }
+                return _slots[tail % _slots_count];
+            }
+            // return the slot obtained by read_slot() to the producer
+            void commit_read()
+            {
+                _tail.fetch_add(1, std::memory_order_release);
+            }
+            // block until a slot is filled or the timeout elapses
+            bool wait_readable(std::chrono::microseconds timeout);
+            // spin until a slot is filled or the timeout elapses, never sleeps
+            // and never makes the producer issue a wake
+            bool spin_readable(std::chrono::microseconds timeout);
+            // wake a consumer sleeping in wait_readable()
+            void wake();
+
+        private:
+            alignas(cache_line) std::atomic<uint32_t> _head;
+            alignas(cache_line) std::atomic<uint32_t> _tail;
+            alignas(cache_line) std::atomic<uint32_t> _waiting;
+            alignas(cache_line) size_t _slots_count;
+            size_t _slot_size;
+            void ** _slots;
+#ifndef __linux__
+            // wake() never holds this mutex, a missed notify costs one wait period
+            std::mutex _wait_mutex;
+            std::condition_variable _wait_cond;
+#endif
+        };
+
+    } // namespace RigExpert
+} // namespace gr
+
+#endif /* INCLUDED_RIGEXPERT_FOBOS_RING_H */
@@ -14,24 +14,81 @@
 //  2024.04.26
 //==============================================================================
 #include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <stdexcept>
 #include "fobos_sdr_impl.h"
+#include <fobos/fobos_decim.h>
+#include <fobos/fobos_pfb.h>
+#include <fobos/fobos_fft.h>
+#include <fobos/fobos_psd.h>
 #include <gnuradio/io_signature.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 namespace gr
 {
     namespace RigExpert
     {
         //======================================================================
-        using output_type = gr_complex;
+        // the iq ports, then the spectrum port
+        gr::io_signature::sptr fobos_sdr_impl::outputs(int channels, int output_type, int psd_size, bool iq_output)
+        {
+            std::vector<int> sizes;
+            if (iq_output)
+            {
+                sizes.assign(std::max(channels, 1), fobos_rx_sample_size(output_type));
+            }
+            if (psd_size > 0)
+            {
+                sizes.push_back(sizeof(float));
+            }
+            if (sizes.empty())
+            {
+                throw std::invalid_argument("fobos_sdr: iq_output off wants a psd_size");
+            }
+            return gr::io_signature::makev((int)sizes.size(), (int)sizes.size(), sizes);
+        }
+        //======================================================================
         fobos_sdr::sptr fobos_sdr::make(int index, 
                                         double frequency_mhz, 
                                         double samplerate_mhz,
                                         int lna_gain,
                                         int vga_gain,
                                         int direct_sampling,
-                                        int clock_source)
+                                        int clock_source,
+                                        int output_type,
+                                        double latency_ms,
+                                        double headroom_ms,
+                                        double stats_interval_ms,
+                                        int usb_cpu,
+                                        int work_cpu,
+                                        int rt_priority,
+                                        bool busy_poll,
+                                        int decimation,
+                                        double if_offset_mhz,
+                                        bool auto_if,
+                                        int channels,
+                                        bool oversample,
+                                        int psd_size,
+                                        int psd_window,
+                                        double psd_overlap,
+                                        int psd_averages,
+                                        bool iq_output,
+                                        const std::string& record_path,
+                                        int record_prealloc_mb,
+                                        double history_s,
+                                        double snapshot_pre_s,
+                                        double snapshot_post_s,
+                                        const std::string& snapshot_path,
+                                        int workers)
         {
-            printf("make (%d, %f, %f, %d, %d, %d, %d)\n", index, frequency_mhz, samplerate_mhz, lna_gain, vga_gain, direct_sampling, clock_source);
+            printf("make (%d, %f, %f, %d, %d, %d, %d, %d, %f, %f, %f, %d, %d, %d, %d, %d, %f, %d, %d, %d, %d, %d, %f, %d, %d, %s, %d, %f, %f, %f, %s, %d)\n", index, frequency_mhz, samplerate_mhz, lna_gain, vga_gain, direct_sampling, clock_source, output_type, latency_ms, headroom_ms, stats_interval_ms, usb_cpu, work_cpu, rt_priority, busy_poll, decimation, if_offset_mhz, auto_if, channels, oversample, psd_size, psd_window, psd_overlap, psd_averages, iq_output, record_path.c_str(), record_prealloc_mb, history_s, snapshot_pre_s, snapshot_post_s, snapshot_path.c_str(), workers);
             return gnuradio::make_block_sptr<fobos_sdr_impl>(
                                         index, 
                                         frequency_mhz, 
@@ -39,7 +96,32 @@ namespace gr
                                         lna_gain,
                                         vga_gain,
                                         direct_sampling,
-                                        clock_source);
+                                        clock_source,
+                                        output_type,
+                                        latency_ms,
+                                        headroom_ms,
+                                        stats_interval_ms,
+                                        usb_cpu,
+                                        work_cpu,
+                                        rt_priority,
+                                        busy_poll,
+                                        decimation,
+                                        if_offset_mhz,
+                                        auto_if,
+                                        channels,
+                                        oversample,
+                                        psd_size,
+                                        psd_window,
+                                        psd_overlap,
+                                        psd_averages,
+                                        iq_output,
+                                        record_path,
+                                        record_prealloc_mb,
+                                        history_s,
+                                        snapshot_pre_s,
+                                        snapshot_post_s,
+                                        snapshot_path,
+                                        workers);
         }
         //======================================================================
         // The private constructor
@@ -49,41 +131,210 @@ namespace gr
                                         int lna_gain,
                                         int vga_gain,
                                         int direct_sampling,
-                                        int clock_source)
-            : gr::sync_block("fobos_sdr",
-                             gr::io_signature::make(0, 0, 0),
-                             gr::io_signature::make(
-                                 1, 1, sizeof(output_type)))
-        {
-            _rx_bufs = 0;
-            _rx_idx_w = 0;
+                                        int clock_source,
+                                        int output_type,
+                                        double latency_ms,
+                                        double headroom_ms,
+                                        double stats_interval_ms,
+                                        int usb_cpu,
+                                        int work_cpu,
+                                        int rt_priority,
+                                        bool busy_poll,
+                                        int decimation,
+                                        double if_offset_mhz,
+                                        bool auto_if,
+                                        int channels,
+                                        bool oversample,
+                                        int psd_size,
+                                        int psd_window,
+                                        double psd_overlap,
+                                        int psd_averages,
+                                        bool iq_output,
+                                        const std::string& record_path,
+                                        int record_prealloc_mb,
+                                        double history_s,
+                                        double snapshot_pre_s,
+                                        double snapshot_post_s,
+                                        const std::string& snapshot_path,
+                                        int workers,
+                                        const replay_source& replay)
+            : gr::block("fobos_sdr",
+                        gr::io_signature::make(0, 0, 0),
+                        outputs(channels, output_type, psd_size, iq_output))
+        {
+            if ((output_type < 0) || (output_type >= FOBOS_FORMAT_COUNT))
+            {
+                throw std::invalid_argument("fobos_sdr: unsupported output_type");
+            }
+            if ((latency_ms <= 0.0) || (headroom_ms <= 0.0))
+            {
+                throw std::invalid_argument("fobos_sdr: latency_ms and headroom_ms must be positive");
+            }
+            if (stats_interval_ms < 0.0)
+            {
+                throw std::invalid_argument("fobos_sdr: stats_interval_ms must not be negative");
+            }
+            if ((usb_cpu < -1) || (work_cpu < -1))
+            {
+                throw std::invalid_argument("fobos_sdr: usb_cpu and work_cpu must be -1 or a core number");
+            }
+            if ((rt_priority < 0) || (rt_priority > 99))
+            {
+                throw std::invalid_argument("fobos_sdr: rt_priority must be 0..99");
+            }
+            if ((decimation < 1) || !fobos_decim_supported(decimation))
+            {
+                throw std::invalid_argument("fobos_sdr: decimation must be 2^n * 1, 3 or 5, n = 0..6");
+            }
+            if ((channels != 1) && (!fobos_pfb_supported(channels) || (decimation != 1)))
+            {
+                throw std::invalid_argument("fobos_sdr: channels must be 1 or 2^n up to 1024, without decimation");
+            }
+            if ((psd_size != 0) && ((psd_size < 16) || !fobos_fft_supported(psd_size)))
+            {
+                throw std::invalid_argument("fobos_sdr: psd_size must be 0 or 2^n from 16 to 65536");
+            }
+            if ((psd_window < 0) || (psd_window >= FOBOS_WINDOW_COUNT) || (psd_overlap < 0.0) || (psd_overlap > 0.95) || (psd_averages < 1))
+            {
+                throw std::invalid_argument("fobos_sdr: psd_window must be 0..2, psd_overlap 0..0.95, psd_averages positive");
+            }
+            if (record_prealloc_mb < 0)
+            {
+                throw std::invalid_argument("fobos_sdr: record_prealloc_mb must not be negative");
+            }
+            if ((history_s < 0.0) || (snapshot_pre_s < 0.0) || (snapshot_post_s < 0.0))
+            {
+                throw std::invalid_argument("fobos_sdr: history_s, snapshot_pre_s and snapshot_post_s must not be negative");
+            }
+            if ((workers < 0) || (workers > 16))
+            {
+                throw std::invalid_argument("fobos_sdr: workers must be 0..16");
+            }
+            _output_type = output_type;
+            _channels = channels;
+            _decimation = (channels == 1) ? decimation : (oversample ? channels / 2 : channels);
+            _latency_ms = latency_ms;
+            _headroom_ms = headroom_ms;
+            _samplerate = 0.0;
+            _rx_buffs_count = 0;
+            _rx_buff_len = 0;
+            _transfers_count = 0;
+            set_output_multiple(conversion_chunk);
             _rx_pos_r = 0;
-            _rx_idx_r = 0;
-            _rx_pos_w = 0;
-            _rx_filled = 0;
             _running = false;
             _buff_counter = 0;
             _overruns_count = 0;
-            int count = fobos_rx_get_device_count();
-            printf("fobos_sdr_impl:: found devices: %d\n", count);
+            _estimator_running = false;
+            _estimator_decimation = 1;
+            _estimator_counter = 0;
+            _stats_interval_ms = stats_interval_ms;
+            _stats_next = std::chrono::steady_clock::now();
+            _slot_w = 0;
+            _slot_r = 0;
+            _tag_frequency = frequency_mhz * 1E6;
+            _tag_if_offset = 0.0;
+            _tag_samplerate = samplerate_mhz * 1E6;
+            _tune_count = 0;
+            _config_changed = false;
+            _time_anchored = false;
+            _tag_next_sample = 0;
+            _tag_tune_count = 0;
+            _hop_seq = 0;
+            _hop_settle_tagged = false;
+            _iq_output = iq_output;
+            _psd_size = psd_size;
+            _psd_port = (psd_size > 0) ? (iq_output ? std::max(channels, 1) : 0) : -1;
+            _psd_hop = (uint32_t)(psd_size - (int)(psd_size * psd_overlap));
+            _psd_averages = (uint32_t)psd_averages;
+            _psd_rows_len = 0;
+            _psd_rows_pos = 0;
+            _psd_row_count = 0;
+            _record_prealloc = (uint64_t)record_prealloc_mb * 1024 * 1024;
+            _history_s = history_s;
+            _snapshot_pre_s = snapshot_pre_s;
+            _snapshot_post_s = snapshot_post_s;
+            _snapshot_path = snapshot_path.empty() ? std::string("fobos_snapshot") : snapshot_path;
+            _replay = !replay.path.empty();
+            _replay_paced = replay.paced;
+            _stopping = false;
+            _ring_high_water = 0;
+            memset(&_latency_hist, 0, sizeof(_latency_hist));
+            memset(&_convert_hist, 0, sizeof(_convert_hist));
+            if (busy_poll && (rt_priority > 0) && ((work_cpu < 0) || (work_cpu == usb_cpu)))
+            {
+                // a SCHED_FIFO spinner never yields, a usb thread sharing its core starves
+                printf("fobos_sdr_impl:: busy_poll with rt_priority wants work_cpu on a core of its own\n");
+            }
+            _usb_cpu = usb_cpu;
+            _work_cpu = work_cpu;
+            _rt_priority = rt_priority;
+            _busy_poll = busy_poll;
+            _usb_policy.cpu = -1;
+            _usb_policy.priority = 0;
+            _work_policy.cpu = -1;
+            _work_policy.priority = 0;
+            message_port_register_out(pmt::mp("stats"));
+            message_port_register_in(pmt::mp("trigger"));
+            set_msg_handler(pmt::mp("trigger"), [this](const pmt::pmt_t& msg) { handle_trigger(msg); });
+            int count = 1;
+            if (!_replay)
+            {
+                count = fobos_rx_get_device_count();
+                printf("fobos_sdr_impl:: found devices: %d\n", count);
+            }
             if (count > 0)
             {
                 int result = 0;
 
-                result = fobos_rx_open(&_dev, index);
+                if (_replay)
+                {
+                    result = fobos_rx_open_replay(&_dev, replay.path.c_str(), replay.format, replay.paced, replay.repeat);
+                    if (result != 0)
+                    {
+                        throw std::runtime_error("fobos_replay: can not open " + replay.path);
+                    }
+                    // what the recording tells, 0 MHz - as recorded
+                    struct fobos_replay_info info;
+                    fobos_rx_get_replay_info(_dev, &info);
+                    frequency_mhz = (frequency_mhz > 0.0) ? frequency_mhz : info.frequency / 1E6;
+                    samplerate_mhz = (samplerate_mhz > 0.0) ? samplerate_mhz : info.samplerate / 1E6;
+                    lna_gain = info.lna_gain;
+                    vga_gain = info.vga_gain;
+                    direct_sampling = info.direct_sampling;
+                    if (!(samplerate_mhz > 0.0))
+                    {
+                        fobos_rx_close(_dev);
+                        _dev = NULL;
+                        throw std::invalid_argument("fobos_replay: the recording has no sample rate, samplerate_mhz must be set");
+                    }
+                    _tag_frequency = frequency_mhz * 1E6;
+                }
+                else
+                {
+                    result = fobos_rx_open(&_dev, index);
+                }
 
                 if (result == 0)
                 {
                     printf("open...ok\n");
                     printf("(%d, %f, %f, %d, %d, %d, %d)\n", index, frequency_mhz, samplerate_mhz, lna_gain, vga_gain, direct_sampling, clock_source);
 
-                    result = fobos_rx_set_frequency(_dev, frequency_mhz * 1E6, 0);
-                    if (result != 0)
+                    // a headerless recording and no frequency_mhz: nothing to tune, the samples are the same
+                    if ((frequency_mhz > 0.0) || !_replay)
                     {
-                        printf("fobos_rx_set_frequency - error!\n");
+                        double frequency = 0.0;
+                        result = fobos_rx_set_frequency(_dev, frequency_mhz * 1E6, &frequency);
+                        if (result != 0)
+                        {
+                            printf("fobos_rx_set_frequency - error!\n");
+                        }
+                        else
+                        {
+                            _tag_frequency = frequency;
+                        }
                     }
 
-                    result = fobos_rx_set_samplerate(_dev, samplerate_mhz * 1E6, 0);
+                    result = fobos_rx_set_samplerate(_dev, samplerate_mhz * 1E6, &_samplerate);
                     if (result != 0)
                     {
                         printf("fobos_rx_set_samplerate - error!\n");
@@ -113,17 +364,92 @@ namespace gr
                         printf("fobos_rx_set_clk_source - error!\n");
                     }
 
-                    _rx_buffs_count = 32;
-                    _rx_buff_len = 65536*2;
+                    // the ring keeps raw usb transfers, work() converts them straight into the output buffer
+                    result = fobos_rx_set_sample_format(_dev, FOBOS_FORMAT_RAW);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_sample_format - error!\n");
+                    }
+
+                    // work() hands the conversion of a transfer to them and waits
+                    result = fobos_rx_set_workers(_dev, workers);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_workers - error!\n");
+                    }
+
+                    result = fobos_rx_set_decimation(_dev, decimation);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_decimation - error!\n");
+                    }
+
+                    result = fobos_rx_set_channels(_dev, _channels, oversample);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_channels - error!\n");
+                    }
+
+                    if (_psd_port >= 0)
+                    {
+                        result = fobos_rx_set_psd(_dev, psd_size, psd_window, psd_size - _psd_hop, _psd_averages);
+                        if (result != 0)
+                        {
+                            printf("fobos_rx_set_psd - error!\n");
+                        }
+                    }
+
+                    result = fobos_rx_set_auto_if(_dev, auto_if);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_auto_if - error!\n");
+                    }
 
-                    _rx_bufs = (float**)malloc(_rx_buffs_count * sizeof(float*));
-                    for (unsigned int i = 0; i < _rx_buffs_count; i++)
+                    // at the actual sample rate, the center stays where set_frequency() put it
+                    result = fobos_rx_set_if_offset(_dev, if_offset_mhz * 1E6);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_if_offset - error!\n");
+                    }
+                    else
+                    {
+                        _tag_if_offset = if_offset_mhz * 1E6;
+                    }
+
+                    if (!record_path.empty())
                     {
-                        _rx_bufs[i] = (float*)malloc(_rx_buff_len * 2 * sizeof(float));
+                        // ahead of the stream, the first transfer starts the first capture
+                        set_record_path(record_path);
                     }
 
-                    _running = true;
-                    _thread = gr::thread::thread(thread_proc, this);
+                    if (_samplerate > 0.0)
+                    {
+                        _tag_samplerate = _samplerate;
+                    }
+                    set_history(_tag_samplerate);
+                    buffer_plan plan;
+                    plan_buffers(_tag_samplerate, plan);
+                    apply_buffers(_tag_samplerate, plan);
+                    // whole transfers per call at the initial rate, work() also copes with partial slots
+                    // after set_samplerate() changed the transfer length
+                    if (!_iq_output)
+                    {
+                        // whole rows per call
+                        set_output_multiple(_psd_size);
+                    }
+                    else if (_decimation == 1)
+                    {
+                        set_output_multiple(_rx_buff_len);
+                        set_min_noutput_items(_rx_buff_len);
+                    }
+                    else
+                    {
+                        // a transfer plus the samples the filters kept back from the previous one
+                        set_min_noutput_items(_rx_buff_len / _decimation + 1);
+                    }
+
+                    start_estimator();
+                    start_stream();
                 }
                 else
                 {
@@ -141,70 +467,275 @@ namespace gr
         {
             if (_dev)
             {
-                fobos_rx_cancel_async(_dev);
+                stop_stream();
+                stop_estimator();
                 fobos_rx_close(_dev);
             }
-            //if (_thread.joinable()) // - does not work in boost::thread 
-            if (_running)
+        }
+        //======================================================================
+        // derive the usb transfer length, the in flight transfers count and the ring
+        // depth from the latency & headroom targets
+        void fobos_sdr_impl::plan_buffers(double samplerate, buffer_plan & plan) const
+        {
+            size_t transfer_len = 128 * (size_t)(samplerate * _latency_ms * 1E-3 / 128.0);
+            transfer_len = std::min(std::max(transfer_len, min_transfer_len), max_transfer_len);
+            double transfer_ms = transfer_len * 1E3 / samplerate;
+            // the usb side only bridges event thread hiccups, a quarter of the headroom
+            size_t transfers_count = (size_t)ceil(_headroom_ms * 0.25 / transfer_ms);
+            transfers_count = std::min(std::max(transfers_count, min_transfers_count), max_transfers_count);
+            // the ring bridges scheduler stalls
+            size_t slot_size = transfer_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW);
+            size_t buffs_count = (size_t)ceil(_headroom_ms / transfer_ms);
+            buffs_count = std::min(std::max(buffs_count, (size_t)4), std::max(max_ring_size / slot_size, (size_t)4));
+            plan.rx_buff_len = transfer_len;
+            plan.transfers_count = (uint32_t)transfers_count;
+            plan.rx_buffs_count = buffs_count;
+            plan.estimator_decimation = std::max((size_t)(1E3 / (transfer_ms * estimator_rate)), (size_t)1);
+            plan.transfer_ms = transfer_ms;
+        }
+        //======================================================================
+        // the ring slots and the callback copies are sized from _rx_buff_len, only with the
+        // usb thread stopped
+        void fobos_sdr_impl::apply_buffers(double samplerate, const buffer_plan & plan)
+        {
+            _rx_buff_len = plan.rx_buff_len;
+            _transfers_count = plan.transfers_count;
+            _rx_buffs_count = plan.rx_buffs_count;
+            _estimator_decimation = plan.estimator_decimation;
+            printf("fobos_sdr_impl:: %f MS/s, transfer %zu samples (%.2f ms) x %u, ring %zu slots (%.1f ms)\n",
+                   samplerate / 1E6, _rx_buff_len, plan.transfer_ms, _transfers_count, _rx_buffs_count, _rx_buffs_count * plan.transfer_ms);
+        }
+        //======================================================================
+        void fobos_sdr_impl::start_stream()
+        {
+            _ring.reset(new fobos_ring(_rx_buffs_count, _rx_buff_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW)));
+            _slot_info.assign(_rx_buffs_count, slot_info());
+            _slot_w = 0;
+            _slot_r = 0;
+            _rx_pos_r = 0;
+            // the device counts samples from 0 again, the first slot gets the full set of tags
+            _time_anchored = false;
+            _tag_next_sample = UINT64_MAX;
+            // the events of the previous stream count samples that will not come
+            fobos_rx_hop_event events[16];
+            while (fobos_rx_read_hop_events(_dev, &_hop_seq, events, 16) > 0)
             {
-                _thread.join();
             }
-            if (_rx_bufs)
+            _hop_events.clear();
+            _hop_settle_tagged = false;
+            _stopping = false;
+            _running = true;
+            _thread = gr::thread::thread(thread_proc, this);
+        }
+        //======================================================================
+        void fobos_sdr_impl::stop_stream()
+        {
+            if (!_ring)
             {
-                for (unsigned int i = 0; i < _rx_buffs_count; i++)
-                {
-                    if (_rx_bufs[i])
-                    {
-                        free(_rx_bufs[i]);
-                    }
-                }
-                free(_rx_bufs);
+                return;
+            }
+            // an unpaced replay waiting for the ring gives up
+            _stopping = true;
+            // a cancel issued before the stream reached the running state is lost, repeat it
+            while (_running)
+            {
+                fobos_rx_cancel_async(_dev);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
             }
+            _thread.join();
         }
         //======================================================================
-        // Work
-        int fobos_sdr_impl::work(int noutput_items,
-                                 gr_vector_const_void_star& input_items,
-                                 gr_vector_void_star& output_items)
+        // the dc & iq imbalance estimator runs on snapshots of the stream at the idle priority,
+        // work() only copies every _estimator_decimation-th transfer into a 2 slot ring
+        void fobos_sdr_impl::start_estimator()
         {
-            auto out = static_cast<output_type*>(output_items[0]);
-            if (!_running)
+            _estimator_ring.reset(new fobos_ring(2, estimator_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW)));
+            _estimator_counter = 0;
+            _estimator_running = true;
+            _estimator_thread = gr::thread::thread(estimator_proc, this);
+        }
+        //======================================================================
+        void fobos_sdr_impl::stop_estimator()
+        {
+            if (!_estimator_ring)
             {
-                printf("%d ", noutput_items);
-                printf("^");
-                return 0;
+                return;
             }
+            _estimator_running = false;
+            _estimator_ring->wake();
+            _estimator_thread.join();
+        }
+        //======================================================================
+        void fobos_sdr_impl::estimator_proc(fobos_sdr_impl * _this)
+        {
+#ifdef _WIN32
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(SCHED_IDLE)
+            struct sched_param param = {};
+            pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+            while (_this->_estimator_running)
             {
-                std::unique_lock<std::mutex> lock(_rx_mutex);
-                if (_rx_filled == 0)
+                int16_t * slot = static_cast<int16_t*>(_this->_estimator_ring->read_slot());
+                if (!slot)
                 {
-                    //printf("w");
-                    _rx_cond.wait(lock);
+                    _this->_estimator_ring->wait_readable(std::chrono::milliseconds(100));
+                    continue;
                 }
+                fobos_rx_update_iq_estimate(_this->_dev, slot, estimator_len);
+                _this->_estimator_ring->commit_read();
+            }
+        }
+        //======================================================================
+        // Work: the iq ports get an item per decimation input samples, the spectrum port
+        // a row per psd averages blocks, both from the same slots
+        int fobos_sdr_impl::general_work(int noutput_items,
+                                         gr_vector_int& ninput_items,
+                                         gr_vector_const_void_star& input_items,
+                                         gr_vector_void_star& output_items)
+        {
+            if (!_ring)
+            {
+                return WORK_DONE;
+            }
+            if ((_stats_interval_ms > 0.0) && (std::chrono::steady_clock::now() >= _stats_next))
+            {
+                _stats_next = std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t)(_stats_interval_ms * 1E3));
+                message_port_pub(pmt::mp("stats"), collect_stats());
+            }
+            // the scheduler may run work() on a new thread after a flowgraph restart
+            if (std::this_thread::get_id() != _work_thread_id)
+            {
+                _work_thread_id = std::this_thread::get_id();
+                apply_thread_policy("work", _work_cpu, _rt_priority, _work_policy);
             }
-            if (this->_rx_filled > 0)
+            uint8_t * out = _iq_output ? static_cast<uint8_t*>(output_items[0]) : NULL;
+            float * psd_out = (_psd_port >= 0) ? static_cast<float*>(output_items[_psd_port]) : NULL;
+            void * channel_out[FOBOS_PFB_MAX_CHANNELS];
+            const size_t item_size = fobos_rx_sample_size(_output_type);
+            size_t produced = 0;
+            size_t psd_produced = 0;
+            bool consumed = false;
+            for (;;)
             {
-                float * buff = _rx_bufs[_rx_idx_r] + _rx_pos_r * 2;
-                size_t samples_count = (_rx_buff_len - _rx_pos_r);
-                if (samples_count > (size_t)noutput_items)
+                if (psd_out)
+                {
+                    psd_produced += output_psd_rows(psd_out + psd_produced, noutput_items - psd_produced, nitems_written(_psd_port) + psd_produced);
+                    // a full spectrum port holds the next slot back
+                    if (_psd_rows_pos < _psd_rows_len)
+                    {
+                        break;
+                    }
+                }
+                if (_iq_output && (produced >= (size_t)noutput_items))
+                {
+                    break;
+                }
+                int16_t * slot = static_cast<int16_t*>(_ring->read_slot());
+                if (!slot)
+                {
+                    // wait only when nothing was produced or consumed yet
+                    if ((produced > 0) || (psd_produced > 0) || consumed)
+                    {
+                        break;
+                    }
+                    if (_replay && !_running)
+                    {
+                        // the recording ended, done once the ring is empty
+                        if (!_ring->read_slot())
+                        {
+                            return WORK_DONE;
+                        }
+                        continue;
+                    }
+                    bool readable = _busy_poll ? _ring->spin_readable(std::chrono::milliseconds(100))
+                                               : _ring->wait_readable(std::chrono::milliseconds(100));
+                    if (!readable)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+                uint64_t t0 = now_us();
+                const slot_info & info = _slot_info[_slot_r % _slot_info.size()];
+                if (_rx_pos_r == 0)
+                {
+                    fobos_hist_add(&_latency_hist, t0 - info.time_us);
+                    // stream start, a dropped transfer or a retune
+                    if (_iq_output && ((info.sample != _tag_next_sample) || (info.tune_count != _tag_tune_count)))
+                    {
+                        add_stream_tags(nitems_written(0) + produced, info);
+                        _tag_tune_count = info.tune_count;
+                    }
+                    _tag_next_sample = info.sample + _rx_buff_len;
+                }
+                size_t produced_before = produced;
+                size_t samples_count = _rx_buff_len - _rx_pos_r;
+                if (_iq_output)
+                {
+                    // the filters may hold up to decimation - 1 input samples back from the last call
+                    size_t samples_max = (noutput_items - produced) * _decimation - (_decimation - 1);
+                    if (samples_count > samples_max)
+                    {
+                        samples_count = samples_max;
+                    }
+                    if (_channels > 1)
+                    {
+                        for (int k = 0; k < _channels; k++)
+                        {
+                            channel_out[k] = static_cast<uint8_t*>(output_items[k]) + produced * item_size;
+                        }
+                        produced += fobos_rx_channelize(_dev, slot + _rx_pos_r * 2, channel_out, samples_count, _output_type, info.sample + _rx_pos_r);
+                    }
+                    else
+                    {
+                        produced += fobos_rx_decimate(_dev, slot + _rx_pos_r * 2, out + produced * item_size, samples_count, _output_type, info.sample + _rx_pos_r);
+                    }
+                }
+                if (psd_out)
                 {
-                    samples_count = noutput_items;
+                    // the samples just converted are still in cache
+                    add_psd_rows(slot + _rx_pos_r * 2, samples_count, info.sample + _rx_pos_r, info.frequency);
                 }
-                memcpy((float*)out, buff, samples_count * 2 * sizeof(float));
+                fobos_hist_add(&_convert_hist, now_us() - t0);
+                if (_iq_output)
+                {
+                    add_hop_tags(info.sample + _rx_pos_r, samples_count, nitems_written(0) + produced_before, produced - produced_before);
+                }
+                consumed = true;
                 _rx_pos_r += samples_count;
                 if (_rx_pos_r >= _rx_buff_len)
                 {
-                    std::lock_guard<std::mutex> lock(_rx_mutex);
+                    if (++_estimator_counter >= _estimator_decimation)
+                    {
+                        // never waits for the estimator, a busy estimator just misses this snapshot
+                        void * snapshot = _estimator_ring->write_slot();
+                        if (snapshot)
+                        {
+                            _estimator_counter = 0;
+                            memcpy(snapshot, slot, estimator_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW));
+                            _estimator_ring->commit_write();
+                        }
+                    }
                     _rx_pos_r = 0;
-                    _rx_idx_r = (_rx_idx_r + 1) % _rx_buffs_count;
-                    _rx_filled--;
+                    _slot_r++;
+                    _ring->commit_read();
                 }
             }
-            else
+            if (!psd_out)
+            {
+                return (int)produced;
+            }
+            if (!_iq_output)
+            {
+                return (int)psd_produced;
+            }
+            for (int k = 0; k < _channels; k++)
             {
-                printf("u");
+                produce(k, (int)produced);
             }
-            return noutput_items;
+            produce(_psd_port, (int)psd_produced);
+            return WORK_CALLED_PRODUCE;
         }
         //======================================================================
         void fobos_sdr_impl::read_samples_callback(float *buf, uint32_t buf_length, void *ctx)
@@ -216,13 +747,28 @@ namespace gr
                 printf("Err: wrong buf_length!!!");
                 printf("canceling...");
                 fobos_rx_cancel_async(_this->_dev);
+                // the ring slots hold _rx_buff_len samples
+                return;
+            }
+            // never blocks: a full ring drops the transfer; an unpaced replay has no rate to keep up
+            // with, it waits for work() instead
+            void * slot = _this->_ring->write_slot();
+            while (!slot && _this->_replay && !_this->_replay_paced && !_this->_stopping)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                slot = _this->_ring->write_slot();
             }
-            std::lock_guard<std::mutex> lock(_this->_rx_mutex);
-            if (_this->_rx_filled < _this->_rx_buffs_count)
+            if (slot)
             {
-                memcpy(_this->_rx_bufs[_this->_rx_idx_w], buf, _this->_rx_buff_len * 2 *sizeof(float));
-                _this->_rx_idx_w = (_this->_rx_idx_w + 1) % _this->_rx_buffs_count;
-                _this->_rx_filled++;
+                memcpy(slot, buf, _this->_rx_buff_len * fobos_rx_sample_size(FOBOS_FORMAT_RAW));
+                _this->stamp_slot(_this->_slot_info[_this->_slot_w++ % _this->_slot_info.size()], buf_length);
+                _this->_ring->commit_write();
+                // only this thread raises the mark, reset_stats() may lower it
+                uint32_t filled = (uint32_t)_this->_ring->filled();
+                if (filled > _this->_ring_high_water.load(std::memory_order_relaxed))
+                {
+                    _this->_ring_high_water.store(filled, std::memory_order_relaxed);
+                }
             }
             else
             {
@@ -230,16 +776,21 @@ namespace gr
                 // printf("#");
                 //printf("OVERRUN!!!");
             }
-            _this->_rx_cond.notify_one();
         }
         //======================================================================
         void fobos_sdr_impl::thread_proc(fobos_sdr_impl * _this)
         {
-            int result = fobos_rx_read_async(_this->_dev, read_samples_callback, _this, 16, _this->_rx_buff_len);
+            apply_thread_policy("usb", _this->_usb_cpu, _this->_rt_priority, _this->_usb_policy);
+            int result = fobos_rx_read_async(_this->_dev, read_samples_callback, _this, _this->_transfers_count, _this->_rx_buff_len);
             if (result == 0)
             {
                 printf("fobos_rx_read_async - ok!\n");
             }
+            else if (_this->_replay)
+            {
+                // the device is gone at the end of the recording
+                printf("fobos_rx_read_async - end of the recording\n");
+            }
             else
             {
                 printf("fobos_rx_read_async - error!\n");
@@ -247,41 +798,516 @@ namespace gr
             _this->_running = false;
         }
         //======================================================================
+        // the usb thread: arrival time, sample index and the rx_time of the first sample,
+        // the host clock only anchors the sample count at the stream start and rate changes
+        void fobos_sdr_impl::stamp_slot(slot_info & info, uint32_t buf_length)
+        {
+            if (_config_changed.exchange(false))
+            {
+                // a batch ran before this transfer or is still queued
+                fobos_rx_config config;
+                if (fobos_rx_get_config(_dev, &config) == 0)
+                {
+                    if (config.pending)
+                    {
+                        _config_changed = true;
+                    }
+                    else if ((config.actual_frequency != _tag_frequency) || (config.if_offset != _tag_if_offset))
+                    {
+                        _tag_frequency = config.actual_frequency;
+                        _tag_if_offset = config.if_offset;
+                        _tune_count++;
+                    }
+                }
+            }
+            info.time_us = now_us();
+            fobos_rx_get_sample_index(_dev, &info.sample);
+            info.tune_count = _tune_count;
+            info.frequency = _tag_frequency;
+            info.samplerate = _tag_samplerate;
+            if (!_time_anchored)
+            {
+                // the first sample left the adc a transfer before the transfer completed
+                double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count() - buf_length / info.samplerate;
+                _time_anchor_secs = (uint64_t)now;
+                _time_anchor_frac = now - (double)_time_anchor_secs;
+                _time_anchor_sample = info.sample;
+                _time_anchor_rate = info.samplerate;
+                _time_anchored = true;
+            }
+            double offset = _time_anchor_frac + (double)(info.sample - _time_anchor_sample) / _time_anchor_rate;
+            double secs = floor(offset);
+            info.time_secs = _time_anchor_secs + (uint64_t)secs;
+            info.time_frac = offset - secs;
+            if (info.samplerate != _time_anchor_rate)
+            {
+                // the rate changed without a restart, count on from here at the new one
+                _time_anchor_secs = info.time_secs;
+                _time_anchor_frac = info.time_frac;
+                _time_anchor_sample = info.sample;
+                _time_anchor_rate = info.samplerate;
+            }
+        }
+        //======================================================================
+        // UHD compatible: rx_time (uint64 full secs, double frac secs), rx_rate and rx_freq in Hz
+        void fobos_sdr_impl::add_stream_tags(uint64_t offset, const slot_info & info)
+        {
+            const pmt::pmt_t srcid = pmt::string_to_symbol(alias());
+            for (int k = 0; k < _channels; k++)
+            {
+                // channel k at k / channels of the rate, the upper half below the center
+                int channel = (k < (_channels + 1) / 2) ? k : k - _channels;
+                add_item_tag(k, offset, pmt::mp("rx_time"), pmt::make_tuple(pmt::from_uint64(info.time_secs), pmt::from_double(info.time_frac)), srcid);
+                add_item_tag(k, offset, pmt::mp("rx_rate"), pmt::from_double(info.samplerate / _decimation), srcid);
+                add_item_tag(k, offset, pmt::mp("rx_freq"), pmt::from_double(info.frequency + channel * info.samplerate / _channels), srcid);
+            }
+        }
+        //======================================================================
+        // rx_settle (the hop index) where the pll starts to settle, rx_freq and rx_hop where
+        // the dwell starts, at the item the sample went into; the samples sample ..
+        // sample + samples_count went into items_count items from offset on
+        void fobos_sdr_impl::add_hop_tags(uint64_t sample, size_t samples_count, uint64_t offset, size_t items_count)
+        {
+            fobos_rx_hop_event events[16];
+            int count;
+            while ((count = fobos_rx_read_hop_events(_dev, &_hop_seq, events, 16)) > 0)
+            {
+                _hop_events.insert(_hop_events.end(), events, events + count);
+            }
+            if (items_count == 0)
+            {
+                return;
+            }
+            const pmt::pmt_t srcid = pmt::string_to_symbol(alias());
+            while (!_hop_events.empty())
+            {
+                const fobos_rx_hop_event & event = _hop_events.front();
+                uint64_t start = _hop_settle_tagged ? event.dwell_sample : event.settle_sample;
+                if (start >= sample + samples_count)
+                {
+                    break;
+                }
+                // a start the filters still held back goes to the first item of this call
+                uint64_t item = offset + std::min((start > sample) ? (start - sample) / _decimation : 0, (uint64_t)items_count - 1);
+                for (int k = 0; k < _channels; k++)
+                {
+                    if (!_hop_settle_tagged)
+                    {
+                        add_item_tag(k, item, pmt::mp("rx_settle"), pmt::from_long(event.hop), srcid);
+                        continue;
+                    }
+                    int channel = (k < (_channels + 1) / 2) ? k : k - _channels;
+                    add_item_tag(k, item, pmt::mp("rx_freq"), pmt::from_double(event.frequency + channel * _tag_samplerate / _channels), srcid);
+                    add_item_tag(k, item, pmt::mp("rx_hop"), pmt::from_long(event.hop), srcid);
+                }
+                if (_hop_settle_tagged)
+                {
+                    _tag_frequency = event.frequency;
+                    _hop_events.pop_front();
+                }
+                _hop_settle_tagged = !_hop_settle_tagged;
+            }
+        }
+        //======================================================================
+        // the rows the samples complete, each with the center it was taken at, only
+        // after the port took all of the previous ones
+        void fobos_sdr_impl::add_psd_rows(const int16_t * raw, size_t samples_count, uint64_t sample, double frequency)
+        {
+            _psd_rows_len = 0;
+            _psd_rows_pos = 0;
+            size_t rows_max = samples_count / _psd_hop / _psd_averages + 1;
+            if (_psd_rows.size() < rows_max * _psd_size)
+            {
+                _psd_rows.resize(rows_max * _psd_size);
+            }
+            int rows = fobos_rx_psd(_dev, raw, (uint32_t)samples_count, _psd_rows.data(), sample);
+            if (rows > 0)
+            {
+                _psd_rows_len = (size_t)rows * _psd_size;
+                _psd_row_frequency.insert(_psd_row_frequency.end(), rows, frequency);
+            }
+        }
+        //======================================================================
+        // as many of the waiting floats as fit from item offset on, psd_row and rx_freq
+        // on the first bin of every row
+        size_t fobos_sdr_impl::output_psd_rows(float * out, size_t space, uint64_t offset)
+        {
+            size_t count = std::min(space, _psd_rows_len - _psd_rows_pos);
+            const pmt::pmt_t srcid = pmt::string_to_symbol(alias());
+            size_t i = (_psd_size - _psd_rows_pos % _psd_size) % _psd_size;
+            for (; i < count; i += _psd_size)
+            {
+                add_item_tag(_psd_port, offset + i, pmt::mp("psd_row"), pmt::from_uint64(_psd_row_count++), srcid);
+                add_item_tag(_psd_port, offset + i, pmt::mp("rx_freq"), pmt::from_double(_psd_row_frequency.front()), srcid);
+                _psd_row_frequency.pop_front();
+            }
+            memcpy(out, _psd_rows.data() + _psd_rows_pos, count * sizeof(float));
+            _psd_rows_pos += count;
+            return count;
+        }
+        //======================================================================
+        uint64_t fobos_sdr_impl::now_us()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        //======================================================================
+        // pin the calling thread and raise its priority, a refusal is reported, not fatal
+        void fobos_sdr_impl::apply_thread_policy(const char * name, int cpu, int priority, thread_policy & applied)
+        {
+            applied.cpu = -1;
+            applied.priority = 0;
+            if (cpu >= 0)
+            {
+#ifdef _WIN32
+                bool pinned = (cpu < 64) && (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0);
+#elif defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                bool pinned = (cpu < CPU_SETSIZE) && (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0);
+#else
+                bool pinned = false;
+#endif
+                if (pinned)
+                {
+                    applied.cpu = cpu;
+                }
+                else
+                {
+                    printf("fobos_sdr_impl:: %s thread: could not pin to cpu %d\n", name, cpu);
+                }
+            }
+            if (priority > 0)
+            {
+#ifdef _WIN32
+                bool raised = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#else
+                struct sched_param param = {};
+                param.sched_priority = priority;
+                bool raised = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+                if (raised)
+                {
+                    applied.priority = priority;
+                }
+                else
+                {
+                    printf("fobos_sdr_impl:: %s thread: SCHED_FIFO %d not permitted, default scheduling\n", name, priority);
+                }
+            }
+        }
+        //======================================================================
+        static pmt::pmt_t hist_to_pmt(const struct fobos_hist & hist)
+        {
+            pmt::pmt_t dict = pmt::make_dict();
+            dict = pmt::dict_add(dict, pmt::mp("count"), pmt::from_uint64(hist.count));
+            dict = pmt::dict_add(dict, pmt::mp("mean_us"), pmt::from_double(hist.count ? (double)hist.sum_us / hist.count : 0.0));
+            dict = pmt::dict_add(dict, pmt::mp("max_us"), pmt::from_uint64(hist.max_us));
+            dict = pmt::dict_add(dict, pmt::mp("bins"), pmt::init_u64vector(FOBOS_HIST_BINS, hist.bins));
+            return dict;
+        }
+        //======================================================================
+        // the caller holds d_setlock (work() or get_stats())
+        pmt::pmt_t fobos_sdr_impl::collect_stats()
+        {
+            struct fobos_rx_stats rx_stats;
+            memset(&rx_stats, 0, sizeof(rx_stats));
+            if (_dev)
+            {
+                fobos_rx_get_stats(_dev, &rx_stats);
+            }
+            pmt::pmt_t dict = pmt::make_dict();
+            dict = pmt::dict_add(dict, pmt::mp("overruns"), pmt::from_uint64(_overruns_count));
+            dict = pmt::dict_add(dict, pmt::mp("buffers"), pmt::from_uint64(rx_stats.buffers));
+            dict = pmt::dict_add(dict, pmt::mp("rx_failures"), pmt::from_uint64(rx_stats.rx_failures));
+            dict = pmt::dict_add(dict, pmt::mp("transfer_errors"), pmt::from_uint64(rx_stats.transfer_errors));
+            dict = pmt::dict_add(dict, pmt::mp("resubmit_errors"), pmt::from_uint64(rx_stats.resubmit_errors));
+            dict = pmt::dict_add(dict, pmt::mp("control_transfers"), pmt::from_uint64(rx_stats.control_transfers));
+            dict = pmt::dict_add(dict, pmt::mp("ring_slots"), pmt::from_uint64(_ring ? _ring->slots_count() : 0));
+            dict = pmt::dict_add(dict, pmt::mp("ring_filled"), pmt::from_uint64(_ring ? _ring->filled() : 0));
+            dict = pmt::dict_add(dict, pmt::mp("ring_high_water"), pmt::from_uint64(_ring_high_water));
+            dict = pmt::dict_add(dict, pmt::mp("usb_interval"), hist_to_pmt(rx_stats.usb_interval));
+            dict = pmt::dict_add(dict, pmt::mp("buffer_time"), hist_to_pmt(rx_stats.buffer_time));
+            dict = pmt::dict_add(dict, pmt::mp("retune_time"), hist_to_pmt(rx_stats.retune_time));
+            dict = pmt::dict_add(dict, pmt::mp("latency"), hist_to_pmt(_latency_hist));
+            dict = pmt::dict_add(dict, pmt::mp("convert_time"), hist_to_pmt(_convert_hist));
+            dict = pmt::dict_add(dict, pmt::mp("usb_thread_cpu"), pmt::from_long(_usb_policy.cpu));
+            dict = pmt::dict_add(dict, pmt::mp("usb_thread_priority"), pmt::from_long(_usb_policy.priority));
+            dict = pmt::dict_add(dict, pmt::mp("work_thread_cpu"), pmt::from_long(_work_policy.cpu));
+            dict = pmt::dict_add(dict, pmt::mp("work_thread_priority"), pmt::from_long(_work_policy.priority));
+            dict = pmt::dict_add(dict, pmt::mp("busy_poll"), pmt::from_bool(_busy_poll));
+            struct fobos_rx_recording recording;
+            memset(&recording, 0, sizeof(recording));
+            if (_dev)
+            {
+                fobos_rx_get_recording(_dev, &recording);
+            }
+            dict = pmt::dict_add(dict, pmt::mp("record_active"), pmt::from_bool(recording.active != 0));
+            dict = pmt::dict_add(dict, pmt::mp("record_bytes"), pmt::from_uint64(recording.bytes));
+            dict = pmt::dict_add(dict, pmt::mp("record_written"), pmt::from_uint64(recording.written));
+            dict = pmt::dict_add(dict, pmt::mp("record_dropped"), pmt::from_uint64(recording.dropped));
+            dict = pmt::dict_add(dict, pmt::mp("record_gaps"), pmt::from_uint64(recording.gaps));
+            dict = pmt::dict_add(dict, pmt::mp("record_error"), pmt::from_long(recording.error));
+            struct fobos_rx_snapshot snapshot;
+            memset(&snapshot, 0, sizeof(snapshot));
+            if (_dev)
+            {
+                fobos_rx_get_snapshot(_dev, &snapshot);
+            }
+            dict = pmt::dict_add(dict, pmt::mp("history_start"), pmt::from_uint64(snapshot.history_start));
+            dict = pmt::dict_add(dict, pmt::mp("history_end"), pmt::from_uint64(snapshot.history_end));
+            dict = pmt::dict_add(dict, pmt::mp("snapshot_active"), pmt::from_bool(snapshot.active != 0));
+            dict = pmt::dict_add(dict, pmt::mp("snapshot_start"), pmt::from_uint64(snapshot.start));
+            dict = pmt::dict_add(dict, pmt::mp("snapshot_end"), pmt::from_uint64(snapshot.end));
+            dict = pmt::dict_add(dict, pmt::mp("snapshot_samples"), pmt::from_uint64(snapshot.samples));
+            dict = pmt::dict_add(dict, pmt::mp("snapshot_gaps"), pmt::from_uint64(snapshot.gaps));
+            dict = pmt::dict_add(dict, pmt::mp("snapshot_error"), pmt::from_long(snapshot.error));
+            dict = pmt::dict_add(dict, pmt::mp("snapshots"), pmt::from_uint64(snapshot.snapshots));
+            if (_replay)
+            {
+                struct fobos_replay_info replay;
+                memset(&replay, 0, sizeof(replay));
+                if (_dev)
+                {
+                    fobos_rx_get_replay_info(_dev, &replay);
+                }
+                dict = pmt::dict_add(dict, pmt::mp("replay_position"), pmt::from_uint64(replay.position));
+                dict = pmt::dict_add(dict, pmt::mp("replay_samples"), pmt::from_uint64(replay.samples));
+                dict = pmt::dict_add(dict, pmt::mp("replay_loops"), pmt::from_uint64(replay.loops));
+            }
+            return dict;
+        }
+        //======================================================================
+        pmt::pmt_t fobos_sdr_impl::get_stats()
+        {
+            gr::thread::scoped_lock lock(d_setlock);
+            return collect_stats();
+        }
+        //======================================================================
+        void fobos_sdr_impl::reset_stats()
+        {
+            gr::thread::scoped_lock lock(d_setlock);
+            _overruns_count = 0;
+            _ring_high_water = 0;
+            memset(&_latency_hist, 0, sizeof(_latency_hist));
+            memset(&_convert_hist, 0, sizeof(_convert_hist));
+            if (_dev)
+            {
+                fobos_rx_reset_stats(_dev);
+            }
+        }
+        //======================================================================
         void fobos_sdr_impl::set_frequency(double frequency_mhz)
         {
-            double actual;
-            int res = fobos_rx_set_frequency(_dev, frequency_mhz * 1e6, &actual);
-            printf("Setting freq %f MHz, actual %f MHz: %s\n", frequency_mhz, actual / 1E6, res == 0 ? "OK" : "ERR");
+            int res = change_config([&](fobos_rx_config & config) { config.frequency = frequency_mhz * 1e6; });
+            printf("Setting freq %f MHz: %s\n", frequency_mhz, res == 0 ? "OK" : "ERR");
+        }
+        //======================================================================
+        void fobos_sdr_impl::prepare_frequencies(const std::vector<double>& frequencies_mhz)
+        {
+            std::vector<double> values(frequencies_mhz.size());
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                values[i] = frequencies_mhz[i] * 1e6;
+            }
+            int res = fobos_rx_prepare_frequencies(_dev, values.data(), (uint32_t)values.size());
+            printf("Preparing %u frequencies: %s\n", (unsigned int)values.size(), res == 0 ? "OK" : "ERR");
+        }
+        //======================================================================
+        void fobos_sdr_impl::set_hops(const std::vector<double>& frequencies_mhz,
+                                      const std::vector<int>& dwell_samples,
+                                      const std::vector<int>& settle_samples)
+        {
+            std::vector<fobos_rx_hop> hops(frequencies_mhz.size());
+            bool valid = (dwell_samples.size() == hops.size()) && (settle_samples.size() == hops.size());
+            for (size_t i = 0; valid && (i < hops.size()); i++)
+            {
+                valid = (dwell_samples[i] > 0) && (settle_samples[i] >= 0);
+                hops[i].frequency = frequencies_mhz[i] * 1e6;
+                hops[i].dwell = (uint32_t)dwell_samples[i];
+                hops[i].settle = (uint32_t)settle_samples[i];
+            }
+            int res = valid ? fobos_rx_set_hops(_dev, hops.data(), (uint32_t)hops.size()) : -7;
+            printf("Setting %u hops: %s\n", (unsigned int)hops.size(), res == 0 ? "OK" : "ERR");
+        }
+        //======================================================================
+        void fobos_sdr_impl::set_record_path(const std::string& path)
+        {
+            if (!_dev)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(_config_lock);
+            if (!_record_path.empty())
+            {
+                // the stream goes on while the queued writes drain
+                int res = fobos_rx_stop_recording(_dev);
+                printf("Stopping recording %s: %s\n", _record_path.c_str(), res == 0 ? "OK" : "ERR");
+                _record_path.clear();
+            }
+            if (!path.empty())
+            {
+                int res = fobos_rx_start_recording(_dev, path.c_str(), _record_prealloc, 0.0);
+                printf("Recording to %s.sigmf-data: %s\n", path.c_str(), res == 0 ? "OK" : "ERR");
+                if (res == 0)
+                {
+                    _record_path = path;
+                }
+            }
+        }
+        //======================================================================
+        // history_s of raw transfers at samplerate, not while streaming
+        void fobos_sdr_impl::set_history(double samplerate)
+        {
+            if (!_dev || (_history_s <= 0.0))
+            {
+                return;
+            }
+            uint64_t size = (uint64_t)(_history_s * samplerate) * 4;
+            int res = fobos_rx_set_history(_dev, size);
+            printf("Keeping %f s (%llu MB) of history: %s\n", _history_s, (unsigned long long)(size >> 20), res == 0 ? "OK" : "ERR");
+        }
+        //======================================================================
+        // any message snapshots the history around the newest sample, a dictionary may
+        // tell path, pre, post (s) and sample
+        void fobos_sdr_impl::handle_trigger(const pmt::pmt_t& msg)
+        {
+            if (!_dev || (_history_s <= 0.0))
+            {
+                printf("fobos_sdr: a trigger without history_s\n");
+                return;
+            }
+            std::string path;
+            double pre_s = _snapshot_pre_s;
+            double post_s = _snapshot_post_s;
+            uint64_t sample = FOBOS_SNAPSHOT_NOW;
+            if (pmt::is_dict(msg))
+            {
+                pmt::pmt_t value = pmt::dict_ref(msg, pmt::mp("path"), pmt::PMT_NIL);
+                if (pmt::is_symbol(value))
+                {
+                    path = pmt::symbol_to_string(value);
+                }
+                value = pmt::dict_ref(msg, pmt::mp("pre"), pmt::PMT_NIL);
+                if (pmt::is_number(value))
+                {
+                    pre_s = pmt::to_double(value);
+                }
+                value = pmt::dict_ref(msg, pmt::mp("post"), pmt::PMT_NIL);
+                if (pmt::is_number(value))
+                {
+                    post_s = pmt::to_double(value);
+                }
+                value = pmt::dict_ref(msg, pmt::mp("sample"), pmt::PMT_NIL);
+                if (pmt::is_uint64(value) || pmt::is_integer(value))
+                {
+                    sample = pmt::is_uint64(value) ? pmt::to_uint64(value) : (uint64_t)pmt::to_long(value);
+                }
+            }
+            if (path.empty())
+            {
+                // snapshot_path_20240426T101502.123Z
+                auto now = std::chrono::system_clock::now();
+                std::time_t secs = std::chrono::system_clock::to_time_t(now);
+                long ms = (long)(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+                char stamp[32];
+                std::strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%S", std::gmtime(&secs));
+                char suffix[48];
+                snprintf(suffix, sizeof(suffix), "_%s.%03ldZ", stamp, ms);
+                path = _snapshot_path + suffix;
+            }
+            double samplerate = _samplerate > 0.0 ? _samplerate : (double)_tag_samplerate;
+            uint64_t pre = (uint64_t)(std::max(pre_s, 0.0) * samplerate);
+            uint64_t post = (uint64_t)(std::max(post_s, 0.0) * samplerate);
+            int res = fobos_rx_trigger_snapshot(_dev, path.c_str(), sample, pre, post);
+            printf("Snapshot to %s.sigmf-data: %s\n", path.c_str(), res == 0 ? "OK" : (res == -5 ? "BUSY" : "ERR"));
+        }
+        //======================================================================
+        void fobos_sdr_impl::set_if_offset(double if_offset_mhz)
+        {
+            // the lo moves with the batch, stamp_slot() tags the first transfer after it
+            int res = change_config([&](fobos_rx_config & config) { config.if_offset = if_offset_mhz * 1e6; });
+            printf("Setting if offset %f MHz: %s\n", if_offset_mhz, res == 0 ? "OK" : "ERR");
+        }
+        //======================================================================
+        void fobos_sdr_impl::set_auto_if(bool auto_if)
+        {
+            int res = change_config([&](fobos_rx_config & config) { config.auto_if = auto_if ? 1 : 0; });
+            printf("Setting auto if to %d: %s\n", auto_if, res == 0 ? "OK" : "ERR");
         }
         //======================================================================
         void fobos_sdr_impl::set_samplerate(double samplerate_mhz)
         {
-            double actual;
+            // the scheduler holds d_setlock around work(), so the ring can be swapped safely
+            gr::thread::scoped_lock lock(d_setlock);
+            // no config batch in between, both write the clocks and the gpo
+            std::lock_guard<std::mutex> config_lock(_config_lock);
+            // the usb thread copies _rx_buff_len samples into the ring, it stops before the
+            // clocks change; the transfers still in the ring were taken at the old rate and go
+            // with it
+            bool streaming = (bool)_ring;
+            if (streaming)
+            {
+                stop_stream();
+            }
+            double actual = 0.0;
             int res = fobos_rx_set_samplerate(_dev, samplerate_mhz * 1e6, &actual);
             printf("Setting sample rate %f MHz, actual %f MHz: %s\n", samplerate_mhz, actual / 1E6, res == 0 ? "OK" : "ERR");
+            if ((res == 0) && streaming)
+            {
+                buffer_plan plan;
+                plan_buffers(actual, plan);
+                apply_buffers(actual, plan);
+                // the same seconds at the new rate, the stream indices start over anyway
+                set_history(actual);
+                // only the slots of the new ring get the new rate
+                _samplerate = actual;
+                _tag_samplerate = actual;
+                _tune_count++;
+            }
+            if (streaming)
+            {
+                start_stream();
+            }
+        }
+        //======================================================================
+        // read, change, apply: right away when not streaming, otherwise the usb thread runs the
+        // batch between two transfers and stamp_slot() picks up the frequency it reached
+        int fobos_sdr_impl::change_config(const std::function<void(fobos_rx_config &)> & change)
+        {
+            std::lock_guard<std::mutex> lock(_config_lock);
+            fobos_rx_config config;
+            int res = fobos_rx_get_config(_dev, &config);
+            if (res == 0)
+            {
+                change(config);
+                res = fobos_rx_apply_config(_dev, &config);
+                _config_changed = true;
+            }
+            return res;
         }
         //======================================================================
         void fobos_sdr_impl::set_lna_gain(int lna_gain)
         {
-            int res = fobos_rx_set_lna_gain(_dev, lna_gain);
+            int res = change_config([&](fobos_rx_config & config) { config.lna_gain = lna_gain; });
             printf("Setting LNA gain to #%d: %s\n", lna_gain, res == 0 ? "OK" : "ERR");
         }
         //======================================================================
         void fobos_sdr_impl::set_vga_gain(int vga_gain)
         {
-            int res = fobos_rx_set_vga_gain(_dev, vga_gain);
+            int res = change_config([&](fobos_rx_config & config) { config.vga_gain = vga_gain; });
             printf("Setting VGA gain to #%d: %s\n",  vga_gain, res == 0 ? "OK" : "ERR");
         }
         //======================================================================
         void fobos_sdr_impl::set_direct_sampling(int direct_sampling)
         {
-            int res = fobos_rx_set_direct_sampling(_dev, direct_sampling);
+            int res = change_config([&](fobos_rx_config & config) { config.direct_sampling = direct_sampling ? 1 : 0; });
             printf("Setting direct sampling mode to %d: %s\n",  direct_sampling, res == 0 ? "OK" : "ERR");
         }
         //======================================================================
         void fobos_sdr_impl::set_clock_source(int clock_source)
         {
-            int res = fobos_rx_set_clk_source(_dev, clock_source);
+            int res = change_config([&](fobos_rx_config & config) { config.clock_source = clock_source ? 1 : 0; });
             printf("Setting clock source to %s: %s\n",  clock_source == 0 ? "internal" : "external", res == 0 ? "OK" : "ERR");
         }
         //======================================================================
@@ -17,37 +17,175 @@
 #ifndef INCLUDED_RIGEXPERT_FOBOS_SDR_IMPL_H
 #define INCLUDED_RIGEXPERT_FOBOS_SDR_IMPL_H
 
-#include <gnuradio/sync_block.h>
+#include <gnuradio/block.h>
+#include <gnuradio/io_signature.h>
 #include <gnuradio/thread/thread.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
 #include <gnuradio/RigExpert/fobos_sdr.h>
 #include <fobos/fobos.h>
+#include "fobos_ring.h"
 
 namespace gr
 {
     namespace RigExpert
     {
-        class fobos_sdr_impl : public fobos_sdr
+        class fobos_sdr_impl : public virtual fobos_sdr
         {
+        protected:
+            // a recording streamed instead of a device, fobos_replay
+            struct replay_source
+            {
+                std::string path;       // empty - the device index
+                int format;
+                bool paced;
+                bool repeat;
+                replay_source() : format(FOBOS_REPLAY_AUTO), paced(true), repeat(false) {}
+            };
+            static gr::io_signature::sptr outputs(int channels, int output_type, int psd_size, bool iq_output);
         private:
             uint32_t _buff_counter;
-            bool _running;
+            std::atomic<bool> _running;
             gr::thread::thread _thread;
-            std::mutex _rx_mutex;
-            std::condition_variable _rx_cond;
-            float ** _rx_bufs;
+            std::unique_ptr<fobos_ring> _ring;
+            std::atomic<bool> _estimator_running;
+            gr::thread::thread _estimator_thread;
+            std::unique_ptr<fobos_ring> _estimator_ring;
+            size_t _estimator_decimation;
+            size_t _estimator_counter;
+            int _output_type;
+            int _decimation;                // input samples per output item, of every port
+            int _channels;
+            double _latency_ms;
+            double _headroom_ms;
+            double _samplerate;
             size_t _rx_buffs_count;
             size_t _rx_buff_len;
-            size_t _rx_filled;
-            size_t _rx_idx_w;
-            size_t _rx_pos_w;
-            size_t _rx_idx_r;
+            uint32_t _transfers_count;
+            // what plan_buffers() derives, applied with the usb thread stopped
+            struct buffer_plan
+            {
+                size_t rx_buff_len;
+                uint32_t transfers_count;
+                size_t rx_buffs_count;
+                size_t estimator_decimation;
+                double transfer_ms;
+            };
             size_t _rx_pos_r;
-            uint32_t _overruns_count;
+            std::atomic<uint32_t> _overruns_count;
+            // _slot_info mirrors the ring: written before commit_write(), read after read_slot()
+            struct slot_info
+            {
+                uint64_t time_us;       // arrival, now_us()
+                uint64_t sample;        // absolute index of the first sample
+                uint32_t tune_count;    // _tune_count when it arrived
+                uint64_t time_secs;     // rx_time of the first sample
+                double time_frac;
+                double frequency;
+                double samplerate;
+            };
+            std::vector<slot_info> _slot_info;
+            uint32_t _slot_w;
+            uint32_t _slot_r;
+            // stream tags: the usb thread stamps the slots, work() tags a slot that does not
+            // continue the previous one or follows a retune
+            std::atomic<double> _tag_frequency;
+            double _tag_if_offset;          // the usb thread, a change moves the lo and the dc
+            std::atomic<double> _tag_samplerate;
+            std::atomic<uint32_t> _tune_count;
+            bool _time_anchored;
+            uint64_t _time_anchor_secs;
+            double _time_anchor_frac;
+            uint64_t _time_anchor_sample;
+            double _time_anchor_rate;
+            uint64_t _tag_next_sample;
+            uint32_t _tag_tune_count;
+            // hops: the driver events queue up until work() converts the samples they start at
+            uint32_t _hop_seq;
+            std::deque<fobos_rx_hop_event> _hop_events;
+            bool _hop_settle_tagged;        // of the front event
+            // spectrum: the rows fobos_rx_psd() completes wait in _psd_rows until the port takes them
+            int _psd_size;
+            int _psd_port;                  // -1 - no spectrum port
+            bool _iq_output;
+            uint32_t _psd_hop;
+            uint32_t _psd_averages;
+            std::vector<float> _psd_rows;
+            size_t _psd_rows_len;           // floats in _psd_rows
+            size_t _psd_rows_pos;           // floats of them already out
+            std::deque<double> _psd_row_frequency;
+            uint64_t _psd_row_count;
+            // the setters change the driver settings in batches, the usb thread runs them
+            std::mutex _config_lock;
+            std::atomic<bool> _config_changed;
+            // raw recording, the driver records the transfers on its own
+            std::string _record_path;       // empty - not recording
+            uint64_t _record_prealloc;
+            // history: the driver keeps the raw transfers, "trigger" messages snapshot them
+            double _history_s;              // 0 - no history
+            double _snapshot_pre_s;
+            double _snapshot_post_s;
+            std::string _snapshot_path;
+            // replay: an unpaced one waits for the ring instead of dropping, the end of the
+            // recording ends the stream
+            bool _replay;
+            bool _replay_paced;
+            std::atomic<bool> _stopping;
+            // stats
+            double _stats_interval_ms;
+            std::chrono::steady_clock::time_point _stats_next;
+            std::atomic<uint32_t> _ring_high_water;
+            struct fobos_hist _latency_hist;
+            struct fobos_hist _convert_hist;
+            // affinity & priority a streaming thread actually got, -1 / 0 - none
+            struct thread_policy
+            {
+                std::atomic<int> cpu;
+                std::atomic<int> priority;
+            };
+            int _usb_cpu;
+            int _work_cpu;
+            int _rt_priority;
+            bool _busy_poll;
+            thread_policy _usb_policy;
+            thread_policy _work_policy;
+            std::thread::id _work_thread_id;
             struct fobos_dev_t * _dev = NULL;
             static void read_samples_callback(float * buf, uint32_t buf_length, void * ctx);
+            static const size_t conversion_chunk = 8;
+            static const size_t min_transfer_len = 8192;        // 32 KB, smaller bulk transfers cost usb throughput
+            static const size_t max_transfer_len = 1024 * 1024; // 4 MB
+            static const size_t min_transfers_count = 4;
+            static const size_t max_transfers_count = 64;       // FOBOS_MAX_BUF_COUNT
+            static const size_t max_ring_size = 256 * 1024 * 1024;
+            static const size_t estimator_len = min_transfer_len; // samples per estimator snapshot, never more than a transfer
+            static const size_t estimator_rate = 20;            // snapshots per second
             static void thread_proc(fobos_sdr_impl * ctx);
+            static void estimator_proc(fobos_sdr_impl * ctx);
+            void plan_buffers(double samplerate, buffer_plan & plan) const;
+            void apply_buffers(double samplerate, const buffer_plan & plan);
+            void start_stream();
+            void stop_stream();
+            void start_estimator();
+            void stop_estimator();
+            static uint64_t now_us();
+            void stamp_slot(slot_info & info, uint32_t buf_length);
+            void add_stream_tags(uint64_t offset, const slot_info & info);
+            void add_hop_tags(uint64_t sample, size_t samples_count, uint64_t offset, size_t items_count);
+            void add_psd_rows(const int16_t * raw, size_t samples_count, uint64_t sample, double frequency);
+            size_t output_psd_rows(float * out, size_t space, uint64_t offset);
+            int change_config(const std::function<void(fobos_rx_config &)> & change);
+            void set_history(double samplerate);
+            void handle_trigger(const pmt::pmt_t& msg);
+            static void apply_thread_policy(const char * name, int cpu, int priority, thread_policy & applied);
+            pmt::pmt_t collect_stats();
         public:
             fobos_sdr_impl( int index, 
                             double frequency_mhz, 
@@ -55,19 +193,56 @@ namespace gr
                             int lna_gain,
                             int vga_gain,
                             int direct_sampling,
-                            int clock_source);
+                            int clock_source,
+                            int output_type,
+                            double latency_ms,
+                            double headroom_ms,
+                            double stats_interval_ms,
+                            int usb_cpu,
+                            int work_cpu,
+                            int rt_priority,
+                            bool busy_poll,
+                            int decimation,
+                            double if_offset_mhz,
+                            bool auto_if,
+                            int channels,
+                            bool oversample,
+                            int psd_size,
+                            int psd_window,
+                            double psd_overlap,
+                            int psd_averages,
+                            bool iq_output,
+                            const std::string& record_path,
+                            int record_prealloc_mb,
+                            double history_s,
+                            double snapshot_pre_s,
+                            double snapshot_post_s,
+                            const std::string& snapshot_path,
+                            int workers,
+                            const replay_source& replay = replay_source());
             ~fobos_sdr_impl();
 
-            int work(int noutput_items,
-                     gr_vector_const_void_star& input_items,
-                     gr_vector_void_star& output_items);
+            int general_work(int noutput_items,
+                             gr_vector_int& ninput_items,
+                             gr_vector_const_void_star& input_items,
+                             gr_vector_void_star& output_items);
 
             void set_frequency(double frequency_mhz);
             void set_samplerate(double samplerate_mhz);
+            void set_if_offset(double if_offset_mhz);
+            void set_auto_if(bool auto_if);
             void set_lna_gain(int lna_gain);
             void set_vga_gain(int vga_gain);
             void set_direct_sampling(int direct_sampling);
             void set_clock_source(int clock_source);
+            void prepare_frequencies(const std::vector<double>& frequencies_mhz);
+            void set_hops(const std::vector<double>& frequencies_mhz,
+                          const std::vector<int>& dwell_samples,
+                          const std::vector<int>& settle_samples);
+            void set_record_path(const std::string& path);
+
+            pmt::pmt_t get_stats();
+            void reset_stats();
         };
 
     } // namespace RigExpert
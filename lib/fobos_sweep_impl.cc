@@ -0,0 +1,297 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/             
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <string.h>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "fobos_sweep_impl.h"
+#include <fobos/fobos_psd.h>
+#include <gnuradio/io_signature.h>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // the vector length is known only with the device open at the actual rate
+        static uint32_t sweep_bins(int index, double samplerate_mhz, const fobos_sweep_config & config)
+        {
+            uint32_t bins = 0;
+            struct fobos_dev_t * dev = NULL;
+            if ((fobos_rx_get_device_count() > index) && (fobos_rx_open(&dev, index) == 0))
+            {
+                fobos_rx_set_samplerate(dev, samplerate_mhz * 1E6, NULL);
+                if (fobos_rx_get_sweep_bins(dev, &config, &bins) != 0)
+                {
+                    bins = 0;
+                }
+                fobos_rx_close(dev);
+            }
+            if (bins == 0)
+            {
+                // no device or an invalid config, one bin keeps the signature valid
+                bins = 1;
+            }
+            return bins;
+        }
+        //======================================================================
+        static fobos_sweep_config sweep_config(double start_mhz, double stop_mhz, int fft_size, int window, int averages, int settle, double usable)
+        {
+            fobos_sweep_config config;
+            memset(&config, 0, sizeof(config));
+            config.start = start_mhz * 1E6;
+            config.stop = stop_mhz * 1E6;
+            config.fft_size = fft_size;
+            config.window = window;
+            config.averages = averages;
+            config.settle = settle;
+            config.usable = usable;
+            return config;
+        }
+        //======================================================================
+        fobos_sweep::sptr fobos_sweep::make(int index, 
+                                            double start_mhz, 
+                                            double stop_mhz,
+                                            double samplerate_mhz,
+                                            int fft_size,
+                                            int window,
+                                            int averages,
+                                            int settle,
+                                            double usable,
+                                            int lna_gain,
+                                            int vga_gain)
+        {
+            printf("make (%d, %f, %f, %f, %d, %d, %d, %d, %f, %d, %d)\n", index, start_mhz, stop_mhz, samplerate_mhz, fft_size, window, averages, settle, usable, lna_gain, vga_gain);
+            return gnuradio::make_block_sptr<fobos_sweep_impl>(
+                                            index, 
+                                            start_mhz, 
+                                            stop_mhz,
+                                            samplerate_mhz,
+                                            fft_size,
+                                            window,
+                                            averages,
+                                            settle,
+                                            usable,
+                                            lna_gain,
+                                            vga_gain);
+        }
+        //======================================================================
+        // The private constructor
+        fobos_sweep_impl::fobos_sweep_impl( int index, 
+                                            double start_mhz, 
+                                            double stop_mhz,
+                                            double samplerate_mhz,
+                                            int fft_size,
+                                            int window,
+                                            int averages,
+                                            int settle,
+                                            double usable,
+                                            int lna_gain,
+                                            int vga_gain)
+            : gr::sync_block("fobos_sweep",
+                             gr::io_signature::make(0, 0, 0),
+                             gr::io_signature::make(1, 1, sizeof(float) *
+                                 sweep_bins(index, samplerate_mhz, sweep_config(start_mhz, stop_mhz, fft_size, window, averages, settle, usable))))
+        {
+            if ((fft_size < 16) || (fft_size > 65536) || (fft_size & (fft_size - 1)))
+            {
+                throw std::invalid_argument("fobos_sweep: fft_size must be 2^n, 16..65536");
+            }
+            if ((window < 0) || (window >= FOBOS_WINDOW_COUNT))
+            {
+                throw std::invalid_argument("fobos_sweep: window must be 0, 1 or 2");
+            }
+            if ((averages < 1) || (settle < 0))
+            {
+                throw std::invalid_argument("fobos_sweep: averages must be positive, settle must not be negative");
+            }
+            if ((usable <= 0.0) || (usable > 1.0) || (stop_mhz <= start_mhz))
+            {
+                throw std::invalid_argument("fobos_sweep: usable must be 0..1, stop_mhz above start_mhz");
+            }
+            _config = sweep_config(start_mhz, stop_mhz, fft_size, window, averages, settle, usable);
+            _bins = 0;
+            _start_frequency = _config.start;
+            _bin_width = 0.0;
+            _running = false;
+            int count = fobos_rx_get_device_count();
+            printf("fobos_sweep_impl:: found devices: %d\n", count);
+            if (count > 0)
+            {
+                int result = fobos_rx_open(&_dev, index);
+                if (result == 0)
+                {
+                    printf("open...ok\n");
+                    double samplerate = 0.0;
+                    result = fobos_rx_set_samplerate(_dev, samplerate_mhz * 1E6, &samplerate);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_samplerate - error!\n");
+                    }
+                    result = fobos_rx_set_lna_gain(_dev, lna_gain);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_lna_gain - error!\n");
+                    }
+                    result = fobos_rx_set_vga_gain(_dev, vga_gain);
+                    if (result != 0)
+                    {
+                        printf("fobos_rx_set_vga_gain - error!\n");
+                    }
+                    result = fobos_rx_get_sweep_bins(_dev, &_config, &_bins);
+                    if (result == 0)
+                    {
+                        _bin_width = samplerate / fft_size;
+                        start_sweep();
+                    }
+                    else
+                    {
+                        printf("fobos_rx_get_sweep_bins - error! at most 512 steps of samplerate * usable\n");
+                    }
+                }
+                else
+                {
+                    printf("could not open device! err (%i)\n", result);
+                }
+            }
+            else
+            {
+                printf("could not find any fobos_sdr compatible device!\n");
+            }
+        }
+        //======================================================================
+        // virtual destructor
+        fobos_sweep_impl::~fobos_sweep_impl()
+        {
+            if (_dev)
+            {
+                stop_sweep();
+                fobos_rx_close(_dev);
+            }
+        }
+        //======================================================================
+        void fobos_sweep_impl::thread_proc(fobos_sweep_impl * _this)
+        {
+            int result = fobos_rx_sweep(_this->_dev, &_this->_config, read_row_callback, _this, 0);
+            printf("fobos_rx_sweep - %s\n", result == 0 ? "ok!" : "error!");
+            _this->_running = false;
+            _this->_rows_ready.notify_all();
+        }
+        //======================================================================
+        void fobos_sweep_impl::read_row_callback(const float * power_db, uint32_t bins, double start_hz, double bin_hz, uint32_t sweep, void * ctx)
+        {
+            fobos_sweep_impl * _this = static_cast<fobos_sweep_impl*>(ctx);
+            {
+                std::lock_guard<std::mutex> lock(_this->_rows_lock);
+                if (_this->_rows.size() >= max_rows)
+                {
+                    _this->_rows.pop_front();
+                }
+                _this->_rows.push_back(row{sweep, std::vector<float>(power_db, power_db + bins)});
+            }
+            _this->_rows_ready.notify_one();
+        }
+        //======================================================================
+        void fobos_sweep_impl::start_sweep()
+        {
+            if (_bins > 0)
+            {
+                _running = true;
+                _thread = gr::thread::thread(thread_proc, this);
+            }
+        }
+        //======================================================================
+        void fobos_sweep_impl::stop_sweep()
+        {
+            // a cancel issued before the sweep reached the running state is lost, repeat it
+            while (_running)
+            {
+                fobos_rx_cancel_async(_dev);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (_thread.joinable())
+            {
+                _thread.join();
+            }
+        }
+        //======================================================================
+        // Work
+        int fobos_sweep_impl::work(int noutput_items,
+                                   gr_vector_const_void_star& input_items,
+                                   gr_vector_void_star& output_items)
+        {
+            if (!_dev || (_bins == 0))
+            {
+                return WORK_DONE;
+            }
+            float * out = static_cast<float*>(output_items[0]);
+            const pmt::pmt_t srcid = pmt::string_to_symbol(alias());
+            std::unique_lock<std::mutex> lock(_rows_lock);
+            if (_rows.empty())
+            {
+                _rows_ready.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            int produced = 0;
+            while ((produced < noutput_items) && !_rows.empty())
+            {
+                const row & next = _rows.front();
+                memcpy(out + (size_t)produced * _bins, next.power.data(), _bins * sizeof(float));
+                add_item_tag(0, nitems_written(0) + produced, pmt::mp("sweep_row"), pmt::from_uint64(next.index), srcid);
+                _rows.pop_front();
+                produced++;
+            }
+            return produced;
+        }
+        //======================================================================
+        int fobos_sweep_impl::bins() const
+        {
+            return (int)_bins;
+        }
+        //======================================================================
+        double fobos_sweep_impl::start_frequency() const
+        {
+            return _start_frequency;
+        }
+        //======================================================================
+        double fobos_sweep_impl::bin_width() const
+        {
+            return _bin_width;
+        }
+        //======================================================================
+        // the schedule owns the frequency, so a gain change stops the sweep instead of
+        // queueing a batch behind its back, and starts it over
+        void fobos_sweep_impl::set_lna_gain(int lna_gain)
+        {
+            if (!_dev)
+            {
+                return;
+            }
+            stop_sweep();
+            int res = fobos_rx_set_lna_gain(_dev, lna_gain);
+            printf("Setting LNA gain to #%d: %s\n", lna_gain, res == 0 ? "OK" : "ERR");
+            start_sweep();
+        }
+        //======================================================================
+        void fobos_sweep_impl::set_vga_gain(int vga_gain)
+        {
+            if (!_dev)
+            {
+                return;
+            }
+            stop_sweep();
+            int res = fobos_rx_set_vga_gain(_dev, vga_gain);
+            printf("Setting VGA gain to #%d: %s\n", vga_gain, res == 0 ? "OK" : "ERR");
+            start_sweep();
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
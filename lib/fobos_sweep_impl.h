@@ -0,0 +1,84 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/             
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+
+#ifndef INCLUDED_RIGEXPERT_FOBOS_SWEEP_IMPL_H
+#define INCLUDED_RIGEXPERT_FOBOS_SWEEP_IMPL_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <gnuradio/RigExpert/fobos_sweep.h>
+#include <fobos/fobos.h>
+
+namespace gr 
+{
+    namespace RigExpert 
+    {
+        class fobos_sweep_impl : public fobos_sweep
+        {
+        private:
+            struct fobos_dev_t * _dev = NULL;
+            struct fobos_sweep_config _config;
+            uint32_t _bins;
+            double _start_frequency;
+            double _bin_width;
+            std::atomic<bool> _running;
+            gr::thread::thread _thread;
+            // the usb thread queues the rows, work() takes them, the oldest go when nobody does
+            struct row
+            {
+                uint64_t index;
+                std::vector<float> power;
+            };
+            std::mutex _rows_lock;
+            std::condition_variable _rows_ready;
+            std::deque<row> _rows;
+            static const size_t max_rows = 16;
+            static void thread_proc(fobos_sweep_impl * ctx);
+            static void read_row_callback(const float * power_db, uint32_t bins, double start_hz, double bin_hz, uint32_t sweep, void * ctx);
+            void start_sweep();
+            void stop_sweep();
+        public:
+            fobos_sweep_impl(   int index, 
+                                double start_mhz, 
+                                double stop_mhz,
+                                double samplerate_mhz,
+                                int fft_size,
+                                int window,
+                                int averages,
+                                int settle,
+                                double usable,
+                                int lna_gain,
+                                int vga_gain);
+            ~fobos_sweep_impl();
+
+            int work(int noutput_items,
+                     gr_vector_const_void_star& input_items,
+                     gr_vector_void_star& output_items);
+
+            int bins() const;
+            double start_frequency() const;
+            double bin_width() const;
+            void set_lna_gain(int lna_gain);
+            void set_vga_gain(int vga_gain);
+        };
+
+    } // namespace RigExpert
+} // namespace gr
+
+#endif /* INCLUDED_RIGEXPERT_FOBOS_SWEEP_IMPL_H */
+
+//==============================================================================
\ No newline at end of file
@@ -0,0 +1,352 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos_convert.h>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // golden reference: the fixed 2x2 correction plus offset, written out per item
+        static void golden_convert(const int16_t * psample, float * out, size_t complex_samples_count,
+                                   const struct fobos_convert_params & p)
+        {
+            for (size_t i = 0; i < complex_samples_count; i++)
+            {
+                float re = (float)(psample[0] & 0x3FFF);
+                float im = (float)(psample[1] & 0x3FFF);
+                float re_a = re * p.a[0];
+                float im_b = im * p.b[0];
+                out[0] = (re_a + im_b) + p.offset[0];
+                float im_a = im * p.a[1];
+                float re_b = re * p.b[1];
+                out[1] = (im_a + re_b) + p.offset[1];
+                psample += 2;
+                out += 2;
+            }
+        }
+        //======================================================================
+        static struct fobos_convert_params make_params(float scale, int swap_iq)
+        {
+            struct fobos_iq_correction correction;
+            correction.dc_re = 8190.25f;
+            correction.dc_im = 8201.5f;
+            correction.gain = 1.037f;
+            correction.phase = 0.021f;
+            struct fobos_convert_params params;
+            fobos_convert_params_make(&params, &correction, scale, swap_iq);
+            return params;
+        }
+        //======================================================================
+        // raw samples with random flag bits above the 14 bit payload
+        static std::vector<int16_t> make_raw(size_t complex_samples_count)
+        {
+            std::vector<int16_t> raw(complex_samples_count * 2);
+            uint32_t lfsr = 0x12345678u;
+            for (size_t i = 0; i < raw.size(); i++)
+            {
+                lfsr = lfsr * 1664525u + 1013904223u;
+                raw[i] = (int16_t)(lfsr >> 16);
+            }
+            // full scale edges
+            raw[0] = 0x0000;
+            raw[1] = 0x3FFF;
+            raw[2] = (int16_t)0xFFFF;
+            raw[3] = (int16_t)0xC000;
+            return raw;
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_convert_kernels_match_golden)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            BOOST_REQUIRE(count > 0);
+            const size_t lengths[] = { 0, 7, 8, 9, 1000, 65536 + 3 };
+            const float scales[] = { 1.0f / 32768.0f, 1.0f / 32786.0f };
+            for (size_t length : lengths)
+            {
+                std::vector<int16_t> raw = make_raw(length < 8 ? 8 : length);
+                for (float scale : scales)
+                {
+                    for (int swap_iq = 0; swap_iq < 2; swap_iq++)
+                    {
+                        struct fobos_convert_params params = make_params(scale, swap_iq);
+                        std::vector<float> expected(length * 2 + 16, -1.0f);
+                        golden_convert(raw.data(), expected.data(), length, params);
+                        for (unsigned int n = 0; n < count; n++)
+                        {
+                            if (!kernels[n].supported())
+                            {
+                                BOOST_TEST_MESSAGE("skipping unsupported kernel " << kernels[n].name);
+                                continue;
+                            }
+                            std::vector<float> actual(length * 2 + 16, -1.0f);
+                            kernels[n].convert[FOBOS_FORMAT_FC32](&params, raw.data(), actual.data(), length);
+                            BOOST_TEST_INFO("kernel " << kernels[n].name << " length " << length << " swap " << swap_iq);
+                            BOOST_CHECK(memcmp(actual.data(), expected.data(), actual.size() * sizeof(float)) == 0);
+                        }
+                    }
+                }
+            }
+        }
+        //======================================================================
+        // the integer and half formats are checked against the scalar kernels
+        BOOST_AUTO_TEST_CASE(test_fobos_convert_formats_match_scalar)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            const int formats[] = { FOBOS_FORMAT_SC16, FOBOS_FORMAT_SC8, FOBOS_FORMAT_FC16 };
+            const float scales[] = { 1.0f, 1.0f / 64.0f, 1.0f / 32786.0f };
+            const size_t length = 65536 + 5;
+            std::vector<int16_t> raw = make_raw(length);
+            for (size_t f = 0; f < 3; f++)
+            {
+                int format = formats[f];
+                size_t bytes = length * fobos_rx_sample_size(format) + 64;
+                for (int swap_iq = 0; swap_iq < 2; swap_iq++)
+                {
+                    // x4 overdrives the integer formats into saturation
+                    struct fobos_convert_params params = make_params(scales[f] * (format == FOBOS_FORMAT_FC16 ? 1.0f : 4.0f), swap_iq);
+                    std::vector<uint8_t> expected(bytes, 0xA5);
+                    kernels[0].convert[format](&params, raw.data(), expected.data(), length);
+                    for (unsigned int n = 1; n < count; n++)
+                    {
+                        if (!kernels[n].supported())
+                        {
+                            continue;
+                        }
+                        std::vector<uint8_t> actual(bytes, 0xA5);
+                        kernels[n].convert[format](&params, raw.data(), actual.data(), length);
+                        BOOST_TEST_INFO("kernel " << kernels[n].name << " format " << format << " swap " << swap_iq);
+                        BOOST_CHECK(actual == expected);
+                    }
+                }
+            }
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_convert_sums_exact)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            const size_t lengths[] = { 0, 3, 4, 31, 32, 33, 262147 };
+            for (size_t length : lengths)
+            {
+                std::vector<int16_t> raw = make_raw(length < 8 ? 8 : length);
+                // worst case squares in one long run
+                for (size_t i = 4; i < raw.size() / 2; i++)
+                {
+                    raw[i] = (int16_t)0xFFFF;
+                }
+                struct fobos_convert_sums expected = { 0, 0, 0, 0, 0, 0 };
+                for (size_t i = 0; i < length; i++)
+                {
+                    int64_t re = raw[i * 2] & 0x3FFF;
+                    int64_t im = raw[i * 2 + 1] & 0x3FFF;
+                    expected.count++;
+                    expected.sum_re += re;
+                    expected.sum_im += im;
+                    expected.sum2_re += re * re;
+                    expected.sum2_im += im * im;
+                    expected.sum_re_im += re * im;
+                }
+                for (unsigned int n = 0; n < count; n++)
+                {
+                    if (!kernels[n].supported())
+                    {
+                        continue;
+                    }
+                    struct fobos_convert_sums actual = { 0, 0, 0, 0, 0, 0 };
+                    kernels[n].sums(raw.data(), length, &actual);
+                    BOOST_TEST_INFO("kernel " << kernels[n].name << " length " << length);
+                    BOOST_CHECK_EQUAL(actual.count, expected.count);
+                    BOOST_CHECK_EQUAL(actual.sum_re, expected.sum_re);
+                    BOOST_CHECK_EQUAL(actual.sum_im, expected.sum_im);
+                    BOOST_CHECK_EQUAL(actual.sum2_re, expected.sum2_re);
+                    BOOST_CHECK_EQUAL(actual.sum2_im, expected.sum2_im);
+                    BOOST_CHECK_EQUAL(actual.sum_re_im, expected.sum_re_im);
+                }
+            }
+        }
+        //======================================================================
+        // a circular noise signal with known dc, gain and phase errors
+        BOOST_AUTO_TEST_CASE(test_fobos_iq_estimator)
+        {
+            const double dc_re = 8100.0;
+            const double dc_im = 8300.0;
+            const double gain = 1.08;
+            const double phase = 0.05;
+            const size_t length = 1 << 16;
+            std::vector<int16_t> raw(length * 2);
+            uint32_t lfsr = 0x2468ACE1u;
+            auto uniform = [&lfsr]() { lfsr = lfsr * 1664525u + 1013904223u; return (double)(lfsr >> 8) / 16777216.0 - 0.5; };
+            struct fobos_iq_estimator estimator;
+            fobos_iq_estimator_init(&estimator, 0.05);
+            for (int update = 0; update < 8; update++)
+            {
+                for (size_t i = 0; i < length; i++)
+                {
+                    double i_ = 0.0;
+                    double q_ = 0.0;
+                    for (int j = 0; j < 4; j++)
+                    {
+                        i_ += uniform() * 1000.0;
+                        q_ += uniform() * 1000.0;
+                    }
+                    double im = gain * (sin(phase) * i_ + cos(phase) * q_);
+                    raw[i * 2] = (int16_t)lround(dc_re + i_);
+                    raw[i * 2 + 1] = (int16_t)lround(dc_im + im) | (int16_t)0xC000; // flag bits are ignored
+                }
+                struct fobos_convert_sums sums = { 0, 0, 0, 0, 0, 0 };
+                fobos_convert_select()->sums(raw.data(), length, &sums);
+                fobos_iq_estimator_update(&estimator, &sums);
+            }
+            struct fobos_iq_correction correction;
+            BOOST_REQUIRE(fobos_iq_estimator_get(&estimator, &correction) == 0);
+            BOOST_CHECK_CLOSE(correction.dc_re, dc_re, 0.1);
+            BOOST_CHECK_CLOSE(correction.dc_im, dc_im, 0.1);
+            BOOST_CHECK_CLOSE(correction.gain, gain, 0.5);
+            BOOST_CHECK_CLOSE(correction.phase, phase, 5.0);
+            // the corrected pair is orthogonal with equal power
+            struct fobos_convert_params params;
+            fobos_convert_params_make(&params, &correction, 1.0f, 0);
+            std::vector<float> out(length * 2);
+            fobos_convert_kernels(nullptr)[0].convert[FOBOS_FORMAT_FC32](&params, raw.data(), out.data(), length);
+            double p_re = 0.0;
+            double p_im = 0.0;
+            double p_x = 0.0;
+            for (size_t i = 0; i < length; i++)
+            {
+                p_re += out[i * 2] * out[i * 2];
+                p_im += out[i * 2 + 1] * out[i * 2 + 1];
+                p_x += out[i * 2] * out[i * 2 + 1];
+            }
+            BOOST_CHECK_CLOSE(p_im, p_re, 1.0);
+            BOOST_CHECK_SMALL(p_x / p_re, 0.01);
+        }
+        //======================================================================
+        // every kernel rotates bit exactly as the scalar one, in place and to sc16 at 4 per
+        // raw lsb (saturating), odd lengths cover the tails
+        BOOST_AUTO_TEST_CASE(test_fobos_nco_kernels_match)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            const double frequencies[] = { 0.0, 0.1234567, -0.3141592, 0.5 };
+            const size_t length = 4096 + 5;
+            std::vector<int16_t> raw = make_raw(length);
+            struct fobos_convert_params params = make_params(4.0f, 0);
+            std::vector<float> iq(2 * length);
+            kernels[0].convert[FOBOS_FORMAT_FC32](&params, raw.data(), iq.data(), length);
+            for (double frequency : frequencies)
+            {
+                struct fobos_nco nco;
+                fobos_nco_make(&nco, frequency);
+                std::vector<float> expected = iq;
+                kernels[0].nco(&nco, 0x9E3779B9u, expected.data(), nullptr, length);
+                std::vector<int16_t> expected_sc16(2 * length);
+                kernels[0].nco(&nco, 0x9E3779B9u, iq.data(), expected_sc16.data(), length);
+                for (unsigned int n = 1; n < count; n++)
+                {
+                    if (!kernels[n].supported())
+                    {
+                        continue;
+                    }
+                    std::vector<float> actual = iq;
+                    kernels[n].nco(&nco, 0x9E3779B9u, actual.data(), nullptr, length);
+                    std::vector<int16_t> actual_sc16(2 * length);
+                    kernels[n].nco(&nco, 0x9E3779B9u, iq.data(), actual_sc16.data(), length);
+                    BOOST_TEST_INFO("kernel " << kernels[n].name << " frequency " << frequency);
+                    BOOST_CHECK(memcmp(actual.data(), expected.data(), actual.size() * sizeof(float)) == 0);
+                    BOOST_CHECK(actual_sc16 == expected_sc16);
+                }
+            }
+        }
+        //======================================================================
+        // the phase of a long run, fed call by call, stays on the exact uint32 accumulator
+        BOOST_AUTO_TEST_CASE(test_fobos_nco_no_drift)
+        {
+            const struct fobos_convert_kernel * kernel = fobos_convert_select();
+            const double frequency = -0.0123456789;
+            struct fobos_nco nco;
+            fobos_nco_make(&nco, frequency);
+            BOOST_CHECK_EQUAL(nco.step, (uint32_t)(int32_t)std::llround(frequency * 4294967296.0));
+            const size_t chunk = 4096 + 3;
+            const size_t chunks_count = 1024;
+            std::vector<float> iq(2 * chunk);
+            uint32_t phase = 0;
+            double max_error = 0.0;
+            for (size_t c = 0; c < chunks_count; c++)
+            {
+                for (size_t n = 0; n < chunk; n++)
+                {
+                    iq[2 * n] = 1.0f;
+                    iq[2 * n + 1] = 0.0f;
+                }
+                kernel->nco(&nco, phase, iq.data(), nullptr, chunk);
+                for (size_t n = 0; n < chunk; n++)
+                {
+                    uint32_t p = phase + nco.step * (uint32_t)n;
+                    double angle = 2.0 * M_PI * p / 4294967296.0;
+                    max_error = std::max(max_error, std::hypot(iq[2 * n] - cos(angle), iq[2 * n + 1] - sin(angle)));
+                }
+                phase += nco.step * (uint32_t)chunk;
+            }
+            BOOST_CHECK_SMALL(max_error, 1E-6);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_float_to_half)
+        {
+            BOOST_CHECK_EQUAL(fobos_float_to_half(0.0f), 0x0000);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(-0.0f), 0x8000);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(1.0f), 0x3C00);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(-2.0f), 0xC000);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(0.1f), 0x2E66);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(65504.0f), 0x7BFF);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(65520.0f), 0x7C00);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(5.9604645e-08f), 0x0001);
+            BOOST_CHECK_EQUAL(fobos_float_to_half(1.0f + 1.0f / 2048.0f), 0x3C00); // tie to even
+            BOOST_CHECK_EQUAL(fobos_float_to_half(1.0f + 3.0f / 2048.0f), 0x3C02);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_convert_select)
+        {
+            const struct fobos_convert_kernel * kernel = fobos_convert_select();
+            BOOST_REQUIRE(kernel != nullptr);
+            BOOST_CHECK(kernel->supported());
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_hist)
+        {
+            struct fobos_hist hist;
+            memset(&hist, 0, sizeof(hist));
+            const uint64_t values[] = { 0, 1, 2, 3, 4, 1000, 1ull << 40 };
+            for (uint64_t value : values)
+            {
+                fobos_hist_add(&hist, value);
+            }
+            BOOST_CHECK_EQUAL(hist.count, 7u);
+            BOOST_CHECK_EQUAL(hist.max_us, 1ull << 40);
+            BOOST_CHECK_EQUAL(hist.sum_us, 1010 + (1ull << 40));
+            BOOST_CHECK_EQUAL(hist.bins[0], 1u);    // 0
+            BOOST_CHECK_EQUAL(hist.bins[1], 1u);    // 1
+            BOOST_CHECK_EQUAL(hist.bins[2], 2u);    // 2, 3
+            BOOST_CHECK_EQUAL(hist.bins[3], 1u);    // 4
+            BOOST_CHECK_EQUAL(hist.bins[10], 1u);   // 512 .. 1023
+            BOOST_CHECK_EQUAL(hist.bins[FOBOS_HIST_BINS - 1], 1u);
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
@@ -0,0 +1,245 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos_decim.h>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        static const uint32_t decim_factors[] = { 2, 3, 4, 5, 8, 12, 20, 64, 320 };
+        //======================================================================
+        // centered raw units to fc32: 8192 - 0, amplitude 8192 - 1.0
+        static struct fobos_convert_params decim_params()
+        {
+            struct fobos_iq_correction correction;
+            correction.dc_re = 8192.0f;
+            correction.dc_im = 8192.0f;
+            correction.gain = 1.0f;
+            correction.phase = 0.0f;
+            struct fobos_convert_params params;
+            fobos_convert_params_make(&params, &correction, 1.0f / 8192.0f, 0);
+            return params;
+        }
+        //======================================================================
+        // complex tone of f cycles per sample in the usb word layout
+        static std::vector<int16_t> decim_tone(size_t complex_samples_count, double f, double amplitude)
+        {
+            std::vector<int16_t> raw(complex_samples_count * 2);
+            for (size_t n = 0; n < complex_samples_count; n++)
+            {
+                double phase = 2.0 * M_PI * fmod(f * n, 1.0);
+                raw[2 * n] = (int16_t)lrint(8192.0 + amplitude * cos(phase));
+                raw[2 * n + 1] = (int16_t)lrint(8192.0 + amplitude * sin(phase));
+            }
+            return raw;
+        }
+        //======================================================================
+        static double tone_power(const std::vector<std::complex<float>> & x, size_t first, double f)
+        {
+            std::complex<double> acc = 0.0;
+            for (size_t n = first; n < x.size(); n++)
+            {
+                acc += std::complex<double>(x[n]) * std::polar(1.0, -2.0 * M_PI * fmod(f * n, 1.0));
+            }
+            return std::norm(acc / (double)(x.size() - first));
+        }
+        //======================================================================
+        // a tone at f input cycles per sample through the chain, the output power at its alias
+        static double decim_response(uint32_t decimation, double f)
+        {
+            const size_t out_count = 2048;
+            const size_t settle = 128;
+            struct fobos_decim * decim = fobos_decim_create(decimation, fobos_convert_select());
+            BOOST_REQUIRE(decim != nullptr);
+            std::vector<int16_t> raw = decim_tone(out_count * decimation, f, 4096.0);
+            struct fobos_convert_params params = decim_params();
+            std::vector<std::complex<float>> out(out_count);
+            BOOST_REQUIRE_EQUAL(fobos_decim_run(decim, &params, raw.data(), out_count * decimation, out.data(), FOBOS_FORMAT_FC32), out_count);
+            fobos_decim_destroy(decim);
+            return tone_power(out, settle, f * decimation);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_decim_supported)
+        {
+            const uint32_t supported[] = { 1, 2, 3, 4, 5, 6, 10, 48, 64, 96, 160, 192, 320 };
+            const uint32_t unsupported[] = { 0, 7, 9, 15, 25, 128, 384, 640 };
+            for (uint32_t decimation : supported)
+            {
+                BOOST_CHECK_MESSAGE(fobos_decim_supported(decimation), decimation);
+            }
+            for (uint32_t decimation : unsupported)
+            {
+                BOOST_CHECK_MESSAGE(!fobos_decim_supported(decimation), decimation);
+                BOOST_CHECK(fobos_decim_create(decimation, fobos_convert_select()) == nullptr);
+            }
+            // 1 is no filtering, nothing to create
+            BOOST_CHECK(fobos_decim_create(1, fobos_convert_select()) == nullptr);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_decim_design)
+        {
+            struct fobos_fir fir;
+            // too steep for FOBOS_FIR_MAX_TAPS
+            BOOST_CHECK_EQUAL(fobos_decim_design(&fir, 2, 0.2, 0.21), -1);
+            BOOST_CHECK_EQUAL(fobos_decim_design(&fir, 2, 0.3, 0.2), -1);
+            BOOST_CHECK_EQUAL(fobos_decim_design(&fir, FOBOS_FIR_MAX_DECIMATION + 1, 0.02, 0.1), -1);
+            // the stages next to the output, where the transition is narrowest
+            const uint32_t decimations[] = { 2, 3, 5 };
+            for (uint32_t decimation : decimations)
+            {
+                double pass = FOBOS_DECIM_PASS / decimation;
+                BOOST_REQUIRE_EQUAL(fobos_decim_design(&fir, decimation, pass, 1.0 / decimation - pass), 0);
+                BOOST_CHECK(fir.taps_count % 2 == 1);
+                std::vector<int32_t> taps(fir.taps_count, 0);
+                for (uint32_t p = 0; p < fir.pairs_count; p++)
+                {
+                    for (int k = 0; k < 2; k++)
+                    {
+                        taps[fir.pairs[p].offset[k] * decimation + fir.pairs[p].phase[k]] += fir.pairs[p].coeff[k];
+                    }
+                }
+                int32_t sum = 0;
+                for (uint32_t t = 0; t < fir.taps_count; t++)
+                {
+                    sum += taps[t];
+                    BOOST_CHECK_EQUAL(taps[t], taps[fir.taps_count - 1 - t]);
+                }
+                // unity dc gain in Q15
+                BOOST_CHECK_EQUAL(sum, 32768);
+                BOOST_CHECK(fobos_decim_attenuation(&fir, 1.0 / decimation - pass) >= FOBOS_DECIM_STOP_DB);
+            }
+            // every other tap of a halfband is zero and skipped
+            BOOST_REQUIRE_EQUAL(fobos_decim_design(&fir, 2, 0.1, 0.4), 0);
+            BOOST_CHECK(fir.pairs_count <= (fir.taps_count + 1) / 4 + 1);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_decim_passband)
+        {
+            for (uint32_t decimation : decim_factors)
+            {
+                const double input = (4096.0 / 8192.0) * (4096.0 / 8192.0);
+                // up to the pass band edge, both signs
+                const double frequencies[] = { 0.0, 0.1, -0.25, 0.39 };
+                for (double f : frequencies)
+                {
+                    double gain_db = 10.0 * log10(decim_response(decimation, f / decimation) / input);
+                    BOOST_TEST_INFO("decimation " << decimation << " f " << f);
+                    BOOST_CHECK(fabs(gain_db) < 0.05);
+                }
+            }
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_decim_alias_rejection)
+        {
+            for (uint32_t decimation : decim_factors)
+            {
+                const double input = (4096.0 / 8192.0) * (4096.0 / 8192.0);
+                // the first images and the ones closest to the input nyquist, off any
+                // ratio of small integers: the rounding error of the 14 bit test tone
+                // spreads as noise instead of piling up in spurs
+                const uint32_t images[] = { 1, decimation / 2, decimation - 1 };
+                const double offsets[] = { -0.38917, 0.00173, 0.25311, 0.38873 };
+                for (uint32_t k : images)
+                {
+                    for (double offset : offsets)
+                    {
+                        double f = (k + offset) / decimation;
+                        double rejection_db = -10.0 * log10(decim_response(decimation, f) / input + 1E-30);
+                        BOOST_TEST_INFO("decimation " << decimation << " image " << k << " offset " << offset);
+                        BOOST_CHECK(rejection_db >= FOBOS_DECIM_STOP_DB);
+                    }
+                }
+            }
+        }
+        //======================================================================
+        // pieces of any length give the stream a single call gives, reset restarts it
+        BOOST_AUTO_TEST_CASE(test_fobos_decim_chunked)
+        {
+            const size_t length = 100000;
+            std::vector<int16_t> raw = decim_tone(length, 0.013, 7000.0);
+            uint32_t lfsr = 0x2468ACE1u;
+            for (size_t i = 0; i < raw.size(); i++)
+            {
+                // flag bits above the payload and some noise
+                lfsr = lfsr * 1664525u + 1013904223u;
+                raw[i] = (int16_t)((raw[i] + (int16_t)((lfsr >> 16) & 0xFF) - 128) | (lfsr & 0xC000));
+            }
+            struct fobos_convert_params params = decim_params();
+            for (uint32_t decimation : decim_factors)
+            {
+                struct fobos_decim * decim = fobos_decim_create(decimation, fobos_convert_select());
+                BOOST_REQUIRE(decim != nullptr);
+                std::vector<std::complex<float>> whole(length / decimation + 1);
+                size_t whole_count = fobos_decim_run(decim, &params, raw.data(), length, whole.data(), FOBOS_FORMAT_FC32);
+                // the first output falls on the first input sample
+                BOOST_CHECK_EQUAL(whole_count, (length + decimation - 1) / decimation);
+                fobos_decim_reset(decim);
+                std::vector<std::complex<float>> pieces(length / decimation + 1);
+                size_t pieces_count = 0;
+                size_t pos = 0;
+                while (pos < length)
+                {
+                    lfsr = lfsr * 1664525u + 1013904223u;
+                    size_t n = std::min<size_t>((lfsr >> 16) % 9000 + 1, length - pos);
+                    pieces_count += fobos_decim_run(decim, &params, raw.data() + 2 * pos, n, pieces.data() + pieces_count, FOBOS_FORMAT_FC32);
+                    pos += n;
+                }
+                BOOST_TEST_INFO("decimation " << decimation);
+                BOOST_REQUIRE_EQUAL(pieces_count, whole_count);
+                BOOST_CHECK(memcmp(pieces.data(), whole.data(), whole_count * sizeof(std::complex<float>)) == 0);
+                fobos_decim_destroy(decim);
+            }
+        }
+        //======================================================================
+        // every kernel table row filters to the same samples
+        BOOST_AUTO_TEST_CASE(test_fobos_decim_kernels_match)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            const size_t length = 50000;
+            // full scale square wave: the overshoot saturates the int16 stages
+            std::vector<int16_t> raw(length * 2);
+            for (size_t i = 0; i < raw.size(); i++)
+            {
+                raw[i] = ((i / 2) % 37 < 18) ? 0x0000 : 0x3FFF;
+            }
+            struct fobos_convert_params params = decim_params();
+            for (uint32_t decimation : decim_factors)
+            {
+                std::vector<int16_t> expected(length * 2, 0);
+                struct fobos_decim * decim = fobos_decim_create(decimation, &kernels[0]);
+                size_t expected_count = fobos_decim_run(decim, &params, raw.data(), length, expected.data(), FOBOS_FORMAT_SC16);
+                fobos_decim_destroy(decim);
+                for (unsigned int n = 1; n < count; n++)
+                {
+                    if (!kernels[n].supported())
+                    {
+                        continue;
+                    }
+                    std::vector<int16_t> actual(length * 2, 0);
+                    decim = fobos_decim_create(decimation, &kernels[n]);
+                    BOOST_CHECK_EQUAL(fobos_decim_run(decim, &params, raw.data(), length, actual.data(), FOBOS_FORMAT_SC16), expected_count);
+                    fobos_decim_destroy(decim);
+                    BOOST_TEST_INFO("kernel " << kernels[n].name << " decimation " << decimation);
+                    BOOST_CHECK(actual == expected);
+                }
+            }
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
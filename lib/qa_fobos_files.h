@@ -0,0 +1,42 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+
+#ifndef INCLUDED_RIGEXPERT_QA_FOBOS_FILES_H
+#define INCLUDED_RIGEXPERT_QA_FOBOS_FILES_H
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // the files the recording, replay and history tests write and read back
+        static inline std::string qa_temp_path(const char * name)
+        {
+            return (std::filesystem::temp_directory_path() / name).string();
+        }
+        //======================================================================
+        // the whole file, empty if it does not exist
+        static inline std::string qa_read_file(const std::string & path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        //======================================================================
+    } // namespace RigExpert
+} // namespace gr
+
+#endif /* INCLUDED_RIGEXPERT_QA_FOBOS_FILES_H */
@@ -0,0 +1,192 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos.h>
+#include "qa_fobos_files.h"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        static const uint32_t transfer_samples = 16384;
+        //======================================================================
+        // every buffer of FOBOS_FORMAT_RAW as it came, snapshots triggered from the callback
+        struct history_capture
+        {
+            fobos_dev_t * dev = nullptr;
+            uint32_t buffers = 0;
+            uint32_t stop_after = 0;
+            uint64_t first = 0;             // stream index of raw[0]
+            std::vector<uint8_t> raw;
+            // trigger_at: the buffer the snapshot is triggered in, at its first sample + offset
+            uint32_t trigger_at = 0;
+            uint64_t offset = 0;
+            uint64_t pre = 0;
+            uint64_t post = 0;
+            std::string path;
+            int triggered = 1;
+            int again = 0;                  // a second trigger right after the first
+            int set_history = 0;            // fobos_rx_set_history() while streaming
+
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                history_capture * capture = static_cast<history_capture*>(ctx);
+                uint64_t sample = 0;
+                fobos_rx_get_sample_index(capture->dev, &sample);
+                if (capture->buffers == 0)
+                {
+                    capture->first = sample;
+                }
+                const uint8_t * bytes = reinterpret_cast<const uint8_t*>(buf);
+                capture->raw.insert(capture->raw.end(), bytes, bytes + buf_length * 4);
+                if (++capture->buffers == capture->trigger_at)
+                {
+                    capture->triggered = fobos_rx_trigger_snapshot(capture->dev, capture->path.c_str(), sample + capture->offset, capture->pre, capture->post);
+                    capture->again = fobos_rx_trigger_snapshot(capture->dev, capture->path.c_str(), sample, 0, 1);
+                    capture->set_history = fobos_rx_set_history(capture->dev, 0);
+                }
+                if (capture->buffers == capture->stop_after)
+                {
+                    fobos_rx_cancel_async(capture->dev);
+                }
+            }
+        };
+        //======================================================================
+        static fobos_rx_snapshot wait_snapshot(fobos_dev_t * dev)
+        {
+            fobos_rx_snapshot status;
+            for (int i = 0; i < 10000; i++)
+            {
+                BOOST_REQUIRE(fobos_rx_get_snapshot(dev, &status) == 0);
+                if (!status.active)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return status;
+        }
+        //======================================================================
+        static fobos_dev_t * open_sim()
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            BOOST_REQUIRE(fobos_sim_enable(&config) == 0);
+            fobos_dev_t * dev = nullptr;
+            BOOST_REQUIRE(fobos_rx_open(&dev, 0) == 0);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW) == 0);
+            return dev;
+        }
+        //======================================================================
+        // a window around a sample of the stream: the samples before the trigger come from the
+        // history, those after it as they arrive, the file holds exactly what the stream had
+        BOOST_AUTO_TEST_CASE(test_fobos_history_snapshot)
+        {
+            fobos_dev_t * dev = open_sim();
+            std::string path = qa_temp_path("qa_fobos_history");
+            fobos_rx_snapshot status;
+            BOOST_CHECK_EQUAL(fobos_rx_trigger_snapshot(dev, path.c_str(), FOBOS_SNAPSHOT_NOW, 1, 1), -7);
+            BOOST_REQUIRE(fobos_rx_get_snapshot(dev, &status) == 0);
+            BOOST_CHECK_EQUAL(status.snapshots, 0u);
+            BOOST_REQUIRE(fobos_rx_set_history(dev, 64 * transfer_samples * 4) == 0);
+            // nothing held yet
+            BOOST_CHECK_EQUAL(fobos_rx_trigger_snapshot(dev, path.c_str(), FOBOS_SNAPSHOT_NOW, 1, 1), -7);
+            history_capture live;
+            live.dev = dev;
+            live.stop_after = 80;
+            live.trigger_at = 40;
+            live.offset = 1000;
+            live.pre = 20 * transfer_samples + 5;
+            live.post = 10 * transfer_samples + 7;
+            live.path = path;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, history_capture::callback, &live, 4, transfer_samples) == 0);
+            BOOST_CHECK_EQUAL(live.triggered, 0);
+            BOOST_CHECK_EQUAL(live.again, -5);
+            BOOST_CHECK_EQUAL(live.set_history, -5);
+            status = wait_snapshot(dev);
+            BOOST_REQUIRE_EQUAL(status.active, 0);
+            BOOST_CHECK_EQUAL(status.error, 0);
+            BOOST_CHECK_EQUAL(status.gaps, 0u);
+            BOOST_CHECK_EQUAL(status.snapshots, 1u);
+            uint64_t trigger = live.first + 39 * transfer_samples + live.offset;
+            BOOST_CHECK_EQUAL(status.start, trigger - live.pre);
+            BOOST_CHECK_EQUAL(status.end, trigger + live.post);
+            BOOST_CHECK_EQUAL(status.samples, live.pre + live.post);
+            BOOST_CHECK_EQUAL(status.history_end, live.first + live.buffers * transfer_samples);
+            BOOST_CHECK(status.history_end - status.history_start <= 64 * transfer_samples);
+            std::string data = qa_read_file(path + ".sigmf-data");
+            BOOST_REQUIRE_EQUAL(data.size(), status.samples * 4);
+            BOOST_CHECK(std::memcmp(live.raw.data() + (status.start - live.first) * 4, data.data(), data.size()) == 0);
+            std::string meta = qa_read_file(path + ".sigmf-meta");
+            BOOST_CHECK(meta.find("\"core:global_index\": " + std::to_string(status.start)) != std::string::npos);
+
+            // after the stream: the newest samples, the window end never comes
+            BOOST_REQUIRE(fobos_rx_trigger_snapshot(dev, path.c_str(), FOBOS_SNAPSHOT_NOW, 8 * transfer_samples, transfer_samples) == 0);
+            status = wait_snapshot(dev);
+            BOOST_REQUIRE_EQUAL(status.active, 0);
+            BOOST_CHECK_EQUAL(status.error, 0);
+            BOOST_CHECK_EQUAL(status.snapshots, 2u);
+            BOOST_CHECK_EQUAL(status.samples, 8u * transfer_samples);
+            data = qa_read_file(path + ".sigmf-data");
+            BOOST_REQUIRE_EQUAL(data.size(), 8u * transfer_samples * 4);
+            BOOST_CHECK(std::memcmp(live.raw.data() + live.raw.size() - data.size(), data.data(), data.size()) == 0);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            fobos_sim_enable(nullptr);
+            std::remove((path + ".sigmf-data").c_str());
+            std::remove((path + ".sigmf-meta").c_str());
+        }
+        //======================================================================
+        // a window reaching further back than the history: cut to what it still holds
+        BOOST_AUTO_TEST_CASE(test_fobos_history_cut)
+        {
+            fobos_dev_t * dev = open_sim();
+            std::string path = qa_temp_path("qa_fobos_history_cut");
+            BOOST_REQUIRE(fobos_rx_set_history(dev, 16 * transfer_samples * 4) == 0);
+            history_capture live;
+            live.dev = dev;
+            live.stop_after = 40;
+            live.trigger_at = 30;
+            live.pre = 25 * transfer_samples;
+            live.post = 2 * transfer_samples;
+            live.path = path;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, history_capture::callback, &live, 4, transfer_samples) == 0);
+            BOOST_REQUIRE_EQUAL(live.triggered, 0);
+            fobos_rx_snapshot status = wait_snapshot(dev);
+            BOOST_REQUIRE_EQUAL(status.active, 0);
+            BOOST_CHECK_EQUAL(status.error, 0);
+            uint64_t trigger = live.first + 29 * transfer_samples;
+            BOOST_CHECK(status.start > trigger - live.pre);
+            BOOST_CHECK_EQUAL((status.start - live.first) % transfer_samples, 0u);
+            BOOST_CHECK_EQUAL(status.end, trigger + live.post);
+            BOOST_CHECK_EQUAL(status.samples, status.end - status.start);
+            BOOST_CHECK(status.samples <= 16u * transfer_samples);
+            std::string data = qa_read_file(path + ".sigmf-data");
+            BOOST_REQUIRE_EQUAL(data.size(), status.samples * 4);
+            BOOST_CHECK(std::memcmp(live.raw.data() + (status.start - live.first) * 4, data.data(), data.size()) == 0);
+            // off again
+            BOOST_REQUIRE(fobos_rx_set_history(dev, 0) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_trigger_snapshot(dev, path.c_str(), FOBOS_SNAPSHOT_NOW, 1, 1), -7);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            fobos_sim_enable(nullptr);
+            std::remove((path + ".sigmf-data").c_str());
+            std::remove((path + ".sigmf-meta").c_str());
+        }
+    } /* namespace RigExpert */
+} /* namespace gr */
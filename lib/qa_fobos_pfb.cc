@@ -0,0 +1,206 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos_pfb.h>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        typedef std::vector<std::complex<float>> pfb_channel;
+        //======================================================================
+        // complex tone of f cycles per sample
+        static pfb_channel pfb_tone(size_t complex_samples_count, double f, double amplitude)
+        {
+            pfb_channel x(complex_samples_count);
+            for (size_t n = 0; n < complex_samples_count; n++)
+            {
+                x[n] = std::polar(amplitude, 2.0 * M_PI * fmod(f * n, 1.0));
+            }
+            return x;
+        }
+        //======================================================================
+        // all of x through the channelizer, one vector per channel
+        static std::vector<pfb_channel> pfb_split(struct fobos_pfb * pfb, uint32_t channels, const pfb_channel & x)
+        {
+            size_t count = x.size() / fobos_pfb_decimation(pfb) + 1;
+            std::vector<pfb_channel> out(channels, pfb_channel(count));
+            std::vector<void *> dst(channels);
+            for (uint32_t k = 0; k < channels; k++)
+            {
+                dst[k] = out[k].data();
+            }
+            count = fobos_pfb_run(pfb, reinterpret_cast<const float *>(x.data()), x.size(), dst.data(), 0, 1, FOBOS_FORMAT_FC32);
+            for (uint32_t k = 0; k < channels; k++)
+            {
+                out[k].resize(count);
+            }
+            return out;
+        }
+        //======================================================================
+        static double pfb_power(const pfb_channel & x, size_t first)
+        {
+            double sum = 0.0;
+            for (size_t n = first; n < x.size(); n++)
+            {
+                sum += std::norm(std::complex<double>(x[n]));
+            }
+            return sum / (double)(x.size() - first);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_pfb_supported)
+        {
+            const uint32_t supported[] = { 2, 4, 16, 256, 1024 };
+            const uint32_t unsupported[] = { 0, 1, 3, 12, 100, 2048 };
+            for (uint32_t channels : supported)
+            {
+                BOOST_CHECK(fobos_pfb_supported(channels));
+            }
+            for (uint32_t channels : unsupported)
+            {
+                BOOST_CHECK(!fobos_pfb_supported(channels));
+                BOOST_CHECK(fobos_pfb_create(channels, 0, fobos_convert_select()) == nullptr);
+            }
+            struct fobos_pfb * pfb = fobos_pfb_create(64, 0, fobos_convert_select());
+            BOOST_REQUIRE(pfb != nullptr);
+            BOOST_CHECK_EQUAL(fobos_pfb_decimation(pfb), 64u);
+            fobos_pfb_destroy(pfb);
+            pfb = fobos_pfb_create(64, 1, fobos_convert_select());
+            BOOST_REQUIRE(pfb != nullptr);
+            BOOST_CHECK_EQUAL(fobos_pfb_decimation(pfb), 32u);
+            fobos_pfb_destroy(pfb);
+        }
+        //======================================================================
+        // a tone 0.2 channel widths above the center of channel k: unity gain there, the right
+        // frequency at the channel rate, the other channels in the stop band
+        BOOST_AUTO_TEST_CASE(test_fobos_pfb_channels)
+        {
+            const uint32_t channels = 16;
+            const size_t settle = 2 * FOBOS_PFB_TAPS;
+            const int tone_channels[] = { 0, 5, 12 };
+            for (int oversample = 0; oversample < 2; oversample++)
+            {
+                for (int k : tone_channels)
+                {
+                    BOOST_TEST_INFO("oversample " << oversample << " channel " << k);
+                    double center = (k < (int)channels / 2 ? k : k - (int)channels) / (double)channels;
+                    double f = center + 0.2 / channels;
+                    struct fobos_pfb * pfb = fobos_pfb_create(channels, oversample, fobos_convert_select());
+                    BOOST_REQUIRE(pfb != nullptr);
+                    uint32_t decimation = fobos_pfb_decimation(pfb);
+                    std::vector<pfb_channel> out = pfb_split(pfb, channels, pfb_tone(1024 * channels, f, 0.5));
+                    fobos_pfb_destroy(pfb);
+                    BOOST_REQUIRE_EQUAL(out[k].size(), 1024u * channels / decimation);
+                    double power = pfb_power(out[k], settle);
+                    BOOST_CHECK_CLOSE(power, 0.25, 1.0);
+                    // the phase step of the tone at the channel rate
+                    const pfb_channel & y = out[k];
+                    double step = std::arg(std::complex<double>(y[y.size() - 1]) * std::conj(std::complex<double>(y[y.size() - 2])));
+                    BOOST_CHECK_SMALL(step - 2.0 * M_PI * 0.2 * decimation / channels, 1E-4);
+                    for (uint32_t j = 0; j < channels; j++)
+                    {
+                        if ((int)j != k)
+                        {
+                            BOOST_TEST_INFO("other channel " << j);
+                            BOOST_CHECK(pfb_power(out[j], settle) < power * 1E-6);
+                        }
+                    }
+                }
+            }
+        }
+        //======================================================================
+        // pieces of any length, interleaved or not, give the same samples as the whole input
+        BOOST_AUTO_TEST_CASE(test_fobos_pfb_chunked)
+        {
+            const uint32_t channels = 8;
+            const size_t length = 60000;
+            pfb_channel x = pfb_tone(length, 0.013, 0.7);
+            uint32_t lfsr = 0x2468ACE1u;
+            for (size_t n = 0; n < length; n++)
+            {
+                lfsr = lfsr * 1664525u + 1013904223u;
+                x[n] += std::complex<float>((float)((lfsr >> 16) & 0xFF) / 1024.0f, (float)((lfsr >> 8) & 0xFF) / 1024.0f);
+            }
+            for (int oversample = 0; oversample < 2; oversample++)
+            {
+                struct fobos_pfb * pfb = fobos_pfb_create(channels, oversample, fobos_convert_select());
+                BOOST_REQUIRE(pfb != nullptr);
+                uint32_t decimation = fobos_pfb_decimation(pfb);
+                std::vector<pfb_channel> whole = pfb_split(pfb, channels, x);
+                // the first output falls on the first input sample
+                BOOST_CHECK_EQUAL(whole[0].size(), (length + decimation - 1) / decimation);
+                fobos_pfb_reset(pfb);
+                pfb_channel interleaved((length / decimation + 1) * channels);
+                std::vector<void *> dst(channels);
+                for (uint32_t k = 0; k < channels; k++)
+                {
+                    dst[k] = interleaved.data() + k;
+                }
+                size_t count = 0;
+                size_t pos = 0;
+                while (pos < length)
+                {
+                    lfsr = lfsr * 1664525u + 1013904223u;
+                    size_t n = std::min<size_t>((lfsr >> 16) % 9000 + 1, length - pos);
+                    count += fobos_pfb_run(pfb, reinterpret_cast<const float *>(x.data() + pos), n, dst.data(), count, channels, FOBOS_FORMAT_FC32);
+                    pos += n;
+                }
+                fobos_pfb_destroy(pfb);
+                BOOST_TEST_INFO("oversample " << oversample);
+                BOOST_REQUIRE_EQUAL(count, whole[0].size());
+                for (uint32_t k = 0; k < channels; k++)
+                {
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        BOOST_REQUIRE(memcmp(&interleaved[i * channels + k], &whole[k][i], sizeof(std::complex<float>)) == 0);
+                    }
+                }
+            }
+        }
+        //======================================================================
+        // every kernel table row sums to the same samples
+        BOOST_AUTO_TEST_CASE(test_fobos_pfb_kernels_match)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            pfb_channel x = pfb_tone(20000, 0.31, 0.9);
+            const uint32_t channels_list[] = { 2, 4, 32 };
+            for (uint32_t channels : channels_list)
+            {
+                struct fobos_pfb * pfb = fobos_pfb_create(channels, 1, &kernels[0]);
+                std::vector<pfb_channel> expected = pfb_split(pfb, channels, x);
+                fobos_pfb_destroy(pfb);
+                for (unsigned int n = 1; n < count; n++)
+                {
+                    if (!kernels[n].supported())
+                    {
+                        continue;
+                    }
+                    pfb = fobos_pfb_create(channels, 1, &kernels[n]);
+                    std::vector<pfb_channel> actual = pfb_split(pfb, channels, x);
+                    fobos_pfb_destroy(pfb);
+                    BOOST_TEST_INFO("kernel " << kernels[n].name << " channels " << channels);
+                    for (uint32_t k = 0; k < channels; k++)
+                    {
+                        BOOST_CHECK(memcmp(actual[k].data(), expected[k].data(), expected[k].size() * sizeof(std::complex<float>)) == 0);
+                    }
+                }
+            }
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
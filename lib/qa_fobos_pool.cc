@@ -0,0 +1,120 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos_pool.h>
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        struct pool_job
+        {
+            uint32_t seq;
+            uint32_t sleep_us;
+        };
+        struct pool_ctx
+        {
+            std::atomic<int> running{ 0 };
+            std::atomic<int> max_running{ 0 };
+            std::atomic<int> releasing{ 0 };
+            std::vector<uint32_t> released;
+            uint32_t overlaps = 0;
+        };
+        //======================================================================
+        static void pool_work(void * ctx, void * data)
+        {
+            pool_ctx * c = static_cast<pool_ctx*>(ctx);
+            pool_job * job = static_cast<pool_job*>(data);
+            int running = ++c->running;
+            int max_running = c->max_running;
+            while ((running > max_running) && !c->max_running.compare_exchange_weak(max_running, running))
+            {
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(job->sleep_us));
+            c->running--;
+        }
+        //======================================================================
+        static void pool_release(void * ctx, void * data)
+        {
+            pool_ctx * c = static_cast<pool_ctx*>(ctx);
+            pool_job * job = static_cast<pool_job*>(data);
+            if (c->releasing++ != 0)
+            {
+                c->overlaps++;
+            }
+            c->released.push_back(job->seq);
+            c->releasing--;
+        }
+        //======================================================================
+        // jobs of random length finish out of order, they are released in order
+        BOOST_AUTO_TEST_CASE(test_fobos_pool_order)
+        {
+            pool_ctx ctx;
+            fobos_pool * pool = fobos_pool_create(4, 8, sizeof(pool_job), pool_work, pool_release, &ctx);
+            BOOST_REQUIRE(pool != nullptr);
+            BOOST_CHECK_EQUAL(fobos_pool_jobs_count(pool), 8u);
+            uint32_t state = 1;
+            const uint32_t total = 2000;
+            for (uint32_t seq = 0; seq < total; )
+            {
+                pool_job * job = static_cast<pool_job*>(fobos_pool_acquire(pool));
+                if (!job)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                state = state * 1103515245u + 12345u;
+                job->seq = seq++;
+                job->sleep_us = (state >> 16) % 200;
+                fobos_pool_commit(pool);
+            }
+            fobos_pool_drain(pool);
+            BOOST_REQUIRE_EQUAL(ctx.released.size(), total);
+            for (uint32_t seq = 0; seq < total; seq++)
+            {
+                BOOST_REQUIRE_EQUAL(ctx.released[seq], seq);
+            }
+            BOOST_CHECK_EQUAL(ctx.overlaps, 0u);
+            BOOST_CHECK(ctx.max_running > 1);
+            BOOST_CHECK(ctx.max_running <= 4);
+            fobos_pool_destroy(pool);
+        }
+        //======================================================================
+        // a full pool refuses new jobs until the oldest one is released
+        BOOST_AUTO_TEST_CASE(test_fobos_pool_full)
+        {
+            pool_ctx ctx;
+            fobos_pool * pool = fobos_pool_create(2, 4, sizeof(pool_job), pool_work, pool_release, &ctx);
+            BOOST_REQUIRE(pool != nullptr);
+            for (uint32_t seq = 0; seq < 4; seq++)
+            {
+                pool_job * job = static_cast<pool_job*>(fobos_pool_acquire(pool));
+                BOOST_REQUIRE(job != nullptr);
+                job->seq = seq;
+                job->sleep_us = 20000;
+                fobos_pool_commit(pool);
+            }
+            BOOST_CHECK(fobos_pool_acquire(pool) == nullptr);
+            fobos_pool_drain(pool);
+            BOOST_CHECK_EQUAL(ctx.released.size(), 4u);
+            BOOST_CHECK(fobos_pool_acquire(pool) != nullptr);
+            BOOST_CHECK(fobos_pool_create(0, 4, sizeof(pool_job), pool_work, pool_release, &ctx) == nullptr);
+            fobos_pool_destroy(pool);
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
@@ -0,0 +1,189 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos_fft.h>
+#include <fobos/fobos_psd.h>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        typedef std::vector<std::complex<float>> psd_block;
+        //======================================================================
+        // complex tone of f cycles per sample
+        static psd_block psd_tone(size_t complex_samples_count, double f, double amplitude)
+        {
+            psd_block x(complex_samples_count);
+            for (size_t n = 0; n < complex_samples_count; n++)
+            {
+                x[n] = std::polar(amplitude, 2.0 * M_PI * fmod(f * n, 1.0));
+            }
+            return x;
+        }
+        //======================================================================
+        // random samples in -0.5 .. 0.5
+        static psd_block psd_noise(size_t complex_samples_count, uint32_t seed)
+        {
+            psd_block x(complex_samples_count);
+            for (size_t n = 0; n < complex_samples_count; n++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                x[n] = std::complex<float>((float)((seed >> 16) & 0xFF) / 256.0f - 0.5f, (float)((seed >> 8) & 0xFF) / 256.0f - 0.5f);
+            }
+            return x;
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_fft_matches_dft)
+        {
+            const struct fobos_convert_kernel * kernel = fobos_convert_select();
+            const uint32_t unsupported[] = { 0, 1, 3, 100, 131072 };
+            for (uint32_t size : unsupported)
+            {
+                BOOST_CHECK(fobos_fft_create(size, kernel) == nullptr);
+            }
+            BOOST_CHECK(fobos_fft_create(64, nullptr) == nullptr);
+            const uint32_t sizes[] = { 2, 8, 64, 512 };
+            for (uint32_t size : sizes)
+            {
+                struct fobos_fft * fft = fobos_fft_create(size, kernel);
+                BOOST_REQUIRE(fft != nullptr);
+                BOOST_CHECK_EQUAL(fobos_fft_size(fft), size);
+                psd_block x = psd_noise(size, size);
+                psd_block y(size);
+                fobos_fft_run(fft, reinterpret_cast<const float *>(x.data()), reinterpret_cast<float *>(y.data()));
+                fobos_fft_destroy(fft);
+                for (uint32_t k = 0; k < size; k++)
+                {
+                    std::complex<double> sum = 0.0;
+                    for (uint32_t n = 0; n < size; n++)
+                    {
+                        sum += std::complex<double>(x[n]) * std::polar(1.0, -2.0 * M_PI * (double)((uint64_t)k * n % size) / size);
+                    }
+                    BOOST_TEST_INFO("size " << size << " bin " << k);
+                    BOOST_CHECK_SMALL(std::abs(std::complex<double>(y[k]) - sum), 1E-4 * size);
+                }
+            }
+        }
+        //======================================================================
+        // every kernel transforms and sums the power bit exactly as the scalar one, the small
+        // sizes cover the stages narrower than a vector, odd lengths the power tails
+        BOOST_AUTO_TEST_CASE(test_fobos_fft_kernels_match)
+        {
+            unsigned int count = 0;
+            const struct fobos_convert_kernel * kernels = fobos_convert_kernels(&count);
+            const uint32_t sizes[] = { 2, 4, 8, 1024 };
+            for (uint32_t size : sizes)
+            {
+                psd_block x = psd_noise(size, 0x2468ACE0u + size);
+                psd_block expected(size);
+                struct fobos_fft * fft = fobos_fft_create(size, &kernels[0]);
+                BOOST_REQUIRE(fft != nullptr);
+                fobos_fft_run(fft, reinterpret_cast<const float *>(x.data()), reinterpret_cast<float *>(expected.data()));
+                fobos_fft_destroy(fft);
+                for (unsigned int n = 1; n < count; n++)
+                {
+                    if (!kernels[n].supported())
+                    {
+                        continue;
+                    }
+                    psd_block actual(size);
+                    fft = fobos_fft_create(size, &kernels[n]);
+                    BOOST_REQUIRE(fft != nullptr);
+                    fobos_fft_run(fft, reinterpret_cast<const float *>(x.data()), reinterpret_cast<float *>(actual.data()));
+                    fobos_fft_destroy(fft);
+                    BOOST_TEST_INFO("kernel " << kernels[n].name << " size " << size);
+                    BOOST_CHECK(memcmp(actual.data(), expected.data(), size * sizeof(std::complex<float>)) == 0);
+                }
+            }
+            const size_t length = 1024 + 7;
+            psd_block y = psd_noise(length, 0x0F1E2D3Cu);
+            std::vector<float> expected(length, 0.25f);
+            kernels[0].power(reinterpret_cast<const float *>(y.data()), expected.data(), length);
+            for (unsigned int n = 1; n < count; n++)
+            {
+                if (!kernels[n].supported())
+                {
+                    continue;
+                }
+                std::vector<float> actual(length, 0.25f);
+                kernels[n].power(reinterpret_cast<const float *>(y.data()), actual.data(), length);
+                BOOST_TEST_INFO("kernel " << kernels[n].name);
+                BOOST_CHECK(memcmp(actual.data(), expected.data(), length * sizeof(float)) == 0);
+            }
+        }
+        //======================================================================
+        // a full scale tone on a bin center reads 0 dB with every window, dc in the middle
+        BOOST_AUTO_TEST_CASE(test_fobos_psd_tone)
+        {
+            const uint32_t size = 256;
+            const struct fobos_convert_kernel * kernel = fobos_convert_select();
+            BOOST_CHECK(fobos_psd_create(size, FOBOS_WINDOW_COUNT, kernel) == nullptr);
+            BOOST_CHECK(fobos_psd_create(100, FOBOS_WINDOW_HANN, kernel) == nullptr);
+            for (int window = 0; window < FOBOS_WINDOW_COUNT; window++)
+            {
+                BOOST_TEST_INFO("window " << window);
+                struct fobos_psd * psd = fobos_psd_create(size, window, kernel);
+                BOOST_REQUIRE(psd != nullptr);
+                std::vector<float> db(size);
+                fobos_psd_read(psd, db.data());
+                BOOST_CHECK_EQUAL(db[0], FOBOS_PSD_FLOOR_DB);
+                // bin 20 above dc, then -30 below it at -20 dB, averaged
+                psd_block x = psd_tone(size, 20.0 / size, 1.0);
+                fobos_psd_add(psd, reinterpret_cast<const float *>(x.data()));
+                x = psd_tone(size, -30.0 / size, 0.1);
+                fobos_psd_add(psd, reinterpret_cast<const float *>(x.data()));
+                BOOST_CHECK_EQUAL(fobos_psd_count(psd), 2u);
+                fobos_psd_read(psd, db.data());
+                BOOST_CHECK_SMALL(db[size / 2 + 20] - (float)(10.0 * log10(0.5)), 0.01f);
+                BOOST_CHECK_SMALL(db[size / 2 - 30] - (float)(10.0 * log10(0.005)), 0.01f);
+                // the windows keep the leakage of a bin centered tone to their main lobe
+                if (window != FOBOS_WINDOW_RECT)
+                {
+                    BOOST_CHECK(db[size / 2 + 60] < -60.0f);
+                }
+                fobos_psd_reset(psd);
+                BOOST_CHECK_EQUAL(fobos_psd_count(psd), 0u);
+                fobos_psd_destroy(psd);
+            }
+        }
+        //======================================================================
+        // off a bin center the blackman-harris side lobes stay 90 dB down
+        BOOST_AUTO_TEST_CASE(test_fobos_psd_side_lobes)
+        {
+            const uint32_t size = 1024;
+            struct fobos_psd * psd = fobos_psd_create(size, FOBOS_WINDOW_BLACKMAN_HARRIS, fobos_convert_select());
+            BOOST_REQUIRE(psd != nullptr);
+            psd_block x = psd_tone(size, 100.5 / size, 1.0);
+            fobos_psd_add(psd, reinterpret_cast<const float *>(x.data()));
+            std::vector<float> db(size);
+            fobos_psd_read(psd, db.data());
+            fobos_psd_destroy(psd);
+            float peak = std::max(db[size / 2 + 100], db[size / 2 + 101]);
+            BOOST_CHECK(peak > -1.5f);
+            for (uint32_t k = 0; k < size; k++)
+            {
+                int distance = (int)k - (int)(size / 2 + 100);
+                if ((distance < -5) || (distance > 6))
+                {
+                    BOOST_TEST_INFO("bin " << k);
+                    BOOST_CHECK(db[k] < peak - 90.0f);
+                }
+            }
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
@@ -0,0 +1,157 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos_record.h>
+#include "qa_fobos_files.h"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        static size_t count_of(const std::string & text, const std::string & what)
+        {
+            size_t count = 0;
+            for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1))
+            {
+                count++;
+            }
+            return count;
+        }
+        //======================================================================
+        static struct fobos_record_capture record_capture(uint64_t global_index, double frequency)
+        {
+            struct fobos_record_capture capture = {};
+            capture.global_index = global_index;
+            capture.frequency = frequency;
+            capture.samplerate = 20E6;
+            capture.lna_gain = 1;
+            capture.vga_gain = 7;
+            capture.swap_iq = 1;
+            capture.correction.dc_re = 8192.5f;
+            capture.correction.dc_im = 8191.25f;
+            capture.correction.gain = 1.0f;
+            return capture;
+        }
+        //======================================================================
+        // transfers of a size that is no multiple of the alignment, across many chunks,
+        // the file is trimmed to the data; every backend the platform has
+        BOOST_AUTO_TEST_CASE(test_fobos_record_backends)
+        {
+            const int flags[] = { 0, FOBOS_RECORD_NO_URING, FOBOS_RECORD_NO_URING | FOBOS_RECORD_NO_DIRECT };
+            const size_t transfer = 3 * 16384 * 4 + 4 * 100;
+            for (int f : flags)
+            {
+                std::string path = qa_temp_path("qa_fobos_record");
+                fobos_record * record = fobos_record_open(path.c_str(), 64 * 1024 * 1024, 0, f);
+                BOOST_REQUIRE(record);
+                fobos_rx_recording status = {};
+                fobos_record_status(record, &status);
+                BOOST_CHECK(status.active);
+                if (f & FOBOS_RECORD_NO_URING)
+                {
+                    BOOST_CHECK_EQUAL(status.backend, FOBOS_RECORD_BACKEND_THREAD);
+                }
+                else
+                {
+                    BOOST_CHECK(status.backend != FOBOS_RECORD_BACKEND_NONE);
+                }
+                if (f & FOBOS_RECORD_NO_DIRECT)
+                {
+                    BOOST_CHECK_EQUAL(status.direct, 0);
+                }
+                std::vector<uint8_t> expected;
+                std::vector<uint8_t> data(transfer);
+                struct fobos_record_capture capture = record_capture(16384, 100E6);
+                BOOST_REQUIRE(fobos_record_set_capture(record, &capture) == 0);
+                for (uint32_t i = 0; i < 200; i++)
+                {
+                    for (size_t k = 0; k < data.size(); k++)
+                    {
+                        data[k] = (uint8_t)(i * 7 + k * 13 + (k >> 9));
+                    }
+                    if (i == 120)
+                    {
+                        // samples lost ahead of this transfer, the data goes on where it was
+                        BOOST_REQUIRE(fobos_record_gap(record, 5 * 16384) == 0);
+                        capture = record_capture(16384 + (i + 5) * (transfer / 4), 100E6);
+                        BOOST_REQUIRE(fobos_record_set_capture(record, &capture) == 0);
+                    }
+                    int result;
+                    // a full queue drops, the transfer is retried until the writes caught up
+                    while ((result = fobos_record_write(record, data.data(), data.size())) == -5)
+                    {
+                    }
+                    BOOST_REQUIRE_EQUAL(result, 0);
+                    expected.insert(expected.end(), data.begin(), data.end());
+                }
+                fobos_record_status(record, &status);
+                BOOST_CHECK_EQUAL(status.bytes, expected.size());
+                BOOST_CHECK_EQUAL(status.transfers, 200u);
+                BOOST_CHECK_EQUAL(status.gaps, 1u);
+                BOOST_CHECK_EQUAL(status.captures, 2u);
+                BOOST_REQUIRE(fobos_record_close(record, "RigExpert \"Fobos SDR\"") == 0);
+                std::string written = qa_read_file(path + ".sigmf-data");
+                BOOST_REQUIRE_EQUAL(written.size(), expected.size());
+                BOOST_CHECK(std::equal(expected.begin(), expected.end(), (const uint8_t *)written.data()));
+                std::string meta = qa_read_file(path + ".sigmf-meta");
+                BOOST_CHECK(meta.find("\"core:datatype\": \"cu16_le\"") != std::string::npos);
+                BOOST_CHECK(meta.find("\"core:sample_rate\": 20000000,") != std::string::npos);
+                BOOST_CHECK(meta.find("\"core:hw\": \"RigExpert \\\"Fobos SDR\\\"\"") != std::string::npos);
+                BOOST_CHECK_EQUAL(count_of(meta, "\"core:global_index\""), 2u);
+                BOOST_CHECK(meta.find("\"core:global_index\": 16384,") != std::string::npos);
+                BOOST_CHECK(meta.find("\"core:frequency\": 100000000,") != std::string::npos);
+                BOOST_CHECK(meta.find("\"fobos:vga_gain\": 7,") != std::string::npos);
+                BOOST_CHECK(meta.find("\"fobos:dc_re\": 8192.5,") != std::string::npos);
+                // the gap annotation and the second capture start at the transfer after it
+                std::string start = "\"core:sample_start\": " + std::to_string(120 * (transfer / 4)) + ",";
+                BOOST_CHECK_EQUAL(count_of(meta, start), 2u);
+                BOOST_CHECK(meta.find("\"fobos:lost_samples\": 81920") != std::string::npos);
+                std::remove((path + ".sigmf-data").c_str());
+                std::remove((path + ".sigmf-meta").c_str());
+            }
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_record_all_or_nothing)
+        {
+            std::string path = qa_temp_path("qa_fobos_record_drop");
+            BOOST_CHECK(fobos_record_open("", 0, 0, 0) == nullptr);
+            fobos_record * record = fobos_record_open(path.c_str(), 0, 0, 0);
+            BOOST_REQUIRE(record);
+            // more than every buffer together: dropped whole, nothing of it reaches the file
+            std::vector<uint8_t> big((FOBOS_RECORD_MIN_CHUNKS + 1) * (size_t)FOBOS_RECORD_CHUNK, 0x55);
+            BOOST_CHECK_EQUAL(fobos_record_write(record, big.data(), big.size()), -5);
+            std::vector<uint8_t> small(4096, 0xAA);
+            struct fobos_record_capture capture = record_capture(0, 433E6);
+            BOOST_REQUIRE(fobos_record_set_capture(record, &capture) == 0);
+            // a capture without samples is replaced by the next one
+            capture = record_capture(0, 434E6);
+            BOOST_REQUIRE(fobos_record_set_capture(record, &capture) == 0);
+            BOOST_CHECK_EQUAL(fobos_record_write(record, small.data(), small.size()), 0);
+            fobos_rx_recording status = {};
+            fobos_record_status(record, &status);
+            BOOST_CHECK_EQUAL(status.dropped, 1u);
+            BOOST_CHECK_EQUAL(status.bytes, 4096u);
+            BOOST_CHECK_EQUAL(status.captures, 1u);
+            BOOST_REQUIRE(fobos_record_close(record, "") == 0);
+            BOOST_CHECK_EQUAL(qa_read_file(path + ".sigmf-data"), std::string(4096, (char)0xAA));
+            std::string meta = qa_read_file(path + ".sigmf-meta");
+            BOOST_CHECK(meta.find("\"core:frequency\": 434000000,") != std::string::npos);
+            BOOST_CHECK(meta.find("\"fobos:dropped_transfers\": 1") != std::string::npos);
+            std::remove((path + ".sigmf-data").c_str());
+            std::remove((path + ".sigmf-meta").c_str());
+        }
+    } /* namespace RigExpert */
+} /* namespace gr */
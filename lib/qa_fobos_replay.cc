@@ -0,0 +1,169 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos.h>
+#include "qa_fobos_files.h"
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // every buffer of FOBOS_FORMAT_RAW as it came, or the last converted one
+        struct replay_capture
+        {
+            fobos_dev_t * dev = nullptr;
+            uint32_t buffers = 0;
+            uint32_t stop_after = 0;
+            std::vector<uint8_t> raw;
+            std::vector<std::complex<float>> last;
+
+            static void raw_callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                replay_capture * capture = static_cast<replay_capture*>(ctx);
+                const uint8_t * bytes = reinterpret_cast<const uint8_t*>(buf);
+                capture->raw.insert(capture->raw.end(), bytes, bytes + buf_length * 4);
+                if (++capture->buffers == capture->stop_after)
+                {
+                    fobos_rx_cancel_async(capture->dev);
+                }
+            }
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                replay_capture * capture = static_cast<replay_capture*>(ctx);
+                const std::complex<float> * samples = reinterpret_cast<const std::complex<float>*>(buf);
+                capture->last.assign(samples, samples + buf_length);
+                if (++capture->buffers == capture->stop_after)
+                {
+                    fobos_rx_cancel_async(capture->dev);
+                }
+            }
+        };
+        //======================================================================
+        // a simulated stream recorded and replayed as fast as possible: the same transfers
+        // in the same order, the settings of the recording, the stream ends with the file
+        BOOST_AUTO_TEST_CASE(test_fobos_replay_raw)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            BOOST_REQUIRE(fobos_sim_enable(&config) == 0);
+            fobos_dev_t * dev = nullptr;
+            BOOST_REQUIRE(fobos_rx_open(&dev, 0) == 0);
+            std::string path = qa_temp_path("qa_fobos_replay");
+            double samplerate = 0.0;
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, &samplerate) == 0);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_set_vga_gain(dev, 5) == 0);
+            BOOST_REQUIRE(fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW) == 0);
+            fobos_replay_info info;
+            BOOST_CHECK_EQUAL(fobos_rx_get_replay_info(dev, &info), -7);
+            BOOST_REQUIRE(fobos_rx_start_recording(dev, path.c_str(), 0, 0.0) == 0);
+            replay_capture live;
+            live.dev = dev;
+            live.stop_after = 64;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, replay_capture::raw_callback, &live, 4, 16384) == 0);
+            BOOST_REQUIRE(fobos_rx_stop_recording(dev) == 0);
+            fobos_rx_recording status = {};
+            BOOST_REQUIRE(fobos_rx_get_recording(dev, &status) == 0);
+            BOOST_REQUIRE_EQUAL(status.dropped, 0u);
+            BOOST_REQUIRE(status.transfers >= 64u);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            fobos_sim_enable(nullptr);
+            std::string data = qa_read_file(path + ".sigmf-data");
+            BOOST_REQUIRE_EQUAL(data.size(), status.bytes);
+            BOOST_REQUIRE(std::memcmp(live.raw.data(), data.data(), live.raw.size()) == 0);
+
+            BOOST_CHECK_EQUAL(fobos_rx_open_replay(&dev, (path + ".missing").c_str(), FOBOS_REPLAY_AUTO, 0, 0), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_open_replay(&dev, path.c_str(), FOBOS_REPLAY_FC32, 0, 0), -7);
+            BOOST_REQUIRE(fobos_rx_open_replay(&dev, (path + ".sigmf-meta").c_str(), FOBOS_REPLAY_AUTO, 0, 0) == 0);
+            BOOST_REQUIRE(fobos_rx_get_replay_info(dev, &info) == 0);
+            BOOST_CHECK_EQUAL(info.format, FOBOS_REPLAY_RAW);
+            BOOST_CHECK_EQUAL(info.samplerate, samplerate);
+            BOOST_CHECK(std::abs(info.frequency - 100E6) < 5E6);
+            BOOST_CHECK_EQUAL(info.vga_gain, 5u);
+            BOOST_CHECK_EQUAL(info.captures, status.captures);
+            BOOST_CHECK_EQUAL(info.samples, status.bytes / 4);
+            BOOST_CHECK_EQUAL(info.position, 0u);
+            BOOST_REQUIRE(fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW) == 0);
+            replay_capture replay;
+            replay.dev = dev;
+            // read_async() returns on its own at the end
+            fobos_rx_read_async(dev, replay_capture::raw_callback, &replay, 4, 16384);
+            BOOST_CHECK_EQUAL(replay.buffers, status.transfers);
+            BOOST_REQUIRE_EQUAL(replay.raw.size(), data.size());
+            BOOST_CHECK(std::memcmp(replay.raw.data(), data.data(), data.size()) == 0);
+            BOOST_REQUIRE(fobos_rx_get_replay_info(dev, &info) == 0);
+            BOOST_CHECK_EQUAL(info.position, info.samples);
+            BOOST_CHECK_EQUAL(info.loops, 0u);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            std::remove((path + ".sigmf-data").c_str());
+            std::remove((path + ".sigmf-meta").c_str());
+        }
+        //======================================================================
+        // a headerless fc32 file through the conversion: the tone where it was recorded,
+        // at its level; repeated, the replay goes round
+        BOOST_AUTO_TEST_CASE(test_fobos_replay_fc32)
+        {
+            std::string path = qa_temp_path("qa_fobos_replay.cf32");
+            // 5.5 transfers, the half one is not replayed
+            const size_t samples = 16384 * 11 / 2;
+            std::vector<std::complex<float>> tone(samples);
+            for (size_t n = 0; n < samples; n++)
+            {
+                tone[n] = std::polar(0.125f, (float)(2.0 * M_PI * (n % 8) / 8.0));
+            }
+            {
+                std::ofstream file(path, std::ios::binary);
+                file.write(reinterpret_cast<const char*>(tone.data()), tone.size() * sizeof(tone[0]));
+            }
+            fobos_dev_t * dev = nullptr;
+            BOOST_REQUIRE(fobos_rx_open_replay(&dev, path.c_str(), FOBOS_REPLAY_AUTO, 0, 1) == 0);
+            fobos_replay_info info;
+            BOOST_REQUIRE(fobos_rx_get_replay_info(dev, &info) == 0);
+            BOOST_CHECK_EQUAL(info.format, FOBOS_REPLAY_FC32);
+            BOOST_CHECK_EQUAL(info.samplerate, 0.0);
+            BOOST_CHECK_EQUAL(info.captures, 1u);
+            BOOST_CHECK_EQUAL(info.samples, samples);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            replay_capture replay;
+            replay.dev = dev;
+            replay.stop_after = 12;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, replay_capture::callback, &replay, 4, 16384) == 0);
+            BOOST_REQUIRE_EQUAL(replay.last.size(), 16384u);
+            std::complex<double> up = 0.0;
+            std::complex<double> down = 0.0;
+            for (size_t n = 0; n < replay.last.size(); n++)
+            {
+                up += std::complex<double>(replay.last[n]) * std::polar(1.0, -2.0 * M_PI * n / 8.0);
+                down += std::complex<double>(replay.last[n]) * std::polar(1.0, 2.0 * M_PI * n / 8.0);
+            }
+            up /= (double)replay.last.size();
+            down /= (double)replay.last.size();
+            BOOST_CHECK_CLOSE(std::abs(up), 0.125, 1.0);
+            BOOST_CHECK(std::abs(down) < 0.001);
+            BOOST_REQUIRE(fobos_rx_get_replay_info(dev, &info) == 0);
+            BOOST_CHECK(info.loops >= 2u);
+            BOOST_CHECK(info.position < samples);
+            BOOST_CHECK_EQUAL(info.position % 16384, 0u);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            std::remove(path.c_str());
+        }
+    } /* namespace RigExpert */
+} /* namespace gr */
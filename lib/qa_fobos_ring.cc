@@ -0,0 +1,104 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include "fobos_ring.h"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <thread>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_ring_full_and_empty)
+        {
+            fobos_ring ring(4, 256);
+            BOOST_CHECK(ring.read_slot() == nullptr);
+            BOOST_CHECK(!ring.wait_readable(std::chrono::microseconds(1000)));
+            for (int i = 0; i < 4; i++)
+            {
+                void * slot = ring.write_slot();
+                BOOST_REQUIRE(slot != nullptr);
+                BOOST_CHECK((reinterpret_cast<uintptr_t>(slot) % fobos_ring::cache_line) == 0);
+                ring.commit_write();
+            }
+            BOOST_CHECK(ring.write_slot() == nullptr);
+            BOOST_CHECK_EQUAL(ring.filled(), 4u);
+            BOOST_CHECK(ring.wait_readable(std::chrono::microseconds(0)));
+            ring.commit_read();
+            BOOST_CHECK(ring.write_slot() != nullptr);
+            BOOST_CHECK_EQUAL(ring.filled(), 3u);
+        }
+        //======================================================================
+        // the consumer sleeps most of the time, every slot must arrive in order
+        BOOST_AUTO_TEST_CASE(test_fobos_ring_threads)
+        {
+            const uint32_t total = 200000;
+            fobos_ring ring(8, sizeof(uint32_t) * 16);
+            std::thread producer([&]
+            {
+                for (uint32_t n = 0; n < total; )
+                {
+                    uint32_t * slot = static_cast<uint32_t*>(ring.write_slot());
+                    if (!slot)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    for (int i = 0; i < 16; i++)
+                    {
+                        slot[i] = n;
+                    }
+                    ring.commit_write();
+                    n++;
+                }
+            });
+            uint32_t errors = 0;
+            for (uint32_t n = 0; n < total; )
+            {
+                if (!ring.wait_readable(std::chrono::milliseconds(100)))
+                {
+                    continue;
+                }
+                const uint32_t * slot = static_cast<const uint32_t*>(ring.read_slot());
+                for (int i = 0; i < 16; i++)
+                {
+                    errors += (slot[i] != n);
+                }
+                ring.commit_read();
+                n++;
+            }
+            producer.join();
+            BOOST_CHECK_EQUAL(errors, 0u);
+            BOOST_CHECK(ring.read_slot() == nullptr);
+        }
+        //======================================================================
+        // busy poll: times out on an empty ring, sees a slot published later
+        BOOST_AUTO_TEST_CASE(test_fobos_ring_spin)
+        {
+            fobos_ring ring(4, 256);
+            auto t0 = std::chrono::steady_clock::now();
+            BOOST_CHECK(!ring.spin_readable(std::chrono::milliseconds(5)));
+            BOOST_CHECK(std::chrono::steady_clock::now() - t0 >= std::chrono::milliseconds(5));
+            std::thread producer([&]
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                ring.write_slot();
+                ring.commit_write();
+            });
+            BOOST_CHECK(ring.spin_readable(std::chrono::seconds(5)));
+            BOOST_CHECK(ring.read_slot() != nullptr);
+            producer.join();
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
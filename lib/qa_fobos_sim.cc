@@ -0,0 +1,906 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+#include <fobos/fobos.h>
+#include <fobos/fobos_psd.h>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // streams the simulated device until stop_after buffers arrived
+        struct sim_capture
+        {
+            fobos_dev_t * dev = nullptr;
+            uint32_t buffers = 0;
+            uint32_t stop_after = 0;
+            std::vector<std::complex<float>> last;
+
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                sim_capture * capture = static_cast<sim_capture*>(ctx);
+                capture->buffers++;
+                if (capture->buffers == capture->stop_after)
+                {
+                    const std::complex<float> * samples = reinterpret_cast<const std::complex<float>*>(buf);
+                    capture->last.assign(samples, samples + buf_length);
+                    fobos_rx_cancel_async(capture->dev);
+                }
+            }
+        };
+        //======================================================================
+        static fobos_dev_t * open_sim(const fobos_sim_config & config)
+        {
+            BOOST_REQUIRE(fobos_sim_enable(&config) == 0);
+            BOOST_REQUIRE_EQUAL(fobos_rx_get_device_count(), 1);
+            fobos_dev_t * dev = nullptr;
+            BOOST_REQUIRE(fobos_rx_open(&dev, 0) == 0);
+            BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+            return dev;
+        }
+        //======================================================================
+        static void close_sim(fobos_dev_t * dev)
+        {
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            fobos_sim_enable(nullptr);
+        }
+        //======================================================================
+        static double tone_power(const std::vector<std::complex<float>> & x, double f)
+        {
+            std::complex<double> acc = 0.0;
+            for (size_t n = 0; n < x.size(); n++)
+            {
+                acc += std::complex<double>(x[n]) * std::polar(1.0, -2.0 * M_PI * f * n);
+            }
+            return std::norm(acc / (double)x.size());
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_tone_and_correction)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            config.dc_re = 0.02;
+            config.dc_im = -0.03;
+            config.gain = 1.1;
+            config.phase = 0.05;
+            fobos_dev_t * dev = open_sim(config);
+            double samplerate = 0.0;
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, &samplerate) == 0);
+            BOOST_CHECK_EQUAL(samplerate, 20E6);
+            // the low band and the spectrum inverting high band
+            const double frequencies[] = { 100E6, 3000E6 };
+            for (double frequency : frequencies)
+            {
+                BOOST_TEST_INFO("frequency " << frequency);
+                BOOST_REQUIRE(fobos_rx_set_frequency(dev, frequency, nullptr) == 0);
+                BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+                sim_capture capture;
+                capture.dev = dev;
+                capture.stop_after = 200;
+                BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+                BOOST_REQUIRE_EQUAL(capture.last.size(), 65536u);
+
+                fobos_iq_correction correction;
+                BOOST_REQUIRE(fobos_rx_get_iq_correction(dev, &correction) == 0);
+                BOOST_CHECK_CLOSE(correction.dc_re, 8192.0 * 1.02, 0.1);
+                BOOST_CHECK_CLOSE(correction.dc_im, 8192.0 * 0.97, 0.1);
+                BOOST_CHECK_CLOSE(correction.gain, 1.1, 1.0);
+                BOOST_CHECK_CLOSE(correction.phase, 0.05, 5.0);
+
+                // the corrected tone sits at +1 MHz, its image is well suppressed
+                double tone = tone_power(capture.last, 1E6 / samplerate);
+                double image = tone_power(capture.last, -1E6 / samplerate);
+                BOOST_CHECK(tone > 1E-4);
+                BOOST_CHECK(image < tone * 1E-4);
+
+                fobos_rx_stats stats;
+                BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+                BOOST_CHECK_EQUAL(stats.buffers, 200u + 4u); // + calibration
+                BOOST_CHECK_EQUAL(stats.rx_failures, 0u);
+            }
+            close_sim(dev);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_decimation)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, nullptr) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_set_decimation(dev, 7), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_decimation(dev, 0), -7);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 4) == 0);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 100;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            BOOST_REQUIRE_EQUAL(capture.last.size(), 65536u / 4);
+            // the +1 MHz tone at 5 MS/s, inside the pass band
+            double tone = tone_power(capture.last, 1E6 / 5E6);
+            double image = tone_power(capture.last, -1E6 / 5E6);
+            BOOST_CHECK(tone > 1E-4);
+            BOOST_CHECK(image < tone * 1E-4);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 1) == 0);
+            close_sim(dev);
+        }
+        //======================================================================
+        // the simulated tone sits 1 MHz above the lo wherever the lo is, so only the mixer moves it
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_if_offset)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 4) == 0);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_set_if_offset(dev, 10E6), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_if_offset(dev, -12E6), -7);
+            const double rate = 5E6;
+            // explicit: the lo 2 MHz below the center, the tone 1 MHz below it
+            BOOST_REQUIRE(fobos_rx_set_if_offset(dev, 2E6) == 0);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 20;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            BOOST_REQUIRE_EQUAL(capture.last.size(), 65536u / 4);
+            double tone = tone_power(capture.last, -1E6 / rate);
+            BOOST_CHECK(tone > 1E-4);
+            BOOST_CHECK(tone_power(capture.last, 1E6 / rate) < tone * 1E-4);
+            // auto: within 0.4 * 20 MHz * 3 / 4 of the lo only the mixer moves, the tone to 0 Hz
+            BOOST_REQUIRE(fobos_rx_set_if_offset(dev, 0.0) == 0);
+            BOOST_REQUIRE(fobos_rx_set_auto_if(dev, 1) == 0);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            double actual = 0.0;
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 101E6, &actual) == 0);
+            BOOST_CHECK_SMALL(actual - 101E6, 20E6 / 4294967296.0);
+            capture.buffers = 0;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            tone = tone_power(capture.last, 0.0);
+            BOOST_CHECK(tone > 1E-4);
+            BOOST_CHECK(tone_power(capture.last, 1E6 / rate) < tone * 1E-4);
+            // out of the span the lo retunes, the tone is back at +1 MHz
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 200E6, &actual) == 0);
+            BOOST_CHECK_SMALL(actual - 200E6, 20E6 / 4294967296.0);
+            capture.buffers = 0;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            tone = tone_power(capture.last, 1E6 / rate);
+            BOOST_CHECK(tone > 1E-4);
+            BOOST_CHECK(tone_power(capture.last, 0.0) < tone * 1E-4);
+            BOOST_REQUIRE(fobos_rx_set_auto_if(dev, 0) == 0);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 1) == 0);
+            close_sim(dev);
+        }
+        //======================================================================
+        // only the registers that differ go over usb, the band switches follow the plans
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_retune)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            const double frequencies[] = { 101E6, 103E6, 200E6, 2400E6, 5000E6 };
+            BOOST_CHECK_EQUAL(fobos_rx_prepare_frequencies(dev, nullptr, 1), -7);
+            BOOST_REQUIRE(fobos_rx_prepare_frequencies(dev, frequencies, 5) == 0);
+            const double out_of_range[] = { 7000E6, 300E6 };
+            BOOST_CHECK_EQUAL(fobos_rx_prepare_frequencies(dev, out_of_range, 2), -5);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.control_transfers, 0u);
+            double actual[5];
+            uint64_t transfers[5];
+            for (int i = 0; i < 5; i++)
+            {
+                BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+                BOOST_REQUIRE(fobos_rx_set_frequency(dev, frequencies[i], &actual[i]) == 0);
+                BOOST_CHECK_SMALL(actual[i] - frequencies[i], 100.0);
+                BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+                BOOST_CHECK_EQUAL(stats.retune_time.count, 1u);
+                transfers[i] = stats.control_transfers;
+            }
+            // 101 and 103 MHz share the rffc507x lo, the max2830 divider alone changes
+            BOOST_CHECK(transfers[1] <= 2u);
+            // a new rffc507x lo: enbl off, the pll registers that differ, enbl on
+            BOOST_CHECK(transfers[2] > 2u);
+            BOOST_CHECK(transfers[2] <= 2u + 7u + 2u);
+            // the same frequency again: nothing to write
+            BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+            double again = 0.0;
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 5000E6, &again) == 0);
+            BOOST_CHECK_EQUAL(again, actual[4]);
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.control_transfers, 0u);
+            // high band and back: the preselector and the iq swap agree, the tone is at +1 MHz
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 20;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            double tone = tone_power(capture.last, 0.1);
+            BOOST_CHECK(tone > 1E-4);
+            BOOST_CHECK(tone_power(capture.last, -0.1) < tone * 1E-4);
+            close_sim(dev);
+        }
+        //======================================================================
+        // queues a batch from the callback, looks for it at the last buffer
+        struct sim_config_capture : sim_capture
+        {
+            fobos_rx_config config;
+            int queued = 1;
+            fobos_rx_config seen;
+
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                sim_config_capture * capture = static_cast<sim_config_capture*>(ctx);
+                if (capture->buffers == 2)
+                {
+                    capture->queued = fobos_rx_apply_config(capture->dev, &capture->config);
+                }
+                if (capture->buffers + 1 == capture->stop_after)
+                {
+                    fobos_rx_get_config(capture->dev, &capture->seen);
+                }
+                sim_capture::callback(buf, buf_length, ctx);
+            }
+        };
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_config)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_CHECK_EQUAL(fobos_rx_get_config(dev, nullptr), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_apply_config(dev, nullptr), -7);
+            fobos_rx_config rx_config;
+            BOOST_REQUIRE(fobos_rx_get_config(dev, &rx_config) == 0);
+            BOOST_CHECK_EQUAL(rx_config.batches, 0u);
+            BOOST_CHECK_EQUAL(rx_config.pending, 0);
+            BOOST_CHECK_EQUAL(rx_config.clock_source, 0);
+            // not streaming: right away, only what differs
+            rx_config.frequency = 100E6;
+            rx_config.lna_gain = 2;
+            rx_config.vga_gain = 7;
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            fobos_rx_config applied;
+            BOOST_REQUIRE(fobos_rx_get_config(dev, &applied) == 0);
+            BOOST_CHECK_EQUAL(applied.batches, 1u);
+            BOOST_CHECK_EQUAL(applied.result, 0);
+            BOOST_CHECK_EQUAL(applied.lna_gain, 2u);
+            BOOST_CHECK_EQUAL(applied.vga_gain, 7u);
+            BOOST_CHECK_EQUAL(applied.frequency, 100E6);
+            BOOST_CHECK_SMALL(applied.actual_frequency - 100E6, 100.0);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.control_transfers, 0u);
+            rx_config.frequency = 9000E6;
+            BOOST_CHECK_EQUAL(fobos_rx_apply_config(dev, &rx_config), -5);
+            rx_config.frequency = 100E6;
+            rx_config.clock_source = 2;
+            BOOST_CHECK_EQUAL(fobos_rx_apply_config(dev, &rx_config), -7);
+            // the clock source and direct sampling gpo changes are one write, the single setters two
+            BOOST_REQUIRE(fobos_rx_set_clk_source(dev, 1) == 0);
+            BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+            BOOST_REQUIRE(fobos_rx_set_direct_sampling(dev, 1) == 0);
+            BOOST_REQUIRE(fobos_rx_set_clk_source(dev, 0) == 0);
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            uint64_t single = stats.control_transfers;
+            rx_config.clock_source = 1;
+            rx_config.direct_sampling = 0;
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+            rx_config.clock_source = 0;
+            rx_config.direct_sampling = 1;
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.control_transfers, single - 1);
+            rx_config.direct_sampling = 0;
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            // the if offset moves the lo, the center stays
+            rx_config.if_offset = 6E6;
+            BOOST_CHECK_EQUAL(fobos_rx_apply_config(dev, &rx_config), -7);
+            rx_config.if_offset = 2E6;
+            rx_config.auto_if = 2;
+            BOOST_CHECK_EQUAL(fobos_rx_apply_config(dev, &rx_config), -7);
+            rx_config.auto_if = 1;
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            BOOST_REQUIRE(fobos_rx_get_config(dev, &applied) == 0);
+            BOOST_CHECK_EQUAL(applied.if_offset, 2E6);
+            BOOST_CHECK_EQUAL(applied.auto_if, 1);
+            BOOST_CHECK_SMALL(applied.actual_frequency - 100E6, 100.0);
+            rx_config.if_offset = 0.0;
+            rx_config.auto_if = 0;
+            BOOST_REQUIRE(fobos_rx_apply_config(dev, &rx_config) == 0);
+            // streaming: queued, run by the event thread between two transfers
+            sim_config_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 20;
+            capture.config = rx_config;
+            capture.config.frequency = 200E6;
+            capture.config.vga_gain = 3;
+            capture.config.if_offset = 1E6;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_config_capture::callback, &capture, 8, 65536) == 0);
+            BOOST_CHECK_EQUAL(capture.queued, 0);
+            BOOST_CHECK_EQUAL(capture.seen.pending, 0);
+            BOOST_CHECK_EQUAL(capture.seen.result, 0);
+            BOOST_CHECK_EQUAL(capture.seen.vga_gain, 3u);
+            BOOST_CHECK_EQUAL(capture.seen.frequency, 200E6);
+            BOOST_CHECK_EQUAL(capture.seen.if_offset, 1E6);
+            BOOST_CHECK_SMALL(capture.seen.actual_frequency - 200E6, 100.0);
+            BOOST_CHECK(capture.seen.batches > applied.batches);
+            // the lo 1 MHz below the new center, the tone 1 MHz above the lo is on the center
+            double tone = tone_power(capture.last, 0.0);
+            BOOST_CHECK(tone > 1E-4);
+            BOOST_CHECK(tone_power(capture.last, 0.1) < tone * 1E-4);
+            close_sim(dev);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_hops)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            uint32_t seq = 0;
+            fobos_rx_hop_event events[64];
+            BOOST_CHECK_EQUAL(fobos_rx_set_hops(dev, nullptr, 1), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_read_hop_events(dev, nullptr, events, 64), -7);
+            fobos_rx_hop hops[3] = {{150E6, 100000, 1000}, {250E6, 50000, 2000}, {9000E6, 100000, 1000}};
+            BOOST_CHECK_EQUAL(fobos_rx_set_hops(dev, hops, 3), -5);
+            hops[2].frequency = 350E6;
+            hops[2].dwell = 0;
+            BOOST_CHECK_EQUAL(fobos_rx_set_hops(dev, hops, 3), -7);
+            hops[2].dwell = 100000;
+            BOOST_REQUIRE(fobos_rx_set_hops(dev, hops, 3) == 0);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 60;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            int count = fobos_rx_read_hop_events(dev, &seq, events, 64);
+            BOOST_REQUIRE(count > 6);
+            BOOST_CHECK_EQUAL(fobos_rx_read_hop_events(dev, &seq, events, 64), 0);
+            for (int i = 0; i < count; i++)
+            {
+                const fobos_rx_hop & hop = hops[i % 3];
+                BOOST_TEST_INFO("hop event " << i);
+                BOOST_CHECK_EQUAL(events[i].hop, (uint32_t)(i % 3));
+                BOOST_CHECK_EQUAL(events[i].result, 0);
+                BOOST_CHECK_SMALL(events[i].frequency - hop.frequency, 100.0);
+                // a transfer in flight while the lo moves, then the settle time
+                BOOST_CHECK_EQUAL(events[i].dwell_sample - events[i].settle_sample, 65536u + hop.settle);
+                if (i > 0)
+                {
+                    // hops happen between transfers, not before the dwell is over
+                    BOOST_CHECK(events[i].settle_sample >= events[i - 1].dwell_sample + hops[(i - 1) % 3].dwell);
+                    BOOST_CHECK(events[i].settle_sample < events[i - 1].dwell_sample + hops[(i - 1) % 3].dwell + 65536);
+                    BOOST_CHECK_EQUAL(events[i].settle_sample % 65536, 0u);
+                }
+            }
+            // no hops, no events
+            BOOST_REQUIRE(fobos_rx_set_hops(dev, nullptr, 0) == 0);
+            capture.buffers = 0;
+            capture.stop_after = 10;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_read_hop_events(dev, &seq, events, 64), 0);
+            close_sim(dev);
+        }
+        //======================================================================
+        // the rows of a sweep and where they were called back with
+        struct sim_sweep_capture
+        {
+            std::vector<uint32_t> sweeps;
+            std::vector<float> last;
+            double start_hz = 0.0;
+            double bin_hz = 0.0;
+
+            static void callback(const float * power_db, uint32_t bins, double start_hz, double bin_hz, uint32_t sweep, void * ctx)
+            {
+                sim_sweep_capture * capture = static_cast<sim_sweep_capture*>(ctx);
+                capture->sweeps.push_back(sweep);
+                capture->last.assign(power_db, power_db + bins);
+                capture->start_hz = start_hz;
+                capture->bin_hz = bin_hz;
+            }
+        };
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_sweep)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 10E6, nullptr) == 0);
+            // 7.5 MHz steps of 768 bins
+            fobos_sweep_config sweep = {100E6, 400E6, 1024, FOBOS_WINDOW_BLACKMAN_HARRIS, 2, 1000, 0.75};
+            uint32_t bins = 0;
+            BOOST_REQUIRE(fobos_rx_get_sweep_bins(dev, &sweep, &bins) == 0);
+            BOOST_CHECK_EQUAL(bins, 40u * 768u);
+            sim_sweep_capture capture;
+            BOOST_CHECK_EQUAL(fobos_rx_sweep(dev, &sweep, nullptr, &capture, 1), -7);
+            fobos_sweep_config invalid = sweep;
+            invalid.fft_size = 1000;
+            BOOST_CHECK_EQUAL(fobos_rx_get_sweep_bins(dev, &invalid, &bins), -7);
+            invalid = sweep;
+            invalid.averages = 0;
+            BOOST_CHECK_EQUAL(fobos_rx_sweep(dev, &invalid, sim_sweep_capture::callback, &capture, 1), -7);
+            invalid = sweep;
+            invalid.stop = 6000E6;
+            BOOST_CHECK_EQUAL(fobos_rx_sweep(dev, &invalid, sim_sweep_capture::callback, &capture, 1), -7);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 2) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_sweep(dev, &sweep, sim_sweep_capture::callback, &capture, 1), -7);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 1) == 0);
+            BOOST_REQUIRE(fobos_rx_reset_stats(dev) == 0);
+            BOOST_REQUIRE(fobos_rx_sweep(dev, &sweep, sim_sweep_capture::callback, &capture, 3) == 0);
+            BOOST_REQUIRE_EQUAL(capture.sweeps.size(), 3u);
+            BOOST_CHECK_EQUAL(capture.sweeps[2], 2u);
+            BOOST_REQUIRE_EQUAL(capture.last.size(), bins);
+            BOOST_CHECK_EQUAL(capture.start_hz, 100E6);
+            BOOST_CHECK_EQUAL(capture.bin_hz, 10E6 / 1024);
+            // the tone 1 MHz above every step center, the noise floor between them
+            for (uint32_t step = 0; step < 40; step++)
+            {
+                uint32_t tone = step * 768 + 384 + (uint32_t)lround(1E6 / capture.bin_hz);
+                BOOST_TEST_INFO("step " << step);
+                BOOST_CHECK(capture.last[tone] > -40.0f);
+                BOOST_CHECK(capture.last[tone] > capture.last[tone + 100] + 40.0f);
+            }
+            // a retune per step, the last and first step of two passes are the same one
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK(stats.retune_time.count >= 3 * 40 - 3);
+            // the schedule is gone afterwards
+            uint32_t seq = 0;
+            fobos_rx_hop_event events[FOBOS_RX_MAX_HOPS];
+            while (fobos_rx_read_hop_events(dev, &seq, events, FOBOS_RX_MAX_HOPS) > 0)
+            {
+            }
+            sim_capture stream;
+            stream.dev = dev;
+            stream.stop_after = 10;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &stream, 8, 65536) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_read_hop_events(dev, &seq, events, FOBOS_RX_MAX_HOPS), 0);
+            close_sim(dev);
+        }
+        //======================================================================
+        // a raw consumer feeding the spectrum of the stream, the rows of every buffer appended
+        struct sim_psd_capture
+        {
+            fobos_dev_t * dev = nullptr;
+            uint32_t buffers = 0;
+            uint32_t stop_after = 0;
+            int rows_max = 0;               // per buffer
+            bool failed = false;
+            std::vector<float> row_buf;
+            std::vector<float> rows;
+
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                sim_psd_capture * capture = static_cast<sim_psd_capture*>(ctx);
+                uint64_t sample = 0;
+                fobos_rx_get_sample_index(capture->dev, &sample);
+                int rows = fobos_rx_psd(capture->dev, buf, buf_length, capture->row_buf.data(), sample);
+                if ((rows < 0) || (rows > capture->rows_max))
+                {
+                    capture->failed = true;
+                }
+                else
+                {
+                    capture->rows.insert(capture->rows.end(), capture->row_buf.begin(), capture->row_buf.begin() + rows * 1024);
+                }
+                if (++capture->buffers == capture->stop_after)
+                {
+                    fobos_rx_cancel_async(capture->dev);
+                }
+            }
+        };
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_psd)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, nullptr) == 0);
+            std::vector<int16_t> raw(2 * 2048, 0x2000);
+            std::vector<float> row(1024);
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 1024, row.data(), 0), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_psd(dev, 8, FOBOS_WINDOW_HANN, 0, 1), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_psd(dev, 1000, FOBOS_WINDOW_HANN, 0, 1), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_psd(dev, 1024, FOBOS_WINDOW_COUNT, 0, 1), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_psd(dev, 1024, FOBOS_WINDOW_HANN, 1024, 1), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_psd(dev, 1024, FOBOS_WINDOW_HANN, 0, 0), -7);
+            BOOST_REQUIRE(fobos_rx_set_psd(dev, 1024, FOBOS_WINDOW_HANN, 512, 4) == 0);
+            // 4 blocks a row, a block every 512 samples from the 1024th on
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 2048, row.data(), 1000000), 0);
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 512, row.data(), 1002048), 1);
+            // a gap drops the partial block and row: 2 blocks, 3, then the row
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 1536, row.data(), 5000000), 0);
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 512, row.data(), 5001536), 0);
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 512, row.data(), 5002048), 1);
+            // streaming, the rows restart with the stream
+            BOOST_REQUIRE(fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW) == 0);
+            sim_psd_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 20;
+            capture.rows_max = 16384 / 512 / 4 + 1;
+            capture.row_buf.resize(capture.rows_max * 1024);
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_psd_capture::callback, &capture, 8, 16384) == 0);
+            BOOST_CHECK(!capture.failed);
+            BOOST_REQUIRE_EQUAL(capture.rows.size(), (size_t)((20 * 16384 - 1024) / 512 + 1) / 4 * 1024);
+            // the +1 MHz tone in bin 512 + 51.2, above everything but the uncorrected dc
+            const size_t tone = 512 + 51;
+            for (size_t r = 0; r < capture.rows.size() / 1024; r++)
+            {
+                const float * db = capture.rows.data() + r * 1024;
+                float peak = FOBOS_PSD_FLOOR_DB;
+                for (size_t k = 0; k < 1024; k++)
+                {
+                    if ((k + 2 < 512) || (k > 512 + 2))
+                    {
+                        peak = std::max(peak, db[k]);
+                    }
+                }
+                BOOST_TEST_INFO("row " << r);
+                BOOST_CHECK_EQUAL(db[tone], peak);
+                BOOST_CHECK(db[tone] > -40.0f);
+            }
+            BOOST_REQUIRE(fobos_rx_set_psd(dev, 0, 0, 0, 0) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_psd(dev, raw.data(), 1024, row.data(), 0), -7);
+            close_sim(dev);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_channels)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 16E6, nullptr) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_set_channels(dev, 12, 0), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_set_channels(dev, 0, 0), -7);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 4) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_set_channels(dev, 16, 0), -7);
+            BOOST_REQUIRE(fobos_rx_set_decimation(dev, 1) == 0);
+            BOOST_REQUIRE(fobos_rx_set_channels(dev, 16, 0) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_set_decimation(dev, 2), -7);
+            std::vector<std::complex<float>> raw(16);
+            std::vector<void *> dst(16, raw.data());
+            BOOST_CHECK_EQUAL(fobos_rx_channelize(dev, raw.data(), nullptr, 1, FOBOS_FORMAT_FC32, 0), -7);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 20;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 65536) == 0);
+            // 16 channels of 1 MHz interleaved, 4096 samples each
+            BOOST_REQUIRE_EQUAL(capture.last.size(), 65536u);
+            std::vector<std::vector<std::complex<float>>> channels(16);
+            for (size_t i = 0; i < capture.last.size(); i++)
+            {
+                channels[i % 16].push_back(capture.last[i]);
+            }
+            // the +1 MHz tone at the center of channel 1, nowhere else
+            double tone = tone_power(channels[1], 0.0);
+            BOOST_CHECK(tone > 1E-4);
+            for (size_t k = 0; k < channels.size(); k++)
+            {
+                if (k != 1)
+                {
+                    BOOST_TEST_INFO("channel " << k);
+                    BOOST_CHECK(tone_power(channels[k], 0.0) < tone * 1E-4);
+                }
+            }
+            BOOST_REQUIRE(fobos_rx_set_channels(dev, 1, 0) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_channelize(dev, raw.data(), dst.data(), 1, FOBOS_FORMAT_FC32, 0), -7);
+            close_sim(dev);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_short_transfers)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            config.short_rate = 0.25;
+            fobos_dev_t * dev = open_sim(config);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 300;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 4, 16384) == 0);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK(stats.rx_failures > 50u);
+            BOOST_CHECK(stats.rx_failures < 200u);
+            BOOST_CHECK(stats.buffers >= 300u);
+            close_sim(dev);
+        }
+        //======================================================================
+        // the first sample index of every buffer, a short transfer leaves a gap of one transfer
+        struct sim_index
+        {
+            fobos_dev_t * dev = nullptr;
+            std::vector<uint64_t> indices;
+
+            static void callback(float *, uint32_t, void * ctx)
+            {
+                sim_index * index = static_cast<sim_index*>(ctx);
+                uint64_t sample = 0;
+                BOOST_CHECK(fobos_rx_get_sample_index(index->dev, &sample) == 0);
+                index->indices.push_back(sample);
+                if (index->indices.size() == 300)
+                {
+                    fobos_rx_cancel_async(index->dev);
+                }
+            }
+        };
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_sample_index)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            config.short_rate = 0.25;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_CHECK_EQUAL(fobos_rx_get_sample_index(dev, nullptr), -7);
+            sim_index index;
+            index.dev = dev;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_index::callback, &index, 4, 16384) == 0);
+            BOOST_REQUIRE(index.indices.size() >= 300u);
+            uint64_t lost = 0;
+            for (size_t i = 1; i < index.indices.size(); i++)
+            {
+                BOOST_REQUIRE(index.indices[i] > index.indices[i - 1]);
+                BOOST_REQUIRE_EQUAL(index.indices[i] % 16384, 0u);
+                lost += (index.indices[i] - index.indices[i - 1]) / 16384 - 1;
+            }
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            // the calibration transfers and the ones after the last buffer do not count
+            BOOST_CHECK(lost > 50u);
+            BOOST_CHECK(lost <= stats.rx_failures);
+            close_sim(dev);
+        }
+        //======================================================================
+        // retunes halfway through the buffers
+        struct sim_record_capture : sim_capture
+        {
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                sim_record_capture * capture = static_cast<sim_record_capture*>(ctx);
+                if (capture->buffers == capture->stop_after / 2)
+                {
+                    fobos_rx_set_frequency(capture->dev, 433E6, nullptr);
+                }
+                sim_capture::callback(buf, buf_length, ctx);
+            }
+        };
+        //======================================================================
+        // short transfers are not recorded: every one a gap annotation and a new capture
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_record)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            config.short_rate = 0.25;
+            fobos_dev_t * dev = open_sim(config);
+            std::string path = (std::filesystem::temp_directory_path() / "qa_fobos_sim_record").string();
+            BOOST_CHECK_EQUAL(fobos_rx_stop_recording(dev), -7);
+            BOOST_CHECK_EQUAL(fobos_rx_start_recording(dev, "", 0, 0.0), -7);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_start_recording(dev, path.c_str(), 0, 0.0) == 0);
+            BOOST_CHECK_EQUAL(fobos_rx_start_recording(dev, path.c_str(), 0, 0.0), -5);
+            sim_record_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 200;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_record_capture::callback, &capture, 4, 16384) == 0);
+            fobos_rx_recording status = {};
+            BOOST_REQUIRE(fobos_rx_get_recording(dev, &status) == 0);
+            BOOST_CHECK(status.active);
+            BOOST_REQUIRE(fobos_rx_stop_recording(dev) == 0);
+            BOOST_REQUIRE(fobos_rx_get_recording(dev, &status) == 0);
+            BOOST_CHECK(!status.active);
+            BOOST_CHECK_EQUAL(status.error, 0);
+            BOOST_CHECK_EQUAL(status.dropped, 0u);
+            BOOST_CHECK(status.transfers >= 200u);
+            BOOST_CHECK_EQUAL(status.bytes, status.transfers * 16384 * 4);
+            BOOST_CHECK_EQUAL(status.written, status.bytes);
+            BOOST_CHECK(status.gaps > 20u);
+            BOOST_CHECK(status.captures > status.gaps);
+            std::ifstream data(path + ".sigmf-data", std::ios::binary | std::ios::ate);
+            BOOST_CHECK_EQUAL((uint64_t)data.tellg(), status.bytes);
+            std::ifstream file(path + ".sigmf-meta");
+            std::string meta((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            size_t lost = 0;
+            for (size_t pos = meta.find("\"fobos:lost_samples\""); pos != std::string::npos; pos = meta.find("\"fobos:lost_samples\"", pos + 1))
+            {
+                lost++;
+            }
+            BOOST_CHECK_EQUAL(lost, status.gaps);
+            // the lo of every capture, the first ones before the retune, the last ones after it
+            std::vector<double> lo;
+            const std::string key = "\"core:frequency\": ";
+            for (size_t pos = meta.find(key); pos != std::string::npos; pos = meta.find(key, pos + 1))
+            {
+                lo.push_back(std::stod(meta.substr(pos + key.size())));
+            }
+            BOOST_REQUIRE_EQUAL(lo.size(), status.captures);
+            BOOST_CHECK(std::abs(lo.front() - 100E6) < 5E6);
+            BOOST_CHECK(std::abs(lo.back() - 433E6) < 5E6);
+            BOOST_CHECK(meta.find("\"core:hw\": \"") != std::string::npos);
+            data.close();
+            std::remove((path + ".sigmf-data").c_str());
+            std::remove((path + ".sigmf-meta").c_str());
+            close_sim(dev);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_device_loss)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.realtime = 0;
+            config.lost_after = 50;
+            fobos_dev_t * dev = open_sim(config);
+            sim_capture capture;
+            capture.dev = dev;
+            // read_async() returns on its own once the device is gone
+            fobos_rx_read_async(dev, sim_capture::callback, &capture, 8, 16384);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.buffers, 50u);
+            BOOST_CHECK(stats.transfer_errors > 0u);
+            close_sim(dev);
+        }
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_realtime)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            config.jitter_us = 200.0;
+            fobos_dev_t * dev = open_sim(config);
+            double samplerate = 0.0;
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 50E6, &samplerate) == 0);
+            sim_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 100;
+            auto t0 = std::chrono::steady_clock::now();
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_capture::callback, &capture, 16, 131072) == 0);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            double expected = (100 + 4) * 131072 / samplerate;
+            BOOST_CHECK(elapsed > expected * 0.95);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            // 2.6 ms transfers, the jitter shows up in the interval histogram
+            BOOST_CHECK(stats.usb_interval.max_us > 2621u);
+            close_sim(dev);
+        }
+        //======================================================================
+        // the workers convert out of order, the tone phase runs on across every buffer edge
+        struct sim_sequence
+        {
+            fobos_dev_t * dev = nullptr;
+            uint32_t buffers = 0;
+            int busy_result = 0;
+            std::vector<std::complex<float>> samples;
+            std::vector<size_t> edges;
+            uint32_t index_errors = 0;
+
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                sim_sequence * sequence = static_cast<sim_sequence*>(ctx);
+                const std::complex<float> * samples = reinterpret_cast<const std::complex<float>*>(buf);
+                sequence->busy_result = fobos_rx_set_workers(sequence->dev, 2);
+                uint64_t sample = 0;
+                fobos_rx_get_sample_index(sequence->dev, &sample);
+                sequence->index_errors += sample != sequence->samples.size();
+                sequence->edges.push_back(sequence->samples.size());
+                sequence->samples.insert(sequence->samples.end(), samples, samples + buf_length);
+                if (++sequence->buffers == 64)
+                {
+                    fobos_rx_cancel_async(sequence->dev);
+                }
+            }
+        };
+        //======================================================================
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_workers)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            // in real time, as fast as possible outruns the consumer and drops transfers
+            config.noise_level = 0.0;
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_CHECK_EQUAL(fobos_rx_set_workers(dev, 17), -7);
+            BOOST_REQUIRE_EQUAL(fobos_rx_set_workers(dev, 4), 0);
+            double samplerate = 0.0;
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, &samplerate) == 0);
+            sim_sequence sequence;
+            sequence.dev = dev;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, sim_sequence::callback, &sequence, 8, 16384) == 0);
+            BOOST_CHECK_EQUAL(sequence.busy_result, -5);
+            BOOST_REQUIRE(sequence.buffers >= 64u);
+            // skip the first buffers, the estimator still settles there
+            const double step = 2.0 * M_PI * config.tone_hz[0] / samplerate;
+            uint32_t jumps = 0;
+            for (size_t i = 8; i < sequence.edges.size(); i++)
+            {
+                size_t n = sequence.edges[i];
+                double delta = std::arg(sequence.samples[n] * std::conj(sequence.samples[n - 1]));
+                jumps += std::fabs(delta - step) > 0.05;
+            }
+            BOOST_CHECK_EQUAL(jumps, 0u);
+            BOOST_CHECK_EQUAL(sequence.index_errors, 0u);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.worker_drops, 0u);
+            BOOST_CHECK_EQUAL(stats.resubmit_errors, 0u);
+            BOOST_CHECK_EQUAL(stats.buffer_time.count, (uint64_t)sequence.buffers);
+            close_sim(dev);
+        }
+        //======================================================================
+        // the consumer of a raw stream splits its conversion over the workers, every part
+        // converts as it would in one piece, the mixer phase follows the sample index
+        BOOST_AUTO_TEST_CASE(test_fobos_sim_raw_workers)
+        {
+            fobos_sim_config config;
+            fobos_sim_config_init(&config);
+            fobos_dev_t * dev = open_sim(config);
+            BOOST_REQUIRE(fobos_rx_set_samplerate(dev, 20E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            BOOST_REQUIRE(fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW) == 0);
+            // not a multiple of the parts
+            const uint32_t count = 65536 + 13;
+            std::vector<int16_t> raw(2 * count);
+            uint32_t seed = 1;
+            for (int16_t & value : raw)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                value = (int16_t)((seed >> 16) & 0x3FFF);
+            }
+            const uint64_t sample = 123457;
+            for (int mixing = 0; mixing < 2; mixing++)
+            {
+                BOOST_REQUIRE(fobos_rx_set_if_offset(dev, mixing ? 2E6 : 0.0) == 0);
+                for (int format : { FOBOS_FORMAT_FC32, FOBOS_FORMAT_SC16 })
+                {
+                    // bytes, sc16 pairs read as float may be nan
+                    std::vector<uint8_t> single(count * sizeof(std::complex<float>));
+                    std::vector<uint8_t> split(single.size());
+                    BOOST_REQUIRE(fobos_rx_set_workers(dev, 0) == 0);
+                    BOOST_REQUIRE_EQUAL(fobos_rx_decimate(dev, raw.data(), single.data(), count, format, sample), (int)count);
+                    BOOST_REQUIRE(fobos_rx_set_workers(dev, 4) == 0);
+                    BOOST_REQUIRE_EQUAL(fobos_rx_decimate(dev, raw.data(), split.data(), count, format, sample), (int)count);
+                    BOOST_CHECK(single == split);
+                    if (!mixing)
+                    {
+                        std::fill(split.begin(), split.end(), 0);
+                        BOOST_REQUIRE(fobos_rx_convert(dev, raw.data(), split.data(), count, format) == 0);
+                        BOOST_CHECK(single == split);
+                    }
+                }
+            }
+            BOOST_REQUIRE(fobos_rx_set_workers(dev, 0) == 0);
+            close_sim(dev);
+        }
+        //======================================================================
+    } /* namespace RigExpert */
+} /* namespace gr */
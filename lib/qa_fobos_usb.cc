@@ -0,0 +1,356 @@
+//==============================================================================
+//       _____     __           _______
+//      /  __  \  /_/          /  ____/                                __
+//     /  /_ / / _   ____     / /__  __  __   ____    ____    ____   _/ /_
+//    /    __ / / / /  _  \  / ___/  \ \/ /  / __ \  / __ \  / ___\ /  _/
+//   /  /\ \   / / /  /_/ / / /___   /   /  / /_/ / /  ___/ / /     / /_
+//  /_ /  \_\ /_/  \__   / /______/ /_/\_\ / ____/  \____/ /_/      \___/
+//               /______/                 /_/
+//  Fobos SDR API library
+//  Copyright (C) Rig Expert Ukraine Ltd.
+//==============================================================================
+// the libusb transport of the driver against a libusb stub defined here: the test
+// is built with the driver sources, not with gnuradio-RigExpert and the real libusb
+#include <fobos/fobos.h>
+#include <libusb-1.0/libusb.h>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// one Fobos on the bus, bulk transfers complete at once with a counting pattern
+namespace
+{
+    struct usb_stub
+    {
+        int contexts = 0;                   // libusb_init() minus libusb_exit()
+        int opened = 0;
+        int claimed = 0;
+        int controls = 0;
+        int handle_events = 0;
+        libusb_context * events_ctx = nullptr;
+        int transfers = 0;                  // allocated minus freed
+        uint16_t gpo = 0;
+        int streaming = 0;                  // the last 0xE1 request
+        uint32_t word = 0;                  // next value of the pattern
+        uint16_t max2830[16] = {};          // as the chips got them
+        uint16_t rffc507x[31] = {};
+        uint8_t fail_request = 0;           // fails the next fail_count requests of this code
+        int fail_count = 0;
+        std::deque<libusb_transfer *> queue;
+        std::set<libusb_transfer *> cancelled;
+    };
+    usb_stub stub;
+    int stub_context;
+    int stub_device;
+    int stub_handle;
+    libusb_device * stub_list[1] = { reinterpret_cast<libusb_device *>(&stub_device) };
+}
+//==============================================================================
+extern "C"
+{
+    int LIBUSB_CALL libusb_init(libusb_context ** ctx)
+    {
+        stub.contexts++;
+        *ctx = reinterpret_cast<libusb_context *>(&stub_context);
+        return 0;
+    }
+
+    void LIBUSB_CALL libusb_exit(libusb_context * ctx)
+    {
+        (void)ctx;
+        stub.contexts--;
+    }
+
+    ssize_t LIBUSB_CALL libusb_get_device_list(libusb_context * ctx, libusb_device *** list)
+    {
+        (void)ctx;
+        *list = stub_list;
+        return 1;
+    }
+
+    void LIBUSB_CALL libusb_free_device_list(libusb_device ** list, int unref_devices)
+    {
+        (void)list;
+        (void)unref_devices;
+    }
+
+    int LIBUSB_CALL libusb_get_device_descriptor(libusb_device * dev, struct libusb_device_descriptor * desc)
+    {
+        (void)dev;
+        memset(desc, 0, sizeof(*desc));
+        desc->idVendor = 0x16d0;
+        desc->idProduct = 0x132e;
+        desc->iSerialNumber = 3;
+        return 0;
+    }
+
+    int LIBUSB_CALL libusb_open(libusb_device * dev, libusb_device_handle ** dev_handle)
+    {
+        (void)dev;
+        stub.opened++;
+        *dev_handle = reinterpret_cast<libusb_device_handle *>(&stub_handle);
+        return 0;
+    }
+
+    void LIBUSB_CALL libusb_close(libusb_device_handle * dev_handle)
+    {
+        (void)dev_handle;
+        stub.opened--;
+    }
+
+    int LIBUSB_CALL libusb_claim_interface(libusb_device_handle * dev_handle, int interface_number)
+    {
+        (void)dev_handle;
+        (void)interface_number;
+        stub.claimed++;
+        return 0;
+    }
+
+    int LIBUSB_CALL libusb_get_string_descriptor_ascii(libusb_device_handle * dev_handle, uint8_t desc_index, unsigned char * data, int length)
+    {
+        (void)dev_handle;
+        const char * text = (desc_index == 3) ? "USBSTUB" : "";
+        strncpy(reinterpret_cast<char *>(data), text, length);
+        return (int)strlen(text);
+    }
+
+    int LIBUSB_CALL libusb_control_transfer(libusb_device_handle * dev_handle, uint8_t request_type, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned char * data, uint16_t wLength, unsigned int timeout)
+    {
+        (void)dev_handle;
+        (void)wIndex;
+        (void)timeout;
+        stub.controls++;
+        if ((bRequest == stub.fail_request) && (stub.fail_count > 0))
+        {
+            stub.fail_count--;
+            return LIBUSB_ERROR_IO;
+        }
+        if ((bRequest == 0xE5) && data && (wLength == 3))
+        {
+            stub.max2830[data[0] & 0x0F] = data[1] | (data[2] << 8);
+        }
+        if ((bRequest == 0xE6) && data && (wLength == 3) && (data[0] < 31))
+        {
+            stub.rffc507x[data[0]] = data[1] | (data[2] << 8);
+        }
+        if (bRequest == 0xE1)
+        {
+            stub.streaming = wValue;
+        }
+        if (bRequest == 0xE4)
+        {
+            stub.gpo = wValue;
+        }
+        if ((request_type & LIBUSB_ENDPOINT_IN) && data)
+        {
+            memset(data, 0, wLength);
+        }
+        return wLength;
+    }
+
+    struct libusb_transfer * LIBUSB_CALL libusb_alloc_transfer(int iso_packets)
+    {
+        (void)iso_packets;
+        stub.transfers++;
+        return static_cast<libusb_transfer *>(calloc(1, sizeof(libusb_transfer)));
+    }
+
+    void LIBUSB_CALL libusb_free_transfer(struct libusb_transfer * transfer)
+    {
+        stub.transfers--;
+        free(transfer);
+    }
+
+    int LIBUSB_CALL libusb_submit_transfer(struct libusb_transfer * transfer)
+    {
+        stub.queue.push_back(transfer);
+        return 0;
+    }
+
+    int LIBUSB_CALL libusb_cancel_transfer(struct libusb_transfer * transfer)
+    {
+        for (libusb_transfer * queued : stub.queue)
+        {
+            if (queued == transfer)
+            {
+                stub.cancelled.insert(transfer);
+                return 0;
+            }
+        }
+        return LIBUSB_ERROR_NOT_FOUND;
+    }
+
+    // completes the cancelled transfers, otherwise the oldest one
+    int LIBUSB_CALL libusb_handle_events_timeout_completed(libusb_context * ctx, struct timeval * tv, int * completed)
+    {
+        (void)tv;
+        stub.handle_events++;
+        stub.events_ctx = ctx;
+        if ((completed && *completed) || stub.queue.empty())
+        {
+            return 0;
+        }
+        if (!stub.cancelled.empty())
+        {
+            std::deque<libusb_transfer *> queue;
+            queue.swap(stub.queue);
+            for (libusb_transfer * transfer : queue)
+            {
+                if (stub.cancelled.erase(transfer))
+                {
+                    transfer->status = LIBUSB_TRANSFER_CANCELLED;
+                    transfer->actual_length = 0;
+                    transfer->callback(transfer);
+                }
+                else
+                {
+                    stub.queue.push_back(transfer);
+                }
+            }
+            return 0;
+        }
+        libusb_transfer * transfer = stub.queue.front();
+        stub.queue.pop_front();
+        uint16_t * words = reinterpret_cast<uint16_t *>(transfer->buffer);
+        for (int i = 0; i < transfer->length / 2; i++)
+        {
+            words[i] = (uint16_t)(stub.word++ & 0x3FFF);
+        }
+        transfer->status = LIBUSB_TRANSFER_COMPLETED;
+        transfer->actual_length = transfer->length;
+        transfer->callback(transfer);
+        return 0;
+    }
+
+    unsigned char * LIBUSB_CALL libusb_dev_mem_alloc(libusb_device_handle * dev_handle, size_t length)
+    {
+        (void)dev_handle;
+        (void)length;
+        return nullptr;
+    }
+
+    int LIBUSB_CALL libusb_dev_mem_free(libusb_device_handle * dev_handle, unsigned char * buffer, size_t length)
+    {
+        (void)dev_handle;
+        (void)buffer;
+        (void)length;
+        return 0;
+    }
+}
+
+namespace gr
+{
+    namespace RigExpert
+    {
+        //======================================================================
+        // the raw buffers handed to the callback, cancelled after stop_after of them
+        struct usb_capture
+        {
+            fobos_dev_t * dev = nullptr;
+            uint32_t buffers = 0;
+            uint32_t stop_after = 0;
+            std::vector<uint16_t> words;
+
+            static void callback(float * buf, uint32_t buf_length, void * ctx)
+            {
+                usb_capture * capture = static_cast<usb_capture*>(ctx);
+                const uint16_t * words = reinterpret_cast<const uint16_t*>(buf);
+                capture->words.insert(capture->words.end(), words, words + buf_length * 2);
+                if (++capture->buffers == capture->stop_after)
+                {
+                    fobos_rx_cancel_async(capture->dev);
+                }
+            }
+        };
+        //======================================================================
+        static fobos_dev_t * open_usb()
+        {
+            fobos_sim_enable(nullptr);
+            stub = usb_stub();
+            BOOST_REQUIRE_EQUAL(fobos_rx_get_device_count(), 1);
+            BOOST_REQUIRE_EQUAL(stub.contexts, 0);
+            fobos_dev_t * dev = nullptr;
+            BOOST_REQUIRE(fobos_rx_open(&dev, 0) == 0);
+            return dev;
+        }
+        //======================================================================
+        // open, the initial register writes go out as control transfers, close releases it all
+        BOOST_AUTO_TEST_CASE(test_fobos_usb_open)
+        {
+            fobos_dev_t * dev = open_usb();
+            BOOST_CHECK_EQUAL(stub.contexts, 1);
+            BOOST_CHECK_EQUAL(stub.opened, 1);
+            BOOST_CHECK_EQUAL(stub.claimed, 1);
+            BOOST_CHECK(stub.controls > 0);
+            char serial[256];
+            BOOST_REQUIRE(fobos_rx_get_board_info(dev, nullptr, nullptr, nullptr, nullptr, serial) == 0);
+            BOOST_CHECK_EQUAL(std::string(serial), "USBSTUB");
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            BOOST_CHECK_EQUAL(stub.contexts, 0);
+            BOOST_CHECK_EQUAL(stub.opened, 0);
+        }
+        //======================================================================
+        // a register write that failed is not taken as written, tuning to the same
+        // frequency again brings both synthesizers to it
+        BOOST_AUTO_TEST_CASE(test_fobos_usb_failed_write)
+        {
+            fobos_dev_t * dev = open_usb();
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+            usb_stub tuned = stub;
+            BOOST_REQUIRE(fobos_rx_set_frequency(dev, 102E6, nullptr) == 0);
+            BOOST_REQUIRE(memcmp(stub.max2830, tuned.max2830, sizeof(stub.max2830)) != 0);
+            BOOST_REQUIRE(memcmp(stub.rffc507x, tuned.rffc507x, sizeof(stub.rffc507x)) != 0);
+            for (uint8_t request : { 0xE5, 0xE6 })
+            {
+                stub.fail_request = request;
+                stub.fail_count = 1000;
+                fobos_rx_set_frequency(dev, 100E6, nullptr);
+                stub.fail_count = 0;
+                BOOST_REQUIRE(fobos_rx_set_frequency(dev, 100E6, nullptr) == 0);
+                BOOST_CHECK(memcmp(stub.max2830, tuned.max2830, sizeof(stub.max2830)) == 0);
+                BOOST_CHECK(memcmp(stub.rffc507x, tuned.rffc507x, sizeof(stub.rffc507x)) == 0);
+                BOOST_REQUIRE(fobos_rx_set_frequency(dev, 102E6, nullptr) == 0);
+            }
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+        }
+        //======================================================================
+        // the event loop reaches libusb with the device context, every sample arrives in
+        // order after the calibration transfers, cancel hands back and frees every transfer
+        BOOST_AUTO_TEST_CASE(test_fobos_usb_stream)
+        {
+            const uint32_t transfer_samples = 16384;
+            fobos_dev_t * dev = open_usb();
+            BOOST_REQUIRE(fobos_rx_set_sample_format(dev, FOBOS_FORMAT_RAW) == 0);
+            usb_capture capture;
+            capture.dev = dev;
+            capture.stop_after = 20;
+            BOOST_REQUIRE(fobos_rx_read_async(dev, usb_capture::callback, &capture, 4, transfer_samples) == 0);
+            BOOST_CHECK_EQUAL(capture.buffers, 20u);
+            BOOST_CHECK(stub.handle_events >= 20);
+            BOOST_CHECK(stub.events_ctx != nullptr);
+            BOOST_CHECK_EQUAL(stub.streaming, 0);
+            BOOST_CHECK(stub.queue.empty());
+            BOOST_CHECK_EQUAL(stub.transfers, 0);
+            BOOST_REQUIRE_EQUAL(capture.words.size(), 20u * transfer_samples * 2);
+            // the first 4 transfers went to the calibration
+            uint32_t word = 4 * transfer_samples * 2;
+            size_t mismatches = 0;
+            for (uint16_t value : capture.words)
+            {
+                mismatches += value != (word++ & 0x3FFF);
+            }
+            BOOST_CHECK_EQUAL(mismatches, 0u);
+            fobos_rx_stats stats;
+            BOOST_REQUIRE(fobos_rx_get_stats(dev, &stats) == 0);
+            BOOST_CHECK_EQUAL(stats.resubmit_errors, 0u);
+            BOOST_CHECK(fobos_rx_close(dev) == 0);
+            BOOST_CHECK_EQUAL(stub.contexts, 0);
+        }
+    } /* namespace RigExpert */
+} /* namespace gr */
@@ -34,6 +34,12 @@
  static const char *__doc_gr_RigExpert_fobos_sdr_set_samplerate = R"doc()doc";
 
 
+ static const char *__doc_gr_RigExpert_fobos_sdr_set_if_offset = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sdr_set_auto_if = R"doc()doc";
+
+
  static const char *__doc_gr_RigExpert_fobos_sdr_set_lna_gain = R"doc()doc";
 
 
@@ -45,3 +51,9 @@
 
 static const char *__doc_gr_RigExpert_fobos_sdr_set_clock_source = R"doc()doc";
 
+
+ static const char *__doc_gr_RigExpert_fobos_sdr_get_stats = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sdr_reset_stats = R"doc()doc";
+
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+#include "pydoc_macros.h"
+#define D(...) DOC(gr,RigExpert, __VA_ARGS__ )
+/*
+  This file contains placeholders for docstrings for the Python bindings.
+  Do not edit! These were automatically extracted during the binding process
+  and will be overwritten during the build process
+ */
+
+
+ 
+ static const char *__doc_gr_RigExpert_fobos_sweep = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_fobos_sweep_0 = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_fobos_sweep_1 = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_make = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_bins = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_start_frequency = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_bin_width = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_set_lna_gain = R"doc()doc";
+
+
+ static const char *__doc_gr_RigExpert_fobos_sweep_set_vga_gain = R"doc()doc";
+
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(fobos_replay.h)                                     */
+/* BINDTOOL_HEADER_FILE_HASH(d8740c1b4953888c28aac0178e62578d)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/RigExpert/fobos_replay.h>
+// pydoc.h is automatically generated in the build directory
+#include <fobos_replay_pydoc.h>
+
+void bind_fobos_replay(py::module& m)
+{
+
+    using fobos_replay    = ::gr::RigExpert::fobos_replay;
+
+
+    py::class_<fobos_replay, gr::RigExpert::fobos_sdr, gr::block, gr::basic_block,
+        std::shared_ptr<fobos_replay>>(m, "fobos_replay", D(fobos_replay))
+
+        .def(py::init(&fobos_replay::make),
+           py::arg("path") = "",
+           py::arg("format") = 0,
+           py::arg("samplerate") = 0.0,
+           py::arg("frequency") = 0.0,
+           py::arg("paced") = true,
+           py::arg("repeat") = false,
+           py::arg("output_type") = 0,
+           py::arg("latency_ms") = 10.0,
+           py::arg("headroom_ms") = 250.0,
+           py::arg("stats_interval_ms") = 0.0,
+           py::arg("usb_cpu") = -1,
+           py::arg("work_cpu") = -1,
+           py::arg("rt_priority") = 0,
+           py::arg("busy_poll") = false,
+           py::arg("decimation") = 1,
+           py::arg("if_offset") = 0.0,
+           py::arg("auto_if") = false,
+           py::arg("channels") = 1,
+           py::arg("oversample") = false,
+           py::arg("psd_size") = 0,
+           py::arg("psd_window") = 2,
+           py::arg("psd_overlap") = 0.5,
+           py::arg("psd_averages") = 16,
+           py::arg("iq_output") = true,
+           D(fobos_replay,make)
+        )
+        ;
+}
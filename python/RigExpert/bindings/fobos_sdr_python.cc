@@ -14,7 +14,7 @@
 /* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
 /* BINDTOOL_USE_PYGCCXML(0)                                                        */
 /* BINDTOOL_HEADER_FILE(fobos_sdr.h)                                        */
-/* BINDTOOL_HEADER_FILE_HASH(f06b7121ccf4e00c9fa9af4432643237)                     */
+/* BINDTOOL_HEADER_FILE_HASH(f99a717dc39c4df0af5dc540acd474ba)                     */
 /***********************************************************************************/
 
 #include <pybind11/complex.h>
@@ -33,7 +33,7 @@ void bind_fobos_sdr(py::module& m)
     using fobos_sdr    = ::gr::RigExpert::fobos_sdr;
 
 
-    py::class_<fobos_sdr, gr::sync_block, gr::block, gr::basic_block,
+    py::class_<fobos_sdr, gr::block, gr::basic_block,
         std::shared_ptr<fobos_sdr>>(m, "fobos_sdr", D(fobos_sdr))
 
         .def(py::init(&fobos_sdr::make),
@@ -44,6 +44,31 @@ void bind_fobos_sdr(py::module& m)
            py::arg("vga_gain") = 0,
            py::arg("direct_sampling") = 0,
            py::arg("clock_source") = 0,
+           py::arg("output_type") = 0,
+           py::arg("latency_ms") = 10.0,
+           py::arg("headroom_ms") = 250.0,
+           py::arg("stats_interval_ms") = 0.0,
+           py::arg("usb_cpu") = -1,
+           py::arg("work_cpu") = -1,
+           py::arg("rt_priority") = 0,
+           py::arg("busy_poll") = false,
+           py::arg("decimation") = 1,
+           py::arg("if_offset") = 0.0,
+           py::arg("auto_if") = false,
+           py::arg("channels") = 1,
+           py::arg("oversample") = false,
+           py::arg("psd_size") = 0,
+           py::arg("psd_window") = 2,
+           py::arg("psd_overlap") = 0.5,
+           py::arg("psd_averages") = 16,
+           py::arg("iq_output") = true,
+           py::arg("record_path") = "",
+           py::arg("record_prealloc_mb") = 0,
+           py::arg("history_s") = 0.0,
+           py::arg("snapshot_pre_s") = 1.0,
+           py::arg("snapshot_post_s") = 1.0,
+           py::arg("snapshot_path") = "fobos_snapshot",
+           py::arg("workers") = 0,
            D(fobos_sdr,make)
         )
         
@@ -57,6 +82,16 @@ void bind_fobos_sdr(py::module& m)
             D(fobos_sdr,set_samplerate)
         )
 
+        .def("set_if_offset",&fobos_sdr::set_if_offset,
+            py::arg("if_offset"),
+            D(fobos_sdr,set_if_offset)
+        )
+
+        .def("set_auto_if",&fobos_sdr::set_auto_if,
+            py::arg("auto_if"),
+            D(fobos_sdr,set_auto_if)
+        )
+
         .def("set_lna_gain",&fobos_sdr::set_lna_gain,       
             py::arg("lna_gain"),
             D(fobos_sdr,set_lna_gain)
@@ -74,7 +109,32 @@ void bind_fobos_sdr(py::module& m)
         .def("set_clock_source",&fobos_sdr::set_clock_source,       
             py::arg("clock_source"),
             D(fobos_sdr,set_clock_source)
-        )        
+        )
+
+        .def("get_stats",&fobos_sdr::get_stats,
+            D(fobos_sdr,get_stats)
+        )
+
+        .def("prepare_frequencies",&fobos_sdr::prepare_frequencies,
+            py::arg("frequencies_mhz"),
+            D(fobos_sdr,prepare_frequencies)
+        )
+
+        .def("set_hops",&fobos_sdr::set_hops,
+            py::arg("frequencies_mhz"),
+            py::arg("dwell_samples"),
+            py::arg("settle_samples"),
+            D(fobos_sdr,set_hops)
+        )
+
+        .def("set_record_path",&fobos_sdr::set_record_path,
+            py::arg("path"),
+            D(fobos_sdr,set_record_path)
+        )
+
+        .def("reset_stats",&fobos_sdr::reset_stats,
+            D(fobos_sdr,reset_stats)
+        )
         ;
 
 
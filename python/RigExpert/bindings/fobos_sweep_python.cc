@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(fobos_sweep.h)                                      */
+/* BINDTOOL_HEADER_FILE_HASH(810e1830d551b57ed886835667ee6b90)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/RigExpert/fobos_sweep.h>
+// pydoc.h is automatically generated in the build directory
+#include <fobos_sweep_pydoc.h>
+
+void bind_fobos_sweep(py::module& m)
+{
+
+    using fobos_sweep    = ::gr::RigExpert::fobos_sweep;
+
+
+    py::class_<fobos_sweep, gr::sync_block, gr::block, gr::basic_block,
+        std::shared_ptr<fobos_sweep>>(m, "fobos_sweep", D(fobos_sweep))
+
+        .def(py::init(&fobos_sweep::make),
+           py::arg("index") = 0,
+           py::arg("start") = 50.0,
+           py::arg("stop") = 6000.0,
+           py::arg("samplerate") = 20.0,
+           py::arg("fft_size") = 1024,
+           py::arg("window") = 2,
+           py::arg("averages") = 4,
+           py::arg("settle") = 2000,
+           py::arg("usable") = 0.75,
+           py::arg("lna_gain") = 0,
+           py::arg("vga_gain") = 0,
+           D(fobos_sweep,make)
+        )
+
+        .def("bins",&fobos_sweep::bins,
+            D(fobos_sweep,bins)
+        )
+
+        .def("start_frequency",&fobos_sweep::start_frequency,
+            D(fobos_sweep,start_frequency)
+        )
+
+        .def("bin_width",&fobos_sweep::bin_width,
+            D(fobos_sweep,bin_width)
+        )
+
+        .def("set_lna_gain",&fobos_sweep::set_lna_gain,
+            py::arg("lna_gain"),
+            D(fobos_sweep,set_lna_gain)
+        )
+
+        .def("set_vga_gain",&fobos_sweep::set_vga_gain,
+            py::arg("vga_gain"),
+            D(fobos_sweep,set_vga_gain)
+        )
+        ;
+}
@@ -22,6 +22,8 @@ namespace py = pybind11;
 /**************************************/
 // BINDING_FUNCTION_PROTOTYPES(
     void bind_fobos_sdr(py::module& m);
+    void bind_fobos_replay(py::module& m);
+    void bind_fobos_sweep(py::module& m);
 // ) END BINDING_FUNCTION_PROTOTYPES
 
 
@@ -51,5 +53,7 @@ PYBIND11_MODULE(RigExpert_python, m)
     /**************************************/
     // BINDING_FUNCTION_CALLS(
     bind_fobos_sdr(m);
+    bind_fobos_replay(m);
+    bind_fobos_sweep(m);
     // ) END BINDING_FUNCTION_CALLS
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright 2024 RigExpert.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+
+import array
+import cmath
+import os
+import tempfile
+
+import pmt
+from gnuradio import gr, gr_unittest
+from gnuradio import blocks
+try:
+  from gnuradio.RigExpert import fobos_replay
+except ImportError:
+    import os
+    import sys
+    dirname, filename = os.path.split(os.path.abspath(__file__))
+    sys.path.append(os.path.join(dirname, "bindings"))
+    from gnuradio.RigExpert import fobos_replay
+
+class qa_fobos_replay(gr_unittest.TestCase):
+
+    def setUp(self):
+        self.tb = gr.top_block()
+        self.path = os.path.join(tempfile.gettempdir(), "qa_fobos_replay.cf32")
+
+    def tearDown(self):
+        self.tb = None
+        if os.path.exists(self.path):
+            os.remove(self.path)
+
+    def test_001_unpaced_to_the_end(self):
+        # 10 ms transfers at 10 MS/s: 99968 samples, three of them and a tail
+        transfer = 99968
+        samples = 3 * transfer + 500
+        tone = array.array("f")
+        for n in range(samples):
+            x = cmath.rect(0.125, 2.0 * cmath.pi * (n % 8) / 8.0)
+            tone.extend((x.real, x.imag))
+        with open(self.path, "wb") as f:
+            tone.tofile(f)
+        src = fobos_replay(self.path, 0, 10.0, 100.0, paced=False)
+        sink = blocks.vector_sink_c()
+        self.tb.connect(src, sink)
+        # done on its own at the end of the file
+        self.tb.run()
+        data = sink.data()
+        self.assertEqual(len(data), 3 * transfer)
+        # the tone turns by +pi/4 a sample at its level
+        for n in range(1000, 1100):
+            self.assertAlmostEqual(abs(data[n]), 0.125, 2)
+            self.assertAlmostEqual(cmath.phase(data[n + 1] * data[n].conjugate()), cmath.pi / 4, 2)
+        keys = [pmt.symbol_to_string(tag.key) for tag in sink.tags()]
+        self.assertIn("rx_rate", keys)
+        stats = pmt.to_python(src.get_stats())
+        self.assertEqual(stats["overruns"], 0)
+        self.assertEqual(stats["replay_samples"], samples)
+        self.assertEqual(stats["replay_position"], 3 * transfer)
+
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_fobos_replay)
@@ -6,8 +6,15 @@
 # SPDX-License-Identifier: GPL-3.0-or-later
 #
 
+import os
+# hardware free: fobos_rx_open() gets the simulated device (fobos/fobos_sim.c)
+os.environ.setdefault("FOBOS_SIM", "1")
+
+import tempfile
+import time
+import pmt
 from gnuradio import gr, gr_unittest
-# from gnuradio import blocks
+from gnuradio import blocks
 try:
   from gnuradio.RigExpert import fobos_sdr
 except ImportError:
@@ -34,6 +41,64 @@ class qa_fobos_sdr(gr_unittest.TestCase):
         self.tb.run()
         # check data
 
+    def test_002_simulated_stream(self):
+        count = 1000000
+        src = fobos_sdr(0, 100.0, 10.0)
+        head = blocks.head(gr.sizeof_gr_complex, count)
+        sink = blocks.vector_sink_c()
+        self.tb.connect(src, head, sink)
+        self.tb.run()
+        data = sink.data()
+        self.assertEqual(len(data), count)
+        # the simulator default is a -20 dBFS tone plus noise around a removed dc
+        mean = sum(data[-100000:]) / 100000
+        self.assertLess(abs(mean), 1e-3)
+        stats = pmt.to_python(src.get_stats())
+        self.assertGreater(stats["buffers"], 0)
+        self.assertEqual(stats["rx_failures"], 0)
+
+    def test_003_simulated_psd(self):
+        size = 1024
+        src = fobos_sdr(0, 100.0, 10.0, psd_size=size, psd_window=2, psd_overlap=0.5, psd_averages=4)
+        iq_head = blocks.head(gr.sizeof_gr_complex, 1000000)
+        iq_sink = blocks.null_sink(gr.sizeof_gr_complex)
+        rows = blocks.stream_to_vector(gr.sizeof_float, size)
+        head = blocks.head(gr.sizeof_float * size, 8)
+        sink = blocks.vector_sink_f(size)
+        self.tb.connect((src, 0), iq_head, iq_sink)
+        self.tb.connect((src, 1), rows, head, sink)
+        self.tb.run()
+        data = sink.data()
+        self.assertEqual(len(data), 8 * size)
+        # dc in the middle, the simulator tone 1 MHz above it
+        row = data[-size:]
+        tone = size // 2 + int(round(1e6 / (10e6 / size)))
+        peak = max(range(size), key=lambda k: row[k] if abs(k - size // 2) > 2 else -1000.0)
+        self.assertLessEqual(abs(peak - tone), 1)
+        keys = [pmt.symbol_to_string(tag.key) for tag in sink.tags()]
+        self.assertEqual(keys.count("psd_row"), 8)
+
+    def test_004_simulated_snapshot(self):
+        path = os.path.join(tempfile.gettempdir(), "qa_fobos_sdr_snapshot")
+        src = fobos_sdr(0, 100.0, 10.0, history_s=0.2)
+        head = blocks.head(gr.sizeof_gr_complex, 2000000)
+        sink = blocks.null_sink(gr.sizeof_gr_complex)
+        self.tb.connect(src, head, sink)
+        # 50 ms from the stream start on, written while it goes on
+        src.to_basic_block()._post(pmt.intern("trigger"), pmt.to_pmt({"path": path, "pre": 0.0, "post": 0.05}))
+        self.tb.run()
+        for _ in range(1000):
+            stats = pmt.to_python(src.get_stats())
+            if not stats["snapshot_active"]:
+                break
+            time.sleep(0.01)
+        self.assertEqual(stats["snapshots"], 1)
+        self.assertEqual(stats["snapshot_error"], 0)
+        self.assertEqual(stats["snapshot_samples"], 500000)
+        self.assertEqual(os.path.getsize(path + ".sigmf-data"), 500000 * 4)
+        os.remove(path + ".sigmf-data")
+        os.remove(path + ".sigmf-meta")
+
 
 if __name__ == '__main__':
     gr_unittest.run(qa_fobos_sdr)
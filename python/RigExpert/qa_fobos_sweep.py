@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright 2024 RigExpert.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+
+import os
+# hardware free: fobos_rx_open() gets the simulated device (fobos/fobos_sim.c)
+os.environ.setdefault("FOBOS_SIM", "1")
+
+import pmt
+from gnuradio import gr, gr_unittest
+from gnuradio import blocks
+try:
+  from gnuradio.RigExpert import fobos_sweep
+except ImportError:
+    import os
+    import sys
+    dirname, filename = os.path.split(os.path.abspath(__file__))
+    sys.path.append(os.path.join(dirname, "bindings"))
+    from gnuradio.RigExpert import fobos_sweep
+
+class qa_fobos_sweep(gr_unittest.TestCase):
+
+    def setUp(self):
+        self.tb = gr.top_block()
+
+    def tearDown(self):
+        self.tb = None
+
+    def test_001_simulated_rows(self):
+        # 7.5 MHz steps of 768 bins
+        src = fobos_sweep(0, 100.0, 400.0, 10.0, 1024, 2, 2, 1000, 0.75)
+        bins = src.bins()
+        self.assertEqual(bins, 40 * 768)
+        self.assertAlmostEqual(src.bin_width(), 10e6 / 1024)
+        head = blocks.head(gr.sizeof_float * bins, 3)
+        sink = blocks.vector_sink_f(bins)
+        self.tb.connect(src, head, sink)
+        self.tb.run()
+        data = sink.data()
+        self.assertEqual(len(data), 3 * bins)
+        # the simulator tone sits 1 MHz above every step center
+        row = data[-bins:]
+        step = 768 * src.bin_width()
+        for i in range(40):
+            tone = int(round((i * step + step / 2 + 1e6) / src.bin_width()))
+            self.assertGreater(row[tone], max(row[tone - 40], row[tone + 40]) + 20.0)
+        keys = [pmt.symbol_to_string(tag.key) for tag in sink.tags()]
+        self.assertEqual(keys.count("sweep_row"), 3)
+
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_fobos_sweep)